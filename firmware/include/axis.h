@@ -0,0 +1,126 @@
+/// @file axis.h
+/// @brief Compile-time drive-train constants for every axis.
+///
+/// Each axis is a type built from its motor's full steps and microsteps
+/// (motor_control.h) and its drive train (config.h).  Steps per mm / per
+/// revolution and their reciprocals are constexpr, so a conversion in the
+/// step path is a multiply by a literal and nothing is derived at start-up.
+/// Drive-train figures are integers (µm of travel, pulley teeth), so every
+/// constant is one correctly rounded float instead of the product of
+/// rounded intermediates.
+///
+/// A microstep setting the drivers cannot select fails to build, as does a
+/// mandrel drive whose steps per revolution is not a whole number (pattern
+/// slots and turn-around phases are counted in whole steps).
+///
+/// Functions rather than static data members keep the constants usable by
+/// reference under C++11 without out-of-line definitions.
+
+#pragma once
+
+#include <stdint.h>
+
+#include "config.h"
+#include "motor_control.h"
+
+/// @namespace AxisCheck
+/// @brief constexpr predicates behind the static_asserts below.
+namespace AxisCheck {
+
+    constexpr bool isPowerOfTwo(uint32_t v) { return v != 0 && (v & (v - 1)) == 0; }
+
+    /// Microstep resolutions the TMC22xx drivers can select (MRES): 1 … 256.
+    constexpr bool isDriverMicrostep(uint32_t m) { return m <= 256 && isPowerOfTwo(m); }
+
+}  // namespace AxisCheck
+
+/// @struct LinearAxis
+/// @brief Axis moving @p UmPerRev µm per motor revolution (belt or lead screw).
+template <uint16_t FullSteps, uint16_t Microsteps, uint32_t UmPerRev>
+struct LinearAxis {
+    static_assert(FullSteps > 0, "motor needs full steps per revolution");
+    static_assert(AxisCheck::isDriverMicrostep(Microsteps),
+                  "microsteps must be a power of two from 1 to 256");
+    static_assert(UmPerRev > 0, "axis needs travel per motor revolution");
+
+    static constexpr uint32_t microStepsPerRev() { return static_cast<uint32_t>(FullSteps) * Microsteps; }
+
+    static constexpr float stepsPerMM() { return microStepsPerRev() * 1000.0f / UmPerRev; }
+    static constexpr float mmPerStep()  { return UmPerRev / (microStepsPerRev() * 1000.0f); }
+
+    static constexpr float toSteps(float mm) { return mm * stepsPerMM(); }
+    static constexpr float toMM(long steps)  { return steps * mmPerStep(); }
+};
+
+/// @struct RotaryAxis
+/// @brief Axis whose output turns once per DrivenTeeth / DriverTeeth motor
+///        revolutions.
+template <uint16_t FullSteps, uint16_t Microsteps, uint16_t DriverTeeth, uint16_t DrivenTeeth>
+struct RotaryAxis {
+    static_assert(FullSteps > 0, "motor needs full steps per revolution");
+    static_assert(AxisCheck::isDriverMicrostep(Microsteps),
+                  "microsteps must be a power of two from 1 to 256");
+    static_assert(DriverTeeth > 0 && DrivenTeeth > 0, "pulleys need teeth");
+
+    static constexpr uint32_t microStepsPerRev() { return static_cast<uint32_t>(FullSteps) * Microsteps; }
+
+    /// @return true if one output revolution is a whole number of steps.
+    static constexpr bool wholeStepsPerRev() {
+        return (microStepsPerRev() * DrivenTeeth) % DriverTeeth == 0;
+    }
+
+    static constexpr float stepsPerRev() {
+        return static_cast<float>(microStepsPerRev() * DrivenTeeth) / DriverTeeth;
+    }
+    static constexpr float revsPerStep() {
+        return static_cast<float>(DriverTeeth) / (microStepsPerRev() * DrivenTeeth);
+    }
+    static constexpr float stepsPerDegree() {
+        return static_cast<float>(microStepsPerRev() * DrivenTeeth) / (DriverTeeth * 360.0f);
+    }
+    static constexpr float degreesPerStep() {
+        return DriverTeeth * 360.0f / (microStepsPerRev() * DrivenTeeth);
+    }
+
+    static constexpr float toSteps(float deg)  { return deg * stepsPerDegree(); }
+    static constexpr float toDegrees(long steps) { return steps * degreesPerStep(); }
+};
+
+// ============================================================================
+//  Machine Axes
+// ============================================================================
+
+using MandrelAxis  = RotaryAxis<MANDREL_MOTOR_PARAMS.stepsPerRev, MANDREL_MOTOR_PARAMS.microsteps,
+                                MOTOR_PULLEY_TEETH, MANDREL_PULLEY_TEETH>;
+using CarriageAxis = LinearAxis<CARRIAGE_MOTOR_PARAMS.stepsPerRev, CARRIAGE_MOTOR_PARAMS.microsteps,
+                                CARRIAGE_UM_PER_MOTOR_REV>;
+using ToolarmAxis  = LinearAxis<TOOLARM_MOTOR_PARAMS.stepsPerRev, TOOLARM_MOTOR_PARAMS.microsteps,
+                                TOOLARM_UM_PER_MOTOR_REV>;
+using ToolheadAxis = RotaryAxis<TOOLHEAD_MOTOR_PARAMS.stepsPerRev, TOOLHEAD_MOTOR_PARAMS.microsteps,
+                                MOTOR_PULLEY_TEETH, TOOLHEAD_PULLEY_TEETH>;
+
+// ============================================================================
+//  Compile-Time Checks
+// ============================================================================
+
+static_assert(MandrelAxis::wholeStepsPerRev(),
+              "mandrel steps per revolution must be whole (pattern slots are counted in steps)");
+static_assert(MandrelAxis::microStepsPerRev() == MANDREL_MOTOR_PARAMS.microStepsPerRev &&
+              CarriageAxis::microStepsPerRev() == CARRIAGE_MOTOR_PARAMS.microStepsPerRev &&
+              ToolarmAxis::microStepsPerRev() == TOOLARM_MOTOR_PARAMS.microStepsPerRev &&
+              ToolheadAxis::microStepsPerRev() == TOOLHEAD_MOTOR_PARAMS.microStepsPerRev,
+              "microStepsPerRev overflowed its uint16_t field");
+
+// The template arithmetic against hand-worked drive trains.
+static_assert(LinearAxis<200, 8, 40000>::stepsPerMM() == 40.0f, "GT2 × 20T belt at 1/8");
+static_assert(LinearAxis<200, 8, 40000>::mmPerStep() == 0.025f, "GT2 × 20T belt at 1/8");
+static_assert(LinearAxis<200, 16, 8000>::stepsPerMM() == 400.0f, "T8 lead screw at 1/16");
+static_assert(LinearAxis<200, 8, 4000>::toSteps(2.5f) == 1000.0f, "4 mm lead screw at 1/8");
+static_assert(RotaryAxis<200, 8, 20, 48>::stepsPerRev() == 3840.0f, "20T → 48T at 1/8");
+static_assert(RotaryAxis<200, 8, 20, 48>::stepsPerDegree() == 3840.0f / 360.0f, "20T → 48T at 1/8");
+static_assert(RotaryAxis<200, 8, 20, 60>::toSteps(90.0f) == 1200.0f, "20T → 60T at 1/8");
+static_assert(RotaryAxis<200, 1, 20, 48>::wholeStepsPerRev(), "9600 / 20 steps per revolution");
+static_assert(!RotaryAxis<200, 1, 30, 47>::wholeStepsPerRev(), "9400 / 30 steps per revolution");
+static_assert(AxisCheck::isDriverMicrostep(256) && !AxisCheck::isDriverMicrostep(12) &&
+              !AxisCheck::isDriverMicrostep(512) && !AxisCheck::isDriverMicrostep(0),
+              "driver microstep resolutions");
@@ -9,12 +9,22 @@
 #include <stdint.h>
 
 // ============================================================================
-//  Limit-Switch Pins
+//  Limit-Switch and E-Stop Pins
 // ============================================================================
 
 /// Carriage home / limit switch (active LOW with internal pull-up).
 constexpr uint8_t CARRIAGE_LIMIT_PIN = 16;
 
+/// Toolarm home switch, arm fully retracted (active LOW with internal pull-up).
+constexpr uint8_t TOOLARM_LIMIT_PIN = 4;
+
+/// Toolhead home switch (active LOW with internal pull-up).
+constexpr uint8_t TOOLHEAD_LIMIT_PIN = 22;
+
+/// E-stop, normally closed to GND (active HIGH with internal pull-up), so a
+/// broken wire stops the machine too.
+constexpr uint8_t E_STOP_PIN = 15;
+
 /// Built-in LED pin (GPIO 2 on most ESP32 dev boards).
 constexpr uint8_t LED_PIN = 2;
 
@@ -25,35 +35,20 @@ constexpr unsigned long LED_BLINK_INTERVAL_MS = 500;
 //  Drive-Train Mechanical Constants
 // ============================================================================
 
-constexpr float BELT_PITCH_MM         = 2.0f;  ///< GT2 belt tooth pitch (mm).
-constexpr int   MOTOR_PULLEY_TEETH    = 20;    ///< Motor-shaft pulley tooth count.
-constexpr int   MANDREL_PULLEY_TEETH  = 48;    ///< Mandrel driven-pulley tooth count.
-constexpr int   CARRIAGE_PULLEY_TEETH = 20;    ///< Carriage driven-pulley tooth count.
+constexpr uint32_t BELT_PITCH_UM         = 2000;  ///< GT2 belt tooth pitch (µm).
+constexpr uint16_t MOTOR_PULLEY_TEETH    = 20;    ///< Motor-shaft pulley tooth count.
+constexpr uint16_t MANDREL_PULLEY_TEETH  = 48;    ///< Mandrel driven-pulley tooth count.
+constexpr uint16_t CARRIAGE_PULLEY_TEETH = 20;    ///< Carriage driven-pulley tooth count.
+constexpr uint16_t TOOLHEAD_PULLEY_TEETH = 60;    ///< Toolhead driven-pulley tooth count.
 
-/// Mandrel gear ratio  (driven / driver).
-constexpr float MANDREL_GEAR_RATIO =
-    static_cast<float>(MANDREL_PULLEY_TEETH) / MOTOR_PULLEY_TEETH;
+/// Carriage linear travel per motor revolution (µm).
+constexpr uint32_t CARRIAGE_UM_PER_MOTOR_REV = CARRIAGE_PULLEY_TEETH * BELT_PITCH_UM;
 
-/// Carriage linear travel per motor revolution (mm).
-constexpr float CARRIAGE_MM_PER_MOTOR_REV =
-    static_cast<float>(CARRIAGE_PULLEY_TEETH) * BELT_PITCH_MM;
-
-// ============================================================================
-//  Derived-Ratio Helper Functions
-// ============================================================================
+/// Toolarm lead-screw travel per motor revolution (µm).
+constexpr uint32_t TOOLARM_UM_PER_MOTOR_REV = 4000;
 
-/// Compute carriage motor microsteps per millimetre of linear travel.
-/// @param microStepsPerRev  Carriage motor total microsteps per revolution.
-inline float computeCarriageStepsPerMM(uint16_t microStepsPerRev) {
-    return static_cast<float>(microStepsPerRev) / CARRIAGE_MM_PER_MOTOR_REV;
-}
-
-/// Compute total mandrel motor microsteps per full mandrel revolution
-/// (accounting for the belt/pulley gear ratio).
-/// @param microStepsPerRev  Mandrel motor total microsteps per revolution.
-inline float computeMandrelStepsPerRev(uint16_t microStepsPerRev) {
-    return static_cast<float>(microStepsPerRev) * MANDREL_GEAR_RATIO;
-}
+// Steps per mm / per revolution of each axis, and their reciprocals, are
+// derived from these and the motor parameters at compile time — see axis.h.
 
 // ============================================================================
 //  Default Motion Parameters
@@ -63,4 +58,165 @@ constexpr float DEFAULT_MANDREL_SPEED      = 600.0f;   ///< Mandrel constant spe
 constexpr float DEFAULT_MANDREL_MAX_SPEED  = 1000.0f;  ///< Mandrel maximum speed  (steps/s).
 constexpr float DEFAULT_CARRIAGE_MAX_SPEED = 3000.0f;  ///< Carriage maximum speed (steps/s).
 constexpr float DEFAULT_CARRIAGE_ACCEL     = 5000.0f;  ///< Carriage acceleration  (steps/s²).
-constexpr float ZEROING_SPEED              = 400.0f;   ///< Carriage homing speed  (steps/s).
+constexpr float DEFAULT_TOOLHEAD_MAX_SPEED = 2400.0f;  ///< Toolhead flip speed    (steps/s; 180 °/s).
+constexpr float DEFAULT_TOOLHEAD_ACCEL     = 12000.0f; ///< Toolhead acceleration  (steps/s²; 900 °/s²).
+constexpr float DEFAULT_TOOLARM_MAX_SPEED  = 4000.0f;  ///< Toolarm maximum speed  (steps/s; 10 mm/s).
+constexpr float DEFAULT_TOOLARM_ACCEL      = 40000.0f; ///< Toolarm acceleration   (steps/s²; 100 mm/s²).
+constexpr float DEFAULT_MANDREL_ACCEL      = 600.0f;   ///< Mandrel speed changes  (steps/s²; toolarm slow-downs).
+
+// The toolhead turns the payout eye to the fibre angle, mirrored every
+// pass.  Square to the mandrel axis (0°) is this far from the home switch,
+// so neither orientation runs back onto it.
+constexpr float TOOLHEAD_SQUARE_DEG = 90.0f;
+
+// Velocity-mode gearing: the carriage runs at the geared speed plus a
+// catch-up speed proportional to its following error, capped so the
+// catch-up can be shed within GEAR_CATCH_UP_ACCEL (no overshoot).
+constexpr float GEAR_CATCH_UP_GAIN  = 20.0f;                          ///< Catch-up per step of error (1/s).
+constexpr float GEAR_CATCH_UP_ACCEL = 0.5f * DEFAULT_CARRIAGE_ACCEL;  ///< Share of the acceleration (steps/s²).
+
+// The toolarm follows the mandrel surface the same way: the profile slope
+// times the carriage speed, plus a catch-up on its error against the
+// target at the carriage position (toolarm_plan.h).
+constexpr float TOOLARM_CATCH_UP_GAIN  = 20.0f;                         ///< Catch-up per step of error (1/s).
+constexpr float TOOLARM_CATCH_UP_ACCEL = 0.1f * DEFAULT_TOOLARM_ACCEL;  ///< Share of the acceleration (steps/s²).
+
+// On a profiled mandrel the toolarm plan slows the mandrel, and a dwell
+// ramps it up from the plan's speed and back; either sets its speed every
+// this many mandrel steps, not on every step.
+constexpr long MANDREL_LIMIT_STEPS = 8;
+
+// ============================================================================
+//  Homing
+// ============================================================================
+
+// Two-stage homing (homing.h): the seek only has to find the switch, so it
+// runs fast; the slow approach defines home.  Home is the position latched
+// at the switch edge, so the approach speed is bounded by the switch's own
+// repeatability, not by loop or debounce latency.
+constexpr float CARRIAGE_HOMING_FAST_SPEED = 2400.0f;   ///< Seek speed (steps/s; 60 mm/s).
+constexpr float CARRIAGE_HOMING_ACCEL      = 20000.0f;  ///< Seek acceleration and braking (steps/s²).
+constexpr float CARRIAGE_HOMING_SLOW_SPEED = 400.0f;    ///< Approach speed (steps/s; 10 mm/s).
+constexpr float CARRIAGE_HOMING_BACKOFF_MM = 2.0f;      ///< Clearance past the seek's trigger point (mm).
+constexpr float CARRIAGE_TRAVEL_MM         = 1200.0f;   ///< Carriage travel; a seek gives up after it (mm).
+
+constexpr float TOOLARM_HOMING_FAST_SPEED = 4000.0f;   ///< Seek speed (steps/s; 10 mm/s).
+constexpr float TOOLARM_HOMING_ACCEL      = 40000.0f;  ///< Seek acceleration and braking (steps/s²).
+constexpr float TOOLARM_HOMING_SLOW_SPEED = 1600.0f;   ///< Approach speed (steps/s; 4 mm/s).
+constexpr float TOOLARM_HOMING_BACKOFF_MM = 0.5f;      ///< Clearance past the seek's trigger point (mm).
+constexpr float TOOLARM_TRAVEL_MM         = 150.0f;    ///< Toolarm travel; a seek gives up after it (mm).
+
+constexpr float TOOLHEAD_HOMING_FAST_SPEED  = 2400.0f;   ///< Seek speed (steps/s; 180 °/s).
+constexpr float TOOLHEAD_HOMING_ACCEL       = 20000.0f;  ///< Seek acceleration and braking (steps/s²).
+constexpr float TOOLHEAD_HOMING_SLOW_SPEED  = 400.0f;    ///< Approach speed (steps/s; 30 °/s).
+constexpr float TOOLHEAD_HOMING_BACKOFF_DEG = 3.0f;      ///< Clearance past the seek's trigger point (°).
+constexpr float TOOLHEAD_TRAVEL_DEG         = 400.0f;    ///< A seek gives up after a little over a turn (°).
+
+// Seek resolution: with its driver on the UART (tmc2209.h) an axis seeks,
+// brakes and backs off at this many microsteps, fewer pulses for the same
+// speed, and approaches at its own.  An axis whose driver is not on the
+// UART seeks at its own resolution.
+constexpr uint16_t CARRIAGE_HOMING_SEEK_MICROSTEPS = 2;
+constexpr uint16_t TOOLARM_HOMING_SEEK_MICROSTEPS  = 2;
+constexpr uint16_t TOOLHEAD_HOMING_SEEK_MICROSTEPS = 2;
+
+// Flip resolution: with its driver on the UART the toolhead turns to the
+// next pass's fibre angle at this many microsteps, switched at rest as the
+// flip starts and back to its own once it stops (winding.cpp).  The
+// carriage's TMC2225 has no UART, the mandrel turns through every dwell
+// and the toolarm only makes slow moves along the surface, so they wind at
+// their own.
+constexpr uint16_t TOOLHEAD_FLIP_MICROSTEPS = 2;
+
+// Step-loss check: homing finds home in the previous home's frame, so an
+// axis whose home moved by more than this since its last homing lost (or
+// gained) steps in between — two full steps, above the switch's scatter.
+constexpr float CARRIAGE_HOME_TOLERANCE_MM  = 0.4f;    ///< 16 steps.
+constexpr float TOOLARM_HOME_TOLERANCE_MM   = 0.04f;   ///< 16 steps.
+constexpr float TOOLHEAD_HOME_TOLERANCE_DEG = 1.2f;    ///< 16 steps.
+
+// Homing order.  Axes home at the same time unless they could collide: an
+// axis starts once every axis in its mask is homed (bit 0 carriage, bit 1
+// toolarm, bit 2 toolhead — HomeAxis in homing.h).
+constexpr uint8_t CARRIAGE_HOMES_AFTER = 0;
+constexpr uint8_t TOOLARM_HOMES_AFTER  = 0;
+constexpr uint8_t TOOLHEAD_HOMES_AFTER = 1 << 1;   ///< Swings clear of the mandrel only with the arm retracted.
+
+// ============================================================================
+//  Backlash
+// ============================================================================
+
+// Dead band of each drive, taken up at the take-up speed whenever the axis
+// reverses and not counted as travel (StepDirStepper::setBacklash()).  The
+// defaults are uncalibrated; "backlash cal" measures every axis at its
+// limit switch during the next homing (homing.h) and compensates from then
+// on.  A reversal at the switch sees the backlash plus the switch's own
+// differential (operate-to-release travel), which the calibration cannot
+// tell apart: the differential is set here and subtracted — 0 for an
+// optical or Hall switch, the datasheet's differential travel for a lever
+// microswitch.
+constexpr float CARRIAGE_BACKLASH_MM            = 0.0f;     ///< Belt drive dead band (mm).
+constexpr float CARRIAGE_TAKE_UP_SPEED          = 1600.0f;  ///< Take-up speed (steps/s; 40 mm/s).
+constexpr float CARRIAGE_SWITCH_DIFFERENTIAL_MM = 0.0f;     ///< Limit switch differential (mm).
+
+constexpr float TOOLARM_BACKLASH_MM            = 0.0f;     ///< Lead-screw dead band (mm).
+constexpr float TOOLARM_TAKE_UP_SPEED          = 1600.0f;  ///< Take-up speed (steps/s; 4 mm/s).
+constexpr float TOOLARM_SWITCH_DIFFERENTIAL_MM = 0.0f;     ///< Home switch differential (mm).
+
+constexpr float TOOLHEAD_BACKLASH_DEG            = 0.0f;     ///< Belt drive dead band (°).
+constexpr float TOOLHEAD_TAKE_UP_SPEED           = 1600.0f;  ///< Take-up speed (steps/s; 120 °/s).
+constexpr float TOOLHEAD_SWITCH_DIFFERENTIAL_DEG = 0.0f;     ///< Home switch differential (°).
+
+/// Reversals at the switch per calibration: off it and back onto it, each
+/// one reading, so twice as many readings.
+constexpr uint8_t BACKLASH_CALIBRATION_CYCLES = 4;
+
+// ============================================================================
+//  Inputs
+// ============================================================================
+
+// Debounce (inputs.h): a change counts once the line has settled for the
+// window after its first edge.  A limit switch acts within
+// INPUT_DEBOUNCE_US + INPUT_SCAN_US of closing.
+constexpr uint32_t INPUT_DEBOUNCE_US = 2000;   ///< Debounce window after the first edge (µs).
+constexpr uint32_t INPUT_SCAN_US     = 250;    ///< Debounce timer period (µs).
+
+// ============================================================================
+//  Mandrel Encoder
+// ============================================================================
+
+// Optional quadrature encoder on the mandrel shaft (encoder.h).  Fitted,
+// the carriage is geared to the measured mandrel angle, so missed mandrel
+// steps no longer shift the layup, and the job stops when the mandrel
+// loses more than MANDREL_FOLLOWING_LIMIT_DEG within a revolution or two
+// (a stalled or slipping mandrel).
+constexpr bool     MANDREL_ENCODER_FITTED         = false;
+constexpr uint8_t  MANDREL_ENCODER_A_PIN          = 34;     ///< Input-only GPIO; push-pull encoder outputs.
+constexpr uint8_t  MANDREL_ENCODER_B_PIN          = 35;
+constexpr uint32_t MANDREL_ENCODER_COUNTS_PER_REV = 2400;   ///< 600-line encoder × 4 (≤ one count per step).
+constexpr float    MANDREL_FOLLOWING_LIMIT_DEG    = 5.0f;   ///< Loss that stops the job (°).
+
+// ============================================================================
+//  Drivers
+// ============================================================================
+
+// TMC2209 single-wire UART (tmc2209.h): every driver's PDN_UART on the RX
+// pin, TX onto it through 1 kΩ, each driver addressed by its MS1/MS2
+// straps.  Addresses, currents and chopper modes are per axis in
+// motor_control.h; a driver that does not answer at start-up runs at its
+// strapped resolution, which must then be the axis's.
+constexpr uint8_t  TMC_UART_RX_PIN = 36;      ///< Input-only GPIO.
+constexpr uint8_t  TMC_UART_TX_PIN = 5;
+constexpr uint32_t TMC_UART_BAUD   = 115200;
+constexpr float    TMC_SENSE_OHMS  = 0.11f;   ///< Sense resistors (Ω; 0.11 on the common modules).
+
+// Stall detection (stall_monitor.h): while winding, the watched drivers'
+// SG_RESULT is read in turn, one read (≈ 1.1 ms on the wire) in flight at
+// a time and the next no sooner than STALL_POLL_US after the last began.
+// An axis is read once it has run at its driver's stallMinSpeed for
+// STALL_SETTLE_US (StallGuard reads low for the first steps from rest);
+// STALL_CONFIRM_READINGS readings in a row at or below its stall level
+// pause the job.
+constexpr uint32_t STALL_POLL_US          = 1500;
+constexpr uint32_t STALL_SETTLE_US        = 10000;
+constexpr uint8_t  STALL_CONFIRM_READINGS = 2;
@@ -0,0 +1,133 @@
+/// @file dome_path.h
+/// @brief Geodesic / non-geodesic polar-turnaround path over a mandrel dome.
+///
+/// Closed-end vessels turn the fibre around on the domes instead of at a
+/// fixed carriage endpoint.  The path follows the surface of revolution
+/// described by a SplineProfile from the end of the cylinder to the polar
+/// turnaround, where the fibre angle reaches 90°:
+///
+///   geodesic      Clairaut:  r · sin α = r₀   (r₀ = polar opening radius)
+///   non-geodesic  dα/dm = λ · kₙ / cos α − tan α · (dr/dm) / r
+///
+/// with m the meridian arc length, kₙ the surface's normal curvature along
+/// the fibre and λ the slippage coefficient (0 = geodesic; keep |λ| below the
+/// fibre / mandrel friction coefficient).  The cylinder angle that makes the
+/// path turn around exactly at the polar opening is found by bisection.
+///
+/// The integrated path is resampled into at most DOME_PATH_MAX_ENTRIES
+/// compact entries, uniformly spaced in meridian arc length, each giving the
+/// mandrel rotation, carriage, toolarm and toolhead step targets, the fibre
+/// angle and the local gear ratio.  A DomePathCursor streams the table with
+/// the mandrel as master: as mandrel steps accumulate it returns the
+/// interpolated carriage / toolarm / toolhead targets in O(1) amortised.
+///
+/// Pure float arithmetic with no Arduino dependency, so the same generator
+/// runs on the host (tools/dome_path) and can run on the ESP32 at job load.
+/// The winding state machine does not wind polar layers yet: nothing in
+/// the firmware generates a table until it does, and only tools/dome_path
+/// uses it.
+
+#pragma once
+
+#include <stdint.h>
+
+#include "spline_profile.h"
+
+/// Maximum entries in one dome table (16 bytes each).
+constexpr int DOME_PATH_MAX_ENTRIES = 256;
+
+/// Integration steps over the dome meridian per trial cylinder angle.
+constexpr int DOME_PATH_INTEGRATION_STEPS = 1500;
+
+/// Fibre angle at which the path is considered turned around (degrees).
+constexpr float DOME_PATH_TURN_ANGLE = 89.5f;
+
+/// @struct DomePathParams
+/// @brief Inputs to DomePath::generate().
+struct DomePathParams {
+    float cylinderEndMM       = 0.0f;   ///< Carriage position where the dome begins (mm).
+    int   direction           = 1;      ///< +1: dome lies at larger x, −1: at smaller x.
+    float polarOpeningRadius  = 0.0f;   ///< Turnaround radius r₀ (mm).
+    float slippage            = 0.0f;   ///< λ (0 = geodesic).
+    float carriageStepsPerMM  = 0.0f;
+    float mandrelStepsPerRev  = 0.0f;
+    float toolarmStepsPerMM   = 0.0f;
+    float toolheadStepsPerRev = 0.0f;
+    int   maxEntries          = DOME_PATH_MAX_ENTRIES;   ///< ≤ DOME_PATH_MAX_ENTRIES.
+};
+
+/// @struct DomePathEntry
+/// @brief One resampled point of the path.  Steps are absolute for the
+///        carriage / toolarm / toolhead and relative to the cylinder end for
+///        the mandrel.
+struct DomePathEntry {
+    int32_t  mandrelStep;    ///< Mandrel rotation since the cylinder end (steps).
+    int32_t  carriageStep;   ///< Carriage position (steps).
+    int32_t  toolarmStep;    ///< Toolarm target: radius + standoff (steps).
+    int16_t  toolheadStep;   ///< Toolhead target: ± fibre angle (steps).
+    uint16_t angleCdeg;      ///< Fibre angle (0.01°).
+};
+
+static_assert(sizeof(DomePathEntry) == 16, "DomePathEntry should stay 16 bytes");
+
+/// @class DomePath
+/// @brief Precomputed polar-turnaround path for one dome.
+class DomePath {
+public:
+    /// Integrate the path over @p profile and fill the table.
+    /// @return false (see getError()) if the opening cannot be reached.
+    bool generate(const SplineProfile& profile, const DomePathParams& params);
+
+    bool              isValid() const       { return count_ > 0; }
+    const char*       getError() const      { return error_; }
+    int               getCount() const      { return count_; }
+    const DomePathEntry& entry(int i) const { return entries_[i]; }
+
+    float getCylinderAngle() const   { return cylinderAngle_; }   ///< Winding angle on the cylinder (deg).
+    float getTurnaroundMM() const    { return turnaroundMM_; }    ///< Carriage position of the turnaround.
+    float getTurnaroundRadius() const { return turnaroundR_; }    ///< Radius where α reached 90° (mm).
+    float getDomeRotationDeg() const { return rotationDeg_; }     ///< Mandrel rotation cylinder end → turnaround.
+    int   getBisectionSteps() const  { return iterations_; }
+
+    /// Gear ratio (carriage steps per mandrel step) between entries i and i+1.
+    float ratioAt(int i) const;
+
+    /// Bytes of the table in use.
+    unsigned getTableBytes() const { return count_ * sizeof(DomePathEntry); }
+
+private:
+    DomePathEntry entries_[DOME_PATH_MAX_ENTRIES];
+    int           count_         = 0;
+    const char*   error_         = "";
+    float         cylinderAngle_ = 0.0f;
+    float         turnaroundMM_  = 0.0f;
+    float         turnaroundR_   = 0.0f;
+    float         rotationDeg_   = 0.0f;
+    int           iterations_    = 0;
+};
+
+/// @class DomePathCursor
+/// @brief Streams a DomePath with the mandrel as master axis.
+class DomePathCursor {
+public:
+    /// Start at the cylinder end of @p path.
+    void begin(const DomePath& path) { path_ = &path; index_ = 0; }
+
+    /// Advance to @p mandrelStep (steps since the cylinder end; must not
+    /// decrease) and interpolate the slave targets.
+    /// @return false once the turnaround has been passed.
+    bool seek(long mandrelStep);
+
+    long  carriageStep() const { return carriage_; }
+    long  toolarmStep() const  { return toolarm_; }
+    long  toolheadStep() const { return toolhead_; }
+    float angleDeg() const     { return angleDeg_; }
+
+private:
+    const DomePath* path_     = nullptr;
+    int             index_    = 0;
+    long            carriage_ = 0;
+    long            toolarm_  = 0;
+    long            toolhead_ = 0;
+    float           angleDeg_ = 0.0f;
+};
@@ -0,0 +1,46 @@
+/// @file encoder.h
+/// @brief Quadrature encoder on the mandrel shaft.
+///
+/// The stepper's step count is what the mandrel was commanded to turn, not
+/// what it turned: a step lost under load (a heavy wet mandrel) would leave
+/// the layup permanently out of phase.  With the encoder fitted the gearing
+/// follows the measured angle instead (winding.cpp), and the difference
+/// between the two — the following error — stops the job when it grows by
+/// more than MANDREL_FOLLOWING_LIMIT_DEG within a revolution or two.
+///
+/// On the ESP32 a PCNT unit decodes A/B in hardware (4 counts per line,
+/// with a glitch filter); its 16-bit counter is extended to 32 bits on the
+/// limit events, so reads may be arbitrarily far apart.  On the host a
+/// software decoder on the A/B pin-change interrupts stands in for it, fed
+/// by the Arduino stand-in from the simulated mandrel (tools/host).
+
+#pragma once
+
+#include <stdint.h>
+
+/// @namespace MandrelEncoder
+/// @brief Mandrel position feedback.
+namespace MandrelEncoder {
+
+    /// Configure the counter on MANDREL_ENCODER_A_PIN / _B_PIN and zero it.
+    /// Safe to call again.
+    void init();
+
+    /// Release the counter; enabled() is false until the next init().
+    void end();
+
+    /// @return true between init() and end().
+    bool enabled();
+
+    /// Quadrature counts since init() (MANDREL_ENCODER_COUNTS_PER_REV per
+    /// mandrel revolution).
+    long count();
+
+    /// Measured mandrel position in mandrel steps (MandrelAxis units).
+    long steps();
+
+    /// Make the current measured position read as @p step (align it with
+    /// the step count while the mandrel stands).
+    void setSteps(long step);
+
+}  // namespace MandrelEncoder
@@ -0,0 +1,157 @@
+/// @file estimate.h
+/// @brief Winding job time estimator with a per-layer breakdown.
+///
+/// Predicts how long a WindProfile takes from the axis speed / acceleration
+/// limits: two-stage homing of every axis in its dependency order
+/// (homing.h), then for every pass of every layer the
+/// geared traverse (carriage steps = ratio × mandrel steps at the constant
+/// mandrel speed), the carriage's acceleration limit where it cannot keep
+/// up or decelerates into a hand-over, the turn-around rotation (dwell + stepover, or the
+/// layer's winding pattern; only the dwell where one layer hands over to
+/// the next), whatever of the toolhead flip to the next pass's fibre
+/// angle the dwell and the carriage's ramps either side cannot hide, and on
+/// a profiled mandrel the gear ratio following the surface and the
+/// slow-downs the toolarm needs (toolarm_plan.h).
+///
+/// Runs on the ESP32 when a job starts (reported by "status" / "estimate")
+/// and on the host, where tools/job_time checks it against the virtual-time
+/// simulation of the same job.
+
+#pragma once
+
+#include <stdint.h>
+
+#include "homing.h"
+#include "layer.h"
+
+struct WindProfile;
+class SplineProfile;
+
+/// @struct EstimateParams
+/// @brief Motion limits and drive-train ratios the estimate is based on.
+struct EstimateParams {
+    float    mandrelSpeed;        ///< Mandrel constant speed (steps/s).
+    float    carriageMaxSpeed;    ///< Carriage maximum speed (steps/s).
+    float    carriageAccel;       ///< Carriage acceleration (steps/s²).
+    HomingConfig homing[HOMED_AXES];   ///< Homing of each axis, HomeAxis order.
+    float    carriageStepsPerMM;  ///< Carriage microsteps per mm.
+    float    mandrelStepsPerRev;  ///< Mandrel microsteps per mandrel revolution.
+    long     homeDistanceSteps[HOMED_AXES];   ///< Distance of each axis to its switch at start (steps).
+    uint32_t loopUs;              ///< loop() period; step intervals round up to it (0 = ideal).
+    float    toolheadMaxSpeed;    ///< Toolhead flip speed (steps/s).
+    float    toolheadAccel;       ///< Toolhead flip acceleration (steps/s²).
+    bool     overlapFlip;         ///< WindProfile::overlapToolheadFlip.
+    float    toolarmStepsPerMM;   ///< Toolarm microsteps per mm.
+    float    toolarmMaxSpeed;     ///< Toolarm maximum speed (steps/s).
+    float    toolarmAccel;        ///< Toolarm acceleration (steps/s²).
+    float    mandrelAccel;        ///< Mandrel speed changes for the toolarm (steps/s²).
+    bool     toolarmLookAhead;    ///< WindProfile::toolarmLookAhead.
+};
+
+/// @struct FlipTiming
+/// @brief The toolhead flip at a turn-around and how it is fitted around
+///        the dwell.
+///
+/// With the overlap the flip starts leadSeconds before the pass ends, while
+/// the carriage runs down into the endpoint, and may still be turning for
+/// lagSeconds after the next pass starts, while the carriage accelerates;
+/// each is capped at the carriage's ramp time (v / a) and only used as far
+/// as the dwell is too short.  What still does not fit is waitSeconds: the
+/// mandrel holds at the end of the dwell until the toolhead is within
+/// holdSteps of its target.  Without the overlap the flip runs within the
+/// dwell and waits out the rest, as in the reference scripts.
+struct FlipTiming {
+    float seconds     = 0.0f;   ///< Toolhead move time.
+    float leadSeconds = 0.0f;   ///< Turning before the pass ends.
+    float lagSeconds  = 0.0f;   ///< Turning after the next pass starts.
+    float waitSeconds = 0.0f;   ///< Dead time after the dwell.
+    long  leadSteps   = 0;      ///< Carriage steps before the pass end at which the flip starts.
+    long  holdSteps   = 0;      ///< Toolhead steps still to go when the next pass starts.
+};
+
+/// @struct LayerEstimate
+/// @brief Predicted time for one layer.
+struct LayerEstimate {
+    int   passes        = 0;      ///< Passes in the layer.
+    float windSeconds   = 0.0f;   ///< Time spent traversing (WINDING).
+    float dwellSeconds  = 0.0f;   ///< Time spent in turn-around rotation (DWELLING).
+    float flipSeconds   = 0.0f;   ///< Time waiting for the toolhead after the dwells.
+    float totalSeconds  = 0.0f;   ///< windSeconds + dwellSeconds + flipSeconds.
+    float sequentialSeconds = 0.0f;   ///< Same layer laid band by band (= totalSeconds without a pattern).
+    float endMM         = 0.0f;   ///< Carriage position when the layer ends (mm).
+};
+
+/// @struct JobEstimate
+/// @brief Predicted time for a whole WindProfile.
+struct JobEstimate {
+    bool          valid          = false;
+    float         zeroingSeconds = 0.0f;   ///< Homing and turning the toolhead to the first pass.
+    float         totalSeconds   = 0.0f;
+    float         sequentialSeconds = 0.0f;   ///< totalSeconds with every layer laid band by band.
+    int           layerCount     = 0;
+    LayerEstimate layers[MAX_LAYERS];
+};
+
+/// @namespace Estimate
+/// @brief Job-time prediction.
+namespace Estimate {
+
+    /// Parameters matching the firmware's winding defaults (config.h and the
+    /// configured motor microstepping).
+    /// @param carriageHome … toolheadHome  Distance of each axis to its
+    ///                                     switch (steps).
+    EstimateParams defaultParams(long carriageHome = 0, long toolarmHome = 0, long toolheadHome = 0);
+
+    /// Time to home one axis @p distanceSteps from its switch (seconds):
+    /// the seek, braking past the switch, backing off and the approach.
+    float homing(const HomingConfig& config, long distanceSteps, uint32_t loopUs);
+
+    /// Time to home every axis (seconds): axes home concurrently, each
+    /// starting once the axes it waits for have homed, so this is the
+    /// longest chain of dependent axes.
+    float zeroing(const EstimateParams& params);
+
+    /// Toolhead position for a pass of @p layer (steps): the fibre angle
+    /// either side of TOOLHEAD_SQUARE_DEG, by the pass direction.
+    long toolheadSteps(const Layer& layer, bool forward);
+
+    /// Time to turn the toolhead from home to the first pass of @p first,
+    /// and to move the toolarm to the surface of @p mandrel (if given), at
+    /// once (seconds): the end of zeroing.
+    float positioning(const Layer& first, const EstimateParams& params,
+                      const SplineProfile* mandrel = nullptr);
+
+    /// Toolhead flip at a turn-around within @p layer.
+    FlipTiming turnaroundFlip(const Layer& layer, const EstimateParams& params);
+
+    /// Toolhead flip where @p layer hands over to @p next.
+    FlipTiming handOverFlip(const Layer& layer, const Layer& next, const EstimateParams& params);
+
+    /// Carriage position (mm) the last pass of @p layer comes to rest on
+    /// where it hands over to another layer: past the layer's end by the
+    /// carriage's braking distance, as far as the travel allows, so the
+    /// winding zone is wound geared up to its end.  On a profiled mandrel
+    /// (@p mandrel ready) it is the layer's end: the toolarm plan eases
+    /// the mandrel only where passes start from rest, at home and the
+    /// zone's ends.
+    float handOverEndMM(const Layer& layer, const EstimateParams& params,
+                        const SplineProfile* mandrel = nullptr);
+
+    /// Mandrel rotation (degrees) over one full-length pass: the geared
+    /// rotation, or the carriage-limited ramp and cruise above the maximum
+    /// speed.  The winding-pattern planner works from this.
+    float passDegrees(const Layer& layer, const EstimateParams& params);
+
+    /// Estimate one layer.
+    /// @param startMM  Carriage position when the layer starts (mm).
+    /// @param next     The layer that follows, or nullptr: the last
+    ///                 turn-around is then only the fibre-placement dwell
+    ///                 and the flip to @p next's first pass.
+    /// @param mandrel  Mandrel surface the toolarm follows, or nullptr.
+    LayerEstimate layer(const Layer& layer, const EstimateParams& params,
+                        float startMM, const Layer* next, const SplineProfile* mandrel = nullptr);
+
+    /// Estimate a complete job, including zeroing and positioning.
+    JobEstimate job(const WindProfile& profile, const EstimateParams& params);
+
+}  // namespace Estimate
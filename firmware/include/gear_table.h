@@ -0,0 +1,48 @@
+/// @file gear_table.h
+/// @brief Precomputed gear-ratio table for variable-radius mandrels.
+///
+/// On a taper or dome the carriage travel per mandrel revolution that keeps
+/// the fibre angle constant scales with the local radius.  A GearTable holds
+/// the ratio (carriage microsteps per mandrel microstep) at GEAR_TABLE_SIZE
+/// uniformly spaced carriage positions across a layer's winding zone.  It is
+/// built from the SplineProfile once when the job loads, so the step path
+/// only does an index computation and a linear interpolation — no spline
+/// evaluation.  Without a mandrel profile every entry equals
+/// Layer::getStepRatio().
+
+#pragma once
+
+#include "layer.h"
+#include "spline_profile.h"
+
+/// Entries per table (GEAR_TABLE_SIZE − 1 intervals across the zone).
+constexpr int GEAR_TABLE_SIZE = 129;
+
+/// @class GearTable
+/// @brief Uniformly indexed ratio lookup for one layer.
+class GearTable {
+public:
+    /// Fill the table for @p layer.
+    /// @param mandrel  Mandrel surface; if not ready the layer diameter is used.
+    void build(const Layer& layer, const SplineProfile& mandrel,
+               float carriageStepsPerMM, float mandrelStepsPerRev);
+
+    /// Ratio at carriage position @p carriageStep, linearly interpolated
+    /// between entries and clamped to the winding zone.
+    float ratioAt(long carriageStep) const {
+        float pos = (carriageStep - startStep_) * invSpacing_;
+        if (pos <= 0.0f) return ratio_[0];
+        if (pos >= GEAR_TABLE_SIZE - 1) return ratio_[GEAR_TABLE_SIZE - 1];
+        int   i = static_cast<int>(pos);
+        float f = pos - i;
+        return ratio_[i] + f * (ratio_[i + 1] - ratio_[i]);
+    }
+
+    /// Table footprint (bytes).
+    static constexpr unsigned memoryBytes() { return sizeof(GearTable); }
+
+private:
+    float ratio_[GEAR_TABLE_SIZE] = {};
+    long  startStep_  = 0;       ///< Carriage step of entry 0.
+    float invSpacing_ = 0.0f;    ///< Entries per carriage step.
+};
@@ -0,0 +1,590 @@
+/// @file homing.h
+/// @brief Two-stage, non-blocking homing of an axis against its limit switch.
+///
+/// A fast seek with acceleration finds the switch; the axis brakes at the
+/// same rate, backs off past the point where the switch triggered by a
+/// clearance, and re-approaches at a low constant speed.  Only the slow
+/// approach defines home, so its repeatability is the switch's at creep
+/// speed while the seek can run as fast as the axis allows.  Every stage
+/// advances from update(), called once per loop(): nothing blocks, so other
+/// axes and the serial interface keep running while an axis homes.
+///
+/// The loop sees the switch late — debounce plus a loop pass — and the axis
+/// has moved on by then.  Home is therefore not where the loop notices the
+/// switch but the position the switch's edge interrupt latched
+/// (Inputs::edgePosition()); the steps run past it are kept.  Home does not
+/// shift with loop latency or approach speed, so the approach can run
+/// faster without losing repeatability.
+///
+/// Each homing records where the switch triggered in the previous home's
+/// frame — zero for a perfect switch and no lost steps.  The spread of
+/// that error over the homings since start-up is the measured home
+/// repeatability (HomingReport).  An error beyond HomingConfig::lossLimit
+/// is not the switch: the axis lost or gained steps since it was last
+/// homed, and the report flags it (HomingReport::lostSteps).
+///
+/// A homing can also measure the axis's backlash (measureBacklash()).  Once
+/// home is found the axis creeps off the switch until it opens and back on
+/// until it closes, BACKLASH_CALIBRATION_CYCLES times, compensation off.
+/// Between the latched close and open edges the motor turns through the
+/// drive's dead band before the load moves, plus the switch's differential,
+/// plus a step: each edge latches the step that crossed the switch point,
+/// so they are a step apart even without either.  The mean reading less
+/// that step and the configured differential is the backlash, and the
+/// stepper compensates it from then on (StepDirStepper::setBacklash()).
+/// The axis ends on the switch, engaged towards it, as after any homing.
+///
+/// An axis whose driver is on the UART (tmc2209.h) seeks, brakes and backs
+/// off at the coarser HomingConfig::seekShift resolution — fewer pulses for
+/// the same speed — and switches back to its own before the approach.  Each
+/// switch is made at rest and the axis waits until the driver has it.
+///
+/// HomingCoordinator homes several axes at once, each with its own state
+/// machine; an axis that could collide with another waits until that one
+/// is homed (HomingConfig::after), so homing takes about as long as the
+/// longest chain of dependent axes rather than the sum of all of them.
+
+#pragma once
+
+#include <Arduino.h>
+#include <stdint.h>
+
+#include "axis.h"
+#include "config.h"
+#include "inputs.h"
+#include "tmc2209.h"
+
+// ============================================================================
+//  Configuration and Report
+// ============================================================================
+
+/// @struct HomingConfig
+/// @brief Per-axis homing speeds and distances.
+struct HomingConfig {
+    float   fastSpeed;            ///< Seek speed (steps/s).
+    float   acceleration;         ///< Seek acceleration and braking (steps/s²).
+    float   slowSpeed;            ///< Approach speed (steps/s).
+    long    backoffSteps;         ///< Clearance past the seek's trigger point before the approach.
+    long    maxTravelSteps;       ///< Seek distance without a trigger after which homing fails.
+    int8_t  direction;            ///< Towards the switch: -1 or +1.
+    uint8_t after;                ///< Coordinator slots (bit per slot) homed before this axis starts.
+    float   takeUpSpeed;          ///< Backlash take-up speed (steps/s).
+    long    switchDifferential;   ///< Switch operate-to-release travel (steps; taken off a
+                                  ///< backlash reading).
+    uint8_t seekShift;            ///< Seek pulses are 2^seekShift steps, with the driver on the UART.
+    long    lossLimit;            ///< Home moved further than this since the last homing:
+                                  ///< steps were lost (steps).
+};
+
+/// Why a homing failed.
+enum class HomingFault : uint8_t {
+    NONE,
+    NO_SWITCH,      ///< The seek covered maxTravelSteps without a trigger.
+    SWITCH_STUCK,   ///< Still triggered after backing off (or creeping off it to measure backlash).
+    SWITCH_LOST,    ///< The approach passed the seek's trigger point without a trigger.
+};
+
+/// Stage of a homing.
+enum class HomingStage : uint8_t {
+    IDLE,
+    SEEK,       ///< Fast, accelerating towards the switch.
+    BRAKE,      ///< Decelerating past the trigger point.
+    BACK_OFF,   ///< Positioned move to the clearance point.
+    APPROACH,   ///< Creeping back onto the switch.
+    RELEASE,    ///< Backlash calibration: creeping off the switch…
+    RETURN,     ///< …and back onto it.
+    DONE,       ///< Homed: position 0 is the approach's trigger point.
+    FAILED,     ///< Stopped; see HomingReport::fault.
+};
+
+/// @struct HomingReport
+/// @brief Measurements of the last homing and the repeatability so far.
+struct HomingReport {
+    uint16_t    homings        = 0;     ///< Completed homings since start-up.
+    float       seconds        = 0.0f;  ///< Duration of the last homing.
+    long        seekHit        = 0;     ///< Seek trigger point (steps from home).
+    long        overtravel     = 0;     ///< Braking distance past it (steps).
+    long        homeError      = 0;     ///< Approach trigger point in the previous home's frame
+                                        ///< (steps; valid from the second homing on).
+    long        errorMin       = 0;     ///< Smallest / largest homeError so far.
+    long        errorMax       = 0;
+    long        backlash       = 0;     ///< Last measured backlash (steps).
+    long        backlashSpread = 0;     ///< Largest less smallest reading behind it (steps).
+    uint8_t     readings       = 0;     ///< Readings the last homing measured it from
+                                        ///< (0: it did not measure).
+    bool        lostSteps      = false; ///< The last homeError was beyond HomingConfig::lossLimit.
+    HomingFault fault          = HomingFault::NONE;
+
+    /// Spread of the home position over the homings since start-up (steps;
+    /// 0 before the second homing).
+    long repeatability() const { return errorMax - errorMin; }
+};
+
+// ============================================================================
+//  Homing Axis
+// ============================================================================
+
+/// @class Homing
+/// @brief Stepper-independent face of a homing axis, so axes with different
+///        stepper types share one HomingCoordinator.
+class Homing {
+public:
+    /// Begin homing (see HomingAxis::start()).
+    virtual void start() = 0;
+
+    /// Advance the homing (call every loop while busy()).
+    /// @param triggered  Switch state this loop.
+    /// @param edge       Axis position where the switch last changed state
+    ///                   (steps; Inputs::edgePosition()).
+    /// @return the stage after this update.
+    virtual HomingStage update(bool triggered, long edge) = 0;
+
+    /// Abandon a homing in progress; the axis stops at once.
+    virtual void abort() = 0;
+
+    HomingStage stage() const { return stage_; }
+    bool busy() const {
+        return stage_ != HomingStage::IDLE && stage_ != HomingStage::DONE &&
+               stage_ != HomingStage::FAILED;
+    }
+
+    /// @return true once the axis has been homed (position 0 is home).
+    bool referenced() const { return report_.homings > 0; }
+
+    /// Have the next homing measure the backlash over @p cycles reversals
+    /// at the switch and compensate it from then on (0: don't).
+    void measureBacklash(uint8_t cycles) { cycles_ = cycles; }
+
+    const HomingReport& report() const { return report_; }
+    const HomingConfig& config() const { return config_; }
+
+protected:
+    explicit Homing(const HomingConfig& config) : config_(config) {}
+    ~Homing() {}
+
+    const HomingConfig config_;
+    HomingReport       report_;
+    HomingStage        stage_ = HomingStage::IDLE;
+    uint8_t            cycles_ = 0;   ///< Backlash calibration cycles for the next homing.
+};
+
+/// @class HomingAxis
+/// @brief Homing state machine for one StepDirStepper axis with a ramp table.
+template <class Stepper>
+class HomingAxis : public Homing {
+public:
+    /// @param driver  The axis's driver, if it can be on the UART.
+    HomingAxis(Stepper& stepper, const HomingConfig& config, Tmc2209* driver = nullptr)
+        : Homing(config), stepper_(stepper), driver_(driver) {}
+
+    /// Begin homing from rest: sets the seek speed and acceleration
+    /// (restore the axis's own once homed).  A constant speed left set on
+    /// the stepper is dropped rather than ramped from.
+    void start() override {
+        stepper_.setSpeed(0.0f);
+        resolution(config_.seekShift);
+        stepper_.setMaxSpeed(config_.fastSpeed);
+        stepper_.setAcceleration(config_.acceleration);
+        stepper_.setTargetSpeed(config_.direction * config_.fastSpeed);
+        from_            = stepper_.currentPosition();
+        startUs_         = micros();
+        report_.fault    = HomingFault::NONE;
+        report_.readings = 0;
+        stage_           = HomingStage::SEEK;
+    }
+
+    HomingStage update(bool triggered, long edge) override {
+        const long pos = stepper_.currentPosition();
+        if (driver_ && !driver_->settled()) return stage_;   // Changing resolution.
+
+        switch (stage_) {
+        case HomingStage::SEEK:
+            if (triggered) {
+                // Already on the switch: nothing to brake.
+                if (pos == from_) {
+                    seekHit_ = pos;
+                    stepper_.setSpeed(0.0f);
+                } else {
+                    seekHit_ = edge;
+                    stepper_.stop();
+                }
+                stage_ = HomingStage::BRAKE;
+            } else if (labs(pos - from_) >= config_.maxTravelSteps) {
+                fail(HomingFault::NO_SWITCH);
+                break;
+            }
+            stepper_.run();
+            break;
+
+        case HomingStage::BRAKE:
+            if (!stepper_.run()) {
+                overtravel_ = labs(pos - seekHit_);
+                stepper_.moveTo(seekHit_ - config_.direction * config_.backoffSteps);
+                stage_ = HomingStage::BACK_OFF;
+            }
+            break;
+
+        case HomingStage::BACK_OFF:
+            if (!stepper_.run()) {
+                if (triggered) {
+                    fail(HomingFault::SWITCH_STUCK);
+                    break;
+                }
+                resolution(0);
+                stepper_.setSpeed(config_.direction * config_.slowSpeed);
+                from_  = pos;
+                stage_ = HomingStage::APPROACH;
+            }
+            break;
+
+        case HomingStage::APPROACH:
+            if (triggered) {
+                finish(pos, edge);
+            } else if (labs(pos - from_) > 2 * config_.backoffSteps) {
+                fail(HomingFault::SWITCH_LOST);
+            } else {
+                stepper_.runSpeed();
+            }
+            break;
+
+        case HomingStage::RELEASE:
+            if (!triggered) {
+                reading((edge - edge_) * -config_.direction, edge);
+                stepper_.setSpeed(config_.direction * config_.slowSpeed);
+                from_  = pos;
+                stage_ = HomingStage::RETURN;
+            } else if (labs(pos - from_) > config_.backoffSteps) {
+                fail(HomingFault::SWITCH_STUCK);
+            } else {
+                stepper_.runSpeed();
+            }
+            break;
+
+        case HomingStage::RETURN:
+            if (triggered) {
+                reading((edge_ - edge) * -config_.direction, edge);
+                if (--left_ > 0) {
+                    release(pos);
+                } else {
+                    measured();
+                }
+            } else if (labs(pos - from_) > config_.backoffSteps) {
+                fail(HomingFault::SWITCH_LOST);
+            } else {
+                stepper_.runSpeed();
+            }
+            break;
+
+        default:
+            break;
+        }
+        return stage_;
+    }
+
+    void abort() override {
+        if (!busy()) return;
+        stepper_.setSpeed(0.0f);
+        resolution(0);
+        restoreBacklash();
+        stage_ = HomingStage::IDLE;
+    }
+
+private:
+    // Pulses of 2^@p shift steps from now on, the driver and the stepper
+    // switched together (at rest).  The stepper goes first and the driver
+    // only follows if it took the change: one still stepping keeps its
+    // resolution, and so does the driver.  Without the driver on the UART
+    // the axis stays at its own resolution.
+    void resolution(uint8_t shift) {
+        if (!driver_ || !driver_->present()) return;
+        if (stepper_.setStepShift(shift)) driver_->setStepShift(shift);
+    }
+
+    // Home at the approach's trigger point @p hit; the axis stops @p pos,
+    // past it.
+    void finish(long pos, long hit) {
+        report_.lostSteps = referenced() && labs(hit) > config_.lossLimit;
+        if (referenced()) {
+            report_.homeError = hit;
+            if (report_.homings == 1 || hit < report_.errorMin) report_.errorMin = hit;
+            if (report_.homings == 1 || hit > report_.errorMax) report_.errorMax = hit;
+        }
+        report_.seekHit    = seekHit_ - hit;
+        report_.overtravel = overtravel_;
+        report_.seconds    = (micros() - startUs_) * 1e-6f;
+        report_.homings++;
+        stepper_.setCurrentPosition(pos - hit);
+        if (!cycles_) {
+            stage_ = HomingStage::DONE;
+            return;
+        }
+
+        // Measure the backlash, compensation off, from the trigger at 0.
+        previous_ = stepper_.backlash();
+        stepper_.setBacklash(0, config_.takeUpSpeed);
+        left_    = cycles_;
+        cycles_  = 0;
+        sum_     = 0;
+        edge_    = 0;
+        release(pos - hit);
+    }
+
+    // Creep off the switch from @p pos.
+    void release(long pos) {
+        stepper_.setSpeed(-config_.direction * config_.slowSpeed);
+        from_  = pos;
+        stage_ = HomingStage::RELEASE;
+    }
+
+    // A reversal's reading: @p travel steps from the last switch edge to
+    // this one, at @p edge.
+    void reading(long travel, long edge) {
+        edge_ = edge;
+        if (report_.readings == 0 || travel < min_) min_ = travel;
+        if (report_.readings == 0 || travel > max_) max_ = travel;
+        sum_ += travel;
+        report_.readings++;
+    }
+
+    // The readings' mean less the step between the edges and the switch
+    // differential is the backlash.
+    void measured() {
+        const long backlash = lroundf(static_cast<float>(sum_) / report_.readings) - 1 - config_.switchDifferential;
+        report_.backlash       = backlash > 0 ? backlash : 0;
+        report_.backlashSpread = max_ - min_;
+        report_.seconds        = (micros() - startUs_) * 1e-6f;
+        stepper_.setSpeed(0.0f);
+        stepper_.setBacklash(report_.backlash, config_.takeUpSpeed);
+        stage_ = HomingStage::DONE;
+    }
+
+    // A calibration cut short keeps the compensation it started with.
+    void restoreBacklash() {
+        if (stage_ == HomingStage::RELEASE || stage_ == HomingStage::RETURN) {
+            stepper_.setBacklash(previous_, config_.takeUpSpeed);
+        }
+    }
+
+    void fail(HomingFault fault) {
+        stepper_.setSpeed(0.0f);
+        resolution(0);
+        restoreBacklash();
+        report_.fault   = fault;
+        report_.seconds = (micros() - startUs_) * 1e-6f;
+        stage_          = HomingStage::FAILED;
+    }
+
+    Stepper&      stepper_;
+    Tmc2209*      driver_;
+    long          from_       = 0;   ///< Where the seek / approach started.
+    long          seekHit_    = 0;
+    long          overtravel_ = 0;
+    unsigned long startUs_    = 0;
+    long          edge_       = 0;   ///< Backlash calibration: the last switch edge…
+    long          sum_        = 0;   ///< …the readings' sum and extremes…
+    long          min_        = 0;
+    long          max_        = 0;
+    uint8_t       left_       = 0;   ///< …cycles still to go…
+    long          previous_   = 0;   ///< …and the compensation before it.
+};
+
+// ============================================================================
+//  Homing Coordinator
+// ============================================================================
+
+/// @class HomingCoordinator
+/// @brief Homes up to MAX_AXES axes concurrently, in dependency order.
+///
+/// Axes occupy slots in the order they are added.  start() starts every
+/// axis whose HomingConfig::after slots are all homed — none yet, so the
+/// independent ones — and update() starts each of the others in the loop
+/// after its last dependency homes.  An axis can only depend on slots
+/// added before it, which rules out cycles.  If one axis fails, the others
+/// stop and the whole homing fails.
+class HomingCoordinator {
+public:
+    static constexpr uint8_t MAX_AXES = 4;
+    static constexpr uint8_t NO_AXIS  = 0xFF;
+
+    /// Add @p axis, homing against the debounced switch @p limit (inputs.h).
+    /// @return false if the coordinator is full or the axis depends on a
+    ///         slot not added yet.
+    bool add(Homing& axis, Input limit) {
+        if (count_ == MAX_AXES || (axis.config().after >> count_) != 0) return false;
+        axes_[count_]   = &axis;
+        limits_[count_] = limit;
+        count_++;
+        return true;
+    }
+
+    /// Begin homing every axis.
+    void start() {
+        started_ = 0;
+        homed_   = 0;
+        failed_  = NO_AXIS;
+        startUs_ = micros();
+        busy_    = true;
+        startReady();
+    }
+
+    /// Advance every axis homing now and start those it unblocks (call
+    /// every loop while busy()).
+    /// @return busy().
+    bool update() {
+        if (!busy_) return false;
+
+        bool pending = false;
+        for (uint8_t i = 0; i < count_; i++) {
+            Homing& axis = *axes_[i];
+            if (!(started_ & (1u << i))) {
+                pending = true;
+                continue;
+            }
+            if (!axis.busy()) continue;
+
+            const HomingStage stage = axis.update(Inputs::active(limits_[i]),
+                                                  Inputs::edgePosition(limits_[i]));
+            if (stage == HomingStage::DONE) {
+                homed_ |= 1u << i;
+            } else if (stage == HomingStage::FAILED) {
+                failed_ = i;
+                abort();
+                return false;
+            } else {
+                pending = true;
+            }
+        }
+        if (pending) {
+            startReady();
+        } else {
+            seconds_ = (micros() - startUs_) * 1e-6f;
+            busy_    = false;
+        }
+        return busy_;
+    }
+
+    /// Stop every axis still homing.
+    void abort() {
+        for (uint8_t i = 0; i < count_; i++) axes_[i]->abort();
+        seconds_ = (micros() - startUs_) * 1e-6f;
+        busy_    = false;
+    }
+
+    bool busy() const { return busy_; }
+
+    /// @return true if the last homing stopped on a failed axis.
+    bool failed() const { return failed_ != NO_AXIS; }
+
+    /// Slot of the axis that failed, or NO_AXIS.
+    uint8_t failedAxis() const { return failed_; }
+
+    /// Duration of the last homing, start to finish (seconds).
+    float seconds() const { return seconds_; }
+
+    /// The last homing's axes one after another: the sum of their times
+    /// (seconds).
+    float sequentialSeconds() const {
+        float sum = 0.0f;
+        for (uint8_t i = 0; i < count_; i++) {
+            if (started_ & (1u << i)) sum += axes_[i]->report().seconds;
+        }
+        return sum;
+    }
+
+    uint8_t       axes() const           { return count_; }
+    const Homing& axis(uint8_t i) const  { return *axes_[i]; }
+
+private:
+    // Start the axes not started yet whose dependencies have all homed.
+    void startReady() {
+        for (uint8_t i = 0; i < count_; i++) {
+            if ((started_ & (1u << i)) || (axes_[i]->config().after & ~homed_)) continue;
+            axes_[i]->start();
+            started_ |= 1u << i;
+        }
+    }
+
+    Homing*       axes_[MAX_AXES] = {};
+    Input         limits_[MAX_AXES] = {};
+    uint8_t       count_    = 0;
+    uint8_t       started_  = 0;          ///< Bit per slot.
+    uint8_t       homed_    = 0;          ///< Bit per slot.
+    uint8_t       failed_   = NO_AXIS;
+    bool          busy_     = false;
+    unsigned long startUs_  = 0;
+    float         seconds_  = 0.0f;
+};
+
+// ============================================================================
+//  Machine Axes
+// ============================================================================
+
+/// Axes the winder homes, in coordinator slot order — the bits of the
+/// *_HOMES_AFTER masks in config.h.
+enum class HomeAxis : uint8_t { CARRIAGE, TOOLARM, TOOLHEAD };
+constexpr uint8_t HOMED_AXES = 3;
+
+constexpr HomingConfig CARRIAGE_HOMING = {
+    CARRIAGE_HOMING_FAST_SPEED,
+    CARRIAGE_HOMING_ACCEL,
+    CARRIAGE_HOMING_SLOW_SPEED,
+    static_cast<long>(CarriageAxis::toSteps(CARRIAGE_HOMING_BACKOFF_MM)),
+    static_cast<long>(CarriageAxis::toSteps(CARRIAGE_TRAVEL_MM)),
+    -1,   // The limit switch is at the home end.
+    CARRIAGE_HOMES_AFTER,
+    CARRIAGE_TAKE_UP_SPEED,
+    static_cast<long>(CarriageAxis::toSteps(CARRIAGE_SWITCH_DIFFERENTIAL_MM) + 0.5f),
+    tmcStepShift(CARRIAGE_MOTOR_PARAMS.microsteps, CARRIAGE_HOMING_SEEK_MICROSTEPS),
+    static_cast<long>(CarriageAxis::toSteps(CARRIAGE_HOME_TOLERANCE_MM) + 0.5f),
+};
+
+constexpr HomingConfig TOOLARM_HOMING = {
+    TOOLARM_HOMING_FAST_SPEED,
+    TOOLARM_HOMING_ACCEL,
+    TOOLARM_HOMING_SLOW_SPEED,
+    static_cast<long>(ToolarmAxis::toSteps(TOOLARM_HOMING_BACKOFF_MM)),
+    static_cast<long>(ToolarmAxis::toSteps(TOOLARM_TRAVEL_MM)),
+    -1,   // Homes retracted.
+    TOOLARM_HOMES_AFTER,
+    TOOLARM_TAKE_UP_SPEED,
+    static_cast<long>(ToolarmAxis::toSteps(TOOLARM_SWITCH_DIFFERENTIAL_MM) + 0.5f),
+    tmcStepShift(TOOLARM_MOTOR_PARAMS.microsteps, TOOLARM_HOMING_SEEK_MICROSTEPS),
+    static_cast<long>(ToolarmAxis::toSteps(TOOLARM_HOME_TOLERANCE_MM) + 0.5f),
+};
+
+constexpr HomingConfig TOOLHEAD_HOMING = {
+    TOOLHEAD_HOMING_FAST_SPEED,
+    TOOLHEAD_HOMING_ACCEL,
+    TOOLHEAD_HOMING_SLOW_SPEED,
+    static_cast<long>(ToolheadAxis::toSteps(TOOLHEAD_HOMING_BACKOFF_DEG)),
+    static_cast<long>(ToolheadAxis::toSteps(TOOLHEAD_TRAVEL_DEG)),
+    -1,
+    TOOLHEAD_HOMES_AFTER,
+    TOOLHEAD_TAKE_UP_SPEED,
+    static_cast<long>(ToolheadAxis::toSteps(TOOLHEAD_SWITCH_DIFFERENTIAL_DEG) + 0.5f),
+    tmcStepShift(TOOLHEAD_MOTOR_PARAMS.microsteps, TOOLHEAD_HOMING_SEEK_MICROSTEPS),
+    static_cast<long>(ToolheadAxis::toSteps(TOOLHEAD_HOME_TOLERANCE_DEG) + 0.5f),
+};
+
+// The seeks run on the axes' ramp tables.
+static_assert(stepRampLevels(CARRIAGE_HOMING_FAST_SPEED, CARRIAGE_HOMING_ACCEL) <= CARRIAGE_RAMP_STEPS,
+              "CARRIAGE_RAMP_STEPS too small for the carriage homing speed and acceleration");
+static_assert(stepRampLevels(TOOLARM_HOMING_FAST_SPEED, TOOLARM_HOMING_ACCEL) <= TOOLARM_RAMP_STEPS,
+              "TOOLARM_RAMP_STEPS too small for the toolarm homing speed and acceleration");
+static_assert(stepRampLevels(TOOLHEAD_HOMING_FAST_SPEED, TOOLHEAD_HOMING_ACCEL) <= TOOLHEAD_RAMP_STEPS,
+              "TOOLHEAD_RAMP_STEPS too small for the toolhead homing speed and acceleration");
+
+// A seek resolution the axis can step at: the axis's own or coarser.
+static_assert(AxisCheck::isDriverMicrostep(CARRIAGE_HOMING_SEEK_MICROSTEPS) &&
+              AxisCheck::isDriverMicrostep(TOOLARM_HOMING_SEEK_MICROSTEPS) &&
+              AxisCheck::isDriverMicrostep(TOOLHEAD_HOMING_SEEK_MICROSTEPS) &&
+              CARRIAGE_HOMING_SEEK_MICROSTEPS <= CARRIAGE_MOTOR_PARAMS.microsteps &&
+              TOOLARM_HOMING_SEEK_MICROSTEPS <= TOOLARM_MOTOR_PARAMS.microsteps &&
+              TOOLHEAD_HOMING_SEEK_MICROSTEPS <= TOOLHEAD_MOTOR_PARAMS.microsteps,
+              "a *_HOMING_SEEK_MICROSTEPS is not a driver resolution at or below the axis's");
+
+// An axis can only wait for axes homed before it in HomeAxis order.
+static_assert((CARRIAGE_HOMES_AFTER >> static_cast<uint8_t>(HomeAxis::CARRIAGE)) == 0 &&
+              (TOOLARM_HOMES_AFTER >> static_cast<uint8_t>(HomeAxis::TOOLARM)) == 0 &&
+              (TOOLHEAD_HOMES_AFTER >> static_cast<uint8_t>(HomeAxis::TOOLHEAD)) == 0,
+              "a *_HOMES_AFTER mask names an axis that homes later in HomeAxis order");
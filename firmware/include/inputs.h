@@ -0,0 +1,99 @@
+/// @file inputs.h
+/// @brief Interrupt-driven, debounced limit-switch and E-stop inputs.
+///
+/// Every input has a GPIO interrupt on both edges.  The first edge opens a
+/// debounce window and stamps its time; further edges inside the window
+/// are ignored.  A hardware timer ticking every INPUT_SCAN_US closes the
+/// window INPUT_DEBOUNCE_US after the first edge and samples the line: if
+/// it settled at the other level the input changes state and an event is
+/// latched with the first edge's timestamp.  A glitch shorter than the
+/// window produces nothing; contact bounce shorter than it produces exactly
+/// one event.  The loop never reads GPIO: active() is one atomic load.
+///
+/// An input can have a position source (setPositionSource()): the edge
+/// interrupt samples it at the first edge, so a limit switch reports the
+/// axis position where it actually switched (edgePosition()), whatever the
+/// debounce and loop latency.  Homing sets zero from it.
+///
+/// Stop-latency bounds, independent of the loop period:
+///
+///   - E-stop: the edge interrupt itself runs the stop action (the drivers
+///     are disabled) the moment the line reads active — interrupt latency,
+///     a few µs.  The debounced event follows as for the other inputs.
+///   - Limit switches: the state changes at most INPUT_DEBOUNCE_US +
+///     INPUT_SCAN_US after the first edge when the contact settles within
+///     the window; motion acts on it in the next loop pass.
+///
+/// On the host the Arduino stand-in delivers the interrupts and timer ticks
+/// from virtual time (tools/host), so the simulator exercises this path.
+
+#pragma once
+
+#include <stdint.h>
+
+// ============================================================================
+//  Inputs and Events
+// ============================================================================
+
+/// The debounced inputs.  The limit switches come first, in HomeAxis order.
+enum class Input : uint8_t {
+    CARRIAGE_LIMIT,
+    TOOLARM_LIMIT,
+    TOOLHEAD_LIMIT,
+    E_STOP,
+};
+constexpr uint8_t INPUT_COUNT = 4;
+
+/// @struct InputEvent
+/// @brief A debounced change of one input.
+struct InputEvent {
+    Input    input;
+    bool     active;     ///< New state: switch closed / E-stop pressed.
+    uint32_t edgeUs;     ///< micros() of the first edge of the change.
+    uint32_t latchUs;    ///< micros() when the debounce confirmed it.
+    long     position;   ///< Position source at the first edge (0 without one).
+};
+
+/// Latched events held until poll() takes them (a power of two).
+constexpr uint8_t INPUT_EVENT_CAPACITY = 16;
+
+/// @namespace Inputs
+/// @brief Input subsystem: interrupts, debounce timer and latched events.
+namespace Inputs {
+
+    /// Configure the pins, read the initial states, attach the interrupts
+    /// and start the debounce timer.  Clears pending events; the E-stop
+    /// latch is set — and its action run — if it is pressed already.  Set
+    /// the action first.  Safe to call again.
+    void init();
+
+    /// Debounced state of @p input (true = switch closed / E-stop pressed).
+    bool active(Input input);
+
+    /// Sample @p position (an ISR-safe read of an axis position, steps) at
+    /// the first edge of every change of @p input; nullptr stops sampling.
+    void setPositionSource(Input input, long (*position)());
+
+    /// Position source at the first edge of the change behind the current
+    /// state of @p input — at init() if it has not changed since (0 without
+    /// a source).
+    long edgePosition(Input input);
+
+    /// Take the oldest latched event.
+    /// @return false if there is none.
+    bool poll(InputEvent& event);
+
+    /// Events lost because poll() fell INPUT_EVENT_CAPACITY behind.
+    uint32_t overflows();
+
+    /// Action the E-stop edge interrupt runs (keep it short and ISR-safe).
+    void setEStopAction(void (*action)());
+
+    /// @return true from the first E-stop edge until clearEStop().
+    bool eStopLatched();
+
+    /// Clear the E-stop latch.
+    /// @return false (latch kept) while the E-stop is still pressed.
+    bool clearEStop();
+
+}  // namespace Inputs
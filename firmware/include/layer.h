@@ -4,13 +4,20 @@
 /// A Layer represents one set of helical passes at a given fibre angle across
 /// a defined length of the mandrel.  It computes the electronic-gearing ratio,
 /// pass count, and per-pass target positions used by the winding state machine.
+///
+/// By default the passes are laid band by band: every turn-around adds one
+/// stepover of rotation.  A winding pattern (see pattern.h) replaces that with
+/// a skip sequence over the layer's circuits and its own turn-around rotation.
 
 #pragma once
 
 #include <Arduino.h>
 
-/// Maximum number of layers in a single wind profile.
-constexpr int MAX_LAYERS = 10;
+/// Maximum number of layers in a single wind profile.  Each layer is a
+/// Layer in every WindProfile and a LayerEstimate in its JobEstimate, and
+/// Winding keeps 1 + JOB_QUEUE_SIZE of both, so every layer allowed costs
+/// about 230 bytes of RAM (Winding::memoryBytes()).
+constexpr int MAX_LAYERS = 40;
 
 /// @class Layer
 /// @brief Describes one winding layer's geometry and tracks pass progress.
@@ -49,9 +56,23 @@ public:
     void setAngle(float v)    { angle_    = v; recalcPasses(); }
     void setOffset(float v)   { offset_   = v; }
     void setStepover(float v) { stepover_ = v; recalcPasses(); }
-    void setDwell(float v)    { dwell_    = v; }
+    void setDwell(float v)    { dwell_    = v; clearPattern(); }
     void setDiameter(float v) { diameter_ = v; recalcPasses(); }
 
+    // ── Winding pattern ──────────────────────────────────────────────────────
+
+    /// Lay the circuits (forward + return pass pairs) in skip order: circuit
+    /// c starts on slot (c · skip) mod circuits, and every turn-around rotates
+    /// the mandrel by @p turnaroundDeg instead of dwell + stepover.
+    void setPattern(int circuits, int skip, float turnaroundDeg);
+
+    /// Revert to band-by-band sequencing.
+    void clearPattern() { patternCircuits_ = 0; patternSkip_ = 0; turnaroundDeg_ = 0.0f; }
+
+    bool hasPattern()         const { return patternCircuits_ > 0; }
+    int  getPatternCircuits() const { return patternCircuits_; }
+    int  getPatternSkip()     const { return patternSkip_; }
+
     // ── Winding calculations ─────────────────────────────────────────────────
 
     /// Compute the electronic-gearing ratio (carriage microsteps per mandrel
@@ -64,6 +85,10 @@ public:
     /// width around the circumference.
     float getStepoverDegrees() const;
 
+    /// Planned mandrel rotation (degrees) at each turn-around: the pattern's,
+    /// or dwell + stepover when passes are laid band by band.
+    float getTurnaroundDegrees() const;
+
     /// Carriage target position for the current pass direction (mm from home).
     float getTargetEndpoint() const;
 
@@ -88,6 +113,10 @@ private:
     float dwell_    = 0.0f;
     float diameter_ = 0.0f;
 
+    int   patternCircuits_ = 0;      ///< Circuits in the pattern (0 = band by band).
+    int   patternSkip_     = 0;      ///< Slots advanced per circuit.
+    float turnaroundDeg_   = 0.0f;   ///< Pattern turn-around rotation (degrees).
+
     // ── Runtime state ────────────────────────────────────────────────────────
 
     int  totalPasses_     = 0;
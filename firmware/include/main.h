@@ -5,6 +5,14 @@
 
 #include <Arduino.h>
 #include "config.h"
+#include "axis.h"
 #include "motor_control.h"
 #include "layer.h"
 #include "winding.h"
+#include "trace.h"
+#include "estimate.h"
+#include "memstat.h"
+#include "gear_table.h"
+#include "toolarm_plan.h"
+#include "planner.h"
+#include "stall_monitor.h"
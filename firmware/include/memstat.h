@@ -0,0 +1,113 @@
+/// @file memstat.h
+/// @brief Heap and stack high-water-mark instrumentation.
+///
+/// MemStat::sample() reads free heap, the largest free block (fragmentation)
+/// and the stack high-water mark of every registered task, and folds the
+/// reading into two sets of low-water marks: one for the current job (opened
+/// by MemStat::beginJob() when a job is loaded) and one per WindingState.
+/// Sampling walks the heap, so loop() only samples at a fixed interval while
+/// nothing moves (IDLE, PAUSED, COMPLETE), plus once at every state change
+/// to close the window of the state just left; setState() only tags which
+/// state the next samples belong to.
+///
+/// On the ESP32 the figures come from heap_caps / FreeRTOS.  On the host the
+/// heap figures come from the allocation tracker in tools/host (exact peak
+/// between samples) and stack figures are not available.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "winding.h"
+
+class Print;
+
+/// Maximum number of tasks whose stacks are watched.
+constexpr uint8_t MEMSTAT_MAX_TASKS = 6;
+
+/// Interval between samples taken from loop() while no axis moves (ms).
+constexpr unsigned long MEMSTAT_SAMPLE_INTERVAL_MS = 100;
+
+/// Heap a job may use on top of what was in use when it was loaded (bytes).
+/// MemStat::report() flags jobs over budget; tools/mem_budget fails on them.
+constexpr uint32_t MEMSTAT_JOB_HEAP_BUDGET = 8192;
+
+/// Number of WindingState values.
+constexpr uint8_t MEMSTAT_STATE_COUNT = static_cast<uint8_t>(WindingState::COMPLETE) + 1;
+
+// ============================================================================
+//  Readings
+// ============================================================================
+
+/// @struct MemorySnapshot
+/// @brief One reading of the heap and the calling task's stack.
+struct MemorySnapshot {
+    uint32_t heapFree      = 0;   ///< Free 8-bit capable heap (bytes).
+    uint32_t heapMinFree   = 0;   ///< Lowest free heap since boot (bytes).
+    uint32_t largestBlock  = 0;   ///< Largest allocatable block (bytes).
+    uint8_t  fragmentation = 0;   ///< 100 − largestBlock / heapFree, in percent.
+    uint32_t stackFree     = 0;   ///< Calling task's stack high-water mark (bytes, 0 = unknown).
+};
+
+/// @struct MemoryPeak
+/// @brief Worst readings over a window (job or state).
+struct MemoryPeak {
+    uint32_t samples          = 0;            ///< Samples folded in (0 = no data).
+    uint32_t minHeapFree      = UINT32_MAX;   ///< Lowest free heap seen (bytes).
+    uint32_t minLargestBlock  = UINT32_MAX;   ///< Smallest largest-free-block seen (bytes).
+    uint8_t  maxFragmentation = 0;            ///< Highest fragmentation seen (%).
+    uint32_t minStackFree     = UINT32_MAX;   ///< Lowest stack high-water mark of any task (bytes).
+};
+
+// ============================================================================
+//  Instrumentation API
+// ============================================================================
+
+/// @namespace MemStat
+/// @brief Memory usage reporting.
+namespace MemStat {
+
+    /// Register the calling task (the Arduino loop task) and the idle tasks.
+    /// Call once from setup().
+    void init();
+
+    /// Watch another task's stack (e.g. a worker task created later).
+    /// @param handle FreeRTOS TaskHandle_t of the task.
+    /// @return false if MEMSTAT_MAX_TASKS tasks are already registered.
+    bool registerTask(void* handle, const char* name);
+
+    /// Take a reading and fold it into the job and current-state peaks.
+    MemorySnapshot sample();
+
+    /// Take a sample if the state changed since the last one, or if
+    /// MEMSTAT_SAMPLE_INTERVAL_MS has passed outside ZEROING, WINDING and
+    /// DWELLING (call every loop()).
+    void poll();
+
+    /// Start a new job window: record the heap in use at load and reset the
+    /// job and per-state peaks.
+    void beginJob();
+
+    /// Tag following samples with the winding state (cheap; no sampling).
+    void setState(WindingState state);
+
+    /// Free heap when the current job was loaded (bytes).
+    uint32_t jobBaseline();
+
+    /// Peak heap used by the current job on top of its baseline (bytes).
+    uint32_t jobPeakUsed();
+
+    /// Worst readings since beginJob().
+    const MemoryPeak& jobPeak();
+
+    /// Worst readings while in @p state since beginJob().
+    const MemoryPeak& statePeak(WindingState state);
+
+    /// Print a one-line heap / stack summary (for "status").
+    void printSummary(Print& out);
+
+    /// Print the full report: per-task stacks, job peak, per-state peaks.
+    void report(Print& out);
+
+}  // namespace MemStat
@@ -2,7 +2,8 @@
 #pragma once
 
 #include <stdint.h>
-#include <AccelStepper.h>
+#include "step_dir_stepper.h"
+#include "tmc2209.h"
 
 struct StepperMotorParams {
 	uint8_t step_pin;           // step signal pin
@@ -12,14 +13,10 @@ struct StepperMotorParams {
 	uint16_t microsteps;        // microsteps configured per full step
 	uint16_t microStepsPerRev;  // derived: total microsteps per revolution
 
-	StepperMotorParams(uint8_t step, uint8_t dir, uint8_t enable = 1, uint16_t steps = 200, uint16_t micro = 8) {
-		step_pin = step;
-		dir_pin = dir;
-		enable_pin = enable;
-		stepsPerRev = steps;
-		microsteps = micro;
-		microStepsPerRev = stepsPerRev * microsteps;
-	}
+	// constexpr so the axis constants in axis.h can be derived at compile time
+	constexpr StepperMotorParams(uint8_t step, uint8_t dir, uint8_t enable = 1, uint16_t steps = 200, uint16_t micro = 8)
+		: step_pin(step), dir_pin(dir), enable_pin(enable), stepsPerRev(steps), microsteps(micro),
+		  microStepsPerRev(static_cast<uint16_t>(steps * micro)) {}
 };
 
 // step dir enable
@@ -42,15 +39,68 @@ struct StepperMotorParams {
 
 // Default parameters per motor
 // step, dir, enable
-const StepperMotorParams MANDREL_MOTOR_PARAMS(14, 17, 13, 200, 8); // TMCS2209 (8 microsteps default)
-const StepperMotorParams CARRIAGE_MOTOR_PARAMS(25, 26, 27, 200, 8); // TMC2225 (4 microsteps default)
+constexpr StepperMotorParams MANDREL_MOTOR_PARAMS(14, 17, 13, 200, 8); // TMC2209 (8 microsteps strapped)
+constexpr StepperMotorParams CARRIAGE_MOTOR_PARAMS(25, 26, 27, 200, 8); // TMC2225 (strapped; no UART address)
+constexpr StepperMotorParams TOOLARM_MOTOR_PARAMS(18, 19, 21, 200, 8);  // Driver slot 2 (follows the mandrel surface)
+constexpr StepperMotorParams TOOLHEAD_MOTOR_PARAMS(32, 33, 23, 200, 8); // Flips to the fibre angle every pass
+
+// Acceleration ramp tables (levels); the mandrel only runs at constant speed
+constexpr uint16_t CARRIAGE_RAMP_STEPS = 1024;
+constexpr uint16_t TOOLARM_RAMP_STEPS  = 256;
+constexpr uint16_t TOOLHEAD_RAMP_STEPS = 256;
+
+// Driven axes: pins and enable polarity (active low) fixed at compile time
+using MandrelStepper  = StepDirStepper<MANDREL_MOTOR_PARAMS.step_pin, MANDREL_MOTOR_PARAMS.dir_pin,
+                                       MANDREL_MOTOR_PARAMS.enable_pin>;
+using CarriageStepper = StepDirStepper<CARRIAGE_MOTOR_PARAMS.step_pin, CARRIAGE_MOTOR_PARAMS.dir_pin,
+                                       CARRIAGE_MOTOR_PARAMS.enable_pin, CARRIAGE_RAMP_STEPS>;
+using ToolarmStepper  = StepDirStepper<TOOLARM_MOTOR_PARAMS.step_pin, TOOLARM_MOTOR_PARAMS.dir_pin,
+                                       TOOLARM_MOTOR_PARAMS.enable_pin, TOOLARM_RAMP_STEPS>;
+using ToolheadStepper = StepDirStepper<TOOLHEAD_MOTOR_PARAMS.step_pin, TOOLHEAD_MOTOR_PARAMS.dir_pin,
+                                       TOOLHEAD_MOTOR_PARAMS.enable_pin, TOOLHEAD_RAMP_STEPS>;
+
+// Drivers on the UART (tmc2209.h): address (MS1/MS2), RMS run current (mA),
+// hold current (% of run), StealthChop, StallGuard threshold (SGTHRS; 0:
+// not watched) and the speed it is trusted from (steps/s).  The microstep
+// resolution is the axis's, above.  The carriage's TMC2225 has no address
+// straps and cannot share the bus; a TMC2209 in its slot would take
+// address 3.  StallGuard needs StealthChop, so the toolarm is not watched.
+// The thresholds stall well below the SG_RESULT of the running load; the
+// "stalls" command shows the lowest readings of a job to tune them by.
+constexpr TmcConfig MANDREL_DRIVER_CONFIG  = { 0, 1200, 70, true, 40, 150.0f };   // Holds the wet mandrel's phase
+constexpr TmcConfig CARRIAGE_DRIVER_CONFIG = { TMC_NO_ADDRESS, 1000, 50, false, 0, 0.0f };
+constexpr TmcConfig TOOLARM_DRIVER_CONFIG  = { 1, 800, 50, false, 0, 0.0f };      // SpreadCycle: stiff on the surface
+constexpr TmcConfig TOOLHEAD_DRIVER_CONFIG = { 2, 600, 50, true, 30, 400.0f };
 
 // Global stepper objects (defined in motor_control.cpp)
-extern AccelStepper mandrelStepper;
-extern AccelStepper carriageStepper;
+extern MandrelStepper  mandrelStepper;
+extern CarriageStepper carriageStepper;
+extern ToolarmStepper  toolarmStepper;
+extern ToolheadStepper toolheadStepper;
+
+// The drivers' UART and one driver per axis (defined in motor_control.cpp)
+extern TmcBus  tmcBus;
+extern Tmc2209 mandrelDriver;
+extern Tmc2209 carriageDriver;
+extern Tmc2209 toolarmDriver;
+extern Tmc2209 toolheadDriver;
 
 // Initialize stepper instances with the configured pins/params
 void initSteppers();
 
+// Probe and configure every driver on the UART (blocks a few ms per
+// address); returns how many answered
+uint8_t initDrivers();
+
+// One line per axis: resolution, currents and chopper read back from the
+// driver, or that it is strapped
+void printDrivers(Print& out);
+
+// Enable every driver
+void enableSteppers();
+
+// Release every driver at once; ISR-safe (the E-stop interrupt runs it)
+void disableSteppers();
+
 // Run both motors at max speed (call every loop iteration while active)
 void runMotorsMaxSpeed();
\ No newline at end of file
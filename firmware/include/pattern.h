@@ -0,0 +1,69 @@
+/// @file pattern.h
+/// @brief Winding-pattern planner — skip index and turn-around rotation per layer.
+///
+/// A layer's passes pair up into circuits (forward + return).  Its pass count
+/// fixes the number of circuits S and so S evenly spaced start slots,
+/// Δ = 360° / S apart, that together give the requested coverage.  Laid band
+/// by band, every turn-around adds one stepover of rotation regardless of
+/// where the traverse itself left the mandrel.
+///
+/// A pattern instead advances each circuit by k slots (the skip index; any k
+/// with gcd(k, S) = 1 visits every slot exactly once before closing).  A
+/// circuit turns the mandrel 2 · (pass rotation + dwell) on its own, so the
+/// extra rotation it needs to land on its next slot is
+///
+///     e(k) = (k · Δ − 2 · (pass + dwell)) mod 360°
+///
+/// The planner picks the k with the smallest e — the least dwell rotation and
+/// so the fewest mandrel revolutions for the layer — and splits e over the
+/// circuit's two turn-arounds.  The winding state machine snaps the closing
+/// turn-around of each circuit onto its slot, so errors in the predicted pass
+/// rotation do not accumulate.
+
+#pragma once
+
+#include "layer.h"
+#include "estimate.h"
+
+/// @struct WindPattern
+/// @brief Planned pattern for one layer, with the band-by-band figures it replaces.
+struct WindPattern {
+    bool  valid          = false;
+    int   circuits       = 0;      ///< S — forward + return pass pairs.
+    int   skip           = 0;      ///< k — slots advanced per circuit.
+    float slotDeg        = 0.0f;   ///< Δ — rotation between neighbouring slots.
+    float passDeg        = 0.0f;   ///< Mandrel rotation over one traverse.
+    float extraDeg       = 0.0f;   ///< e — extra rotation per circuit to reach the next slot.
+    float turnaroundDeg  = 0.0f;   ///< dwell + e / 2 at each turn-around.
+    float dwellRevs      = 0.0f;   ///< Turn-around rotation over the whole layer (revs).
+    float mandrelRevs    = 0.0f;   ///< Mandrel rotation over the whole layer (revs).
+    float bandDwellRevs  = 0.0f;   ///< dwellRevs when laid band by band.
+    float bandMandrelRevs = 0.0f;  ///< mandrelRevs when laid band by band.
+};
+
+/// @namespace Pattern
+/// @brief Pattern selection and slot arithmetic.
+namespace Pattern {
+
+    /// Choose the pattern for @p layer (invalid if it has no passes).
+    WindPattern plan(const Layer& layer, const EstimateParams& params);
+
+    /// Plan @p layer and store the result in it.
+    /// @return the plan (also when invalid, leaving the layer band by band).
+    WindPattern apply(Layer& layer, const EstimateParams& params);
+
+    /// Slot that circuit @p circuit of a patterned layer starts on.
+    int slot(const Layer& layer, int circuit);
+
+    /// Mandrel phase (steps past the layer start, 0 … stepsPerRev − 1) at
+    /// which circuit @p circuit starts.
+    long slotPhaseSteps(const Layer& layer, int circuit, long stepsPerRev);
+
+    /// Turn-around rotation (mandrel steps) at the end of @p layer's current
+    /// pass, reached at @p mandrelStep: the planned rotation, and at the end
+    /// of a return pass corrected so the next circuit starts on its slot,
+    /// @p layerStartStep being the layer's phase reference.
+    long turnaroundSteps(const Layer& layer, long mandrelStep, long layerStartStep,
+                         float stepsPerRev);
+
+}  // namespace Pattern
@@ -0,0 +1,112 @@
+/// @file planner.h
+/// @brief Background preparation of the next layer's execution plan.
+///
+/// Everything the state machine needs to run a layer that is not progress —
+/// its gear-ratio table, the toolarm plan, the carriage steps it ends on,
+/// the hand-over dwell, the pattern phase reference and the toolhead flip
+/// timing — is collected in a LayerPlan.  Two plans are kept: the one the
+/// active layer runs from and the one being prepared for the layer (or
+/// queued job) that follows.  The winding state machine requests the next
+/// plan as soon as a layer begins; a worker builds it while the layer winds,
+/// and at the boundary acquire() swaps the two buffers, so the motion path
+/// only flips an index.
+///
+/// Each buffer carries an atomic state (FREE → REQUESTED → BUILDING → READY).
+/// The worker claims a request with a compare-and-swap before building, so a
+/// boundary that arrives first can take the request back and build it in
+/// line.  Such a boundary counts as a miss — the plan was not ready in time —
+/// and is traced as TraceEvent::PLAN_MISS.
+///
+/// On the ESP32 the worker is a FreeRTOS task pinned to core 0 (the loop task
+/// runs on core 1).  On the host there is no task: the simulator calls
+/// service() to stand in for it, after a configurable delay.
+
+#pragma once
+
+#include <stdint.h>
+
+#include "gear_table.h"
+#include "toolarm_plan.h"
+
+struct WindProfile;
+struct JobEstimate;
+
+/// Plan buffers: the active layer's and the next one's.
+constexpr int PLANNER_SLOTS = 2;
+
+/// Worker task stack (bytes) and priority.  Building a plan, with the job
+/// preparation the first request carries, goes 3.5 KB deep on the host
+/// (tools/mem_budget measures it per profile); the task gets at least
+/// PLANNER_STACK_MARGIN times that, for the Xtensa register-window frames
+/// and the context the task switch saves on its stack.  On the machine
+/// "mem" reports the planner task's stack high-water mark.
+constexpr uint32_t PLANNER_TASK_STACK    = 8192;
+constexpr uint32_t PLANNER_STACK_MARGIN  = 2;
+constexpr uint8_t  PLANNER_TASK_PRIORITY = 1;
+
+/// @struct LayerPlan
+/// @brief Precomputed execution data for one layer.
+struct LayerPlan {
+    const WindProfile* profile = nullptr;   ///< Job the plan belongs to.
+    int       layer          = -1;          ///< Layer index in that job.
+    GearTable gear;                         ///< Ratio vs. carriage position.
+    ToolarmPlan toolarm;                    ///< Toolarm targets and mandrel speed limits.
+    long      forwardEndStep = 0;           ///< Carriage step a forward pass ends on.
+    long      returnEndStep  = 0;           ///< Carriage step a return pass ends on.
+    long      handOverStep   = 0;           ///< Carriage step the last pass comes to rest on
+                                            ///< when it hands over (Estimate::handOverEndMM()).
+    long      dwellSteps     = 0;           ///< Fibre-placement dwell (hand-over rotation).
+    long      phaseSteps     = 0;           ///< Mandrel steps of one steady pass (pattern
+                                            ///< phase reference after the first pass).
+    long      flipLeadSteps  = 0;           ///< Carriage steps before a turn-around at which
+                                            ///< the toolhead flip starts (FlipTiming).
+    long      flipHoldSteps  = 0;           ///< Toolhead steps the flip may have left when
+                                            ///< the next pass starts.
+    long      handLeadSteps  = 0;           ///< The same for the hand-over to the next layer.
+    long      handHoldSteps  = 0;
+};
+
+/// @namespace Planner
+/// @brief Double-buffered layer plans and their background worker.
+namespace Planner {
+
+    /// Start the worker (once) and drop all plans.
+    void init();
+
+    /// Drop all plans and clear the counters; a build in progress is waited out.
+    void reset();
+
+    /// Build the plan for @p layer of @p profile synchronously into the
+    /// active buffer — job start, where nothing can be prepared ahead.
+    const LayerPlan& prime(const WindProfile& profile, int layer);
+
+    /// Ask the worker to prepare @p layer of @p profile.  With @p prepare
+    /// set the job itself is prepared first (Winding::prepareJob()) and its
+    /// estimate written there — used for the first layer of a queued job.
+    /// Repeating a pending request is a no-op.
+    void request(WindProfile& profile, int layer, JobEstimate* prepare = nullptr);
+
+    /// Hand over to the plan for @p layer of @p profile at a layer boundary.
+    /// If the worker has not finished it the plan is built in line and the
+    /// boundary counted as a miss.
+    const LayerPlan& acquire(WindProfile& profile, int layer, JobEstimate* prepare = nullptr);
+
+    /// Plan of the layer being wound.
+    const LayerPlan& current();
+
+    /// @return true if a request is waiting for the worker.
+    bool pending();
+
+    /// Worker body: build a waiting request, if any.
+    void service();
+
+    /// Boundaries at which the next plan was not ready (since the last reset()).
+    uint32_t misses();
+
+    /// Plans handed over at a boundary (since the last reset()).
+    uint32_t handovers();
+
+    /// Footprint of the plan buffers (bytes).
+    constexpr unsigned memoryBytes() { return PLANNER_SLOTS * sizeof(LayerPlan); }
+
+}  // namespace Planner
@@ -0,0 +1,131 @@
+/// @file spline_profile.h
+/// @brief Mandrel surface profile — natural cubic spline of radius vs. axial
+///        position.
+///
+/// Describes non-cylindrical mandrels (tapers, domes) as ordered (x, r)
+/// points measured from carriage home.  compute() fits a natural cubic spline
+/// once after the points are added; getRadius() evaluates it.  Evaluation
+/// scans the segments, so it belongs at job load (e.g. building a GearTable),
+/// not in the step path.  An empty profile means "cylinder of the
+/// WindProfile diameter".
+///
+/// For the toolarm, compute() with the axis scales also bakes a target table:
+/// toolarm step targets (radius + standoff) on a uniform grid of carriage
+/// steps.  The grid pitch is a power-of-two number of carriage steps, chosen
+/// so that neighbouring entries differ by about one toolarm step at the
+/// steepest part of the profile (coarser if SPLINE_LUT_SIZE would be
+/// exceeded).  getTargetSteps() is then a shift and an array read.  The
+/// toolarm follows the surface from this table while winding (winding.cpp):
+/// getTargetStepsLerp() for its target and getTargetSlope() for its speed.
+
+#pragma once
+
+#include <stdint.h>
+
+/// Maximum number of profile points.
+constexpr int SPLINE_MAX_POINTS = 50;
+
+/// Capacity of the baked toolarm target table (entries).
+constexpr int SPLINE_LUT_SIZE = 1024;
+
+/// @class SplineProfile
+/// @brief Radius of the mandrel surface as a function of carriage position.
+class SplineProfile {
+public:
+    /// Remove all points.
+    void clear();
+
+    /// Append a (position, radius) point — call in order of increasing x.
+    /// @return false if the profile is full or x does not increase.
+    bool addPoint(float x, float r);
+
+    /// Fit the spline coefficients — call once after all points are added.
+    void compute();
+
+    /// Fit the spline and bake the toolarm target table.
+    /// @param carriageStepsPerMM  Carriage microsteps per mm (grid axis).
+    /// @param toolarmStepsPerMM   Toolarm microsteps per mm (table values).
+    void compute(float carriageStepsPerMM, float toolarmStepsPerMM);
+
+    /// Mandrel radius at carriage position @p x (mm), clamped to the end
+    /// points outside the profile range.
+    float getRadius(float x) const;
+
+    /// dr/dx and d²r/dx² at @p x (0 outside the profile range).
+    float getSlope(float x) const;
+    float getCurvature(float x) const;
+
+    /// Radius plus the standoff — the toolarm target at @p x (mm).
+    float getTarget(float x) const { return getRadius(x) + standoff_; }
+
+    void  setStandoff(float standoff) { standoff_ = standoff; }
+    float getStandoff() const         { return standoff_; }
+
+    /// Toolarm target (steps) at carriage position @p carriageStep, from the
+    /// baked table: nearest entry, or linear interpolation between entries.
+    /// Clamped to the profile ends.  Requires hasTargetTable().
+    long getTargetSteps(long carriageStep) const {
+        long rel = carriageStep - lutStart_;
+        if (rel <= 0) return lut_[0];
+        long i = (rel + (lutPitch_ >> 1)) >> lutShift_;
+        return (i < lutCount_) ? lut_[i] : lut_[lutCount_ - 1];
+    }
+
+    long getTargetStepsLerp(long carriageStep) const {
+        long rel = carriageStep - lutStart_;
+        if (rel <= 0) return lut_[0];
+        long i = rel >> lutShift_;
+        if (i >= lutCount_ - 1) return lut_[lutCount_ - 1];
+        long frac = rel & (lutPitch_ - 1);
+        return lut_[i] + (((lut_[i + 1] - lut_[i]) * frac) >> lutShift_);
+    }
+
+    /// Toolarm steps per carriage step at @p carriageStep: the slope of the
+    /// table interval it falls in, 0 outside the table (the target is
+    /// clamped there).  Requires hasTargetTable().
+    float getTargetSlope(long carriageStep) const {
+        long rel = carriageStep - lutStart_;
+        if (rel < 0) return 0.0f;
+        long i = rel >> lutShift_;
+        if (i >= lutCount_ - 1) return 0.0f;
+        return (lut_[i + 1] - lut_[i]) * lutInvPitch_;
+    }
+
+    bool hasTargetTable() const { return lutCount_ > 0; }
+    int  getTableEntries() const { return lutCount_; }
+    long getTablePitch() const   { return lutPitch_; }   ///< Carriage steps per entry.
+
+    /// Bytes of the table in use / reserved.
+    unsigned getTableBytes() const             { return lutCount_ * sizeof(lut_[0]); }
+    static constexpr unsigned tableCapacityBytes() { return SPLINE_LUT_SIZE * sizeof(int32_t); }
+
+    int   getPointCount() const { return n_; }
+    float getStart() const      { return n_ ? x_[0] : 0.0f; }
+    float getEnd() const        { return n_ ? x_[n_ - 1] : 0.0f; }
+
+    /// @return true once at least two points have been added and fitted.
+    bool isReady() const { return n_ >= 2 && computed_; }
+
+private:
+    float x_[SPLINE_MAX_POINTS];   ///< Carriage positions (mm).
+    float a_[SPLINE_MAX_POINTS];   ///< Radius at x_ (mm) — constant coefficient.
+    float b_[SPLINE_MAX_POINTS];   ///< Linear coefficient.
+    float c_[SPLINE_MAX_POINTS];   ///< Quadratic coefficient.
+    float d_[SPLINE_MAX_POINTS];   ///< Cubic coefficient.
+    int   n_        = 0;
+    bool  computed_ = false;
+    float standoff_ = 0.0f;        ///< Toolarm standoff from the surface (mm).
+
+    int32_t lut_[SPLINE_LUT_SIZE];  ///< Toolarm targets (steps).
+    int     lutCount_ = 0;          ///< Entries in use (0 = no table).
+    long    lutStart_ = 0;          ///< Carriage step of entry 0.
+    long    lutPitch_ = 1;          ///< Carriage steps per entry (power of two).
+    uint8_t lutShift_ = 0;          ///< log2(lutPitch_).
+    float   lutInvPitch_ = 1.0f;    ///< 1 / lutPitch_.
+
+    /// Largest |dr/dx| over the profile.
+    float maxSlope() const;
+
+    /// Segment containing @p x (profile must be fitted and x inside it).
+    int segment(float x) const;
+};
@@ -0,0 +1,86 @@
+/// @file stall_monitor.h
+/// @brief Stall detection from the drivers' StallGuard readings.
+///
+/// The steppers are open loop: a motor that stalls at speed drops out of
+/// step while the firmware keeps counting, and the rest of the part is
+/// wound off.  A TMC2209 in StealthChop measures its motor's load
+/// (StallGuard4, tmc2209.h): SG_RESULT falls towards 0 as the load nears
+/// what the current can hold.  StallMonitor reads it from every watched
+/// driver in turn while the axes run and reports a stall once an axis has
+/// read at or below its stall level STALL_CONFIRM_READINGS times in a row.
+///
+/// The drivers share one UART, so one read is in flight at a time and
+/// update() never waits for it: it sends the next read (TmcBus::request())
+/// or takes in what has arrived of the last (TmcBus::reply()) and returns.
+/// An axis is read only once it has run at or above its driver's
+/// stallMinSpeed for STALL_SETTLE_US — StallGuard has too little back-EMF
+/// to go on below, and reads low for the first steps from rest — and a
+/// reading counts only if it still does when the reply is in.  Axes
+/// whose driver is not on the UART, or in SpreadCycle, are not watched;
+/// their lost steps show at the next homing (HomingReport::lostSteps).
+
+#pragma once
+
+#include <stdint.h>
+
+#include "tmc2209.h"
+
+/// @class StallMonitor
+/// @brief Round-robin StallGuard reads over the drivers' UART.
+class StallMonitor {
+public:
+    static constexpr uint8_t MAX_AXES = 4;
+    static constexpr uint8_t NO_AXIS  = 0xFF;
+
+    /// Watch @p driver's axis, whose speed (steps/s, signed) @p speed
+    /// returns.  Axes take slots in the order they are added.
+    /// @return false if the monitor is full.
+    bool add(Tmc2209& driver, float (*speed)());
+
+    /// Forget the readings and any stall (a new job, or resuming after one).
+    void start();
+
+    /// Collect a reading or send the next (call every loop while the axes
+    /// run; never blocks).
+    /// @return true once an axis has stalled (stalledAxis()).
+    bool update();
+
+    uint8_t axes() const { return count_; }
+
+    /// Slot of the stalled axis, or NO_AXIS.
+    uint8_t stalledAxis() const { return stalled_; }
+
+    /// @return true if @p slot's driver can report stalls (on the UART, in
+    ///         StealthChop, with a threshold).
+    bool watched(uint8_t slot) const { return axes_[slot].driver->watchesStalls(); }
+
+    const Tmc2209& driver(uint8_t slot) const { return *axes_[slot].driver; }
+
+    /// @p slot's last SG_RESULT, its lowest since start() and the readings
+    /// taken (lowest is SG_RESULT_MAX before the first).
+    uint16_t lastResult(uint8_t slot) const { return axes_[slot].last; }
+    uint16_t lowestResult(uint8_t slot) const { return axes_[slot].lowest; }
+    uint32_t readings(uint8_t slot) const { return axes_[slot].readings; }
+
+private:
+    struct Axis {
+        Tmc2209*      driver;
+        float         (*speed)();
+        uint16_t      last;
+        uint16_t      lowest;
+        uint32_t      readings;
+        uint8_t       low;      ///< Readings in a row at or below the stall level.
+        bool          moving;   ///< Running fast enough…
+        unsigned long since;    ///< …since here (µs).
+    };
+
+    // @return true if @p axis runs fast enough for StallGuard.
+    static bool running(const Axis& axis);
+
+    Axis          axes_[MAX_AXES] = {};
+    uint8_t       count_   = 0;
+    uint8_t       next_    = 0;         ///< Slot to read next.
+    uint8_t       reading_ = NO_AXIS;   ///< Slot whose read is in flight.
+    uint8_t       stalled_ = NO_AXIS;
+    unsigned long sentUs_  = 0;         ///< When the last read was sent.
+};
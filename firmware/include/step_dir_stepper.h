@@ -0,0 +1,426 @@
+/// @file step_dir_stepper.h
+/// @brief STEP/DIR stepper driver specialised at compile time.
+///
+/// A lean replacement for AccelStepper on the step path, for the STEP/DIR
+/// drivers the machine uses (TMC2209 / TMC2225).  Pins and polarity are
+/// template parameters, so a step is two or three GPIO writes to constant
+/// addresses: no virtual call, no switch over wiring modes, no per-pin
+/// inversion lookup, and DIR is only written when it changes.  On the ESP32
+/// the writes go straight to the GPIO set / clear registers; elsewhere (the
+/// host simulator) through digitalWrite() so the pulses stay observable.
+///
+/// runSpeed() is integer-only: a micros() comparison and a position update.
+/// run() walks a StepRamp built when the maximum speed or acceleration
+/// changes: after each step the ramp level goes up, stays or comes down by
+/// one depending on the distance to go, and the next interval is a table
+/// load.  The API the firmware uses (runSpeed / run / move / moveTo / stop /
+/// position accessors) behaves as AccelStepper's; the acceleration is the
+/// same step for step, the deceleration mirrors it (AccelStepper runs its
+/// recurrence backwards, which differs by a few µs per step).  An axis that
+/// only runs at constant speed has no table (RampSteps = 0).
+///
+/// setTargetSpeed() puts run() in velocity mode: the same walk, one level per
+/// step, towards the level of a commanded speed instead of a position.
+///
+/// setBacklash() compensates a drive's backlash.  When the direction
+/// changes, the dead band is taken up first: that many extra pulses at the
+/// take-up speed, before the next step and not counted in the position, so
+/// the position stays that of the load.  The drive is taken as engaged in
+/// the direction it last moved.
+///
+/// setStepShift() makes every STEP pulse move 2^shift steps, for a driver
+/// set to a coarser microstep resolution over UART (tmc2209.h).  Positions,
+/// targets and speeds stay in the axis's own steps (axis.h), so nothing
+/// above the stepper changes; the ramp is built in pulses and the step
+/// interval is per pulse.  A positioned move then ends within a pulse of
+/// its target, and is finished at full resolution.
+
+#pragma once
+
+#include <Arduino.h>
+#include <math.h>
+#include <stdint.h>
+
+#include "step_ramp.h"
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <soc/gpio_struct.h>
+#endif
+
+// ============================================================================
+//  Pin Access
+// ============================================================================
+
+/// @namespace StepDirPins
+/// @brief Compile-time pin writes.
+namespace StepDirPins {
+
+    /// Sentinel for "no enable pin".
+    constexpr uint8_t NONE = 0xff;
+
+#if defined(ARDUINO_ARCH_ESP32)
+    template <uint8_t Pin>
+    inline void write(bool high) {
+        if (Pin < 32) {
+            if (high) GPIO.out_w1ts = 1UL << (Pin & 31);
+            else      GPIO.out_w1tc = 1UL << (Pin & 31);
+        } else {
+            if (high) GPIO.out1_w1ts.val = 1UL << (Pin & 31);
+            else      GPIO.out1_w1tc.val = 1UL << (Pin & 31);
+        }
+    }
+#else
+    template <uint8_t Pin>
+    inline void write(bool high) {
+        digitalWrite(Pin, high ? HIGH : LOW);
+    }
+#endif
+
+}  // namespace StepDirPins
+
+// ============================================================================
+//  Stepper
+// ============================================================================
+
+/// @class StepDirStepper
+/// @brief One STEP/DIR axis.
+///
+/// @tparam StepPin, DirPin  Driver inputs.
+/// @tparam EnablePin        Driver enable, or StepDirPins::NONE.
+/// @tparam RampSteps        Ramp table capacity (levels) for run(); 0 = none.
+/// @tparam EnableActiveLow  Enable polarity (TMC22xx: active low).
+/// @tparam DirInverted      Swap the direction that counts positive.
+/// @tparam PulseUs          STEP high time (µs; TMC22xx need ≥ 100 ns).
+template <uint8_t StepPin, uint8_t DirPin, uint8_t EnablePin = StepDirPins::NONE,
+          uint16_t RampSteps = 0, bool EnableActiveLow = true, bool DirInverted = false,
+          uint8_t PulseUs = 1>
+class StepDirStepper {
+public:
+    StepDirStepper() {
+        if (RampSteps) buildRamp();
+    }
+
+    // ── Outputs ──────────────────────────────────────────────────────────────
+
+    /// Configure the pins as outputs and enable the driver.
+    void enableOutputs() {
+        pinMode(StepPin, OUTPUT);
+        pinMode(DirPin, OUTPUT);
+        digitalWrite(StepPin, LOW);
+        if (EnablePin != StepDirPins::NONE) {
+            pinMode(EnablePin, OUTPUT);
+            digitalWrite(EnablePin, EnableActiveLow ? LOW : HIGH);
+        }
+    }
+
+    /// Release the driver (motor unpowered).  A direct pin write, so an
+    /// interrupt (the E-stop) may call it.
+    void disableOutputs() {
+        if (EnablePin != StepDirPins::NONE) {
+            StepDirPins::write<EnablePin>(EnableActiveLow);
+        }
+    }
+
+    // ── Motion parameters ────────────────────────────────────────────────────
+
+    /// Maximum speed for run() (steps/s); rebuilds the ramp table.
+    void setMaxSpeed(float speed) {
+        if (speed < 0.0f) speed = -speed;
+        if (maxSpeed_ == speed) return;
+        maxSpeed_ = speed;
+        if (RampSteps) buildRamp();
+    }
+
+    /// Acceleration for run() (steps/s²); rebuilds the ramp table.  A ramp in
+    /// progress keeps its speed: the level is rescaled (level ∝ v² / a).
+    void setAcceleration(float acceleration) {
+        if (acceleration == 0.0f) return;
+        if (acceleration < 0.0f) acceleration = -acceleration;
+        if (acceleration_ == acceleration) return;
+        if (!RampSteps) {
+            acceleration_ = acceleration;
+            return;
+        }
+        if (level_ > 0) {
+            const long level = lroundf(level_ * (acceleration_ / acceleration));
+            level_ = static_cast<uint16_t>(constrain(level, 1L, static_cast<long>(RampSteps)));
+        }
+        acceleration_ = acceleration;
+        buildRamp();
+        if (level_ > 0) stepInterval_ = ramp_.interval(level_);
+    }
+
+    /// Velocity mode for run(): accelerate or decelerate at the ramp's rate
+    /// towards @p speed (steps/s, sign = direction), through rest if the
+    /// sign changes.  No divide on the ramp, so it can be re-commanded every
+    /// loop; the ramp moves at most one level per step whatever the command
+    /// does.  A speed below the ramp's first step is run at that speed,
+    /// off the ramp (one divide).
+    void setTargetSpeed(float speed) {
+        static_assert(RampSteps > 0, "setTargetSpeed() / run() need a ramp table (RampSteps)");
+        const float size = (speed > 0.0f ? speed : -speed) / stride_;
+        velocity_      = true;
+        targetForward_ = (speed > 0.0f);
+        targetLevel_   = ramp_.levelForSpeed(size);
+        crawlInterval_ = (targetLevel_ == 0 && size > 0.0f)
+                       ? static_cast<unsigned long>(1000000.0f / size) : 0;
+        if (level_ == 0) computeNewSpeed();
+    }
+
+    /// Constant speed for runSpeed() (steps/s, sign = direction).  Leaves
+    /// the ramp and velocity mode: run() resumes from the nearest level.
+    void setSpeed(float speed) {
+        // Crawling or in velocity mode, speed_ is not what the motor runs.
+        if (level_ == 0 && !crawling_ && !velocity_ && speed == speed_) return;
+        speed = constrain(speed, -maxSpeed_, maxSpeed_);
+        if (speed == 0.0f) {
+            stepInterval_ = 0;
+        } else {
+            stepInterval_ = fabs(1000000.0 * stride_ / speed);
+            direction_    = (speed > 0.0f);
+        }
+        speed_    = speed;
+        level_    = 0;
+        velocity_ = false;
+        crawling_ = false;
+    }
+
+    /// Current speed (steps/s, sign = direction).  On a ramp this is derived
+    /// from the step interval — a divide, so not for the step path.
+    float speed() const {
+        if (level_ == 0 && !crawling_) return speed_;
+        if (!stepInterval_) return 0.0f;
+        const float v = 1000000.0f * stride_ / stepInterval_;
+        return direction_ ? v : -v;
+    }
+
+    float maxSpeed() const     { return maxSpeed_; }
+    float acceleration() const { return acceleration_; }
+
+    /// Backlash compensation: @p steps of dead band taken up at
+    /// @p takeUpSpeed (steps/s) on every change of direction; 0 = none.
+    /// The drive is taken as engaged in the last direction of travel.
+    void setBacklash(long steps, float takeUpSpeed) {
+        if (steps < 0) steps = 0;
+        if (takeUpSpeed < 0.0f) takeUpSpeed = -takeUpSpeed;
+        backlash_       = steps;
+        slack_          = direction_ ? steps : 0;
+        takeUpInterval_ = takeUpSpeed > 0.0f ? static_cast<unsigned long>(1000000.0f / takeUpSpeed) : 0;
+    }
+
+    long backlash() const { return backlash_; }
+
+    /// Where the motor is in the dead band: 0 engaged towards negative
+    /// positions … backlash() engaged towards positive ones.
+    long slack() const { return slack_; }
+
+    /// Pulse size: each STEP pulse moves 2^@p shift steps, the driver set
+    /// to that many times fewer microsteps.  Only at rest; the ramp is
+    /// rebuilt in pulses.  Positions and speeds stay in steps.
+    /// @return false (nothing changed) while the motor runs.
+    bool setStepShift(uint8_t shift) {
+        if (stepInterval_) return false;
+        if (shift == shift_) return true;
+        shift_  = shift;
+        stride_ = 1L << shift;
+        level_  = 0;
+        if (RampSteps) buildRamp();
+        return true;
+    }
+
+    uint8_t stepShift() const { return shift_; }
+
+    // ── Targets and position ─────────────────────────────────────────────────
+
+    /// New target for run().  As in AccelStepper the ramp is re-evaluated
+    /// at once, so a target that keeps moving (electronic gearing) moves the
+    /// level on every change as well as every step.
+    void moveTo(long absolute) {
+        static_assert(RampSteps > 0, "moveTo() / run() need a ramp table (RampSteps)");
+        if (targetPos_ == absolute && !velocity_) return;
+        targetPos_ = absolute;
+        velocity_  = false;
+        computeNewSpeed();
+    }
+
+    void move(long relative) { moveTo(currentPos_ + relative); }
+
+    /// Decelerate to a stop as fast as the acceleration allows.
+    void stop() {
+        if (!stepInterval_) return;
+        if (level_ == 0) level_ = ramp_.levelFor(stepInterval_);
+        const long stepsToStop = static_cast<long>(level_) << shift_;
+        moveTo(currentPos_ + (direction_ ? stepsToStop : -stepsToStop));
+    }
+
+    /// Redefine the current position; stops the motor.  The backlash slack
+    /// is kept.
+    void setCurrentPosition(long position) {
+        targetPos_ = currentPos_ = position;
+        velocity_     = false;
+        crawling_     = false;
+        level_        = 0;
+        stepInterval_ = 0;
+        speed_        = 0.0f;
+    }
+
+    long currentPosition() const { return currentPos_; }
+    long targetPosition() const  { return targetPos_; }
+    long distanceToGo() const    { return targetPos_ - currentPos_; }
+    long stepsToStop() const     { return static_cast<long>(level_) << shift_; }   ///< On the ramp; 0 otherwise.
+    bool isRunning() const       { return stepInterval_ != 0 || labs(targetPos_ - currentPos_) >= stride_; }
+
+    // ── Stepping (call every loop) ───────────────────────────────────────────
+
+    /// Step once if the step interval has elapsed — after taking up the
+    /// backlash if the direction has changed.
+    /// @return true if a step was made (take-up pulses are not steps).
+    bool runSpeed() {
+        if (!stepInterval_) return false;
+        const unsigned long now = micros();
+        if (slack_ != (direction_ ? backlash_ : 0)) return takeUp(now);
+        if (now - lastStepTime_ < stepInterval_) return false;
+
+        currentPos_ += direction_ ? stride_ : -stride_;
+        pulse();
+        lastStepTime_  = now;
+        lastPulseTime_ = now;
+        return true;
+    }
+
+    /// Step towards the target with acceleration.
+    /// @return true while the motor is still moving or short of the target
+    ///         (by a pulse or more).
+    bool run() {
+        if (runSpeed()) computeNewSpeed();
+        return stepInterval_ != 0 || (!velocity_ && labs(distanceToGo()) >= stride_);
+    }
+
+    /// Ramp table footprint (bytes).
+    static constexpr unsigned rampBytes() { return RampSteps ? sizeof(ramp_) : 0; }
+
+private:
+    // DIR first (only on a change), then the STEP pulse.
+    void pulse() {
+        if (dirLevel_ != static_cast<int8_t>(direction_)) {
+            StepDirPins::write<DirPin>(direction_ != DirInverted);
+            dirLevel_ = direction_;
+        }
+        StepDirPins::write<StepPin>(true);
+        delayMicroseconds(PulseUs);
+        StepDirPins::write<StepPin>(false);
+    }
+
+    // Ramp table in pulses.
+    void buildRamp() {
+        ramp_.build(maxSpeed_ / stride_, acceleration_ / stride_, level_);
+    }
+
+    // One take-up pulse if the take-up interval has elapsed since the last
+    // pulse of either kind.  Once the slack is taken up the next step is
+    // due no sooner than a take-up interval on, nor than it was anyway.  A
+    // coarse pulse that takes up the rest of the dead band moves the load
+    // by what is left of it.
+    bool takeUp(unsigned long now) {
+        if (now - lastPulseTime_ < takeUpInterval_) return false;
+        const long goal = direction_ ? backlash_ : 0;
+        slack_ += direction_ ? stride_ : -stride_;
+        if (direction_ ? slack_ > goal : slack_ < goal) {
+            currentPos_ += slack_ - goal;
+            slack_       = goal;
+        }
+        pulse();
+        lastPulseTime_ = now;
+        if (slack_ == goal) {
+            const unsigned long wait = stepInterval_ > takeUpInterval_ ? stepInterval_ - takeUpInterval_ : 0;
+            if (now - lastStepTime_ > wait) lastStepTime_ = now - wait;
+        }
+        return false;
+    }
+
+    // Next ramp level and step interval.  A level is a step, so at level k
+    // the motor needs k − 1 more steps to stop.  The goal is a direction and
+    // a level limit: towards the target with level ≤ distance to go (the
+    // step after next could still stop in time), or the commanded speed in
+    // velocity mode.  The level moves one towards the limit — down first,
+    // through rest, if the direction is wrong.  From a constant speed the
+    // ramp resumes at the nearest level; a commanded speed below level 1
+    // crawls at its own interval.
+    void computeNewSpeed() {
+        if (level_ == 0 && stepInterval_ && !crawling_) {
+            level_ = ramp_.levelFor(stepInterval_);
+            speed_ = 0.0f;
+        }
+
+        bool forward;
+        long limit;
+        if (velocity_) {
+            forward = targetForward_;
+            limit   = targetLevel_;
+        } else {
+            const long distanceTo = distanceToGo();
+            forward = (distanceTo > 0);
+            limit   = (forward ? distanceTo : -distanceTo) >> shift_;   // Pulses to go.
+        }
+        if (limit > ramp_.top()) limit = ramp_.top();
+
+        if (level_ == 0) {
+            if (limit == 0) {
+                crawl(forward);
+                return;
+            }
+            direction_ = forward;
+            level_     = 1;
+            speed_     = 0.0f;   // On the ramp now; speed() derives it.
+            crawling_  = false;
+        } else if (direction_ != forward || level_ > limit) {
+            if (--level_ == 0) {
+                if (limit == 0) {
+                    crawl(forward);
+                    return;
+                }
+                direction_ = forward;   // Reverse from rest.
+                level_     = 1;
+            }
+        } else if (level_ < limit) {
+            level_++;
+        }
+        stepInterval_ = ramp_.interval(level_);
+    }
+
+    // Off the ramp at rest: stop, or in velocity mode run a speed slower
+    // than level 1 — reachable from rest in one step, like level 1 itself.
+    void crawl(bool forward) {
+        crawling_ = velocity_ && crawlInterval_;
+        if (!crawling_) {
+            stepInterval_ = 0;
+            return;
+        }
+        direction_    = forward;
+        stepInterval_ = crawlInterval_;
+        speed_        = 0.0f;   // speed() derives it, as on the ramp.
+    }
+
+    long          currentPos_   = 0;
+    long          targetPos_    = 0;
+    float         speed_        = 0.0f;       ///< setSpeed() speed (steps/s, negative = reverse).
+    float         maxSpeed_     = 1.0f;
+    float         acceleration_ = 1.0f;       ///< Steps/s².
+    unsigned long stepInterval_ = 0;          ///< µs between steps (0 = stopped).
+    unsigned long lastStepTime_ = 0;          ///< The step interval runs from here.
+    unsigned long lastPulseTime_ = 0;         ///< Last STEP pulse, step or take-up.
+    unsigned long takeUpInterval_ = 0;        ///< µs between take-up pulses.
+    long          backlash_     = 0;          ///< Dead band (steps; 0 = no compensation).
+    long          slack_        = 0;          ///< Motor within it: 0 … backlash_.
+    long          stride_       = 1;          ///< Steps per pulse (2^shift_).
+    uint8_t       shift_        = 0;
+    uint16_t      level_        = 0;          ///< Ramp level (0 = not on the ramp).
+    unsigned long crawlInterval_ = 0;         ///< Velocity mode: interval below level 1 (0 = none).
+    uint16_t      targetLevel_  = 0;          ///< Velocity mode: level of the commanded speed.
+    bool          targetForward_ = false;     ///< Velocity mode: commanded direction.
+    bool          velocity_     = false;      ///< run() follows setTargetSpeed(), not the target.
+    bool          crawling_     = false;      ///< Stepping at crawlInterval_, off the ramp.
+    bool          direction_    = false;      ///< true = towards positive positions.
+    int8_t        dirLevel_     = -1;         ///< Direction last written to DIR (-1: none).
+    StepRamp<RampSteps ? RampSteps : 1> ramp_;
+};
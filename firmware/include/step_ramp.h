@@ -0,0 +1,101 @@
+/// @file step_ramp.h
+/// @brief Precomputed step-interval table for an acceleration ramp.
+///
+/// Level k of the ramp is the k-th step from rest; its interval is the one
+/// AccelStepper's computeNewSpeed() gives step k (Equations 13 and 15 of
+/// "Generate stepper-motor speed profiles in real time", D. Austin), clamped
+/// at the maximum speed.  The table is built when the maximum speed or the
+/// acceleration changes — once per job — so a stepper walking it does no
+/// floating-point work per step: accelerating is level + 1, cruising keeps
+/// the level and decelerating walks the same intervals back down, which
+/// also makes the level the number of steps needed to stop.
+
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+
+/// Levels a ramp to @p maxSpeed at @p acceleration needs: v² / 2a steps
+/// (Equation 16) plus the first.  For sizing a table at compile time.
+constexpr uint32_t stepRampLevels(float maxSpeed, float acceleration) {
+    return static_cast<uint32_t>(maxSpeed * maxSpeed / (2.0f * acceleration)) + 2;
+}
+
+/// @class StepRamp
+/// @brief Interval (µs) per ramp level, for up to @p Capacity levels.
+template <uint16_t Capacity>
+class StepRamp {
+public:
+    static_assert(Capacity > 0, "a ramp needs at least one level");
+
+    /// Fill the table for @p maxSpeed (steps/s) and @p acceleration
+    /// (steps/s²).  Levels above the cruise level up to @p keepLevels are
+    /// filled too (unclamped), so a stepper that was faster than the new
+    /// maximum can decelerate down to it.
+    /// @return false if the ramp does not reach @p maxSpeed within Capacity
+    ///         levels; the table then tops out at its last level.
+    bool build(float maxSpeed, float acceleration, uint16_t keepLevels = 0) {
+        const float cmin = 1000000.0 / maxSpeed;
+        float       cn   = 0.676 * sqrt(2.0 / acceleration) * 1000000.0;   // Equation 15
+
+        halfInvAccel_ = 0.5f / acceleration;
+        interval_[0] = static_cast<uint32_t>(cn);
+        top_         = Capacity;
+        uint16_t k   = 1;
+        for (; k < Capacity; k++) {
+            cn = cn - ((2.0 * cn) / ((4.0 * k) + 1));   // Equation 13
+            if (cn <= cmin) {
+                interval_[k] = static_cast<uint32_t>(cmin);
+                top_         = k + 1;
+                break;
+            }
+            interval_[k] = static_cast<uint32_t>(cn);
+        }
+
+        levels_ = top_;
+        if (keepLevels > Capacity) keepLevels = Capacity;
+        for (k = top_; k < keepLevels; k++) {
+            cn = cn - ((2.0 * cn) / ((4.0 * k) + 1));
+            interval_[k] = static_cast<uint32_t>(cn);
+            levels_      = k + 1;
+        }
+        return top_ < Capacity || interval_[Capacity - 1] <= static_cast<uint32_t>(cmin);
+    }
+
+    /// Step interval at @p level (1 … levels()).
+    uint32_t interval(uint16_t level) const { return interval_[level - 1]; }
+
+    /// Cruise level: the first level at the maximum speed.
+    uint16_t top() const { return top_; }
+
+    /// Filled levels (≥ top()).
+    uint16_t levels() const { return levels_; }
+
+    /// Lowest level at least as fast as @p intervalUs (binary search; the
+    /// intervals fall with the level).  top() if none is.
+    uint16_t levelFor(uint32_t intervalUs) const {
+        uint16_t lo = 1, hi = top_;
+        while (lo < hi) {
+            const uint16_t mid = lo + (hi - lo) / 2;
+            if (interval_[mid - 1] <= intervalUs) hi = mid;
+            else                                  lo = mid + 1;
+        }
+        return lo;
+    }
+
+    /// Level running at about @p speed (steps/s): v² / 2a (Equation 16),
+    /// at most top().  A multiply; 0 only for speeds below the first step.
+    uint16_t levelForSpeed(float speed) const {
+        const float level = speed * speed * halfInvAccel_ + 0.5f;
+        return level >= top_ ? top_ : static_cast<uint16_t>(level);
+    }
+
+    /// Table footprint (bytes).
+    static constexpr unsigned memoryBytes() { return sizeof(StepRamp); }
+
+private:
+    uint32_t interval_[Capacity] = {};   ///< µs; index = level − 1.
+    uint16_t top_          = 1;
+    uint16_t levels_       = 1;
+    float    halfInvAccel_ = 0.5f;       ///< 1 / 2a.
+};
@@ -0,0 +1,285 @@
+/// @file tmc2209.h
+/// @brief TMC2209 configuration over its single-wire UART.
+///
+/// The TMC2209 takes register reads and writes as datagrams on its PDN_UART
+/// pin: a write is sync, node address, register | 0x80, four data bytes
+/// (MSB first) and a CRC8; a read is sync, address, register and CRC, and
+/// is answered after SENDDELAY with sync, master address 0xFF, register,
+/// data and CRC.  Up to four drivers share the line, addressed by their
+/// MS1/MS2 straps.  TX and RX share the wire, so every byte sent is also
+/// received; a read skips that echo by looking for the reply's 0xFF.
+///
+/// TmcBus frames datagrams on a serial port (Serial2 on the ESP32; on the
+/// host a register model, tools/host/tmc_model.h).  Tmc2209 is one driver.
+/// begin() probes it (IOIN VERSION) and configures it: microstep resolution
+/// (CHOPCONF MRES, GCONF mstep_reg_select), run and hold current
+/// (IHOLD_IRUN, with the sense range CHOPCONF vsense), and StealthChop or
+/// SpreadCycle (GCONF en_SpreadCycle).  The writes are checked against the
+/// driver's count of the writes it accepted (IFCNT), once more on a
+/// mismatch; a driver that still disagrees is left alone, as one that does
+/// not answer is — it runs at its strapped resolution.  IHOLD_IRUN cannot
+/// be read back, so every register written is shadowed and a change is
+/// made on the shadow.
+///
+/// The microstep resolution is the axis's own (axis.h) shifted down:
+/// setStepShift() runs the driver at 2^shift times fewer microsteps, and
+/// StepDirStepper::setStepShift() makes each pulse count as many steps, so
+/// the firmware keeps working in the axis's steps.  A write after begin()
+/// goes into the UART's FIFO and returns at once; the driver switches when
+/// the datagram has arrived, a frame later (≈ 0.7 ms at 115200 baud), which
+/// settled() tells.  A resolution change is made at rest and the axis is
+/// not pulsed before it has settled.
+///
+/// StallGuard4 measures the motor's load from its back-EMF in StealthChop:
+/// SG_RESULT falls towards 0 as the load nears what the current can hold,
+/// and the driver counts a stall at SG_RESULT ≤ 2 × SGTHRS.  begin() sets
+/// SGTHRS from TmcConfig::stallThreshold and TCOOLTHRS from its minimum
+/// speed, so DIAG reports the same stalls on a board that wires it; the
+/// StallMonitor (stall_monitor.h) reads SG_RESULT over the UART without
+/// blocking — TmcBus::request() sends the read and reply() collects the
+/// answer in a later loop.  A SpreadCycle axis has no StallGuard.
+
+#pragma once
+
+#include <Arduino.h>
+#include <stdint.h>
+
+/// Address of a driver that is not on the UART.
+constexpr uint8_t TMC_NO_ADDRESS = 0xFF;
+
+/// IOIN VERSION of a TMC2209.
+constexpr uint8_t TMC2209_VERSION = 0x21;
+
+/// Longest wait for a read's reply (µs): the echo, SENDDELAY and the reply
+/// take 1.1 ms at 115200 baud.
+constexpr unsigned long TMC_READ_TIMEOUT_US = 5000;
+
+/// Internal clock (Hz) TSTEP and TCOOLTHRS count in.
+constexpr uint32_t TMC_CLOCK_HZ = 12000000;
+
+/// Steps a pulse moves with the driver at @p coarse microsteps on an axis
+/// of @p nominal, as a shift (nominal / coarse = 2^shift).  Both powers of
+/// two, coarse ≤ nominal.
+constexpr uint8_t tmcStepShift(uint16_t nominal, uint16_t coarse) {
+    return nominal > coarse ? 1 + tmcStepShift(nominal / 2, coarse) : 0;
+}
+
+/// @namespace TmcReg
+/// @brief Registers and fields used (TMC2209 datasheet, section 5).
+namespace TmcReg {
+
+    constexpr uint8_t GCONF      = 0x00;
+    constexpr uint8_t GSTAT      = 0x01;   ///< Write 1s to clear.
+    constexpr uint8_t IFCNT      = 0x02;   ///< Accepted writes, mod 256.
+    constexpr uint8_t IOIN       = 0x06;   ///< VERSION in bits 24…31.
+    constexpr uint8_t IHOLD_IRUN = 0x10;   ///< Write-only.
+    constexpr uint8_t TCOOLTHRS  = 0x14;   ///< Write-only; DIAG stall output at TSTEP ≤ it.
+    constexpr uint8_t SGTHRS     = 0x40;   ///< Write-only.
+    constexpr uint8_t SG_RESULT  = 0x41;   ///< StallGuard load reading (0 … 510).
+    constexpr uint8_t CHOPCONF   = 0x6C;
+
+    constexpr uint8_t WRITE = 0x80;        ///< Register byte of a write.
+
+    // GCONF
+    constexpr uint32_t EN_SPREADCYCLE   = 1UL << 2;
+    constexpr uint32_t PDN_DISABLE      = 1UL << 6;   ///< PDN_UART is the UART only.
+    constexpr uint32_t MSTEP_REG_SELECT = 1UL << 7;   ///< Resolution from MRES, not MS1/MS2.
+    constexpr uint32_t MULTISTEP_FILT   = 1UL << 8;
+
+    // CHOPCONF
+    constexpr uint32_t CHOPCONF_RESET = 0x10000053;   ///< TOFF 3, HSTRT 5, intpol, MRES 256.
+    constexpr uint32_t VSENSE         = 1UL << 17;    ///< Low sense range (0.18 V full scale).
+    constexpr uint8_t  MRES_SHIFT     = 24;
+    constexpr uint32_t MRES_MASK      = 0xFUL << MRES_SHIFT;
+
+    // IHOLD_IRUN
+    constexpr uint8_t IRUN_SHIFT       = 8;
+    constexpr uint8_t IHOLDDELAY_SHIFT = 16;
+
+    constexpr uint32_t TCOOLTHRS_MAX = 0xFFFFF;   ///< 20 bits.
+    constexpr uint16_t SG_RESULT_MAX = 0x3FF;
+
+}  // namespace TmcReg
+
+// ============================================================================
+//  Bus
+// ============================================================================
+
+/// State of a read sent with TmcBus::request().
+enum class TmcReply : uint8_t {
+    PENDING,   ///< Not all in yet.
+    DONE,      ///< The value is valid.
+    FAILED,    ///< Timed out or a bad CRC.
+};
+
+/// @class TmcBus
+/// @brief Datagram framing on the drivers' shared UART.
+class TmcBus {
+public:
+    TmcBus(HardwareSerial& port, uint32_t baud) : port_(port), baud_(baud) {}
+
+    /// Open the port on @p rxPin / @p txPin.
+    void begin(uint8_t rxPin, uint8_t txPin);
+
+    /// Queue a register write; returns at once (see idle()).  A read still
+    /// pending is waited for first: the reply would collide with the write.
+    void write(uint8_t address, uint8_t reg, uint32_t value);
+
+    /// Read a register, waiting up to TMC_READ_TIMEOUT_US for the reply.
+    /// @return false on a timeout or a bad CRC.
+    bool read(uint8_t address, uint8_t reg, uint32_t& value);
+
+    /// Send a register read and return at once; reply() collects the
+    /// answer.  Send it with the wire idle(), or the echo of the writes
+    /// still on it can be taken for the reply (the CRC then fails it).
+    void request(uint8_t address, uint8_t reg);
+
+    /// Take in what has arrived of the reply to request() (never blocks).
+    /// @return PENDING until it is complete or TMC_READ_TIMEOUT_US has
+    ///         passed; then, until the next request, DONE (@p value set) or
+    ///         FAILED.
+    TmcReply reply(uint32_t& value);
+
+    /// @return true while a request() is waiting for its reply.
+    bool pending() const { return pending_; }
+
+    /// @return true if the last request() was for @p reg of @p address.
+    bool requested(uint8_t address, uint8_t reg) const { return address_ == address && reg_ == reg; }
+
+    /// @return true once every datagram written has left the wire.
+    bool idle() const { return micros() - sentUs_ >= busyUs_; }
+
+    /// Wire time of @p bytes (µs; 8N1, 10 bits a byte).
+    unsigned long frameUs(uint8_t bytes) const { return bytes * 10000000UL / baud_; }
+
+    /// CRC8 of a datagram's first @p length bytes (polynomial x⁸ + x² + x + 1,
+    /// bytes LSB first, as the datasheet computes it).
+    static uint8_t crc(const uint8_t* data, uint8_t length);
+
+private:
+    // Account for @p bytes going onto the wire now.
+    void send(const uint8_t* data, uint8_t bytes);
+
+    // Block until a pending request() has its reply.
+    void wait();
+
+    HardwareSerial& port_;
+    uint32_t        baud_;
+    unsigned long   sentUs_ = 0;   ///< Bytes written since here…
+    unsigned long   busyUs_ = 0;   ///< …are on the wire this long.
+
+    // The read in flight.
+    bool            pending_   = false;
+    uint8_t         address_   = TMC_NO_ADDRESS;
+    uint8_t         reg_       = 0;
+    uint8_t         rx_[8]     = {};   ///< Reply so far…
+    uint8_t         received_  = 0;    ///< …this many bytes.
+    unsigned long   requestUs_ = 0;
+    uint32_t        value_     = 0;
+    TmcReply        result_    = TmcReply::FAILED;
+};
+
+// ============================================================================
+//  Driver
+// ============================================================================
+
+/// @struct TmcConfig
+/// @brief One driver's UART address and start-up settings.
+struct TmcConfig {
+    uint8_t  address;          ///< MS1/MS2 address (0 … 3), or TMC_NO_ADDRESS.
+    uint16_t runCurrentMA;     ///< RMS run current (mA).
+    uint8_t  holdPercent;      ///< Standstill current (% of the run current).
+    bool     stealthChop;      ///< StealthChop (quiet) rather than SpreadCycle (stiff at speed).
+    uint8_t  stallThreshold;   ///< SGTHRS: a stall at SG_RESULT ≤ 2 × it (0: not watched).
+    float    stallMinSpeed;    ///< StallGuard is trusted from this speed on (steps/s; TCOOLTHRS).
+};
+
+/// @class Tmc2209
+/// @brief One TMC2209 on a TmcBus.
+class Tmc2209 {
+public:
+    /// @param microsteps  The axis's resolution (its StepperMotorParams).
+    Tmc2209(TmcBus& bus, const TmcConfig& config, uint16_t microsteps)
+        : bus_(bus), config_(config), microsteps_(microsteps) {}
+
+    /// Probe the driver and configure it from its TmcConfig (blocks for a
+    /// few ms).  @return present().
+    bool begin();
+
+    /// @return true if the driver answered and took its configuration.
+    bool present() const { return present_; }
+
+    // ── Resolution ───────────────────────────────────────────────────────────
+
+    /// Run at 2^@p shift times fewer microsteps than the axis's (at rest;
+    /// pulse the axis only once settled()).  Ignored if not present().
+    void setStepShift(uint8_t shift);
+
+    uint8_t  stepShift() const  { return shift_; }
+    uint16_t microsteps() const { return microsteps_ >> shift_; }
+
+    /// @return true once the last write has reached the driver.
+    bool settled() const { return bus_.idle(); }
+
+    // ── Current and chopper ──────────────────────────────────────────────────
+
+    /// RMS run current (mA) and standstill current (% of it).
+    void setCurrent(uint16_t runMA, uint8_t holdPercent);
+
+    /// The currents the driver's scales give (mA).
+    uint16_t runCurrentMA() const;
+    uint16_t holdCurrentMA() const;
+
+    void setStealthChop(bool on);
+    bool stealthChop() const { return !(gconf_ & TmcReg::EN_SPREADCYCLE); }
+
+    // ── Checks ───────────────────────────────────────────────────────────────
+
+    /// Read back GCONF, CHOPCONF and IFCNT (blocks) and compare them with
+    /// what was written.  A mismatch counts a fault and resynchronises.
+    /// @return false on a mismatch or a failed read.
+    bool verify();
+
+    /// Failed reads and writes the driver did not take, since begin().
+    uint16_t faults() const { return faults_; }
+
+    uint8_t address() const { return config_.address; }
+
+    /// Raw register read (blocks); false if not present() or on a failure.
+    bool readRegister(uint8_t reg, uint32_t& value);
+
+    // ── StallGuard ───────────────────────────────────────────────────────────
+
+    /// @return true if the driver is present(), in StealthChop and has a
+    ///         stall threshold.
+    bool watchesStalls() const { return present_ && stealthChop() && config_.stallThreshold; }
+
+    /// SG_RESULT at or below which the axis is stalling.
+    uint16_t stallLevel() const { return 2 * config_.stallThreshold; }
+
+    /// Axis speed (steps/s) from which SG_RESULT is trusted.
+    float stallMinSpeed() const { return config_.stallMinSpeed; }
+
+    /// Send a read of SG_RESULT (never blocks).  @return false if the
+    /// driver does not watchesStalls() or the wire is busy.
+    bool requestStallGuard();
+
+    /// The answer to requestStallGuard() (see TmcBus::reply()); a FAILED
+    /// read counts a fault.
+    TmcReply stallGuardReply(uint16_t& result);
+
+private:
+    void write(uint8_t reg, uint32_t value);
+    void configure();
+
+    TmcBus&          bus_;
+    const TmcConfig  config_;
+    const uint16_t   microsteps_;           ///< The axis's resolution.
+    uint8_t          shift_      = 0;
+    bool             present_    = false;
+    uint8_t          writes_     = 0;       ///< IFCNT expected (mod 256).
+    uint16_t         faults_     = 0;
+    uint32_t         gconf_      = 0;       ///< Shadows of the registers written.
+    uint32_t         chopconf_   = TmcReg::CHOPCONF_RESET;
+    uint32_t         iholdIrun_  = 0;
+};
@@ -0,0 +1,110 @@
+/// @file toolarm_plan.h
+/// @brief Look-ahead plan for the toolarm over a layer's winding zone.
+///
+/// On a domed or tapered mandrel the toolarm follows the surface (radius +
+/// standoff, SplineProfile::getTarget()) as the carriage crosses.  Its speed
+/// is the profile slope times the carriage speed and its acceleration the
+/// curvature times the carriage speed squared, so on a steep dome transition
+/// at the winding speed it cannot keep up.  Retargeting a positioned move
+/// every loop, as the 4-axis scripts do, it then falls behind the profile.
+///
+/// A ToolarmPlan samples the profile at TOOLARM_PLAN_SIZE points from home
+/// across the winding zone when the layer plan is built (the first pass
+/// starts at home, and the surface is followed there too): the fastest the
+/// mandrel may turn for the toolarm to follow.  Where the demanded
+/// speed or the curvature term would exceed the toolarm's limits that is
+/// below the winding speed, and the mandrel is slowed there — the carriage
+/// with it, as it is geared to the mandrel.  A forward and a backward sweep
+/// bound how fast the limit may change: within DEFAULT_MANDREL_ACCEL, and
+/// within the toolarm acceleration left for the change in demanded speed.
+/// So the mandrel slows ahead of a steep section and ramps back after it,
+/// in either direction of travel, and only there does the job run below
+/// the winding speed.  Where a pass starts or ends on a steep section the
+/// speed there is bounded by TOOLARM_PLAN_START_ERROR_MM; the turn-around
+/// dwell ramps up from it and back, the carriage standing.  The layup does
+/// not change: the carriage follows the mandrel's steps, not its time.
+///
+/// At run time (winding.cpp) the mandrel turns at the plan's speed at the
+/// carriage position, interpolated like the gear ratio, and the toolarm is
+/// driven in velocity mode from the mandrel's baked target table
+/// (SplineProfile::getTargetStepsLerp() / getTargetSlope()): the slope
+/// times the carriage speed as feed-forward, plus a catch-up on its error
+/// against the target at the carriage position.  Without a mandrel profile
+/// (or its target table) the plan is inactive and the toolarm is not
+/// driven.
+
+#pragma once
+
+#include "layer.h"
+#include "spline_profile.h"
+
+struct EstimateParams;
+
+/// Entries per plan (TOOLARM_PLAN_SIZE − 1 intervals across the zone).
+constexpr int TOOLARM_PLAN_SIZE = 129;
+
+/// Share of the toolarm's speed and acceleration the plan may use; the rest
+/// is left to the tracking's catch-up (TOOLARM_CATCH_UP_ACCEL).
+constexpr float TOOLARM_PLAN_SHARE = 0.9f;
+
+/// Slowest mandrel speed the plan slows to (steps/s).  A profile steeper
+/// than that allows is followed with a lag.
+constexpr float TOOLARM_PLAN_MIN_SPEED = 30.0f;
+
+/// Toolarm error allowed where the carriage starts or stops a pass from or
+/// to rest, at the zone's ends and at home (mm).  The carriage's ramp there
+/// is steeper than the toolarm can follow on a dome, so the mandrel turns
+/// slowly enough that the toolarm lags or overshoots by no more than this.
+constexpr float TOOLARM_PLAN_START_ERROR_MM = 0.02f;
+
+/// @struct ToolarmSummary
+/// @brief What the plan costs per pass, for the estimate and the reports.
+struct ToolarmSummary {
+    float gearSeconds     = 0.0f;   ///< A full pass's time at the winding speed geared to the surface
+                                    ///< (GearTable), over the same at the layer's nominal ratio.
+    float extraSeconds    = 0.0f;   ///< A full pass's time over the same pass at the winding speed.
+    float uniformSeconds  = 0.0f;   ///< The same with the whole pass at minSpeed instead.
+    float approachSeconds = 0.0f;   ///< The same for the way from home into the zone.
+    float minSpeed        = 1.0f;   ///< Slowest planned speed in the zone (fraction of the winding speed).
+    float slowedShare     = 0.0f;   ///< Share of the zone wound below the winding speed.
+    float startSpeed      = 1.0f;   ///< Planned speed at the zone's start…
+    float endSpeed        = 1.0f;   ///< …and end (the turn-around dwells run at these).
+};
+
+/// @class ToolarmPlan
+/// @brief Uniformly indexed mandrel speed limits for one layer.
+class ToolarmPlan {
+public:
+    /// Fill the plan for @p layer.  Inactive if @p mandrel has no target
+    /// table.  Without params.toolarmLookAhead nothing is slowed.
+    void build(const Layer& layer, const SplineProfile& mandrel, const EstimateParams& params);
+
+    /// Plan a pass of @p layer without keeping it (the estimate's view).
+    static ToolarmSummary summarize(const Layer& layer, const SplineProfile& mandrel,
+                                    const EstimateParams& params);
+
+    bool isActive() const { return active_; }
+
+    /// Fastest the mandrel may turn at @p carriageStep (steps/s), linearly
+    /// interpolated between entries and clamped to the span.
+    float speedAt(long carriageStep) const {
+        const float pos = (carriageStep - startStep_) * invSpacing_;
+        if (pos <= 0.0f) return speed_[0];
+        if (pos >= TOOLARM_PLAN_SIZE - 1) return speed_[TOOLARM_PLAN_SIZE - 1];
+        const int   i = static_cast<int>(pos);
+        const float f = pos - i;
+        return speed_[i] + f * (speed_[i + 1] - speed_[i]);
+    }
+
+    const ToolarmSummary& summary() const { return summary_; }
+
+    /// Plan footprint (bytes).
+    static constexpr unsigned memoryBytes() { return sizeof(ToolarmPlan); }
+
+private:
+    float speed_[TOOLARM_PLAN_SIZE]  = {};   ///< Mandrel speed limit (steps/s).
+    long  startStep_  = 0;                   ///< Carriage step of entry 0.
+    float invSpacing_ = 0.0f;                ///< Entries per carriage step.
+    bool  active_     = false;
+    ToolarmSummary summary_;
+};
@@ -0,0 +1,125 @@
+/// @file trace.h
+/// @brief Low-overhead binary event trace recorder.
+///
+/// Timestamped events (state transitions, layer/pass boundaries, serial
+/// commands, step bursts, queue levels, input changes) are written into a
+/// fixed RAM ring buffer.  Recording is a handful of stores, so it can stay
+/// enabled on the motion path.  The buffer is dumped on demand over serial as
+/// a framed binary block which tools/trace2chrome converts into Chrome /
+/// Perfetto trace JSON.
+///
+/// This header has no Arduino dependency so the host tools can share the
+/// record layout and event ids with the firmware.
+
+#pragma once
+
+#include <stdint.h>
+
+class Print;
+
+/// Number of records held in the ring buffer (must be a power of two).
+constexpr uint16_t TRACE_CAPACITY = 2048;
+
+/// Frame magic written in front of every dump ("WTRC", little-endian).
+constexpr uint32_t TRACE_MAGIC   = 0x43525457;
+constexpr uint16_t TRACE_VERSION = 1;
+
+static_assert((TRACE_CAPACITY & (TRACE_CAPACITY - 1)) == 0,
+              "TRACE_CAPACITY must be a power of two");
+
+// ============================================================================
+//  Event Types
+// ============================================================================
+
+/// Event ids stored in TraceRecord::event.  Append only — the host converter
+/// relies on these values.
+enum class TraceEvent : uint8_t {
+    STATE           = 0,   ///< arg = new WindingState, value = previous state.
+    LAYER_BEGIN     = 1,   ///< arg = layer index,      value = total passes.
+    PASS_END        = 2,   ///< arg = layer index,      value = passes completed.
+    SERIAL_CMD      = 3,   ///< arg = command length,   value = first 4 chars packed.
+    STEP_BURST      = 4,   ///< arg = TraceAxis,        value = steps queued.
+    QUEUE_LEVEL     = 5,   ///< arg = TraceAxis,        value = following error (steps).
+    MARK            = 6,   ///< arg / value free for ad-hoc debugging.
+    PLAN_MISS       = 7,   ///< arg = layer index,      value = misses so far.
+    SWITCH          = 8,   ///< arg = Input | active << 8, value = first edge to latch (µs).
+    STALL           = 9,   ///< arg = TraceAxis | layer << 8, value = pass (1-based) << 16 | SG_RESULT.
+    STEP_LOSS       = 10,  ///< arg = TraceAxis,        value = home moved since the last homing (steps).
+    FOLLOWING_ERROR = 11   ///< arg = TraceAxis,        value = following error that stopped the job (steps).
+};
+
+/// Axis ids used as the arg of STEP_BURST / QUEUE_LEVEL / STALL / STEP_LOSS /
+/// FOLLOWING_ERROR events.
+enum class TraceAxis : uint8_t {
+    MANDREL  = 0,
+    CARRIAGE = 1,
+    TOOLARM  = 2,
+    TOOLHEAD = 3
+};
+
+/// @struct TraceRecord
+/// @brief One 12-byte trace entry, dumped verbatim (little-endian).
+struct TraceRecord {
+    uint32_t timeUs;   ///< micros() at the time of the event (wraps ~71 min).
+    uint8_t  event;    ///< TraceEvent id.
+    uint8_t  reserved;
+    uint16_t arg;      ///< Event-specific small argument.
+    int32_t  value;    ///< Event-specific value.
+};
+
+static_assert(sizeof(TraceRecord) == 12, "TraceRecord layout is part of the dump format");
+
+/// @struct TraceHeader
+/// @brief Frame header written before the records of a dump.
+struct TraceHeader {
+    uint32_t magic;        ///< TRACE_MAGIC.
+    uint16_t version;      ///< TRACE_VERSION.
+    uint16_t recordSize;   ///< sizeof(TraceRecord).
+    uint32_t count;        ///< Number of records that follow (oldest first).
+    uint32_t dropped;      ///< Records overwritten since the last clear.
+};
+
+static_assert(sizeof(TraceHeader) == 16, "TraceHeader layout is part of the dump format");
+
+// ============================================================================
+//  Recorder API
+// ============================================================================
+
+/// @namespace Trace
+/// @brief Ring-buffer event recorder.  Single producer (loop context only).
+namespace Trace {
+
+    /// Append one event (no-op while disabled or masked out).  Oldest records
+    /// are overwritten once the buffer is full.
+    void record(TraceEvent event, uint16_t arg = 0, int32_t value = 0);
+
+    /// Enable or disable recording (enabled by default).
+    void setEnabled(bool enabled);
+    bool isEnabled();
+
+    /// Select which event types are recorded (bit n = TraceEvent n, all set
+    /// by default).  Clearing the STEP_BURST / QUEUE_LEVEL bits keeps the
+    /// buffer for the low-rate events over a much longer window.
+    void     setEventMask(uint32_t mask);
+    uint32_t getEventMask();
+
+    /// Mask bit for one event type.
+    constexpr uint32_t bit(TraceEvent event) {
+        return 1UL << static_cast<uint8_t>(event);
+    }
+
+    /// Discard all buffered records.
+    void clear();
+
+    /// Number of records currently buffered.
+    uint32_t size();
+
+    /// Write the buffered records as one binary frame (TraceHeader followed by
+    /// size() TraceRecords, oldest first).  Recording is suspended while the
+    /// frame is written.
+    void dump(Print& out);
+
+    /// Pack the first four characters of a command for a SERIAL_CMD event.
+    int32_t packCommand(const char* cmd);
+
+}  // namespace Trace
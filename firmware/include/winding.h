@@ -8,11 +8,23 @@
 ///
 /// The Winding namespace exposes the public API for the state machine that
 /// executes the profile.  Call Winding::init() once in setup() and
-/// Winding::update() every loop() iteration.
+/// Winding::update() every loop() iteration.  Up to JOB_QUEUE_SIZE further
+/// jobs can be queued behind the running one; each is prepared in the
+/// background while the previous job's last layer winds (see planner.h) and
+/// follows it without re-zeroing.
 
 #pragma once
 
 #include "layer.h"
+#include "estimate.h"
+#include "spline_profile.h"
+
+struct HomingReport;
+enum class HomeAxis : uint8_t;
+class StallMonitor;
+
+/// Jobs that can wait behind the running one.
+constexpr int JOB_QUEUE_SIZE = 2;
 
 // ============================================================================
 //  Winding States
@@ -36,17 +48,37 @@ enum class WindingState : uint8_t {
 /// @brief All parameters that define a complete winding job.
 ///
 /// Populate mandrelDiameter, then call addLayer() for each layer in order.
+/// For a tapered or domed mandrel also add its surface points to
+/// mandrelProfile; the gear ratio then follows the local radius while
+/// mandrelDiameter stays the reference for pass counts and stepover.
+/// With patternSequencing set, start() plans a winding pattern for every
+/// layer (see pattern.h); otherwise passes are laid band by band.  With
+/// overlapToolheadFlip set the toolhead turns to the next pass's fibre
+/// angle while the carriage runs into and out of each turn-around
+/// (FlipTiming in estimate.h); otherwise only during the dwell, waiting
+/// out the rest.  On a profiled mandrel the toolarm follows the surface;
+/// with toolarmLookAhead set it runs a velocity plan sampled ahead of the
+/// carriage and the mandrel slows where it could not keep up
+/// (toolarm_plan.h), otherwise it is retargeted to the surface under the
+/// carriage every loop, as in the 4-axis scripts.
 /// The profile can be cleared and re-used between jobs.
 struct WindProfile {
-    float mandrelDiameter            = 0.0f;   ///< Mandrel OD (mm).
-    int   layerCount                 = 0;       ///< Number of active layers.
-    Layer layers[MAX_LAYERS];                   ///< Layer storage (0 … layerCount-1).
+    float         mandrelDiameter = 0.0f;   ///< Mandrel OD (mm).
+    int           layerCount      = 0;      ///< Number of active layers.
+    Layer         layers[MAX_LAYERS];       ///< Layer storage (0 … layerCount-1).
+    SplineProfile mandrelProfile;           ///< Surface radius vs. position (empty = cylinder).
+    bool          patternSequencing = true; ///< Lay circuits in a planned skip pattern.
+    bool          overlapToolheadFlip = true;   ///< Flip the toolhead across the carriage's ramps.
+    bool          toolarmLookAhead = true;      ///< Plan the toolarm ahead of the carriage.
 
     /// Append a new layer using the stored mandrelDiameter.
     /// @return true on success, false if the profile is full.
     bool addLayer(float length, float angle, float offset,
                   float stepover, float dwell);
 
+    /// Plan (or, without patternSequencing, clear) every layer's winding pattern.
+    void planPatterns(const EstimateParams& params);
+
     /// Remove all layers and reset the profile.
     void clear();
 
@@ -54,6 +86,25 @@ struct WindProfile {
     bool isValid() const;
 };
 
+// ============================================================================
+//  Stall Alarm
+// ============================================================================
+
+/// @struct StallAlarm
+/// @brief The last stall that paused a job (stall_monitor.h).
+///
+/// A watched axis stalling while winding pauses the job where it is; the
+/// axis has lost steps, so the part is only good if it is re-homed (start)
+/// — resume carries on with the axis off by what it lost.
+struct StallAlarm {
+    uint32_t count   = 0;      ///< Stalls since start-up (0: none, the rest unset).
+    uint8_t  axis    = 0;      ///< TraceAxis of the axis that stalled.
+    int      layer   = 0;      ///< Layer (0-based) and pass (1-based) it stalled in.
+    int      pass    = 0;
+    uint16_t result  = 0;      ///< SG_RESULT of the reading that confirmed it.
+    float    seconds = 0.0f;   ///< Job time it stalled at.
+};
+
 // ============================================================================
 //  Winding Controller
 // ============================================================================
@@ -79,9 +130,29 @@ namespace Winding {
     /// Resume from a paused state.
     void resume();
 
+    /// Have the next homing measure every axis's backlash at its limit
+    /// switch and compensate it from then on (homing.h).
+    void calibrateBacklash();
+
+    /// Queue a copy of @p job to run after the current one.
+    /// @return false if the profile is invalid or the queue is full.
+    bool enqueue(const WindProfile& job);
+
+    /// Number of jobs waiting behind the current one.
+    int getQueuedJobs();
+
+    /// Fit the mandrel profile, reset layer progress, plan the winding
+    /// patterns and estimate @p job — everything a job needs before its
+    /// first layer plan.  Runs on the planner worker for queued jobs.
+    /// @param carriageHome … toolheadHome  Axis distances to their switches
+    ///                                     (steps), for the zeroing estimate.
+    void prepareJob(WindProfile& job, JobEstimate& estimate, long carriageHome = 0,
+                    long toolarmHome = 0, long toolheadHome = 0);
+
     // ── Profile access ───────────────────────────────────────────────────────
 
-    /// Get a mutable reference to the active wind profile.
+    /// Get a mutable reference to the active wind profile (the one start()
+    /// runs, or the running job).
     WindProfile& getProfile();
 
     // ── Status queries ───────────────────────────────────────────────────────
@@ -92,4 +163,30 @@ namespace Winding {
     /// Index of the layer currently being wound (0-based).
     int getActiveLayerIndex();
 
+    /// Job-time estimate of the active job (valid == false before start()).
+    const JobEstimate& getEstimate();
+
+    /// Homing measurements of @p axis: the last homing and the home
+    /// repeatability since start-up.
+    const HomingReport& getHomingReport(HomeAxis axis);
+
+    /// The last stall that paused a job.
+    const StallAlarm& getStallAlarm();
+
+    /// The StallGuard readings since the job started or resumed, in
+    /// TraceAxis slots.
+    const StallMonitor& getStallMonitor();
+
+    /// Geared carriage command of the current or last pass (steps); the
+    /// carriage position follows it while winding.
+    long getGearedStep();
+
+    /// Seconds since the active job started, or 0 if no job has been started.
+    float getElapsedSeconds();
+
+    /// Footprint of the running and queued jobs and their estimates (bytes).
+    constexpr unsigned memoryBytes() {
+        return (1 + JOB_QUEUE_SIZE) * (sizeof(WindProfile) + sizeof(JobEstimate));
+    }
+
 }  // namespace Winding
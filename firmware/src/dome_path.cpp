@@ -0,0 +1,242 @@
+/// @file dome_path.cpp
+/// @brief Dome path generator and streaming cursor.
+
+#include "dome_path.h"
+
+#include <math.h>
+
+// ============================================================================
+//  Internal Helpers
+// ============================================================================
+
+namespace {
+
+constexpr float DEG = 3.14159265f / 180.0f;
+
+/// Integration state: axial distance from the cylinder end towards the pole,
+/// fibre angle and mandrel rotation (radians).
+struct PathState {
+    float u;
+    float alpha;
+    float phi;
+};
+
+/// Fixed inputs of one integration.
+struct PathModel {
+    const SplineProfile* profile;
+    float                x0;       // Cylinder end (mm).
+    int                  dir;      // +1 / −1 towards the pole.
+    float                lambda;   // Slippage coefficient.
+
+    float x(float u) const { return x0 + dir * u; }
+
+    // d/dm of the state; false once the path leaves the surface.
+    bool deriv(const PathState& s, PathState& d) const {
+        const float xs = x(s.u);
+        if (xs < profile->getStart() || xs > profile->getEnd()) return false;
+
+        const float r = profile->getRadius(xs);
+        if (r <= 0.0f) return false;
+
+        const float ru  = dir * profile->getSlope(xs);   // dr/du
+        const float ruu = profile->getCurvature(xs);     // d²r/du²
+        const float g   = sqrtf(1.0f + ru * ru);         // dm/du
+
+        const float sa = sinf(s.alpha), ca = cosf(s.alpha);
+        const float km = -ruu / (g * g * g);             // Meridian curvature.
+        const float kp = 1.0f / (r * g);                 // Parallel curvature.
+        const float kn = km * ca * ca + kp * sa * sa;    // Normal curvature along the fibre.
+
+        d.u     = 1.0f / g;
+        d.alpha = lambda * kn / ca - (sa / ca) * (ru / g) / r;
+        d.phi   = (sa / ca) / r;
+        return true;
+    }
+
+    // One RK4 step of length h; false if the path left the surface.
+    bool step(PathState& s, float h) const {
+        PathState k1, k2, k3, k4, t;
+        if (!deriv(s, k1)) return false;
+        t = { s.u + 0.5f * h * k1.u, s.alpha + 0.5f * h * k1.alpha, s.phi + 0.5f * h * k1.phi };
+        if (!deriv(t, k2)) return false;
+        t = { s.u + 0.5f * h * k2.u, s.alpha + 0.5f * h * k2.alpha, s.phi + 0.5f * h * k2.phi };
+        if (!deriv(t, k3)) return false;
+        t = { s.u + h * k3.u, s.alpha + h * k3.alpha, s.phi + h * k3.phi };
+        if (!deriv(t, k4)) return false;
+
+        s.u     += h / 6.0f * (k1.u + 2.0f * k2.u + 2.0f * k3.u + k4.u);
+        s.alpha += h / 6.0f * (k1.alpha + 2.0f * k2.alpha + 2.0f * k3.alpha + k4.alpha);
+        s.phi   += h / 6.0f * (k1.phi + 2.0f * k2.phi + 2.0f * k3.phi + k4.phi);
+        return true;
+    }
+};
+
+// Meridian arc length from the cylinder end to the end of the profile.
+float meridianLength(const PathModel& m) {
+    const float span = (m.dir > 0) ? m.profile->getEnd() - m.x0 : m.x0 - m.profile->getStart();
+    const int   n    = 400;
+    float       len  = 0.0f;
+    for (int i = 0; i < n; i++) {
+        float ra = m.profile->getRadius(m.x(span * i / n));
+        float rb = m.profile->getRadius(m.x(span * (i + 1) / n));
+        len += hypotf(span / n, rb - ra);
+    }
+    return len;
+}
+
+// Step length: the base step, shortened as cos α falls towards the
+// turnaround where tan α (and so the rotation per mm) grows without bound.
+float stepLength(const PathState& s, float h) {
+    return h * fmaxf(cosf(s.alpha), 1.0f / 64.0f);
+}
+
+// Integrate from the cylinder end at angle alpha0 until the fibre turns
+// around.  Returns the meridian length to the turnaround and the final
+// state, or a negative length if the path runs off the profile first.
+float integrate(const PathModel& m, float alpha0, float h, PathState& out) {
+    const float turn = DOME_PATH_TURN_ANGLE * DEG;
+    PathState   s    = { 0.0f, alpha0, 0.0f };
+    float       len  = 0.0f;
+    for (int i = 0; i < 16 * DOME_PATH_INTEGRATION_STEPS; i++) {
+        if (s.alpha >= turn) {
+            out = s;
+            return len;
+        }
+        const float hs = stepLength(s, h);
+        if (!m.step(s, hs) || s.alpha < 0.0f) break;
+        len += hs;
+    }
+    out = s;
+    return -1.0f;
+}
+
+}  // namespace
+
+// ============================================================================
+//  Generator
+// ============================================================================
+
+bool DomePath::generate(const SplineProfile& profile, const DomePathParams& p) {
+    count_ = 0;
+    error_ = "";
+
+    const int maxEntries = (p.maxEntries < 2) ? 2
+                         : (p.maxEntries > DOME_PATH_MAX_ENTRIES) ? DOME_PATH_MAX_ENTRIES
+                         : p.maxEntries;
+
+    if (!profile.isReady()) {
+        error_ = "mandrel profile not fitted";
+        return false;
+    }
+    if (p.carriageStepsPerMM <= 0.0f || p.mandrelStepsPerRev <= 0.0f) {
+        error_ = "axis scales not set";
+        return false;
+    }
+
+    const PathModel model = { &profile, p.cylinderEndMM, (p.direction < 0) ? -1 : 1, p.slippage };
+    const float     rCyl  = profile.getRadius(p.cylinderEndMM);
+    if (p.polarOpeningRadius <= 0.0f || p.polarOpeningRadius >= rCyl) {
+        error_ = "polar opening must be between 0 and the cylinder radius";
+        return false;
+    }
+
+    const float h = meridianLength(model) / DOME_PATH_INTEGRATION_STEPS;
+    if (h <= 0.0f) {
+        error_ = "no dome beyond the cylinder end";
+        return false;
+    }
+
+    // Bisect the cylinder angle: a larger angle turns around at a larger
+    // radius.  A path that runs off the profile counts as radius 0.
+    float     lo = 0.1f * DEG, hi = 89.0f * DEG;
+    PathState end;
+    iterations_ = 0;
+    for (; iterations_ < 40 && hi - lo > 1e-5f; iterations_++) {
+        float mid  = 0.5f * (lo + hi);
+        float len  = integrate(model, mid, h, end);
+        float rEnd = (len < 0.0f) ? 0.0f : profile.getRadius(model.x(end.u));
+        if (rEnd < p.polarOpeningRadius) lo = mid;
+        else                             hi = mid;
+    }
+
+    const float alpha0 = hi;
+    const float total  = integrate(model, alpha0, h, end);
+    if (total <= 0.0f) {
+        error_ = "path does not turn around on the profile";
+        return false;
+    }
+
+    cylinderAngle_ = alpha0 / DEG;
+    turnaroundMM_  = model.x(end.u);
+    turnaroundR_   = profile.getRadius(turnaroundMM_);
+    rotationDeg_   = end.phi / DEG;
+
+    // Resample uniformly in meridian length: re-run the integration and
+    // interpolate each entry between the two surrounding steps.
+    const float spacing = total / (maxEntries - 1);
+    PathState   prev  = { 0.0f, alpha0, 0.0f };
+    PathState   cur   = prev;
+    float       mCur  = 0.0f;
+    float       hLast = 0.0f;
+    for (int k = 0; k < maxEntries; k++) {
+        const float target = (k == maxEntries - 1) ? total : k * spacing;
+        while (mCur < target && cur.alpha < DOME_PATH_TURN_ANGLE * DEG) {
+            prev  = cur;
+            hLast = stepLength(cur, h);
+            if (!model.step(cur, hLast)) break;
+            mCur += hLast;
+        }
+
+        const float     f = (mCur > target && hLast > 0.0f) ? 1.0f - (mCur - target) / hLast : 1.0f;
+        const PathState s = { prev.u + f * (cur.u - prev.u),
+                              prev.alpha + f * (cur.alpha - prev.alpha),
+                              prev.phi + f * (cur.phi - prev.phi) };
+        const float x     = model.x(s.u);
+        const float angle = s.alpha / DEG;
+
+        DomePathEntry& e = entries_[k];
+        e.mandrelStep  = static_cast<int32_t>(s.phi / (2.0f * 3.14159265f) * p.mandrelStepsPerRev);
+        e.carriageStep = static_cast<int32_t>(x * p.carriageStepsPerMM);
+        e.toolarmStep  = static_cast<int32_t>(profile.getTarget(x) * p.toolarmStepsPerMM);
+        e.toolheadStep = static_cast<int16_t>(model.dir * angle / 360.0f * p.toolheadStepsPerRev);
+        e.angleCdeg    = static_cast<uint16_t>(angle * 100.0f + 0.5f);
+    }
+    count_ = maxEntries;
+    return true;
+}
+
+float DomePath::ratioAt(int i) const {
+    if (i < 0 || i + 1 >= count_) return 0.0f;
+    const long dm = entries_[i + 1].mandrelStep - entries_[i].mandrelStep;
+    const long dc = entries_[i + 1].carriageStep - entries_[i].carriageStep;
+    return dm ? static_cast<float>(dc) / dm : 0.0f;
+}
+
+// ============================================================================
+//  Streaming Cursor
+// ============================================================================
+
+bool DomePathCursor::seek(long mandrelStep) {
+    if (!path_ || path_->getCount() < 2) return false;
+
+    const int last = path_->getCount() - 1;
+    while (index_ < last && path_->entry(index_ + 1).mandrelStep <= mandrelStep) index_++;
+
+    const DomePathEntry& a = path_->entry(index_);
+    if (index_ == last) {
+        carriage_ = a.carriageStep;
+        toolarm_  = a.toolarmStep;
+        toolhead_ = a.toolheadStep;
+        angleDeg_ = a.angleCdeg * 0.01f;
+        return false;
+    }
+
+    const DomePathEntry& b  = path_->entry(index_ + 1);
+    const long           dm = b.mandrelStep - a.mandrelStep;
+    const float          f  = dm ? static_cast<float>(mandrelStep - a.mandrelStep) / dm : 0.0f;
+    carriage_ = a.carriageStep + lroundf(f * (b.carriageStep - a.carriageStep));
+    toolarm_  = a.toolarmStep + lroundf(f * (b.toolarmStep - a.toolarmStep));
+    toolhead_ = a.toolheadStep + lroundf(f * (b.toolheadStep - a.toolheadStep));
+    angleDeg_ = (a.angleCdeg + f * (b.angleCdeg - a.angleCdeg)) * 0.01f;
+    return true;
+}
@@ -0,0 +1,261 @@
+/// @file encoder.cpp
+/// @brief Mandrel quadrature encoder implementation.
+
+#include <Arduino.h>
+#include <atomic>
+
+#include "encoder.h"
+#include "axis.h"
+#include "config.h"
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <esp_idf_version.h>
+#if ESP_IDF_VERSION_MAJOR >= 5
+#include <driver/pulse_cnt.h>
+#else
+#include <driver/pcnt.h>
+#endif
+#endif
+
+// ============================================================================
+//  Internal (file-scoped) State
+// ============================================================================
+
+// Mandrel steps per revolution, whole (axis.h).
+static constexpr long STEPS_PER_REV = static_cast<long>(MandrelAxis::stepsPerRev());
+
+static bool s_enabled = false;
+static long s_offset  = 0;   // Mandrel steps at count 0.
+
+// ============================================================================
+//  Counter
+// ============================================================================
+
+#if defined(ARDUINO_ARCH_ESP32)
+
+// The hardware counter wraps to 0 at ±PCNT_LIMIT; the overflow is kept in
+// software.
+static constexpr int PCNT_LIMIT = 30000;
+static constexpr int GLITCH_NS  = 1000;   // Shorter pulses are noise (≤ 500 kHz count rate).
+
+#if ESP_IDF_VERSION_MAJOR >= 5
+
+// The driver accumulates across the limits itself (accum_count, which
+// needs the limits as watch points).
+static pcnt_unit_handle_t s_unit = nullptr;
+
+// Created once; init() after end() only restarts it.
+static void startCounter() {
+    if (!s_unit) {
+        pcnt_unit_config_t unit = {};
+        unit.high_limit         = PCNT_LIMIT;
+        unit.low_limit          = -PCNT_LIMIT;
+        unit.flags.accum_count  = 1;
+        pcnt_new_unit(&unit, &s_unit);
+
+        pcnt_glitch_filter_config_t filter = {};
+        filter.max_glitch_ns               = GLITCH_NS;
+        pcnt_unit_set_glitch_filter(s_unit, &filter);
+
+        // Each channel counts the edges of one line, direction from the other.
+        pcnt_chan_config_t a = {};
+        a.edge_gpio_num      = MANDREL_ENCODER_A_PIN;
+        a.level_gpio_num     = MANDREL_ENCODER_B_PIN;
+        pcnt_chan_config_t b = {};
+        b.edge_gpio_num      = MANDREL_ENCODER_B_PIN;
+        b.level_gpio_num     = MANDREL_ENCODER_A_PIN;
+        pcnt_channel_handle_t chanA = nullptr;
+        pcnt_channel_handle_t chanB = nullptr;
+        pcnt_new_channel(s_unit, &a, &chanA);
+        pcnt_new_channel(s_unit, &b, &chanB);
+        pcnt_channel_set_edge_action(chanA, PCNT_CHANNEL_EDGE_ACTION_DECREASE, PCNT_CHANNEL_EDGE_ACTION_INCREASE);
+        pcnt_channel_set_level_action(chanA, PCNT_CHANNEL_LEVEL_ACTION_KEEP, PCNT_CHANNEL_LEVEL_ACTION_INVERSE);
+        pcnt_channel_set_edge_action(chanB, PCNT_CHANNEL_EDGE_ACTION_INCREASE, PCNT_CHANNEL_EDGE_ACTION_DECREASE);
+        pcnt_channel_set_level_action(chanB, PCNT_CHANNEL_LEVEL_ACTION_KEEP, PCNT_CHANNEL_LEVEL_ACTION_INVERSE);
+
+        pcnt_unit_add_watch_point(s_unit, PCNT_LIMIT);
+        pcnt_unit_add_watch_point(s_unit, -PCNT_LIMIT);
+        pcnt_unit_enable(s_unit);
+    }
+    pcnt_unit_start(s_unit);
+}
+
+static void stopCounter() {
+    pcnt_unit_stop(s_unit);
+}
+
+static long readCounter() {
+    int value = 0;
+    pcnt_unit_get_count(s_unit, &value);
+    return value;
+}
+
+static void clearCounter() {
+    pcnt_unit_clear_count(s_unit);
+}
+
+#else   // ESP-IDF 4: legacy driver, overflow counted in its limit interrupt.
+
+static constexpr pcnt_unit_t UNIT = PCNT_UNIT_0;
+static std::atomic<long>     s_wraps{ 0 };   // Counts carried out of the hardware counter.
+static bool                  s_isrAdded = false;
+
+static void IRAM_ATTR onLimit(void*) {
+    uint32_t status = 0;
+    pcnt_get_event_status(UNIT, &status);
+    if (status & PCNT_EVT_H_LIM) s_wraps.fetch_add(PCNT_LIMIT, std::memory_order_relaxed);
+    if (status & PCNT_EVT_L_LIM) s_wraps.fetch_sub(PCNT_LIMIT, std::memory_order_relaxed);
+}
+
+static void startCounter() {
+    pcnt_config_t a     = {};
+    a.pulse_gpio_num    = MANDREL_ENCODER_A_PIN;
+    a.ctrl_gpio_num     = MANDREL_ENCODER_B_PIN;
+    a.channel           = PCNT_CHANNEL_0;
+    a.unit              = UNIT;
+    a.pos_mode          = PCNT_COUNT_DEC;
+    a.neg_mode          = PCNT_COUNT_INC;
+    a.lctrl_mode        = PCNT_MODE_REVERSE;
+    a.hctrl_mode        = PCNT_MODE_KEEP;
+    a.counter_h_lim     = PCNT_LIMIT;
+    a.counter_l_lim     = -PCNT_LIMIT;
+    pcnt_config_t b     = a;
+    b.pulse_gpio_num    = MANDREL_ENCODER_B_PIN;
+    b.ctrl_gpio_num     = MANDREL_ENCODER_A_PIN;
+    b.channel           = PCNT_CHANNEL_1;
+    b.pos_mode          = PCNT_COUNT_INC;
+    b.neg_mode          = PCNT_COUNT_DEC;
+    pcnt_unit_config(&a);
+    pcnt_unit_config(&b);
+
+    // The filter counts APB cycles (80 MHz) and takes at most 1023.
+    pcnt_set_filter_value(UNIT, GLITCH_NS * 80 / 1000);
+    pcnt_filter_enable(UNIT);
+
+    pcnt_event_enable(UNIT, PCNT_EVT_H_LIM);
+    pcnt_event_enable(UNIT, PCNT_EVT_L_LIM);
+    pcnt_counter_pause(UNIT);
+    pcnt_counter_clear(UNIT);
+    s_wraps.store(0);
+    if (!s_isrAdded) {
+        pcnt_isr_service_install(0);
+        pcnt_isr_handler_add(UNIT, onLimit, nullptr);
+        s_isrAdded = true;
+    }
+    pcnt_counter_resume(UNIT);
+}
+
+static void stopCounter() {
+    pcnt_counter_pause(UNIT);
+}
+
+// Re-read if the limit interrupt moved the overflow in between.
+static long readCounter() {
+    long    wraps;
+    int16_t value;
+    do {
+        wraps = s_wraps.load(std::memory_order_relaxed);
+        pcnt_get_counter_value(UNIT, &value);
+    } while (wraps != s_wraps.load(std::memory_order_relaxed));
+    return wraps + value;
+}
+
+static void clearCounter() {
+    pcnt_counter_clear(UNIT);
+    s_wraps.store(0);
+}
+
+#endif
+
+#else   // Host: decode A/B in their pin-change interrupts.
+
+// The simulated mandrel moves the lines one count at a time only if no
+// step spans more than one count.
+static_assert(MANDREL_ENCODER_COUNTS_PER_REV <= STEPS_PER_REV,
+              "the host decoder needs at most one count per mandrel step");
+
+static std::atomic<long> s_count{ 0 };
+static uint8_t           s_lines = 0;   // B << 1 | A at the last edge.
+
+// Gray-code order of the line states in the counting direction.
+static int8_t phaseOf(uint8_t lines) {
+    static const int8_t PHASE[4] = { 0, 1, 3, 2 };   // 00, A, B, AB.
+    return PHASE[lines];
+}
+
+static uint8_t readLines() {
+    return static_cast<uint8_t>((digitalRead(MANDREL_ENCODER_B_PIN) == HIGH) << 1 |
+                                (digitalRead(MANDREL_ENCODER_A_PIN) == HIGH));
+}
+
+static void IRAM_ATTR onEdge(void*) {
+    const uint8_t lines = readLines();
+    const int     step  = (phaseOf(lines) - phaseOf(s_lines)) & 3;
+    if (step == 1) s_count.fetch_add(1, std::memory_order_relaxed);
+    if (step == 3) s_count.fetch_sub(1, std::memory_order_relaxed);
+    s_lines = lines;   // step 2 (both lines moved): lost, as on real hardware.
+}
+
+static void startCounter() {
+    pinMode(MANDREL_ENCODER_A_PIN, INPUT);
+    pinMode(MANDREL_ENCODER_B_PIN, INPUT);
+    s_lines = readLines();
+    attachInterruptArg(digitalPinToInterrupt(MANDREL_ENCODER_A_PIN), onEdge, nullptr, CHANGE);
+    attachInterruptArg(digitalPinToInterrupt(MANDREL_ENCODER_B_PIN), onEdge, nullptr, CHANGE);
+}
+
+static void stopCounter() {
+    detachInterrupt(digitalPinToInterrupt(MANDREL_ENCODER_A_PIN));
+    detachInterrupt(digitalPinToInterrupt(MANDREL_ENCODER_B_PIN));
+}
+
+static long readCounter() {
+    return s_count.load(std::memory_order_relaxed);
+}
+
+static void clearCounter() {
+    s_count.store(0);
+}
+
+#endif
+
+// Counts to mandrel steps, rounding toward −∞ so the scale has no dead
+// band around 0.
+static long countToSteps(long count) {
+    const int64_t scaled = static_cast<int64_t>(count) * STEPS_PER_REV;
+    const int64_t cpr    = MANDREL_ENCODER_COUNTS_PER_REV;
+    return static_cast<long>(scaled >= 0 ? scaled / cpr : -((-scaled + cpr - 1) / cpr));
+}
+
+// ============================================================================
+//  Public API
+// ============================================================================
+
+void MandrelEncoder::init() {
+    if (s_enabled) stopCounter();
+    startCounter();
+    clearCounter();
+    s_offset  = 0;
+    s_enabled = true;
+}
+
+void MandrelEncoder::end() {
+    if (s_enabled) stopCounter();
+    s_enabled = false;
+}
+
+bool MandrelEncoder::enabled() {
+    return s_enabled;
+}
+
+long MandrelEncoder::count() {
+    return s_enabled ? readCounter() : 0;
+}
+
+long MandrelEncoder::steps() {
+    return s_offset + countToSteps(count());
+}
+
+void MandrelEncoder::setSteps(long step) {
+    s_offset = step - countToSteps(count());
+}
@@ -0,0 +1,380 @@
+/// @file estimate.cpp
+/// @brief Job time estimator implementation.
+
+#include "estimate.h"
+#include "config.h"
+#include "axis.h"
+#include "homing.h"
+#include "toolarm_plan.h"
+#include "winding.h"
+
+// ============================================================================
+//  Internal Helpers
+// ============================================================================
+
+// Time between steps of runSpeed() at a constant speed.  The stepper driver keeps
+// the interval in whole microseconds, and a step can only fire on a loop()
+// pass, so the interval effectively rounds up to a multiple of the loop period.
+static float stepIntervalUs(float speed, uint32_t loopUs) {
+    if (speed <= 0.0f) return 0.0f;
+    unsigned long interval = static_cast<unsigned long>(1000000.0f / speed);
+    if (loopUs > 0) {
+        interval = ((interval + loopUs - 1) / loopUs) * loopUs;
+    }
+    return static_cast<float>(interval);
+}
+
+// Geared carriage speed for a layer and the speed the carriage actually runs
+// at.  Up to the maximum speed the carriage is slaved to the geared speed
+// and catches up what it lost accelerating from rest within the pass, so it
+// ends a pass with the geared command: no following lag to account for.
+struct Following {
+    float geared;
+    float v;
+};
+
+static Following following(float ratio, float manUs, const EstimateParams& params) {
+    Following f;
+    f.geared = ratio * 1000000.0f / manUs;
+    f.v      = (f.geared < params.carriageMaxSpeed) ? f.geared : params.carriageMaxSpeed;
+    return f;
+}
+
+// Carriage speed at the end (and after the start ramp) of a layer's passes
+// (steps/s); 0 if the layer cannot be wound.
+static float passSpeed(const Layer& layer, float manUs, const EstimateParams& params) {
+    const float ratio = layer.getStepRatio(params.carriageStepsPerMM, params.mandrelStepsPerRev);
+    if (ratio <= 0.0f || manUs <= 0.0f) return 0.0f;
+    return following(ratio, manUs, params).v;
+}
+
+// Dwell of @p steps that ramps from @p edge up towards @p top at @p a and
+// back to @p edge by its end (seconds; steps/s): the mandrel turning round
+// where the toolarm plan slows the end of a pass.
+static float rampedSeconds(float steps, float edge, float top, float a) {
+    const float ramp = (top * top - edge * edge) / a;   // Both ramps' steps.
+    if (steps >= ramp) return 2.0f * (top - edge) / a + (steps - ramp) / top;
+    return 2.0f * (sqrtf(edge * edge + a * steps) - edge) / a;
+}
+
+// Positioned move from rest to rest (seconds): a trapezoid, or a triangle
+// if the distance is too short to reach @p v.
+static float moveSeconds(float distance, float v, float a) {
+    return (distance >= v * v / a) ? distance / v + v / a : 2.0f * sqrtf(distance / a);
+}
+
+// Fit a toolhead flip of @p steps around a dwell of @p dwellSeconds, the
+// carriage ramping for up to leadWindow into the pass end and lagWindow
+// out of the next start (see FlipTiming).
+static FlipTiming flip(long steps, float dwellSeconds, float leadWindow, float lagWindow,
+                       const EstimateParams& params) {
+    FlipTiming  t;
+    const float d = steps < 0 ? -steps : steps;
+    const float v = params.toolheadMaxSpeed;
+    const float a = params.toolheadAccel;
+    if (d <= 0.0f || v <= 0.0f || a <= 0.0f) return t;
+    t.seconds = moveSeconds(d, v, a);
+
+    // Split what the dwell cannot hide evenly between the two ramps; a
+    // ramp too short for its half leaves the rest to the other.
+    float excess = t.seconds - dwellSeconds;
+    if (excess < 0.0f) excess = 0.0f;
+    if (params.overlapFlip) {
+        t.leadSeconds = fminf(leadWindow, 0.5f * excess);
+        t.lagSeconds  = fminf(lagWindow, excess - t.leadSeconds);
+        t.leadSeconds = fminf(leadWindow, excess - t.lagSeconds);
+    }
+    t.waitSeconds = excess - t.leadSeconds - t.lagSeconds;
+
+    // Distance the toolhead covers in its last lagSeconds: on its
+    // deceleration, and before that at its peak speed.
+    const float peak = fminf(v, sqrtf(a * d));
+    const float lag  = t.lagSeconds;
+    const float tail = (lag <= peak / a) ? 0.5f * a * lag * lag
+                                         : 0.5f * peak * peak / a + peak * (lag - peak / a);
+    t.holdSteps = static_cast<long>(fminf(tail, d));
+    return t;
+}
+
+// ============================================================================
+//  Estimator
+// ============================================================================
+
+EstimateParams Estimate::defaultParams(long carriageHome, long toolarmHome, long toolheadHome) {
+    EstimateParams p;
+    p.mandrelSpeed       = DEFAULT_MANDREL_SPEED;
+    p.carriageMaxSpeed   = DEFAULT_CARRIAGE_MAX_SPEED;
+    p.carriageAccel      = DEFAULT_CARRIAGE_ACCEL;
+    p.homing[static_cast<uint8_t>(HomeAxis::CARRIAGE)] = CARRIAGE_HOMING;
+    p.homing[static_cast<uint8_t>(HomeAxis::TOOLARM)]  = TOOLARM_HOMING;
+    p.homing[static_cast<uint8_t>(HomeAxis::TOOLHEAD)] = TOOLHEAD_HOMING;
+    p.carriageStepsPerMM = CarriageAxis::stepsPerMM();
+    p.mandrelStepsPerRev = MandrelAxis::stepsPerRev();
+    p.homeDistanceSteps[static_cast<uint8_t>(HomeAxis::CARRIAGE)] = carriageHome;
+    p.homeDistanceSteps[static_cast<uint8_t>(HomeAxis::TOOLARM)]  = toolarmHome;
+    p.homeDistanceSteps[static_cast<uint8_t>(HomeAxis::TOOLHEAD)] = toolheadHome;
+    p.loopUs             = 0;
+    p.toolheadMaxSpeed   = DEFAULT_TOOLHEAD_MAX_SPEED;
+    p.toolheadAccel      = DEFAULT_TOOLHEAD_ACCEL;
+    p.overlapFlip        = true;
+    p.toolarmStepsPerMM  = ToolarmAxis::stepsPerMM();
+    p.toolarmMaxSpeed    = DEFAULT_TOOLARM_MAX_SPEED;
+    p.toolarmAccel       = DEFAULT_TOOLARM_ACCEL;
+    p.mandrelAccel       = DEFAULT_MANDREL_ACCEL;
+    p.toolarmLookAhead   = true;
+    return p;
+}
+
+float Estimate::homing(const HomingConfig& config, long distanceSteps, uint32_t loopUs) {
+    const float d = distanceSteps < 0 ? -distanceSteps : distanceSteps;
+    const float a = config.acceleration;
+    const float v = 1000000.0f / stepIntervalUs(config.fastSpeed, loopUs);
+
+    // The loop sees the switch a debounce window (and half a timer tick)
+    // after it closes; the axis keeps going meanwhile.
+    const float latency = (INPUT_DEBOUNCE_US + INPUT_SCAN_US / 2) * 1e-6f;
+
+    // Seek: accelerate, then cruise if the switch is far enough away; it
+    // triggers at speed vHit and the axis brakes past it.
+    float seek, vHit;
+    if (d >= v * v / (2.0f * a)) {
+        vHit = v;
+        seek = v / a + (d - v * v / (2.0f * a)) / v;
+    } else {
+        vHit = sqrtf(2.0f * a * d);
+        seek = vHit / a;
+    }
+    seek += latency;
+    const float brake = vHit / a;
+
+    // Back-off: a positioned move over the overtravel plus the clearance.
+    const float back    = vHit * latency + vHit * vHit / (2.0f * a) + config.backoffSteps;
+    const float backOff = moveSeconds(back, v, a);
+
+    // Approach: the clearance at the slow speed.
+    const float approach = config.backoffSteps * stepIntervalUs(config.slowSpeed, loopUs) * 1e-6f + latency;
+
+    return seek + brake + backOff + approach;
+}
+
+float Estimate::zeroing(const EstimateParams& params) {
+    // An axis waits only for axes before it, so one pass in order finds
+    // when each finishes.
+    float done[HOMED_AXES];
+    float last = 0.0f;
+    for (uint8_t i = 0; i < HOMED_AXES; i++) {
+        float start = 0.0f;
+        for (uint8_t j = 0; j < i; j++) {
+            if ((params.homing[i].after & (1u << j)) && done[j] > start) start = done[j];
+        }
+        done[i] = start + homing(params.homing[i], params.homeDistanceSteps[i], params.loopUs);
+        if (done[i] > last) last = done[i];
+    }
+    return last;
+}
+
+long Estimate::toolheadSteps(const Layer& layer, bool forward) {
+    return lroundf(ToolheadAxis::toSteps(TOOLHEAD_SQUARE_DEG + (forward ? layer.getAngle() : -layer.getAngle())));
+}
+
+float Estimate::positioning(const Layer& first, const EstimateParams& params, const SplineProfile* mandrel) {
+    const long  steps    = toolheadSteps(first, true);   // A layer's first pass is forward.
+    const float toolhead = moveSeconds(steps < 0 ? -steps : steps, params.toolheadMaxSpeed, params.toolheadAccel);
+    if (!mandrel || !mandrel->isReady()) return toolhead;
+
+    // The toolarm from its switch to the surface under the carriage at home.
+    const float arm = mandrel->getTarget(0.0f) * params.toolarmStepsPerMM;
+    const float toolarm = moveSeconds(arm < 0.0f ? -arm : arm, params.toolarmMaxSpeed, params.toolarmAccel);
+    return toolarm > toolhead ? toolarm : toolhead;
+}
+
+FlipTiming Estimate::turnaroundFlip(const Layer& layer, const EstimateParams& params) {
+    const float manUs = stepIntervalUs(params.mandrelSpeed, params.loopUs);
+    const float v     = passSpeed(layer, manUs, params);
+    const long  dwell = static_cast<long>((layer.getTurnaroundDegrees() / 360.0f) * params.mandrelStepsPerRev);
+    if (v <= 0.0f || params.carriageAccel <= 0.0f) return FlipTiming();
+
+    // At speed into the endpoint: the lead is covered at v.
+    const float window = v / params.carriageAccel;
+    FlipTiming  t      = flip(toolheadSteps(layer, false) - toolheadSteps(layer, true),
+                              dwell * manUs * 1e-6f, window, window, params);
+    t.leadSteps = lroundf(v * t.leadSeconds);
+    return t;
+}
+
+FlipTiming Estimate::handOverFlip(const Layer& layer, const Layer& next, const EstimateParams& params) {
+    const float manUs = stepIntervalUs(params.mandrelSpeed, params.loopUs);
+    const float v     = passSpeed(layer, manUs, params);
+    const float vNext = passSpeed(next, manUs, params);
+    const long  dwell = static_cast<long>((layer.getDwell() / 360.0f) * params.mandrelStepsPerRev);
+    if (v <= 0.0f || vNext <= 0.0f || params.carriageAccel <= 0.0f) return FlipTiming();
+
+    // From the orientation of the layer's last pass to the next layer's
+    // first (forward); braking into the endpoint, the lead is covered
+    // decelerating.
+    const bool lastForward = (layer.getTotalPasses() % 2) == 1;
+    FlipTiming t = flip(toolheadSteps(next, true) - toolheadSteps(layer, lastForward),
+                        dwell * manUs * 1e-6f, v / params.carriageAccel, vNext / params.carriageAccel, params);
+    t.leadSteps = lroundf(0.5f * params.carriageAccel * t.leadSeconds * t.leadSeconds);
+    return t;
+}
+
+float Estimate::handOverEndMM(const Layer& layer, const EstimateParams& params, const SplineProfile* mandrel) {
+    const bool  lastForward = (layer.getTotalPasses() % 2) == 1;
+    const float end         = lastForward ? layer.getOffset() + layer.getLength() : layer.getOffset();
+    const float v           = passSpeed(layer, stepIntervalUs(params.mandrelSpeed, params.loopUs), params);
+    if ((mandrel && mandrel->isReady()) || v <= 0.0f || params.carriageAccel <= 0.0f ||
+        params.carriageStepsPerMM <= 0.0f) {
+        return end;
+    }
+
+    // Brake past the end, not into it, as far as the travel allows.
+    const float brake = v * v / (2.0f * params.carriageAccel) / params.carriageStepsPerMM;
+    return lastForward ? fminf(end + brake, CARRIAGE_TRAVEL_MM) : fmaxf(end - brake, 0.0f);
+}
+
+float Estimate::passDegrees(const Layer& layer, const EstimateParams& params) {
+    const float ratio = layer.getStepRatio(params.carriageStepsPerMM, params.mandrelStepsPerRev);
+    const float manUs = stepIntervalUs(params.mandrelSpeed, params.loopUs);
+    if (ratio <= 0.0f || manUs <= 0.0f || params.carriageAccel <= 0.0f) return 0.0f;
+
+    const Following f      = following(ratio, manUs, params);
+    const float     travel = layer.getLength() * params.carriageStepsPerMM;
+
+    float mandrelSteps;
+    if (f.geared <= params.carriageMaxSpeed) {
+        mandrelSteps = travel / ratio;
+    } else {
+        mandrelSteps = (travel / f.v + f.v / (2.0f * params.carriageAccel)) * 1000000.0f / manUs;
+    }
+    return mandrelSteps / params.mandrelStepsPerRev * 360.0f;
+}
+
+LayerEstimate Estimate::layer(const Layer& source, const EstimateParams& params,
+                              float startMM, const Layer* next, const SplineProfile* mandrel) {
+    LayerEstimate est;
+    est.endMM = startMM;
+
+    Layer layer = source;   // Walk a copy so the caller's progress is untouched.
+    layer.resetProgress();
+    est.passes = layer.getTotalPasses();
+
+    const float ratio = layer.getStepRatio(params.carriageStepsPerMM, params.mandrelStepsPerRev);
+    const float manUs = stepIntervalUs(params.mandrelSpeed, params.loopUs);
+    if (ratio <= 0.0f || manUs <= 0.0f || params.carriageAccel <= 0.0f) return est;
+
+    const Following f      = following(ratio, manUs, params);
+    const float     geared = f.geared;
+    const float     v      = f.v;
+
+    const float totalDeg   = layer.getTurnaroundDegrees();
+    const long  dwellSteps = static_cast<long>((totalDeg / 360.0f) * params.mandrelStepsPerRev);
+    const long  handSteps  = static_cast<long>((layer.getDwell() / 360.0f) * params.mandrelStepsPerRev);
+
+    // The toolhead flips at every turn-around but the job's last.
+    const FlipTiming turn = turnaroundFlip(layer, params);
+    const FlipTiming hand = next ? handOverFlip(layer, *next, params) : FlipTiming();
+
+    // On a profiled mandrel the carriage is geared to the surface, and where
+    // the toolarm cannot keep up the mandrel slows (toolarm_plan.h): a full
+    // pass takes arm.gearSeconds + arm.extraSeconds longer, the way in from
+    // home arm.approachSeconds, and a dwell ramps from the speed of its end.
+    const ToolarmSummary arm      = mandrel ? ToolarmPlan::summarize(layer, *mandrel, params) : ToolarmSummary();
+    const float          zone     = layer.getLength() * params.carriageStepsPerMM;
+    const float          approach = layer.getOffset() * params.carriageStepsPerMM;
+
+    // Every pass starts from rest: zeroing, a turn-around, or the previous
+    // layer's last pass decelerating past its end (see Winding::update()).
+    // Decelerating into a hand-over takes v / 2a longer than the geared
+    // command, which stops there at full speed.
+    float pos = startMM;
+    while (!layer.isDone()) {
+        const bool  last     = layer.getPassesCompleted() == est.passes - 1;
+        const bool  handOver = next && last;
+        const float target   = handOver ? handOverEndMM(layer, params, mandrel) : layer.getTargetEndpoint();
+        float travel = (target - pos) * params.carriageStepsPerMM;
+        if (travel < 0.0f) travel = -travel;
+
+        const float to       = layer.isGoingForward() ? arm.endSpeed : arm.startSpeed;
+
+        if (geared <= params.carriageMaxSpeed) {
+            est.windSeconds += (travel / ratio) * manUs * 1e-6f;
+            if (handOver) est.windSeconds += v / (2.0f * params.carriageAccel);
+        } else {
+            // Carriage-limited: accelerate to max speed, then cruise (and
+            // decelerate into a hand-over).
+            est.windSeconds += travel / v + v / (2.0f * params.carriageAccel);
+            if (handOver) est.windSeconds += v / (2.0f * params.carriageAccel);
+        }
+        if (zone > 0.0f) {
+            const float inside = travel < zone ? travel : zone;
+            est.windSeconds += (arm.gearSeconds + arm.extraSeconds) * inside / zone;
+            if (travel > inside && approach > 0.0f) {
+                est.windSeconds += arm.approachSeconds * fminf(1.0f, (travel - inside) / approach);
+            }
+        }
+        // A pattern's closing turn-around lands the circuit on its slot, so
+        // it takes up what gearing to the surface added to the circuit's two
+        // passes.  The flip waits out what the dwell then leaves uncovered,
+        // its lead steps run at the speed the pass ends on.
+        const FlipTiming& f     = handOver ? hand : turn;
+        const float       top   = 1000000.0f / manUs;
+        long              steps = handOver ? handSteps : dwellSteps;
+        float             wait  = f.waitSeconds;
+        if (!handOver && layer.hasPattern() && !layer.isGoingForward() && arm.gearSeconds != 0.0f) {
+            steps -= lroundf(2.0f * arm.gearSeconds * top);
+            if (steps < 0) steps = 0;
+        }
+        const float dwell = (to < 1.0f && params.mandrelAccel > 0.0f)
+                              ? rampedSeconds(steps, to * top, top, params.mandrelAccel)
+                              : steps * manUs * 1e-6f;
+        if (steps != (handOver ? handSteps : dwellSteps) || to < 1.0f) {
+            const float end  = fminf(geared * to, params.carriageMaxSpeed);
+            const float lead = fmaxf(f.leadSeconds, end > 0.0f ? f.leadSteps / end : 0.0f);
+            wait = fmaxf(0.0f, f.seconds - lead - f.lagSeconds - dwell);
+        }
+        est.dwellSeconds += dwell;
+        if (!last || handOver) est.flipSeconds += wait;
+
+        pos = target;
+        layer.countPass();
+    }
+
+    est.endMM             = pos;
+    est.totalSeconds      = est.windSeconds + est.dwellSeconds + est.flipSeconds;
+    est.sequentialSeconds = est.totalSeconds;
+
+    if (source.hasPattern()) {
+        Layer banded = source;
+        banded.clearPattern();
+        est.sequentialSeconds = Estimate::layer(banded, params, startMM, next, mandrel).totalSeconds;
+    }
+    return est;
+}
+
+JobEstimate Estimate::job(const WindProfile& profile, const EstimateParams& params) {
+    JobEstimate job;
+    if (!profile.isValid()) return job;
+    for (uint8_t i = 0; i < HOMED_AXES; i++) {
+        const HomingConfig& h = params.homing[i];
+        if (h.fastSpeed <= 0.0f || h.acceleration <= 0.0f || h.slowSpeed <= 0.0f) return job;
+    }
+
+    const SplineProfile* mandrel = profile.mandrelProfile.isReady() ? &profile.mandrelProfile : nullptr;
+    job.zeroingSeconds    = zeroing(params) + positioning(profile.layers[0], params, mandrel);
+    job.totalSeconds      = job.zeroingSeconds;
+    job.sequentialSeconds = job.zeroingSeconds;
+    job.layerCount        = profile.layerCount;
+
+    float pos = 0.0f;   // Zeroing leaves the carriage at home.
+    for (int i = 0; i < profile.layerCount; i++) {
+        job.layers[i]          = layer(profile.layers[i], params, pos,
+                                       i < profile.layerCount - 1 ? &profile.layers[i + 1] : nullptr, mandrel);
+        pos                    = job.layers[i].endMM;
+        job.totalSeconds      += job.layers[i].totalSeconds;
+        job.sequentialSeconds += job.layers[i].sequentialSeconds;
+    }
+
+    job.valid = true;
+    return job;
+}
@@ -0,0 +1,25 @@
+/// @file gear_table.cpp
+/// @brief GearTable construction.
+
+#include "gear_table.h"
+
+void GearTable::build(const Layer& layer, const SplineProfile& mandrel,
+                      float carriageStepsPerMM, float mandrelStepsPerRev) {
+    const float startMM   = layer.getOffset();
+    const float lengthMM  = layer.getLength();
+    const float nominal   = layer.getStepRatio(carriageStepsPerMM, mandrelStepsPerRev);
+    const float nominalR  = layer.getDiameter() * 0.5f;
+
+    startStep_  = static_cast<long>(startMM * carriageStepsPerMM);
+    invSpacing_ = (lengthMM > 0.0f)
+                      ? (GEAR_TABLE_SIZE - 1) / (lengthMM * carriageStepsPerMM)
+                      : 0.0f;
+
+    // The ratio is proportional to the radius (travel per rev = 2πr / tan α),
+    // so scale the layer's nominal ratio by r / r_nominal.
+    for (int i = 0; i < GEAR_TABLE_SIZE; i++) {
+        float x = startMM + lengthMM * i / (GEAR_TABLE_SIZE - 1);
+        float r = mandrel.isReady() ? mandrel.getRadius(x) : nominalR;
+        ratio_[i] = (nominalR > 0.0f) ? nominal * (r / nominalR) : 0.0f;
+    }
+}
@@ -0,0 +1,217 @@
+/// @file inputs.cpp
+/// @brief Debounced input subsystem implementation.
+
+#include <Arduino.h>
+#include <atomic>
+
+#include "inputs.h"
+#include "config.h"
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <soc/gpio_struct.h>
+#endif
+
+// ============================================================================
+//  Internal (file-scoped) State
+// ============================================================================
+
+// Pin and active level per Input.
+struct InputPin {
+    uint8_t pin;
+    bool    activeHigh;
+};
+
+static const InputPin s_pins[INPUT_COUNT] = {
+    { CARRIAGE_LIMIT_PIN, false },
+    { TOOLARM_LIMIT_PIN,  false },
+    { TOOLHEAD_LIMIT_PIN, false },
+    { E_STOP_PIN,         true  },   // Normally closed to GND: open (HIGH) stops.
+};
+
+// Debounce window per input, shared by the edge interrupt (opens it) and
+// the timer interrupt (closes it).  Both run on the loop's core at the same
+// interrupt level, so they never interleave.
+static volatile bool     s_pending[INPUT_COUNT] = {};
+static volatile uint32_t s_edgeUs[INPUT_COUNT]  = {};
+static volatile long     s_edgePos[INPUT_COUNT] = {};
+
+// Position sources, and the position behind each input's current state
+// (written by the timer interrupt before it publishes the state).
+static long (*volatile s_positionOf[INPUT_COUNT])() = {};
+static volatile long   s_latchedPos[INPUT_COUNT]    = {};
+
+// Word-sized so the interrupts' read-modify-writes are single S32C1I
+// instructions on the ESP32: 8-bit atomics go through libatomic's helpers,
+// which are not guaranteed to be in IRAM or free of locks.
+static std::atomic<uint32_t> s_active{ 0 };        // Debounced state, bit per Input.
+static std::atomic<uint32_t> s_eStop{ 0 };         // Set on the first E-stop edge.
+static void (*volatile s_eStopAction)() = nullptr;
+
+// Event ring: the timer interrupt produces, poll() consumes.
+static InputEvent            s_events[INPUT_EVENT_CAPACITY];
+static std::atomic<uint32_t> s_head{ 0 };
+static std::atomic<uint32_t> s_tail{ 0 };
+static std::atomic<uint32_t> s_overflows{ 0 };
+
+static_assert(ATOMIC_INT_LOCK_FREE == 2, "the interrupts need lock-free 32-bit atomics");
+static_assert((INPUT_EVENT_CAPACITY & (INPUT_EVENT_CAPACITY - 1)) == 0,
+              "INPUT_EVENT_CAPACITY must be a power of two");
+static_assert(INPUT_SCAN_US > 0 && INPUT_SCAN_US <= INPUT_DEBOUNCE_US,
+              "the debounce timer must tick at least once per debounce window");
+
+// ============================================================================
+//  Interrupts
+// ============================================================================
+
+// Line level without the Arduino layer (a register read on the ESP32).
+static inline bool IRAM_ATTR readActive(uint8_t i) {
+    const uint8_t pin = s_pins[i].pin;
+#if defined(ARDUINO_ARCH_ESP32)
+    const bool high = pin < 32 ? (GPIO.in >> pin) & 1 : (GPIO.in1.val >> (pin - 32)) & 1;
+#else
+    const bool high = digitalRead(pin) == HIGH;
+#endif
+    return high == s_pins[i].activeHigh;
+}
+
+// Any edge: open the debounce window.  The E-stop acts at once.
+static void IRAM_ATTR onEdge(void* arg) {
+    const uint8_t i = static_cast<uint8_t>(reinterpret_cast<uintptr_t>(arg));
+    if (!s_pending[i]) {
+        long (*position)() = s_positionOf[i];
+        s_edgePos[i] = position ? position() : 0;
+        s_edgeUs[i]  = micros();
+        s_pending[i] = true;
+    }
+    if (i == static_cast<uint8_t>(Input::E_STOP) && readActive(i) &&
+        !s_eStop.exchange(1, std::memory_order_acq_rel)) {
+        void (*action)() = s_eStopAction;
+        if (action) action();
+    }
+}
+
+// Debounce timer tick: close every window that has run its length.
+static void IRAM_ATTR onScan() {
+    const uint32_t now = micros();
+    for (uint8_t i = 0; i < INPUT_COUNT; i++) {
+        if (!s_pending[i] || now - s_edgeUs[i] < INPUT_DEBOUNCE_US) continue;
+        s_pending[i] = false;
+
+        const uint32_t bit    = 1u << i;
+        const bool     active = readActive(i);
+        if (active == ((s_active.load(std::memory_order_relaxed) & bit) != 0)) continue;   // A glitch.
+        s_latchedPos[i] = s_edgePos[i];
+        if (active) s_active.fetch_or(bit, std::memory_order_release);
+        else        s_active.fetch_and(~bit, std::memory_order_release);
+
+        const uint32_t head = s_head.load(std::memory_order_relaxed);
+        if (head - s_tail.load(std::memory_order_acquire) >= INPUT_EVENT_CAPACITY) {
+            s_overflows.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        InputEvent& e = s_events[head & (INPUT_EVENT_CAPACITY - 1)];
+        e.input    = static_cast<Input>(i);
+        e.active   = active;
+        e.edgeUs   = s_edgeUs[i];
+        e.latchUs  = now;
+        e.position = s_edgePos[i];
+        s_head.store(head + 1, std::memory_order_release);
+    }
+}
+
+// ============================================================================
+//  Debounce Timer
+// ============================================================================
+
+#if defined(ARDUINO_ARCH_ESP32)
+
+static hw_timer_t* s_timer = nullptr;
+
+static void startScanTimer() {
+    if (s_timer) return;
+#if defined(ESP_ARDUINO_VERSION_MAJOR) && ESP_ARDUINO_VERSION_MAJOR >= 3
+    s_timer = timerBegin(1000000);               // 1 MHz: alarm in µs.
+    timerAttachInterrupt(s_timer, &onScan);
+    timerAlarm(s_timer, INPUT_SCAN_US, true, 0);
+#else
+    s_timer = timerBegin(0, 80, true);           // 80 MHz APB / 80: 1 µs ticks.
+    timerAttachInterrupt(s_timer, &onScan, true);
+    timerAlarmWrite(s_timer, INPUT_SCAN_US, true);
+    timerAlarmEnable(s_timer);
+#endif
+}
+
+#else   // Host: the Arduino stand-in ticks it from virtual time.
+
+static void startScanTimer() {
+    hostAttachTimer(onScan, INPUT_SCAN_US);
+}
+
+#endif
+
+// ============================================================================
+//  Public API
+// ============================================================================
+
+void Inputs::init() {
+    uint32_t active = 0;
+    for (uint8_t i = 0; i < INPUT_COUNT; i++) {
+        detachInterrupt(digitalPinToInterrupt(s_pins[i].pin));
+        pinMode(s_pins[i].pin, INPUT_PULLUP);
+        s_pending[i]    = false;
+        s_latchedPos[i] = s_positionOf[i] ? s_positionOf[i]() : 0;
+        if (readActive(i)) active |= 1u << i;
+    }
+    s_active.store(active);
+    s_tail.store(s_head.load());
+    s_overflows.store(0);
+
+    // Pressed at start-up: latched and acted on as if it had just been hit.
+    const bool eStop = (active >> static_cast<uint8_t>(Input::E_STOP)) & 1;
+    s_eStop.store(eStop ? 1 : 0);
+    if (eStop && s_eStopAction) s_eStopAction();
+
+    for (uint8_t i = 0; i < INPUT_COUNT; i++) {
+        attachInterruptArg(digitalPinToInterrupt(s_pins[i].pin), onEdge,
+                           reinterpret_cast<void*>(static_cast<uintptr_t>(i)), CHANGE);
+    }
+    startScanTimer();
+}
+
+bool Inputs::active(Input input) {
+    return (s_active.load(std::memory_order_acquire) >> static_cast<uint8_t>(input)) & 1;
+}
+
+void Inputs::setPositionSource(Input input, long (*position)()) {
+    s_positionOf[static_cast<uint8_t>(input)] = position;
+}
+
+long Inputs::edgePosition(Input input) {
+    return s_latchedPos[static_cast<uint8_t>(input)];
+}
+
+bool Inputs::poll(InputEvent& event) {
+    const uint32_t tail = s_tail.load(std::memory_order_relaxed);
+    if (tail == s_head.load(std::memory_order_acquire)) return false;
+    event = s_events[tail & (INPUT_EVENT_CAPACITY - 1)];
+    s_tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+uint32_t Inputs::overflows() {
+    return s_overflows.load(std::memory_order_relaxed);
+}
+
+void Inputs::setEStopAction(void (*action)()) {
+    s_eStopAction = action;
+}
+
+bool Inputs::eStopLatched() {
+    return s_eStop.load(std::memory_order_acquire) != 0;
+}
+
+bool Inputs::clearEStop() {
+    if (active(Input::E_STOP)) return false;
+    s_eStop.store(0, std::memory_order_release);
+    return true;
+}
@@ -57,6 +57,10 @@ float Layer::getStepoverDegrees() const {
     return (stepover_ * 360.0f) / (circ * cos(rad));
 }
 
+float Layer::getTurnaroundDegrees() const {
+    return hasPattern() ? turnaroundDeg_ : dwell_ + getStepoverDegrees();
+}
+
 // Returns the carriage target position (mm from home) for the current pass.
 // Forward pass: target is the far end of the winding zone (offset + length).
 // Return pass:  target is the start of the winding zone (offset).
@@ -64,6 +68,20 @@ float Layer::getTargetEndpoint() const {
     return goingForward_ ? (offset_ + length_) : offset_;
 }
 
+// ============================================================================
+//  Winding Pattern
+// ============================================================================
+
+void Layer::setPattern(int circuits, int skip, float turnaroundDeg) {
+    if (circuits <= 0 || circuits * 2 != totalPasses_) {
+        clearPattern();
+        return;
+    }
+    patternCircuits_ = circuits;
+    patternSkip_     = skip;
+    turnaroundDeg_   = turnaroundDeg;
+}
+
 // ============================================================================
 //  Progress Tracking
 // ============================================================================
@@ -90,6 +108,8 @@ float Layer::clampAngle(float angle) {
 
 // Compute how many passes the carriage needs to fully cover the mandrel circumference.
 void Layer::recalcPasses() {
+    clearPattern();   // Geometry changed — the pattern no longer closes.
+
     if (diameter_ <= 0.0f || stepover_ <= 0.0f) {
         totalPasses_ = 0;
         return;
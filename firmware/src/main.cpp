@@ -16,13 +16,16 @@ void setup() {
 
     pinMode(LED_PIN, OUTPUT);
 
+    MemStat::init();
     initSteppers();
+    initDrivers();
+    printDrivers(Serial);
     Winding::init();
 
     Winding::start();
 
     Serial.println(F("=== Filament Winder Ready ==="));
-    Serial.println(F("Commands: profile, start, pause, resume, status, maxspeed, stop"));
+    Serial.println(F("Commands: profile, start, pause, resume, status, estimate, queue, mem, backlash, drivers, stalls, maxspeed, stop, trace, traceclear, tracesteps"));
 }
 
 void loop() {
@@ -32,6 +35,8 @@ void loop() {
         Winding::update();
     }
 
+    MemStat::poll();
+
     // ── Non-blocking LED blink ────────────────────────────────────────────
     unsigned long now = millis();
     if (now - lastLedToggle >= LED_BLINK_INTERVAL_MS) {
@@ -44,6 +49,8 @@ void loop() {
     if (Serial.available()) {
         String cmd = Serial.readStringUntil('\n');
         cmd.trim();
+        Trace::record(TraceEvent::SERIAL_CMD, static_cast<uint16_t>(cmd.length()),
+                      Trace::packCommand(cmd.c_str()));
 
         if (cmd == "start") {
             Winding::start();
@@ -63,7 +70,224 @@ void loop() {
             Serial.print(F("  Layer: "));
             Serial.print(Winding::getActiveLayerIndex());
             Serial.print(F("/"));
-            Serial.println(Winding::getProfile().layerCount);
+            Serial.print(Winding::getProfile().layerCount);
+            Serial.print(F("  Queued jobs: "));
+            Serial.println(Winding::getQueuedJobs());
+            Serial.print(F("Jobs (running + queued): "));
+            Serial.print(Winding::memoryBytes());
+            Serial.print(F(" bytes, "));
+            Serial.print(MAX_LAYERS);
+            Serial.println(F(" layers each"));
+            Serial.print(F("Layer plans: "));
+            Serial.print(Planner::handovers());
+            Serial.print(F(" handed over, "));
+            Serial.print(Planner::misses());
+            Serial.println(F(" not ready in time"));
+            if (Winding::getEstimate().valid) {
+                Serial.print(F("Elapsed: "));
+                Serial.print(Winding::getElapsedSeconds(), 0);
+                Serial.print(F(" s  Estimated: "));
+                Serial.print(Winding::getEstimate().totalSeconds, 0);
+                Serial.println(F(" s"));
+            }
+            const StallAlarm& stall = Winding::getStallAlarm();
+            if (stall.count) {
+                const char* axes[] = { "mandrel", "carriage", "toolarm", "toolhead" };
+                Serial.print(F("Last stall: "));
+                Serial.print(axes[stall.axis & 3]);
+                Serial.print(F(" in layer "));
+                Serial.print(stall.layer);
+                Serial.print(F(", pass "));
+                Serial.print(stall.pass);
+                Serial.print(F(" at "));
+                Serial.print(stall.seconds, 0);
+                Serial.print(F(" s (StallGuard "));
+                Serial.print(stall.result);
+                Serial.print(F("; "));
+                Serial.print(stall.count);
+                Serial.println(F(" since start-up)"));
+            }
+            MemStat::printSummary(Serial);
+
+        } else if (cmd == "queue") {
+            // Queue another run of the loaded profile behind the current job.
+            if (Winding::enqueue(Winding::getProfile())) {
+                Serial.print(F("Job queued ("));
+                Serial.print(Winding::getQueuedJobs());
+                Serial.println(F(" waiting)."));
+            } else {
+                Serial.println(F("Queue full or no valid profile loaded."));
+            }
+
+        } else if (cmd == "mem") {
+            // Per-task stacks, job peak and per-state memory peaks.
+            MemStat::report(Serial);
+            const SplineProfile& mp = Winding::getProfile().mandrelProfile;
+            Serial.print(F("Toolarm target table: "));
+            Serial.print(mp.getTableEntries());
+            Serial.print(F(" entries / pitch "));
+            Serial.print(mp.getTablePitch());
+            Serial.print(F(" steps, "));
+            Serial.print(mp.getTableBytes());
+            Serial.print(F(" of "));
+            Serial.print(SplineProfile::tableCapacityBytes());
+            Serial.println(F(" bytes"));
+            Serial.print(F("Layer plans: "));
+            Serial.print(Planner::memoryBytes());
+            Serial.print(F(" bytes ("));
+            Serial.print(PLANNER_SLOTS);
+            Serial.println(F(" buffers)"));
+            Serial.print(F("Carriage ramp table: "));
+            Serial.print(CarriageStepper::rampBytes());
+            Serial.println(F(" bytes"));
+            Serial.print(F("Toolarm / toolhead ramp tables: "));
+            Serial.print(ToolarmStepper::rampBytes() + ToolheadStepper::rampBytes());
+            Serial.println(F(" bytes"));
+
+        } else if (cmd == "estimate") {
+            // Per-layer breakdown of the estimate for the loaded profile.
+            // A job in progress (and the planner task building its layer
+            // plans) owns its patterns: show the estimate made at start.
+            WindProfile&       p       = Winding::getProfile();
+            const WindingState state   = Winding::getState();
+            const bool         running = state != WindingState::IDLE && state != WindingState::COMPLETE;
+            if (!p.isValid()) {
+                Serial.println(F("No valid profile loaded."));
+            } else {
+                EstimateParams params = Estimate::defaultParams(
+                    carriageStepper.currentPosition(), toolarmStepper.currentPosition(),
+                    toolheadStepper.currentPosition());
+                params.overlapFlip      = p.overlapToolheadFlip;
+                params.toolarmLookAhead = p.toolarmLookAhead;
+                JobEstimate est;
+                if (running) {
+                    est = Winding::getEstimate();
+                    Serial.println(F("Job in progress: estimate made at start."));
+                } else {
+                    p.planPatterns(params);
+                    est = Estimate::job(p, params);
+                }
+                Serial.print(F("Zeroing: "));
+                Serial.print(est.zeroingSeconds, 1);
+                Serial.println(F(" s"));
+                for (int i = 0; i < est.layerCount; i++) {
+                    const LayerEstimate& l = est.layers[i];
+                    Serial.print(F("Layer "));
+                    Serial.print(i);
+                    Serial.print(F(": "));
+                    Serial.print(l.passes);
+                    Serial.print(F(" passes, wind "));
+                    Serial.print(l.windSeconds, 1);
+                    Serial.print(F(" s, dwell "));
+                    Serial.print(l.dwellSeconds, 1);
+                    Serial.print(F(" s, total "));
+                    Serial.print(l.totalSeconds, 1);
+                    Serial.print(F(" s"));
+                    if (p.layers[i].hasPattern()) {
+                        Serial.print(F(", pattern "));
+                        Serial.print(p.layers[i].getPatternCircuits());
+                        Serial.print(F("/"));
+                        Serial.print(p.layers[i].getPatternSkip());
+                        Serial.print(F(" (band by band "));
+                        Serial.print(l.sequentialSeconds, 1);
+                        Serial.print(F(" s)"));
+                    }
+                    if (p.mandrelProfile.isReady()) {
+                        const ToolarmSummary arm = ToolarmPlan::summarize(p.layers[i], p.mandrelProfile, params);
+                        if (arm.minSpeed < 1.0f) {
+                            Serial.print(F(", toolarm slows the mandrel to "));
+                            Serial.print(100.0f * arm.minSpeed, 0);
+                            Serial.print(F(" % over "));
+                            Serial.print(100.0f * arm.slowedShare, 0);
+                            Serial.print(F(" % of the zone"));
+                        }
+                    }
+                    Serial.println();
+                }
+                Serial.print(F("Total: "));
+                Serial.print(est.totalSeconds, 1);
+                Serial.print(F(" s (band by band "));
+                Serial.print(est.sequentialSeconds, 1);
+                Serial.println(F(" s)"));
+            }
+
+        } else if (cmd == "backlash") {
+            Serial.print(F("Backlash: carriage "));
+            Serial.print(CarriageAxis::toMM(carriageStepper.backlash()), 3);
+            Serial.print(F(" mm, toolarm "));
+            Serial.print(ToolarmAxis::toMM(toolarmStepper.backlash()), 3);
+            Serial.print(F(" mm, toolhead "));
+            Serial.print(ToolheadAxis::toDegrees(toolheadStepper.backlash()), 2);
+            Serial.println(F(" deg"));
+
+        } else if (cmd == "backlash cal") {
+            Winding::calibrateBacklash();
+            Serial.println(F("Backlash is measured at the next homing (start)."));
+
+        } else if (cmd.startsWith("backlash ")) {
+            // backlash <carriage mm> <toolarm mm> <toolhead deg> — set the
+            // take-up by hand (with the axes at rest).
+            float carriage = 0.0f, toolarm = 0.0f, toolhead = 0.0f;
+            if (sscanf(cmd.c_str() + 9, "%f %f %f", &carriage, &toolarm, &toolhead) < 3) {
+                Serial.println(F("Usage: backlash [cal | <carriage mm> <toolarm mm> <toolhead deg>]"));
+            } else {
+                carriageStepper.setBacklash(lroundf(CarriageAxis::toSteps(carriage)), CARRIAGE_TAKE_UP_SPEED);
+                toolarmStepper.setBacklash(lroundf(ToolarmAxis::toSteps(toolarm)), TOOLARM_TAKE_UP_SPEED);
+                toolheadStepper.setBacklash(lroundf(ToolheadAxis::toSteps(toolhead)), TOOLHEAD_TAKE_UP_SPEED);
+                Serial.println(F("Backlash set."));
+            }
+
+        } else if (cmd == "drivers") {
+            printDrivers(Serial);
+
+        } else if (cmd.startsWith("drivers ")) {
+            // drivers <mandrel|carriage|toolarm|toolhead> <run mA> <hold %>
+            // <stealth|spread> — change a driver's current and chopper (with
+            // the axis at rest).
+            char axis[12] = "", mode[8] = "";
+            int  runMA = 0, hold = 0;
+            Tmc2209* driver = nullptr;
+            if (sscanf(cmd.c_str() + 8, "%11s %d %d %7s", axis, &runMA, &hold, mode) == 4) {
+                if      (!strcmp(axis, "mandrel"))  driver = &mandrelDriver;
+                else if (!strcmp(axis, "carriage")) driver = &carriageDriver;
+                else if (!strcmp(axis, "toolarm"))  driver = &toolarmDriver;
+                else if (!strcmp(axis, "toolhead")) driver = &toolheadDriver;
+            }
+            if (!driver || runMA <= 0 || hold < 0 || hold > 100 ||
+                (strcmp(mode, "stealth") && strcmp(mode, "spread"))) {
+                Serial.println(F("Usage: drivers [<mandrel|carriage|toolarm|toolhead> <run mA> <hold %> <stealth|spread>]"));
+            } else if (!driver->present()) {
+                Serial.println(F("That driver is not on the UART."));
+            } else {
+                driver->setCurrent(static_cast<uint16_t>(runMA), static_cast<uint8_t>(hold));
+                driver->setStealthChop(!strcmp(mode, "stealth"));
+                printDrivers(Serial);
+            }
+
+        } else if (cmd == "stalls") {
+            // StallGuard readings since the job started or resumed: the
+            // lowest against the stall level is the margin left for tuning
+            // the thresholds and speeds.
+            const StallMonitor& m      = Winding::getStallMonitor();
+            const char*         axes[] = { "mandrel", "carriage", "toolarm", "toolhead" };
+            for (uint8_t i = 0; i < m.axes(); i++) {
+                Serial.print(axes[i & 3]);
+                if (!m.watched(i)) {
+                    Serial.println(F(": not watched"));
+                    continue;
+                }
+                Serial.print(F(": stall at <= "));
+                Serial.print(m.driver(i).stallLevel());
+                Serial.print(F(" from "));
+                Serial.print(m.driver(i).stallMinSpeed(), 0);
+                Serial.print(F(" steps/s, last "));
+                Serial.print(m.lastResult(i));
+                Serial.print(F(", lowest "));
+                Serial.print(m.lowestResult(i));
+                Serial.print(F(" over "));
+                Serial.print(m.readings(i));
+                Serial.println(F(" readings"));
+            }
 
         } else if (cmd == "maxspeed") {
             maxSpeedMode = true;
@@ -75,13 +299,37 @@ void loop() {
             carriageStepper.setSpeed(0);
             Serial.println(F("Motors stopped"));
 
+        } else if (cmd == "trace") {
+            // Binary frame — capture with tools/trace2chrome.
+            Trace::dump(Serial);
+
+        } else if (cmd == "traceclear") {
+            Trace::clear();
+            Serial.println(F("Trace cleared"));
+
+        } else if (cmd == "tracesteps") {
+            // Toggle the high-rate step-burst / queue-level events.
+            const uint32_t stepBits = Trace::bit(TraceEvent::STEP_BURST) |
+                                      Trace::bit(TraceEvent::QUEUE_LEVEL);
+            Trace::setEventMask(Trace::getEventMask() ^ stepBits);
+            Serial.print(F("Step tracing "));
+            Serial.println((Trace::getEventMask() & stepBits) ? F("ON") : F("OFF"));
+
         } else if (cmd == "profile") {
             // Load a test profile — replace with real UI data in production.
-            WindProfile& p = Winding::getProfile();
-            p.clear();
-            p.mandrelDiameter = 50.0f;                           // 50 mm mandrel
-            p.addLayer(200.0f, 45.0f, 0.0f, 4.0f, 10.0f);       // Layer 0
-            Serial.println(F("Test profile loaded (50 mm dia, 1 layer @ 45 deg)."));
+            // A job in progress (and the planner task building its layer
+            // plans) winds from this profile: leave it alone until it ends.
+            const WindingState state = Winding::getState();
+            if (state != WindingState::IDLE && state != WindingState::COMPLETE) {
+                Serial.println(F("Job in progress: profile not loaded."));
+            } else {
+                WindProfile& p = Winding::getProfile();
+                p.clear();
+                p.mandrelDiameter = 50.0f;                           // 50 mm mandrel
+                p.addLayer(200.0f, 45.0f, 0.0f, 4.0f, 10.0f);       // Layer 0
+                Serial.println(F("Test profile loaded (50 mm dia, 1 layer @ 45 deg)."));
+            }
+
         }
     }
 }
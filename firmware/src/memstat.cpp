@@ -0,0 +1,236 @@
+/// @file memstat.cpp
+/// @brief Heap and stack high-water-mark instrumentation implementation.
+
+#include <Arduino.h>
+#include "memstat.h"
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <esp_heap_caps.h>
+#include <esp_idf_version.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#else
+#include "alloc_tracker.h"
+#endif
+
+// ============================================================================
+//  Internal (file-scoped) State
+// ============================================================================
+
+struct WatchedTask {
+    void*       handle;
+    const char* name;
+    uint32_t    minStackFree;   // Lowest high-water mark reported (bytes).
+};
+
+static WatchedTask   s_tasks[MEMSTAT_MAX_TASKS];
+static uint8_t       s_taskCount = 0;
+
+static MemoryPeak    s_jobPeak;
+static MemoryPeak    s_statePeaks[MEMSTAT_STATE_COUNT];
+static uint32_t      s_jobBaseline = 0;
+static WindingState  s_state       = WindingState::IDLE;
+static WindingState  s_windowState = WindingState::IDLE;   // State the open sampling window belongs to.
+static unsigned long s_lastSampleMs = 0;
+
+static const char* const STATE_NAMES[MEMSTAT_STATE_COUNT] = {
+    "IDLE", "PAUSED", "ZEROING", "WINDING", "DWELLING", "COMPLETE"
+};
+
+// ============================================================================
+//  Platform Readings
+// ============================================================================
+
+#if defined(ARDUINO_ARCH_ESP32)
+
+static uint32_t heapFree()     { return heap_caps_get_free_size(MALLOC_CAP_8BIT); }
+static uint32_t heapMinFree()  { return heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT); }
+static uint32_t largestBlock() { return heap_caps_get_largest_free_block(MALLOC_CAP_8BIT); }
+
+// ESP-IDF's FreeRTOS reports the high-water mark in bytes.
+static uint32_t stackFree(void* handle) {
+    return uxTaskGetStackHighWaterMark(static_cast<TaskHandle_t>(handle));
+}
+
+static void* currentTask() { return xTaskGetCurrentTaskHandle(); }
+static void  sampleDone()  {}
+
+static void* idleTask(int core) {
+#if ESP_IDF_VERSION_MAJOR >= 5
+    return xTaskGetIdleTaskHandleForCore(core);
+#else
+    return xTaskGetIdleTaskHandleForCPU(core);
+#endif
+}
+
+#else   // Host: heap figures from the allocation tracker, no stacks.
+
+// Free heap at the worst point since the previous sample, so short-lived
+// allocations between samples still count.
+static uint32_t heapFree()         { return AllocTracker::heapFreeAtPeak(); }
+static uint32_t heapMinFree()      { return AllocTracker::heapMinFree(); }
+static uint32_t largestBlock()     { return AllocTracker::heapFreeAtPeak(); }
+static uint32_t stackFree(void*)   { return 0; }
+static void*    currentTask()      { return nullptr; }
+static void*    idleTask(int)      { return nullptr; }
+static void     sampleDone()       { AllocTracker::resetPeak(); }
+
+#endif
+
+// ============================================================================
+//  Internal Helpers
+// ============================================================================
+
+// States in which loop() drives the axes: no heap walks but at a change.
+static bool isMoving(WindingState state) {
+    return state == WindingState::ZEROING || state == WindingState::WINDING ||
+           state == WindingState::DWELLING;
+}
+
+static void fold(MemoryPeak& peak, const MemorySnapshot& s, uint32_t minStack) {
+    peak.samples++;
+    if (s.heapFree < peak.minHeapFree)          peak.minHeapFree      = s.heapFree;
+    if (s.largestBlock < peak.minLargestBlock)  peak.minLargestBlock  = s.largestBlock;
+    if (s.fragmentation > peak.maxFragmentation) peak.maxFragmentation = s.fragmentation;
+    if (minStack && minStack < peak.minStackFree) peak.minStackFree   = minStack;
+}
+
+static void printPeak(Print& out, const MemoryPeak& p) {
+    if (p.samples == 0) {
+        out.println(F("no samples"));
+        return;
+    }
+    out.print(F("min free "));
+    out.print(p.minHeapFree);
+    out.print(F("  used "));
+    out.print(s_jobBaseline > p.minHeapFree ? s_jobBaseline - p.minHeapFree : 0UL);
+    out.print(F("  min largest "));
+    out.print(p.minLargestBlock);
+    out.print(F("  max frag "));
+    out.print(p.maxFragmentation);
+    out.print(F("%  min stack "));
+    if (p.minStackFree == UINT32_MAX) out.println(F("n/a"));
+    else                              out.println(p.minStackFree);
+}
+
+// ============================================================================
+//  Instrumentation API
+// ============================================================================
+
+void MemStat::init() {
+    s_taskCount = 0;
+    registerTask(currentTask(), "loop");
+    registerTask(idleTask(0), "IDLE0");
+    registerTask(idleTask(1), "IDLE1");
+    beginJob();
+}
+
+bool MemStat::registerTask(void* handle, const char* name) {
+    if (!handle || s_taskCount >= MEMSTAT_MAX_TASKS) return false;
+    s_tasks[s_taskCount++] = { handle, name, UINT32_MAX };
+    return true;
+}
+
+MemorySnapshot MemStat::sample() {
+    MemorySnapshot s;
+    s.heapFree     = heapFree();
+    s.heapMinFree  = heapMinFree();
+    s.largestBlock = largestBlock();
+    s.fragmentation = (s.heapFree > 0 && s.largestBlock < s.heapFree)
+                          ? static_cast<uint8_t>(100 - (100ULL * s.largestBlock) / s.heapFree)
+                          : 0;
+    s.stackFree = stackFree(currentTask());
+
+    uint32_t minStack = 0;
+    for (uint8_t i = 0; i < s_taskCount; i++) {
+        uint32_t hwm = stackFree(s_tasks[i].handle);
+        if (hwm < s_tasks[i].minStackFree)        s_tasks[i].minStackFree = hwm;
+        if (hwm && (minStack == 0 || hwm < minStack)) minStack = hwm;
+    }
+
+    fold(s_jobPeak, s, minStack);
+    fold(s_statePeaks[static_cast<uint8_t>(s_windowState)], s, minStack);
+    s_windowState  = s_state;
+    s_lastSampleMs = millis();
+    sampleDone();
+    return s;
+}
+
+void MemStat::poll() {
+    if (s_state != s_windowState) {
+        sample();   // Close the window of the state just left.
+    } else if (!isMoving(s_state) && millis() - s_lastSampleMs >= MEMSTAT_SAMPLE_INTERVAL_MS) {
+        sample();
+    }
+}
+
+void MemStat::beginJob() {
+    s_jobPeak = MemoryPeak();
+    for (uint8_t i = 0; i < MEMSTAT_STATE_COUNT; i++) s_statePeaks[i] = MemoryPeak();
+    sampleDone();   // Open the next sampling window at the current usage.
+    s_jobBaseline = heapFree();
+    sample();
+}
+
+void MemStat::setState(WindingState state) {
+    s_state = state;
+}
+
+uint32_t MemStat::jobBaseline() {
+    return s_jobBaseline;
+}
+
+uint32_t MemStat::jobPeakUsed() {
+    if (s_jobPeak.samples == 0 || s_jobPeak.minHeapFree >= s_jobBaseline) return 0;
+    return s_jobBaseline - s_jobPeak.minHeapFree;
+}
+
+const MemoryPeak& MemStat::jobPeak() {
+    return s_jobPeak;
+}
+
+const MemoryPeak& MemStat::statePeak(WindingState state) {
+    return s_statePeaks[static_cast<uint8_t>(state)];
+}
+
+void MemStat::printSummary(Print& out) {
+    MemorySnapshot s = sample();
+    out.print(F("Heap: free "));
+    out.print(s.heapFree);
+    out.print(F("  largest "));
+    out.print(s.largestBlock);
+    out.print(F("  frag "));
+    out.print(s.fragmentation);
+    out.print(F("%  min "));
+    out.print(s.heapMinFree);
+    out.print(F("  job peak "));
+    out.print(jobPeakUsed());
+    out.print(F("  stack "));
+    out.println(s.stackFree);
+}
+
+void MemStat::report(Print& out) {
+    printSummary(out);
+
+    for (uint8_t i = 0; i < s_taskCount; i++) {
+        out.print(F("Task "));
+        out.print(s_tasks[i].name);
+        out.print(F(": stack high-water "));
+        out.println(s_tasks[i].minStackFree);
+    }
+
+    out.print(F("Job (baseline "));
+    out.print(s_jobBaseline);
+    out.print(F(", budget "));
+    out.print(MEMSTAT_JOB_HEAP_BUDGET);
+    out.print(jobPeakUsed() > MEMSTAT_JOB_HEAP_BUDGET ? F(", OVER BUDGET): ") : F("): "));
+    printPeak(out, s_jobPeak);
+
+    for (uint8_t i = 0; i < MEMSTAT_STATE_COUNT; i++) {
+        if (s_statePeaks[i].samples == 0) continue;
+        out.print(F("  "));
+        out.print(STATE_NAMES[i]);
+        out.print(F(": "));
+        printPeak(out, s_statePeaks[i]);
+    }
+}
@@ -1,21 +1,33 @@
 // Include the motor control header
 #include "motor_control.h"
 
+#include "axis.h"
+#include "config.h"
+
 // Global stepper instances bound to their configured pins
-AccelStepper mandrelStepper(AccelStepper::DRIVER, MANDREL_MOTOR_PARAMS.step_pin, MANDREL_MOTOR_PARAMS.dir_pin);
-AccelStepper carriageStepper(AccelStepper::DRIVER, CARRIAGE_MOTOR_PARAMS.step_pin, CARRIAGE_MOTOR_PARAMS.dir_pin);
+MandrelStepper  mandrelStepper;
+CarriageStepper carriageStepper;
+ToolarmStepper  toolarmStepper;
+ToolheadStepper toolheadStepper;
+
+TmcBus  tmcBus(Serial2, TMC_UART_BAUD);
+Tmc2209 mandrelDriver(tmcBus, MANDREL_DRIVER_CONFIG, MANDREL_MOTOR_PARAMS.microsteps);
+Tmc2209 carriageDriver(tmcBus, CARRIAGE_DRIVER_CONFIG, CARRIAGE_MOTOR_PARAMS.microsteps);
+Tmc2209 toolarmDriver(tmcBus, TOOLARM_DRIVER_CONFIG, TOOLARM_MOTOR_PARAMS.microsteps);
+Tmc2209 toolheadDriver(tmcBus, TOOLHEAD_DRIVER_CONFIG, TOOLHEAD_MOTOR_PARAMS.microsteps);
 
 void initSteppers() {
     mandrelStepper.setCurrentPosition(0);
     carriageStepper.setCurrentPosition(0);
+    toolarmStepper.setCurrentPosition(0);
+    toolheadStepper.setCurrentPosition(0);
 
-    mandrelStepper.setPinsInverted(false, false, true); // Make EN pin active low
-    mandrelStepper.setEnablePin(MANDREL_MOTOR_PARAMS.enable_pin);
-    mandrelStepper.enableOutputs();
+    enableSteppers();
 
-    carriageStepper.setPinsInverted(false, false, true); // Make EN pin active low
-    carriageStepper.setEnablePin(CARRIAGE_MOTOR_PARAMS.enable_pin);
-    carriageStepper.enableOutputs();
+    // Backlash compensation as configured, until a homing measures it
+    carriageStepper.setBacklash(lroundf(CarriageAxis::toSteps(CARRIAGE_BACKLASH_MM)), CARRIAGE_TAKE_UP_SPEED);
+    toolarmStepper.setBacklash(lroundf(ToolarmAxis::toSteps(TOOLARM_BACKLASH_MM)), TOOLARM_TAKE_UP_SPEED);
+    toolheadStepper.setBacklash(lroundf(ToolheadAxis::toSteps(TOOLHEAD_BACKLASH_DEG)), TOOLHEAD_TAKE_UP_SPEED);
 
     mandrelStepper.setMaxSpeed(MANDREL_MOTOR_PARAMS.microStepsPerRev * 5);
     carriageStepper.setMaxSpeed(CARRIAGE_MOTOR_PARAMS.microStepsPerRev * 5);
@@ -25,6 +37,65 @@ void initSteppers() {
     carriageStepper.setSpeed(CARRIAGE_MOTOR_PARAMS.microStepsPerRev * 2);
 }
 
+uint8_t initDrivers() {
+    tmcBus.begin(TMC_UART_RX_PIN, TMC_UART_TX_PIN);
+
+    // Every axis back at its own resolution: a driver answering now starts
+    // there.
+    mandrelStepper.setStepShift(0);
+    carriageStepper.setStepShift(0);
+    toolarmStepper.setStepShift(0);
+    toolheadStepper.setStepShift(0);
+    return mandrelDriver.begin() + carriageDriver.begin() + toolarmDriver.begin() + toolheadDriver.begin();
+}
+
+static void printDriver(Print& out, const __FlashStringHelper* axis, Tmc2209& driver) {
+    out.print(axis);
+    if (!driver.present()) {
+        out.println(F(": strapped (not on the UART)"));
+        return;
+    }
+    const bool ok = driver.verify();
+    out.print(F(": address "));
+    out.print(driver.address());
+    out.print(F(", 1/"));
+    out.print(driver.microsteps());
+    out.print(F(" step, run "));
+    out.print(driver.runCurrentMA());
+    out.print(F(" mA, hold "));
+    out.print(driver.holdCurrentMA());
+    out.print(driver.stealthChop() ? F(" mA, StealthChop") : F(" mA, SpreadCycle"));
+    out.print(ok ? F(", verified") : F(", READ-BACK MISMATCH"));
+    if (driver.faults()) {
+        out.print(F(" ("));
+        out.print(driver.faults());
+        out.print(F(" faults)"));
+    }
+    out.println();
+}
+
+void printDrivers(Print& out) {
+    printDriver(out, F("Mandrel driver"), mandrelDriver);
+    printDriver(out, F("Carriage driver"), carriageDriver);
+    printDriver(out, F("Toolarm driver"), toolarmDriver);
+    printDriver(out, F("Toolhead driver"), toolheadDriver);
+}
+
+void enableSteppers() {
+    // EN is active low (StepDirStepper default)
+    mandrelStepper.enableOutputs();
+    carriageStepper.enableOutputs();
+    toolarmStepper.enableOutputs();
+    toolheadStepper.enableOutputs();
+}
+
+void IRAM_ATTR disableSteppers() {
+    mandrelStepper.disableOutputs();
+    carriageStepper.disableOutputs();
+    toolarmStepper.disableOutputs();
+    toolheadStepper.disableOutputs();
+}
+
 void runMotorsMaxSpeed() {
     mandrelStepper.setSpeed(MANDREL_MOTOR_PARAMS.microStepsPerRev * 2);
     carriageStepper.setSpeed(CARRIAGE_MOTOR_PARAMS.microStepsPerRev * 2);
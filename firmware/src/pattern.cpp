@@ -0,0 +1,100 @@
+/// @file pattern.cpp
+/// @brief Winding-pattern planner implementation.
+
+#include "pattern.h"
+
+#include <math.h>
+
+// ============================================================================
+//  Internal Helpers
+// ============================================================================
+
+static int gcd(int a, int b) {
+    while (b) {
+        int t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+// Wrap an angle into [0, 360).
+static float wrapDeg(float deg) {
+    float w = fmodf(deg, 360.0f);
+    return (w < 0.0f) ? w + 360.0f : w;
+}
+
+// ============================================================================
+//  Planner
+// ============================================================================
+
+WindPattern Pattern::plan(const Layer& layer, const EstimateParams& params) {
+    WindPattern p;
+    const int passes = layer.getTotalPasses();
+    if (passes < 2 || passes % 2 != 0) return p;
+
+    p.circuits = passes / 2;
+    p.slotDeg  = 360.0f / p.circuits;
+    p.passDeg  = Estimate::passDegrees(layer, params);
+
+    // Rotation a circuit makes on its own: two traverses and two dwells.
+    const float natural = 2.0f * (p.passDeg + layer.getDwell());
+
+    // A single circuit only has to close on itself (k = 0).
+    float best = wrapDeg(-natural);
+    for (int k = 1; k < p.circuits; k++) {
+        if (gcd(k, p.circuits) != 1) continue;
+        const float e = wrapDeg(k * p.slotDeg - natural);
+        if (p.skip == 0 || e < best) {
+            best   = e;
+            p.skip = k;
+        }
+    }
+
+    p.extraDeg      = best;
+    p.turnaroundDeg = layer.getDwell() + 0.5f * best;
+    p.dwellRevs     = passes * p.turnaroundDeg / 360.0f;
+    p.mandrelRevs   = passes * (p.passDeg + p.turnaroundDeg) / 360.0f;
+
+    const float bandTurnDeg = layer.getDwell() + layer.getStepoverDegrees();
+    p.bandDwellRevs   = passes * bandTurnDeg / 360.0f;
+    p.bandMandrelRevs = passes * (p.passDeg + bandTurnDeg) / 360.0f;
+
+    p.valid = true;
+    return p;
+}
+
+WindPattern Pattern::apply(Layer& layer, const EstimateParams& params) {
+    WindPattern p = plan(layer, params);
+    if (p.valid) layer.setPattern(p.circuits, p.skip, p.turnaroundDeg);
+    else         layer.clearPattern();
+    return p;
+}
+
+int Pattern::slot(const Layer& layer, int circuit) {
+    const int s = layer.getPatternCircuits();
+    if (s <= 0) return 0;
+    return static_cast<int>((static_cast<long>(circuit) * layer.getPatternSkip()) % s);
+}
+
+long Pattern::slotPhaseSteps(const Layer& layer, int circuit, long stepsPerRev) {
+    const int s = layer.getPatternCircuits();
+    if (s <= 0) return 0;
+    return static_cast<long>((static_cast<long long>(slot(layer, circuit)) * stepsPerRev) / s);
+}
+
+long Pattern::turnaroundSteps(const Layer& layer, long mandrelStep, long layerStartStep,
+                              float stepsPerRev) {
+    long steps = static_cast<long>((layer.getTurnaroundDegrees() / 360.0f) * stepsPerRev);
+    if (!layer.hasPattern() || layer.isGoingForward()) return steps;
+
+    // Closing a circuit: take the shortest correction onto the next slot.
+    const long rev   = lroundf(stepsPerRev);
+    const long slot  = slotPhaseSteps(layer, layer.getPassesCompleted() / 2 + 1, rev);
+    const long phase = (mandrelStep + steps - layerStartStep) % rev;
+    long err = (slot - phase) % rev;
+    if (err >= rev / 2) err -= rev;
+    if (err < -rev / 2) err += rev;
+    steps += err;
+    return (steps < 0) ? 0 : steps;
+}
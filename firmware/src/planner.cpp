@@ -0,0 +1,227 @@
+/// @file planner.cpp
+/// @brief Double-buffered layer plans and background worker implementation.
+
+#include <Arduino.h>
+#include <atomic>
+#include <math.h>
+
+#include "planner.h"
+#include "winding.h"
+#include "estimate.h"
+#include "trace.h"
+#include "memstat.h"
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#endif
+
+// ============================================================================
+//  Internal (file-scoped) State
+// ============================================================================
+
+enum SlotState : uint8_t {
+    SLOT_FREE,        // Nothing requested.
+    SLOT_REQUESTED,   // Request waiting for the worker.
+    SLOT_BUILDING,    // Claimed — the worker or a boundary is building it.
+    SLOT_READY        // Plan complete.
+};
+
+// One plan buffer and the request it is built for.  The request fields are
+// written before the state is published as REQUESTED and are only read by
+// whoever claimed it, so the state alone orders access.
+struct PlanSlot {
+    LayerPlan            plan;
+    std::atomic<uint8_t> state{ SLOT_FREE };
+    WindProfile*         profile = nullptr;
+    int                  layer   = -1;
+    JobEstimate*         prepare = nullptr;
+};
+
+static PlanSlot s_slots[PLANNER_SLOTS];
+static int      s_current   = 0;   // Buffer the active layer runs from.
+static uint32_t s_misses    = 0;
+static uint32_t s_handovers = 0;
+
+static_assert(PLANNER_SLOTS == 2, "the buffers alternate: the next plan is in slot 1 - s_current");
+
+// ============================================================================
+//  Worker Task
+// ============================================================================
+
+#if defined(ARDUINO_ARCH_ESP32)
+
+static TaskHandle_t s_task = nullptr;
+
+static void workerTask(void*) {
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        Planner::service();
+    }
+}
+
+// Core 0: the loop task and its step generation own core 1.
+static void startWorker() {
+    if (s_task) return;
+    xTaskCreatePinnedToCore(workerTask, "planner", PLANNER_TASK_STACK, nullptr,
+                            PLANNER_TASK_PRIORITY, &s_task, 0);
+    MemStat::registerTask(s_task, "planner");
+}
+
+static void wakeWorker() {
+    if (s_task) xTaskNotifyGive(s_task);
+}
+
+#else   // Host: the simulator calls Planner::service() itself.
+
+static void startWorker() {}
+static void wakeWorker()  {}
+
+#endif
+
+// ============================================================================
+//  Internal Helpers
+// ============================================================================
+
+static void buildPlan(LayerPlan& plan, const WindProfile& profile, int layer) {
+    EstimateParams params = Estimate::defaultParams();
+    params.overlapFlip      = profile.overlapToolheadFlip;
+    params.toolarmLookAhead = profile.toolarmLookAhead;
+    const Layer& l          = profile.layers[layer];
+
+    plan.profile = &profile;
+    plan.layer   = layer;
+    plan.gear.build(l, profile.mandrelProfile, params.carriageStepsPerMM, params.mandrelStepsPerRev);
+    plan.toolarm.build(l, profile.mandrelProfile, params);
+
+    // Round towards the winding zone so the endpoint test still fires.
+    plan.forwardEndStep = static_cast<long>(ceilf((l.getOffset() + l.getLength()) * params.carriageStepsPerMM));
+    plan.returnEndStep  = static_cast<long>(floorf(l.getOffset() * params.carriageStepsPerMM));
+    plan.handOverStep   = lroundf(Estimate::handOverEndMM(l, params, &profile.mandrelProfile) * params.carriageStepsPerMM);
+    plan.dwellSteps     = static_cast<long>((l.getDwell() / 360.0f) * params.mandrelStepsPerRev);
+    plan.phaseSteps     = lroundf(Estimate::passDegrees(l, params) / 360.0f * params.mandrelStepsPerRev);
+
+    // The last layer hands over only to a queued job, whose first layer is
+    // not known here: time that flip as if it were this layer again.
+    const Layer&     next = layer + 1 < profile.layerCount ? profile.layers[layer + 1] : l;
+    const FlipTiming turn = Estimate::turnaroundFlip(l, params);
+    const FlipTiming hand = Estimate::handOverFlip(l, next, params);
+    plan.flipLeadSteps    = turn.leadSteps;
+    plan.flipHoldSteps    = turn.holdSteps;
+    plan.handLeadSteps    = hand.leadSteps;
+    plan.handHoldSteps    = hand.holdSteps;
+}
+
+static void runRequest(PlanSlot& slot) {
+    if (slot.prepare) Winding::prepareJob(*slot.profile, *slot.prepare);
+    buildPlan(slot.plan, *slot.profile, slot.layer);
+}
+
+// Take a buffer back from the worker: withdraw a waiting request, or wait
+// for a build in progress to finish.
+static void release(PlanSlot& slot) {
+    for (;;) {
+        uint8_t state = slot.state.load();
+        if (state == SLOT_BUILDING) {
+            yield();
+            continue;
+        }
+        if (slot.state.compare_exchange_weak(state, SLOT_FREE)) break;
+    }
+    slot.profile = nullptr;
+    slot.layer   = -1;
+    slot.prepare = nullptr;
+}
+
+// ============================================================================
+//  Public API
+// ============================================================================
+
+void Planner::init() {
+    startWorker();
+    reset();
+}
+
+void Planner::reset() {
+    release(s_slots[0]);
+    release(s_slots[1]);
+    s_current   = 0;
+    s_misses    = 0;
+    s_handovers = 0;
+}
+
+const LayerPlan& Planner::prime(const WindProfile& profile, int layer) {
+    LayerPlan& plan = s_slots[s_current].plan;
+    buildPlan(plan, profile, layer);
+    return plan;
+}
+
+void Planner::request(WindProfile& profile, int layer, JobEstimate* prepare) {
+    PlanSlot& slot = s_slots[1 - s_current];
+    if (slot.profile == &profile && slot.layer == layer && slot.state.load() != SLOT_FREE) return;
+
+    release(slot);
+    slot.profile = &profile;
+    slot.layer   = layer;
+    slot.prepare = prepare;
+    slot.state.store(SLOT_REQUESTED);
+    wakeWorker();
+}
+
+const LayerPlan& Planner::acquire(WindProfile& profile, int layer, JobEstimate* prepare) {
+    const int  next      = 1 - s_current;
+    PlanSlot&  slot      = s_slots[next];
+    const bool requested = (slot.profile == &profile && slot.layer == layer);
+
+    if (!requested || slot.state.load() != SLOT_READY) {
+        s_misses++;
+        Trace::record(TraceEvent::PLAN_MISS, static_cast<uint16_t>(layer),
+                      static_cast<int32_t>(s_misses));
+
+        // Claim a request the worker has not started; otherwise let a build
+        // in progress finish and keep it if it is the one needed.
+        uint8_t    waiting = SLOT_REQUESTED;
+        const bool claimed = slot.state.compare_exchange_strong(waiting, SLOT_BUILDING);
+        if (!claimed) {
+            while (slot.state.load() == SLOT_BUILDING) yield();
+        }
+        if (claimed || !requested || slot.state.load() != SLOT_READY) {
+            if (!requested) slot.prepare = prepare;
+            slot.profile = &profile;
+            slot.layer   = layer;
+            runRequest(slot);
+        }
+        slot.state.store(SLOT_READY);
+    }
+
+    s_slots[s_current].state.store(SLOT_FREE);
+    s_current = next;
+    s_handovers++;
+    return slot.plan;
+}
+
+const LayerPlan& Planner::current() {
+    return s_slots[s_current].plan;
+}
+
+bool Planner::pending() {
+    return s_slots[0].state.load() == SLOT_REQUESTED ||
+           s_slots[1].state.load() == SLOT_REQUESTED;
+}
+
+void Planner::service() {
+    for (PlanSlot& slot : s_slots) {
+        uint8_t waiting = SLOT_REQUESTED;
+        if (!slot.state.compare_exchange_strong(waiting, SLOT_BUILDING)) continue;
+        runRequest(slot);
+        slot.state.store(SLOT_READY);
+    }
+}
+
+uint32_t Planner::misses() {
+    return s_misses;
+}
+
+uint32_t Planner::handovers() {
+    return s_handovers;
+}
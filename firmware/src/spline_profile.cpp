@@ -0,0 +1,135 @@
+/// @file spline_profile.cpp
+/// @brief SplineProfile implementation (natural cubic spline, as in the
+///        4-axis test scripts).
+
+#include "spline_profile.h"
+
+#include <math.h>
+
+void SplineProfile::clear() {
+    n_        = 0;
+    computed_ = false;
+    lutCount_ = 0;
+}
+
+bool SplineProfile::addPoint(float x, float r) {
+    if (n_ >= SPLINE_MAX_POINTS) return false;
+    if (n_ > 0 && x <= x_[n_ - 1]) return false;
+
+    x_[n_] = x;
+    a_[n_] = r;
+    n_++;
+    computed_ = false;
+    lutCount_ = 0;
+    return true;
+}
+
+void SplineProfile::compute() {
+    computed_ = false;
+    lutCount_ = 0;
+    if (n_ < 2) return;
+    const int n = n_ - 1;   // Number of segments.
+
+    float h[SPLINE_MAX_POINTS];
+    float alpha[SPLINE_MAX_POINTS];
+    float l[SPLINE_MAX_POINTS];
+    float mu[SPLINE_MAX_POINTS];
+    float z[SPLINE_MAX_POINTS];
+
+    for (int i = 0; i < n; i++) {
+        h[i] = x_[i + 1] - x_[i];
+    }
+    for (int i = 1; i < n; i++) {
+        alpha[i] = (3.0f / h[i]) * (a_[i + 1] - a_[i]) - (3.0f / h[i - 1]) * (a_[i] - a_[i - 1]);
+    }
+
+    l[0] = 1.0f; mu[0] = 0.0f; z[0] = 0.0f;
+    for (int i = 1; i < n; i++) {
+        l[i]  = 2.0f * (x_[i + 1] - x_[i - 1]) - h[i - 1] * mu[i - 1];
+        mu[i] = h[i] / l[i];
+        z[i]  = (alpha[i] - h[i - 1] * z[i - 1]) / l[i];
+    }
+
+    // Natural end conditions: zero curvature at both ends.
+    c_[n] = 0.0f;
+    for (int j = n - 1; j >= 0; j--) {
+        c_[j] = z[j] - mu[j] * c_[j + 1];
+        b_[j] = (a_[j + 1] - a_[j]) / h[j] - h[j] * (c_[j + 1] + 2.0f * c_[j]) / 3.0f;
+        d_[j] = (c_[j + 1] - c_[j]) / (3.0f * h[j]);
+    }
+    computed_ = true;
+}
+
+float SplineProfile::getRadius(float x) const {
+    if (n_ == 0) return 0.0f;
+    if (x <= x_[0] || n_ == 1) return a_[0];
+    if (x >= x_[n_ - 1])       return a_[n_ - 1];
+    if (!computed_)            return a_[0];
+
+    int   i  = segment(x);
+    float dx = x - x_[i];
+    return a_[i] + dx * (b_[i] + dx * (c_[i] + dx * d_[i]));
+}
+
+float SplineProfile::getSlope(float x) const {
+    if (!computed_ || x < x_[0] || x > x_[n_ - 1]) return 0.0f;
+
+    int   i  = segment(x);
+    float dx = x - x_[i];
+    return b_[i] + dx * (2.0f * c_[i] + 3.0f * dx * d_[i]);
+}
+
+float SplineProfile::getCurvature(float x) const {
+    if (!computed_ || x < x_[0] || x > x_[n_ - 1]) return 0.0f;
+
+    int   i  = segment(x);
+    float dx = x - x_[i];
+    return 2.0f * c_[i] + 6.0f * dx * d_[i];
+}
+
+int SplineProfile::segment(float x) const {
+    int i = 0;
+    while (i < n_ - 2 && x > x_[i + 1]) i++;
+    return i;
+}
+
+void SplineProfile::compute(float carriageStepsPerMM, float toolarmStepsPerMM) {
+    compute();
+    if (!computed_ || carriageStepsPerMM <= 0.0f || toolarmStepsPerMM <= 0.0f) return;
+
+    // Pitch: one toolarm step of change at the steepest slope, rounded down
+    // to a power of two carriage steps, then doubled until the range fits.
+    const long  startStep = static_cast<long>(x_[0] * carriageStepsPerMM);
+    const long  span      = static_cast<long>(x_[n_ - 1] * carriageStepsPerMM) - startStep;
+    const float slope     = maxSlope();
+    const float idealMM   = (slope > 0.0f) ? 1.0f / (toolarmStepsPerMM * slope) : x_[n_ - 1] - x_[0];
+    const long  ideal     = static_cast<long>(idealMM * carriageStepsPerMM);
+
+    uint8_t shift = 0;
+    while ((2L << shift) <= ideal && shift < 30) shift++;
+    while ((span >> shift) + 2 > SPLINE_LUT_SIZE) shift++;
+
+    lutStart_ = startStep;
+    lutShift_ = shift;
+    lutPitch_ = 1L << shift;
+    lutInvPitch_ = 1.0f / lutPitch_;
+    lutCount_ = static_cast<int>((span >> shift) + 2);   // Covers the end point.
+
+    for (int i = 0; i < lutCount_; i++) {
+        float x = (startStep + (static_cast<long>(i) << shift)) / carriageStepsPerMM;
+        lut_[i] = static_cast<int32_t>(lroundf(getTarget(x) * toolarmStepsPerMM));
+    }
+}
+
+float SplineProfile::maxSlope() const {
+    float worst = 0.0f;
+    for (int i = 0; i < n_ - 1; i++) {
+        const float h = x_[i + 1] - x_[i];
+        for (int k = 0; k <= 8; k++) {
+            float dx    = h * k / 8.0f;
+            float slope = fabsf(b_[i] + dx * (2.0f * c_[i] + 3.0f * dx * d_[i]));
+            if (slope > worst) worst = slope;
+        }
+    }
+    return worst;
+}
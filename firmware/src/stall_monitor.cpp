@@ -0,0 +1,82 @@
+/// @file stall_monitor.cpp
+/// @brief Round-robin StallGuard reads and stall confirmation.
+
+#include "stall_monitor.h"
+
+#include <math.h>
+
+#include "config.h"
+
+bool StallMonitor::add(Tmc2209& driver, float (*speed)()) {
+    if (count_ == MAX_AXES) return false;
+    axes_[count_]        = Axis();
+    axes_[count_].driver = &driver;
+    axes_[count_].speed  = speed;
+    count_++;
+    start();
+    return true;
+}
+
+void StallMonitor::start() {
+    for (uint8_t i = 0; i < count_; i++) {
+        axes_[i].last     = TmcReg::SG_RESULT_MAX;
+        axes_[i].lowest   = TmcReg::SG_RESULT_MAX;
+        axes_[i].readings = 0;
+        axes_[i].low      = 0;
+        axes_[i].moving   = false;
+    }
+    stalled_ = NO_AXIS;
+}
+
+bool StallMonitor::running(const Axis& axis) {
+    return axis.driver->watchesStalls() && fabsf(axis.speed()) >= axis.driver->stallMinSpeed();
+}
+
+bool StallMonitor::update() {
+    if (stalled_ != NO_AXIS) return true;
+
+    // The read in flight.
+    if (reading_ != NO_AXIS) {
+        Axis&          axis   = axes_[reading_];
+        uint16_t       result = 0;
+        const TmcReply reply  = axis.driver->stallGuardReply(result);
+        if (reply == TmcReply::PENDING) return false;
+
+        const uint8_t slot = reading_;
+        reading_ = NO_AXIS;
+        if (reply == TmcReply::DONE && axis.moving && running(axis)) {
+            axis.last = result;
+            axis.readings++;
+            if (result < axis.lowest) axis.lowest = result;
+            axis.low = (result <= axis.driver->stallLevel()) ? axis.low + 1 : 0;
+            if (axis.low >= STALL_CONFIRM_READINGS) {
+                stalled_ = slot;
+                return true;
+            }
+        }
+    }
+
+    // The next axis that has run fast enough for STALL_SETTLE_US, in turn.
+    const unsigned long now = micros();
+    if (now - sentUs_ < STALL_POLL_US) return false;
+    for (uint8_t i = 0; i < count_; i++) {
+        const uint8_t slot = (next_ + i) % count_;
+        Axis&         axis = axes_[slot];
+        if (!running(axis)) {
+            axis.moving = false;
+            axis.low    = 0;   // A stall is confirmed from consecutive readings at speed.
+            continue;
+        }
+        if (!axis.moving) {
+            axis.moving = true;
+            axis.since  = now;
+        }
+        if (now - axis.since < STALL_SETTLE_US) continue;
+        if (!axis.driver->requestStallGuard()) return false;   // The wire is busy.
+        reading_ = slot;
+        next_    = (slot + 1) % count_;
+        sentUs_  = now;
+        return false;
+    }
+    return false;
+}
@@ -0,0 +1,264 @@
+/// @file tmc2209.cpp
+/// @brief TMC2209 UART datagrams, probing and configuration.
+
+#include "tmc2209.h"
+
+#include <math.h>
+
+#include "config.h"
+
+static constexpr uint8_t SYNC   = 0x05;   ///< First byte of every datagram.
+static constexpr uint8_t MASTER = 0xFF;   ///< Address of a reply.
+
+// ============================================================================
+//  Bus
+// ============================================================================
+
+void TmcBus::begin(uint8_t rxPin, uint8_t txPin) {
+    port_.begin(baud_, SERIAL_8N1, rxPin, txPin);
+}
+
+uint8_t TmcBus::crc(const uint8_t* data, uint8_t length) {
+    uint8_t crc = 0;
+    for (uint8_t i = 0; i < length; i++) {
+        uint8_t byte = data[i];
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc    = ((crc >> 7) ^ (byte & 0x01)) ? static_cast<uint8_t>((crc << 1) ^ 0x07)
+                                                  : static_cast<uint8_t>(crc << 1);
+            byte >>= 1;
+        }
+    }
+    return crc;
+}
+
+void TmcBus::send(const uint8_t* data, uint8_t bytes) {
+    if (idle()) {
+        sentUs_ = micros();
+        busyUs_ = 0;
+    }
+    busyUs_ += frameUs(bytes);
+    port_.write(data, bytes);
+}
+
+void TmcBus::write(uint8_t address, uint8_t reg, uint32_t value) {
+    wait();
+    uint8_t d[8] = { SYNC, address, static_cast<uint8_t>(reg | TmcReg::WRITE),
+                     static_cast<uint8_t>(value >> 24), static_cast<uint8_t>(value >> 16),
+                     static_cast<uint8_t>(value >> 8), static_cast<uint8_t>(value), 0 };
+    d[7] = crc(d, 7);
+    send(d, sizeof(d));
+}
+
+bool TmcBus::read(uint8_t address, uint8_t reg, uint32_t& value) {
+    // Whatever is still coming back is the echo of earlier writes.
+    wait();
+    port_.flush();
+    request(address, reg);
+    port_.flush();
+    wait();
+    value = value_;
+    return result_ == TmcReply::DONE;
+}
+
+void TmcBus::request(uint8_t address, uint8_t reg) {
+    wait();
+    while (port_.available()) port_.read();
+
+    uint8_t d[4] = { SYNC, address, reg, 0 };
+    d[3] = crc(d, 3);
+    send(d, sizeof(d));
+    pending_   = true;
+    address_   = address;
+    reg_       = reg;
+    received_  = 0;
+    requestUs_ = micros();
+}
+
+TmcReply TmcBus::reply(uint32_t& value) {
+    // The reply is the first datagram addressed to the master; the echo
+    // of the request is addressed to the node.
+    while (pending_ && port_.available()) {
+        const uint8_t b = static_cast<uint8_t>(port_.read());
+        if (received_ == 1 && b != MASTER) received_ = 0;
+        if (received_ == 0 && b != SYNC) continue;
+        rx_[received_++] = b;
+        if (received_ < sizeof(rx_)) continue;
+
+        pending_ = false;
+        result_  = (rx_[2] == reg_ && crc(rx_, 7) == rx_[7]) ? TmcReply::DONE : TmcReply::FAILED;
+        value_   = static_cast<uint32_t>(rx_[3]) << 24 | static_cast<uint32_t>(rx_[4]) << 16 |
+                   static_cast<uint32_t>(rx_[5]) << 8 | rx_[6];
+    }
+    if (pending_) {
+        if (micros() - requestUs_ < TMC_READ_TIMEOUT_US) return TmcReply::PENDING;
+        pending_ = false;
+        result_  = TmcReply::FAILED;
+    }
+    if (result_ == TmcReply::DONE) value = value_;
+    return result_;
+}
+
+void TmcBus::wait() {
+    uint32_t value;
+    while (reply(value) == TmcReply::PENDING) delayMicroseconds(10);
+}
+
+// ============================================================================
+//  Current Scale
+// ============================================================================
+
+// RMS current (A) at current scale @p cs (0 … 31) in the sense range
+// @p vsense: (CS + 1) / 32 · V_FS / (R_SENSE + 20 mΩ) / √2.
+static float currentAt(uint8_t cs, bool vsense) {
+    const float fullScale = vsense ? 0.180f : 0.325f;
+    return (cs + 1) / 32.0f * fullScale / (TMC_SENSE_OHMS + 0.02f) * 0.70710678f;
+}
+
+// Current scale nearest @p amps (RMS) in the sense range @p vsense.
+static uint8_t scaleFor(float amps, bool vsense) {
+    const float fullScale = vsense ? 0.180f : 0.325f;
+    const long  cs        = lroundf(32.0f * 1.41421356f * amps * (TMC_SENSE_OHMS + 0.02f) / fullScale) - 1;
+    return static_cast<uint8_t>(constrain(cs, 0L, 31L));
+}
+
+// TCOOLTHRS for an axis of @p microsteps at @p speed (steps/s): TSTEP, the
+// clocks between 1/256 steps, there.
+static uint32_t tstepAt(float speed, uint16_t microsteps) {
+    if (speed <= 0.0f) return 0;
+    const float tstep = TMC_CLOCK_HZ * microsteps / (256.0f * speed);
+    return tstep >= TmcReg::TCOOLTHRS_MAX ? TmcReg::TCOOLTHRS_MAX : static_cast<uint32_t>(tstep);
+}
+
+// MRES for @p microsteps (256 → 0 … 1 → 8).
+static uint32_t mresFor(uint16_t microsteps) {
+    uint32_t mres = 8;
+    for (; microsteps > 1; microsteps >>= 1) mres--;
+    return mres;
+}
+
+// ============================================================================
+//  Driver
+// ============================================================================
+
+/// Standstill to hold current ramp (IHOLDDELAY: 2^18 clocks a step).
+static constexpr uint32_t HOLD_DELAY = 8;
+
+bool Tmc2209::begin() {
+    present_ = false;
+    shift_   = 0;
+    faults_  = 0;
+    if (config_.address == TMC_NO_ADDRESS) return false;
+
+    uint32_t ioin = 0;
+    if (!bus_.read(config_.address, TmcReg::IOIN, ioin) || (ioin >> 24) != TMC2209_VERSION) return false;
+
+    // Shadows first, then every register in one go: the resolution before
+    // GCONF hands it from the straps to MRES.
+    gconf_    = TmcReg::PDN_DISABLE | TmcReg::MSTEP_REG_SELECT | TmcReg::MULTISTEP_FILT;
+    chopconf_ = (TmcReg::CHOPCONF_RESET & ~TmcReg::MRES_MASK) | mresFor(microsteps_) << TmcReg::MRES_SHIFT;
+    setStealthChop(config_.stealthChop);
+    setCurrent(config_.runCurrentMA, config_.holdPercent);
+
+    for (uint8_t attempt = 0; attempt < 2; attempt++) {
+        uint32_t count = 0;
+        if (!bus_.read(config_.address, TmcReg::IFCNT, count)) {
+            faults_++;
+            continue;
+        }
+        writes_ = static_cast<uint8_t>(count);
+        configure();
+        if (verify()) {
+            present_ = true;
+            return true;
+        }
+    }
+    return false;
+}
+
+void Tmc2209::configure() {
+    write(TmcReg::GSTAT, 0x7);
+    write(TmcReg::CHOPCONF, chopconf_);
+    write(TmcReg::IHOLD_IRUN, iholdIrun_);
+    write(TmcReg::TCOOLTHRS, config_.stallThreshold ? tstepAt(config_.stallMinSpeed, microsteps_) : 0);
+    write(TmcReg::SGTHRS, config_.stallThreshold);
+    write(TmcReg::GCONF, gconf_);
+}
+
+void Tmc2209::write(uint8_t reg, uint32_t value) {
+    bus_.write(config_.address, reg, value);
+    writes_++;
+}
+
+void Tmc2209::setStepShift(uint8_t shift) {
+    if (!present_ || shift == shift_) return;
+    shift_    = shift;
+    chopconf_ = (chopconf_ & ~TmcReg::MRES_MASK) | mresFor(microsteps()) << TmcReg::MRES_SHIFT;
+    write(TmcReg::CHOPCONF, chopconf_);
+}
+
+void Tmc2209::setCurrent(uint16_t runMA, uint8_t holdPercent) {
+    // The high range unless the current needs less than half its scale.
+    const float    amps   = runMA * 0.001f;
+    const bool     vsense = scaleFor(amps, false) < 16;
+    const uint8_t  irun   = scaleFor(amps, vsense);
+    const long     ihold  = lroundf((irun + 1) * (holdPercent > 100 ? 100 : holdPercent) * 0.01f) - 1;
+    const uint32_t chop   = vsense ? chopconf_ | TmcReg::VSENSE : chopconf_ & ~TmcReg::VSENSE;
+
+    iholdIrun_ = static_cast<uint32_t>(constrain(ihold, 0L, 31L)) | static_cast<uint32_t>(irun) << TmcReg::IRUN_SHIFT |
+                 HOLD_DELAY << TmcReg::IHOLDDELAY_SHIFT;
+    if (present_ && chop != chopconf_) write(TmcReg::CHOPCONF, chop);
+    chopconf_ = chop;
+    if (present_) write(TmcReg::IHOLD_IRUN, iholdIrun_);
+}
+
+uint16_t Tmc2209::runCurrentMA() const {
+    return static_cast<uint16_t>(lroundf(1000.0f * currentAt((iholdIrun_ >> TmcReg::IRUN_SHIFT) & 0x1F,
+                                                             chopconf_ & TmcReg::VSENSE)));
+}
+
+uint16_t Tmc2209::holdCurrentMA() const {
+    return static_cast<uint16_t>(lroundf(1000.0f * currentAt(iholdIrun_ & 0x1F, chopconf_ & TmcReg::VSENSE)));
+}
+
+void Tmc2209::setStealthChop(bool on) {
+    const uint32_t gconf = on ? gconf_ & ~TmcReg::EN_SPREADCYCLE : gconf_ | TmcReg::EN_SPREADCYCLE;
+    if (gconf == gconf_) return;
+    gconf_ = gconf;
+    if (present_) write(TmcReg::GCONF, gconf_);
+}
+
+bool Tmc2209::verify() {
+    uint32_t gconf = 0, chopconf = 0, count = 0;
+    const bool read = bus_.read(config_.address, TmcReg::GCONF, gconf) &&
+                      bus_.read(config_.address, TmcReg::CHOPCONF, chopconf) &&
+                      bus_.read(config_.address, TmcReg::IFCNT, count);
+    if (read && (gconf & 0x3FF) == gconf_ && chopconf == chopconf_ && static_cast<uint8_t>(count) == writes_) {
+        return true;
+    }
+    faults_++;
+    if (read) writes_ = static_cast<uint8_t>(count);
+    return false;
+}
+
+bool Tmc2209::readRegister(uint8_t reg, uint32_t& value) {
+    if (!present_) return false;
+    if (bus_.read(config_.address, reg, value)) return true;
+    faults_++;
+    return false;
+}
+
+bool Tmc2209::requestStallGuard() {
+    if (!watchesStalls() || !bus_.idle() || bus_.pending()) return false;
+    bus_.request(config_.address, TmcReg::SG_RESULT);
+    return true;
+}
+
+TmcReply Tmc2209::stallGuardReply(uint16_t& result) {
+    // A blocking read since has taken the reply.
+    if (!bus_.requested(config_.address, TmcReg::SG_RESULT)) return TmcReply::FAILED;
+    uint32_t       value = 0;
+    const TmcReply r     = bus_.reply(value);
+    if (r == TmcReply::DONE) result = static_cast<uint16_t>(value & TmcReg::SG_RESULT_MAX);
+    if (r == TmcReply::FAILED) faults_++;
+    return r;
+}
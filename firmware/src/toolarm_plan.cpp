@@ -0,0 +1,211 @@
+/// @file toolarm_plan.cpp
+/// @brief ToolarmPlan construction.
+
+#include "toolarm_plan.h"
+
+#include <math.h>
+
+#include "config.h"
+#include "estimate.h"
+
+// ============================================================================
+//  Internal Helpers
+// ============================================================================
+
+// The span the plan covers — from home (or the zone's start, if that is
+// behind it) to the zone's end — and its drive-train scales.
+struct Zone {
+    float startMM;
+    float lengthMM;
+    float zoneMM;     // Start of the winding zone…
+    float zoneAt;     // …and the (fractional) entry it falls on.
+    int   first;      // First entry in the winding zone.
+    float spacing;    // Carriage steps between entries.
+    float nominal;    // Layer gear ratio at the nominal radius.
+    float nominalR;
+};
+
+static Zone zoneOf(const Layer& layer, const EstimateParams& params) {
+    const float home = 0.0f;
+    Zone z;
+    z.startMM  = layer.getOffset() < home ? layer.getOffset() : home;
+    z.lengthMM = layer.getOffset() + layer.getLength() - z.startMM;
+    z.zoneMM   = layer.getOffset();
+    z.zoneAt   = z.lengthMM > 0.0f ? (z.zoneMM - z.startMM) / z.lengthMM * (TOOLARM_PLAN_SIZE - 1) : 0.0f;
+    z.first    = static_cast<int>(ceilf(z.zoneAt));
+    z.spacing  = z.lengthMM * params.carriageStepsPerMM / (TOOLARM_PLAN_SIZE - 1);
+    z.nominal  = layer.getStepRatio(params.carriageStepsPerMM, params.mandrelStepsPerRev);
+    z.nominalR = layer.getDiameter() * 0.5f;
+    return z;
+}
+
+// The profile at (fractional) entry @p i, in steps.
+struct Sample {
+    float slope;       // Toolarm steps per carriage step.
+    float curvature;   // Change of the slope per carriage step.
+    float ratio;       // Carriage steps per mandrel step (GearTable's, so
+                       // the zone's first short of the zone).
+};
+
+static Sample sampleAt(const Zone& z, float i, const SplineProfile& mandrel, const EstimateParams& params) {
+    const float x  = z.startMM + z.lengthMM * i / (TOOLARM_PLAN_SIZE - 1);
+    const float cs = params.carriageStepsPerMM;
+    const float ts = params.toolarmStepsPerMM;
+    Sample s;
+    s.slope     = mandrel.getSlope(x) * ts / cs;
+    s.curvature = mandrel.getCurvature(x) * ts / (cs * cs);
+    s.ratio     = z.nominalR > 0.0f ? z.nominal * (mandrel.getRadius(fmaxf(x, z.zoneMM)) / z.nominalR) : 0.0f;
+    return s;
+}
+
+// Fastest the mandrel may turn at a sample for the toolarm to follow, up to
+// @p cap: the carriage speed at which the demanded toolarm speed and the
+// curvature term stay within their shares, or any speed if the carriage
+// tops out below that.
+static float speedLimit(const Sample& s, float cap, const EstimateParams& params) {
+    const float vmax = TOOLARM_PLAN_SHARE * params.toolarmMaxSpeed;
+    const float amax = 0.5f * TOOLARM_PLAN_SHARE * params.toolarmAccel;
+
+    float c = params.carriageMaxSpeed;
+    if (fabsf(s.slope) > 0.0f)     c = fminf(c, vmax / fabsf(s.slope));
+    if (fabsf(s.curvature) > 0.0f) c = fminf(c, sqrtf(amax / fabsf(s.curvature)));
+    if (c >= params.carriageMaxSpeed || s.ratio <= 0.0f) return cap;
+    return fmaxf(TOOLARM_PLAN_MIN_SPEED, fminf(cap, c / s.ratio));
+}
+
+// Fastest the mandrel may turn where a pass starts or ends at a sample,
+// the carriage stepping from or to rest: the toolarm then reaches or sheds
+// the demanded speed within TOOLARM_PLAN_START_ERROR_MM.
+static float startLimit(const Sample& s, float cap, const EstimateParams& params) {
+    const float error = TOOLARM_PLAN_START_ERROR_MM * params.toolarmStepsPerMM;
+    const float v     = sqrtf(2.0f * TOOLARM_PLAN_SHARE * params.toolarmAccel * error);
+    const float g     = fabsf(s.slope) * s.ratio;
+    return g > 0.0f ? fmaxf(TOOLARM_PLAN_MIN_SPEED, fminf(cap, v / g)) : cap;
+}
+
+// Fastest the mandrel speed may change at a sample: the mandrel's own
+// limit, and the toolarm acceleration left for the demanded speed's change.
+static float accelLimit(const Sample& s, const EstimateParams& params) {
+    const float share = 0.5f * TOOLARM_PLAN_SHARE * params.toolarmAccel;
+    const float g     = fabsf(s.slope) * s.ratio;
+    return g > 0.0f ? fminf(params.mandrelAccel, share / g) : params.mandrelAccel;
+}
+
+// Fastest the mandrel can turn at entry @p to, one entry on from @p from
+// where it turns at @p speed: m² changes by up to 2·a·Δx / ratio (Δx in
+// carriage steps, the carriage geared to the mandrel).
+static float reach(float speed, int from, int to, const Zone& z, const SplineProfile& mandrel,
+                   const EstimateParams& params) {
+    const Sample s     = sampleAt(z, from, mandrel, params);
+    const Sample t     = sampleAt(z, to, mandrel, params);
+    const float  a     = fminf(accelLimit(s, params), accelLimit(t, params));
+    const float  ratio = fmaxf(s.ratio, t.ratio);
+    return ratio > 0.0f ? sqrtf(speed * speed + 2.0f * a * z.spacing / ratio) : speed;
+}
+
+// Speed limit at (fractional) entry @p at, as ToolarmPlan::speedAt().
+static float speedAt(const float* speed, float at) {
+    const int i = static_cast<int>(at);
+    return i >= TOOLARM_PLAN_SIZE - 1 ? speed[TOOLARM_PLAN_SIZE - 1] : speed[i] + (at - i) * (speed[i + 1] - speed[i]);
+}
+
+// Time to cross from (fractional) entry @p from to @p to with the mandrel
+// at @p speed, interpolated between entries as at run time and capped at
+// @p cap (seconds): the carriage runs the geared speed, topping out at its
+// maximum.  Between entries the speed changes linearly, so the time is the
+// distance over the logarithmic mean of the speeds at either end.
+static float crossSeconds(const Zone& z, float from, float to, const float* speed, float cap,
+                          const SplineProfile& mandrel, const EstimateParams& params) {
+    float seconds = 0.0f;
+    float last    = 0.0f;   // Carriage speed at the previous point.
+    for (float at = from;; at = fminf(floorf(at) + 1.0f, to)) {
+        const float m = speed ? fminf(speedAt(speed, at), cap) : cap;
+        const float c = fminf(sampleAt(z, at, mandrel, params).ratio * m, params.carriageMaxSpeed);
+        if (at > from && c > 0.0f && last > 0.0f) {
+            const float mean = fabsf(c - last) > 1e-3f * c ? (c - last) / logf(c / last) : c;
+            seconds += (at - from) * z.spacing / mean;
+        }
+        last = c;
+        from = at;
+        if (at >= to) return seconds;
+    }
+}
+
+// Plan the mandrel speed limit at every entry into @p speed (steps/s) and
+// sum up what it costs at the winding speed.
+static ToolarmSummary plan(const Zone& z, const SplineProfile& mandrel, const EstimateParams& params,
+                           float* speed) {
+    const float cap  = fmaxf(DEFAULT_MANDREL_MAX_SPEED, params.mandrelSpeed);
+    const float m0   = params.mandrelSpeed;
+    const int   last = TOOLARM_PLAN_SIZE - 1;
+    ToolarmSummary sum;
+    for (int i = 0; i < TOOLARM_PLAN_SIZE; i++) speed[i] = cap;
+    if (m0 <= 0.0f || z.first >= last) return sum;
+
+    // What gearing to the surface costs, slowed or not.
+    const float geared = crossSeconds(z, z.zoneAt, last, nullptr, m0, mandrel, params);
+    const float flat   = fminf(z.nominal * m0, params.carriageMaxSpeed);
+    sum.gearSeconds    = flat > 0.0f ? geared - (last - z.zoneAt) * z.spacing / flat : 0.0f;
+    if (!params.toolarmLookAhead || params.toolarmMaxSpeed <= 0.0f || params.toolarmAccel <= 0.0f) {
+        return sum;
+    }
+
+    for (int i = 0; i < TOOLARM_PLAN_SIZE; i++) {
+        speed[i] = speedLimit(sampleAt(z, i, mandrel, params), cap, params);
+    }
+    // Home and the zone's ends; the zone's start may fall between entries.
+    const int ends[] = { 0, z.first > 0 ? z.first - 1 : 0, z.first, TOOLARM_PLAN_SIZE - 1 };
+    for (int i : ends) {
+        speed[i] = fminf(speed[i], startLimit(sampleAt(z, i, mandrel, params), cap, params));
+    }
+
+    // The backward sweep makes the slow-down ahead of a limit, the forward
+    // one the ramp back after it.
+    for (int i = 1; i < TOOLARM_PLAN_SIZE; i++) {
+        speed[i] = fminf(speed[i], reach(speed[i - 1], i - 1, i, z, mandrel, params));
+    }
+    for (int i = TOOLARM_PLAN_SIZE - 2; i >= 0; i--) {
+        speed[i] = fminf(speed[i], reach(speed[i + 1], i + 1, i, z, mandrel, params));
+    }
+
+    // What it costs within the winding zone, and on the way in from home.
+    float slowest = fminf(m0, speedAt(speed, z.zoneAt));
+    int   slowed  = 0;
+    for (int i = z.first; i <= last; i++) {
+        if (speed[i] < slowest) slowest = speed[i];
+        if (i > z.first && (speed[i - 1] < m0 || speed[i] < m0)) slowed++;
+    }
+    sum.extraSeconds     = crossSeconds(z, z.zoneAt, last, speed, m0, mandrel, params) - geared;
+    sum.uniformSeconds   = crossSeconds(z, z.zoneAt, last, nullptr, slowest, mandrel, params) - geared;
+    sum.approachSeconds  = crossSeconds(z, 0, z.zoneAt, speed, m0, mandrel, params) -
+                           crossSeconds(z, 0, z.zoneAt, nullptr, m0, mandrel, params);
+    sum.minSpeed         = slowest / m0;
+    sum.slowedShare      = static_cast<float>(slowed) / (last - z.first);
+    sum.startSpeed       = fminf(speedAt(speed, z.zoneAt), m0) / m0;
+    sum.endSpeed         = fminf(speed[last], m0) / m0;
+    return sum;
+}
+
+// ============================================================================
+//  ToolarmPlan
+// ============================================================================
+
+void ToolarmPlan::build(const Layer& layer, const SplineProfile& mandrel, const EstimateParams& params) {
+    const Zone z = zoneOf(layer, params);
+    active_      = mandrel.isReady() && mandrel.hasTargetTable() && z.lengthMM > 0.0f;
+    summary_     = ToolarmSummary();
+    if (!active_) return;
+
+    startStep_  = static_cast<long>(z.startMM * params.carriageStepsPerMM);
+    invSpacing_ = 1.0f / z.spacing;
+    summary_    = plan(z, mandrel, params, speed_);
+}
+
+ToolarmSummary ToolarmPlan::summarize(const Layer& layer, const SplineProfile& mandrel,
+                                      const EstimateParams& params) {
+    const Zone z = zoneOf(layer, params);
+    if (!mandrel.isReady() || z.lengthMM <= 0.0f) return ToolarmSummary();
+
+    float speed[TOOLARM_PLAN_SIZE];
+    return plan(z, mandrel, params, speed);
+}
@@ -0,0 +1,90 @@
+/// @file trace.cpp
+/// @brief Ring-buffer trace recorder implementation.
+
+#include <Arduino.h>
+#include "trace.h"
+
+// ============================================================================
+//  Internal (file-scoped) State
+// ============================================================================
+
+static TraceRecord s_records[TRACE_CAPACITY];
+static uint32_t    s_head    = 0;      // Total records written since clear().
+static bool        s_enabled = true;
+static uint32_t    s_mask    = 0xFFFFFFFFUL;
+
+// ============================================================================
+//  Recorder API
+// ============================================================================
+
+void Trace::record(TraceEvent event, uint16_t arg, int32_t value) {
+    if (!s_enabled || !(s_mask & Trace::bit(event))) return;
+
+    TraceRecord& r = s_records[s_head & (TRACE_CAPACITY - 1)];
+    r.timeUs   = micros();
+    r.event    = static_cast<uint8_t>(event);
+    r.reserved = 0;
+    r.arg      = arg;
+    r.value    = value;
+    s_head++;
+}
+
+void Trace::setEnabled(bool enabled) {
+    s_enabled = enabled;
+}
+
+bool Trace::isEnabled() {
+    return s_enabled;
+}
+
+void Trace::setEventMask(uint32_t mask) {
+    s_mask = mask;
+}
+
+uint32_t Trace::getEventMask() {
+    return s_mask;
+}
+
+void Trace::clear() {
+    s_head = 0;
+}
+
+uint32_t Trace::size() {
+    return (s_head < TRACE_CAPACITY) ? s_head : TRACE_CAPACITY;
+}
+
+void Trace::dump(Print& out) {
+    bool wasEnabled = s_enabled;
+    s_enabled = false;
+
+    uint32_t count = size();
+    uint32_t first = s_head - count;   // Oldest record still in the buffer.
+
+    TraceHeader header;
+    header.magic      = TRACE_MAGIC;
+    header.version    = TRACE_VERSION;
+    header.recordSize = sizeof(TraceRecord);
+    header.count      = count;
+    header.dropped    = s_head - count;
+    out.write(reinterpret_cast<const uint8_t*>(&header), sizeof(header));
+
+    // Write in at most two contiguous runs (tail of the ring, then the head).
+    uint32_t start = first & (TRACE_CAPACITY - 1);
+    uint32_t run   = TRACE_CAPACITY - start;
+    if (run > count) run = count;
+    out.write(reinterpret_cast<const uint8_t*>(&s_records[start]),
+              run * sizeof(TraceRecord));
+    out.write(reinterpret_cast<const uint8_t*>(&s_records[0]),
+              (count - run) * sizeof(TraceRecord));
+    out.println();
+
+    s_enabled = wasEnabled;
+}
+
+int32_t Trace::packCommand(const char* cmd) {
+    uint32_t packed = 0;
+    for (int i = 0; i < 4 && cmd[i] != '\0'; i++) {
+        packed |= static_cast<uint32_t>(static_cast<uint8_t>(cmd[i])) << (8 * i);
+    }
+    return static_cast<int32_t>(packed);
+}
@@ -6,27 +6,521 @@
 
 #include "winding.h"
 #include "config.h"
+#include "axis.h"
 #include "motor_control.h"
+#include "homing.h"
+#include "inputs.h"
+#include "encoder.h"
+#include "trace.h"
+#include "memstat.h"
+#include "pattern.h"
+#include "planner.h"
+#include "stall_monitor.h"
+
+// The carriage ramp table is built for these once per job; it must reach the
+// maximum speed or run() tops out below it.
+static_assert(stepRampLevels(DEFAULT_CARRIAGE_MAX_SPEED, DEFAULT_CARRIAGE_ACCEL) <= CARRIAGE_RAMP_STEPS,
+              "CARRIAGE_RAMP_STEPS too small for the default carriage speed and acceleration");
+static_assert(stepRampLevels(DEFAULT_TOOLHEAD_MAX_SPEED, DEFAULT_TOOLHEAD_ACCEL) <= TOOLHEAD_RAMP_STEPS,
+              "TOOLHEAD_RAMP_STEPS too small for the default toolhead speed and acceleration");
+static_assert(stepRampLevels(DEFAULT_TOOLARM_MAX_SPEED, DEFAULT_TOOLARM_ACCEL) <= TOOLARM_RAMP_STEPS,
+              "TOOLARM_RAMP_STEPS too small for the default toolarm speed and acceleration");
 
 // ============================================================================
 //  Internal (file-scoped) State
 // ============================================================================
 
-static WindProfile  s_profile;
+// The running job and the queue behind it, kept as a ring so moving on to
+// the next job only advances s_activeJob.
+static WindProfile  s_jobs[1 + JOB_QUEUE_SIZE];
+static JobEstimate  s_estimates[1 + JOB_QUEUE_SIZE];
+static int          s_activeJob        = 0;
+static int          s_queuedJobs       = 0;
+static WindProfile* s_profile          = &s_jobs[0];
+
 static WindingState s_state            = WindingState::IDLE;
 static int          s_activeLayerIdx   = 0;
 
 // Electronic-gearing runtime variables.
 static float s_carAccumulator   = 0.0f;   // Fractional carriage-step accumulator.
+static long  s_gearStep         = 0;       // Geared carriage command (steps).
 static long  s_lastMandrelStep  = 0;       // Previous mandrel position (steps).
 static long  s_dwellTargetStep  = 0;       // Mandrel step count to end dwell.
+static long  s_layerStartStep   = 0;       // Winding-pattern phase reference of the layer.
+static long  s_followingBase    = 0;       // Mandrel following error a revolution ago (steps)...
+static long  s_followingFrom    = 0;       // ...and the mandrel step count it was taken at.
+
+// Homing of every axis against its limit switch (the ZEROING state),
+// slots in HomeAxis order.
+static HomingAxis<CarriageStepper> s_carriageHoming(carriageStepper, CARRIAGE_HOMING, &carriageDriver);
+static HomingAxis<ToolarmStepper>  s_toolarmHoming(toolarmStepper, TOOLARM_HOMING, &toolarmDriver);
+static HomingAxis<ToolheadStepper> s_toolheadHoming(toolheadStepper, TOOLHEAD_HOMING, &toolheadDriver);
+static HomingCoordinator           s_homing;
+
+// StallGuard watch of the drivers while winding, slots in TraceAxis order,
+// and the last stall it paused a job for.
+static StallMonitor s_stall;
+static StallAlarm   s_stallAlarm;
 
 // State to resume to after un-pausing.
 static WindingState s_stateBeforePause = WindingState::IDLE;
 
-// Derived ratios (computed once in init() from motor params + drive train).
-static float s_carriageStepsPerMM = 0.0f;
-static float s_mandrelStepsPerRev = 0.0f;
+// Plan of the active layer (gear table, end steps, dwell, phase reference),
+// handed over by the planner at every layer boundary.
+static const LayerPlan* s_plan = nullptr;
+
+// Hand-over to the next layer, planned when a layer's last pass begins: the
+// geared command stops past the layer's end (LayerPlan::handOverStep) and
+// the carriage decelerates into it instead of stopping hard, so the winding
+// zone is laid geared up to its end; the boundary only turns the mandrel by
+// the fibre-placement dwell — the next layer starts its own pattern, so no
+// stepover / slot shift is needed.
+struct LayerTransition {
+    bool pending    = false;   // The active pass ends the layer and another (or a job) follows.
+    bool braking    = false;   // Decelerating into endStep (positioned, no longer geared).
+    long endStep    = 0;       // Carriage step the last pass comes to rest on.
+    long dwellSteps = 0;       // Mandrel rotation at the boundary.
+};
+static LayerTransition s_transition;
+
+// Toolhead flip to the next pass's orientation, planned when a pass begins
+// and started once the carriage is within leadSteps of the end (at the end
+// at the latest).  The next pass starts when the dwell is done and no more
+// than holdSteps of the flip are left; until then the mandrel holds.
+struct ToolheadFlip {
+    bool pending   = false;   // Planned, not started.
+    long target    = 0;       // Toolhead step of the next pass's orientation.
+    long endStep   = 0;       // Carriage step the pass ends on.
+    long leadSteps = 0;       // Carriage steps before endStep to start at.
+    long holdSteps = 0;       // Toolhead steps the flip may have left.
+};
+static ToolheadFlip s_flip;
+static bool         s_positioning = false;   // Homed; turning the toolhead to the first pass.
+
+// Flip resolution as a pulse size (StepDirStepper::setStepShift()), and
+// whether a resolution change is still on its way to the driver.
+static constexpr uint8_t TOOLHEAD_FLIP_SHIFT = tmcStepShift(TOOLHEAD_MOTOR_PARAMS.microsteps, TOOLHEAD_FLIP_MICROSTEPS);
+static bool              s_headSwitching     = false;
+
+static_assert(AxisCheck::isDriverMicrostep(TOOLHEAD_FLIP_MICROSTEPS) &&
+              TOOLHEAD_FLIP_MICROSTEPS <= TOOLHEAD_MOTOR_PARAMS.microsteps,
+              "TOOLHEAD_FLIP_MICROSTEPS is not a driver resolution at or below the toolhead's");
+
+// The winding speed the mandrel runs at where the toolarm plan does not
+// slow it, and the mandrel step the current dwell started on.
+static float s_windSpeed  = 0.0f;
+static long  s_dwellStart = 0;
+
+// Mandrel step the speed limit is next set on, and the dwell's edge speed.
+static long  s_limitAt   = 0;
+static float s_dwellEdge = 0.0f;
+
+// Start time of the current job.
+static unsigned long s_jobStartMs = 0;
+static bool          s_jobStarted = false;
+
+// ============================================================================
+//  Internal Helpers
+// ============================================================================
+
+// Single point of state change so every transition lands in the trace.
+static void setState(WindingState next) {
+    Trace::record(TraceEvent::STATE, static_cast<uint16_t>(next),
+                  static_cast<int32_t>(s_state));
+    MemStat::setState(next);
+    s_state = next;
+}
+
+// Position sources of the limit switches: their edge interrupts latch the
+// axis position the switch closed at, which homing sets zero from.
+static long IRAM_ATTR carriagePosition() { return carriageStepper.currentPosition(); }
+static long IRAM_ATTR toolarmPosition()  { return toolarmStepper.currentPosition(); }
+static long IRAM_ATTR toolheadPosition() { return toolheadStepper.currentPosition(); }
+
+// Mandrel angle the gearing, the pattern phase and the dwells follow: the
+// encoder's when it is fitted, so a lost step shifts nothing in the layup.
+static long mandrelAngle() {
+    return MandrelEncoder::enabled() ? MandrelEncoder::steps() : mandrelStepper.currentPosition();
+}
+
+// Speeds the stall monitor reads StallGuard at.  Past the dwell the
+// mandrel holds for the toolhead flip with its winding speed still set.
+static float mandrelSpeed() {
+    const bool holding = s_state == WindingState::DWELLING && mandrelAngle() >= s_dwellTargetStep;
+    return holding ? 0.0f : mandrelStepper.speed();
+}
+static float carriageSpeed() { return carriageStepper.speed(); }
+static float toolarmSpeed()  { return toolarmStepper.speed(); }
+static float toolheadSpeed() { return toolheadStepper.speed(); }
+
+// Mandrel steps commanded but not turned (0 without the encoder).
+static long followingError() {
+    return MandrelEncoder::enabled() ? mandrelStepper.currentPosition() - MandrelEncoder::steps() : 0;
+}
+
+// Ring slot @p ahead jobs after the active one.
+static int jobSlot(int ahead) {
+    return (s_activeJob + ahead) % (1 + JOB_QUEUE_SIZE);
+}
+
+// Called whenever a pass begins: plan the layer transition if it is the
+// layer's last pass and another layer or a queued job follows.
+static void planTransition() {
+    const Layer& active = s_profile->layers[s_activeLayerIdx];
+    s_transition.pending = (active.getPassesCompleted() == active.getTotalPasses() - 1) &&
+                           (s_activeLayerIdx < s_profile->layerCount - 1 || s_queuedJobs > 0);
+    if (!s_transition.pending) return;
+
+    s_transition.endStep    = s_plan->handOverStep;
+    s_transition.dwellSteps = s_plan->dwellSteps;
+}
+
+// Called whenever a pass begins: plan the toolhead flip at its end — to the
+// mirrored angle, to the next layer's (or queued job's) first pass, or
+// nowhere after the job's last pass.  A layer's first pass is forward.
+static void planFlip() {
+    const Layer& active = s_profile->layers[s_activeLayerIdx];
+    const bool   last   = active.getPassesCompleted() == active.getTotalPasses() - 1;
+
+    s_flip.pending = true;
+    s_flip.endStep = active.isGoingForward() ? s_plan->forwardEndStep : s_plan->returnEndStep;
+    if (!last) {
+        s_flip.target    = Estimate::toolheadSteps(active, !active.isGoingForward());
+        s_flip.leadSteps = s_plan->flipLeadSteps;
+        s_flip.holdSteps = s_plan->flipHoldSteps;
+    } else if (s_transition.pending) {
+        s_flip.endStep = s_transition.endStep;
+        const Layer& next = (s_activeLayerIdx < s_profile->layerCount - 1) ? s_profile->layers[s_activeLayerIdx + 1]
+                                                                           : s_jobs[jobSlot(1)].layers[0];
+        s_flip.target    = Estimate::toolheadSteps(next, true);
+        s_flip.leadSteps = s_plan->handLeadSteps;
+        s_flip.holdSteps = s_plan->handHoldSteps;
+    } else {
+        s_flip.target    = toolheadStepper.targetPosition();
+        s_flip.leadSteps = 0;
+        s_flip.holdSteps = 0;
+    }
+}
+
+// Step the toolhead.  A flip run coarse comes to rest within a pulse of
+// its target; it goes back to the toolhead's own resolution and makes the
+// rest of the move at it (moveTo() only starts a move to a new target).
+// The stepper switches at once; the driver once no read is in flight on
+// the UART (the write would wait for its reply), and the toolhead is not
+// pulsed until the driver has it.  @return true while it moves or switches.
+static bool runToolhead() {
+    if (toolheadStepper.stepShift() && !toolheadStepper.isRunning()) {
+        const long target = toolheadStepper.targetPosition();
+        toolheadStepper.setStepShift(0);
+        toolheadStepper.setCurrentPosition(toolheadStepper.currentPosition());
+        toolheadStepper.moveTo(target);
+    }
+    if (toolheadDriver.stepShift() != toolheadStepper.stepShift()) {
+        if (tmcBus.pending()) return true;
+        toolheadDriver.setStepShift(toolheadStepper.stepShift());
+        s_headSwitching = true;
+    }
+    if (s_headSwitching) {
+        if (!toolheadDriver.settled()) return true;
+        s_headSwitching = false;
+    }
+    return toolheadStepper.run();
+}
+
+// The flip is a fast move from rest to rest: with its driver on the UART
+// the toolhead makes it at TOOLHEAD_FLIP_MICROSTEPS, fewer pulses for the
+// same speed, and holds the fibre angle at its own resolution.  The
+// resolution is set before the move, which starts the ramp.
+static void startFlip() {
+    if (toolheadDriver.present()) toolheadStepper.setStepShift(TOOLHEAD_FLIP_SHIFT);
+    toolheadStepper.moveTo(s_flip.target);
+    s_flip.pending = false;
+}
+
+// Velocity-mode gearing, on every mandrel step: the carriage is commanded
+// the geared speed (feed-forward, so it needs no following error to move)
+// plus a catch-up term on the error, which recovers the distance lost while
+// accelerating from rest.  The catch-up is capped at the speed that can be
+// shed within GEAR_CATCH_UP_ACCEL over the remaining error, so it closes
+// the gap without overshooting; the stepper's ramp limits the acceleration.
+static void followGear(float gearedSpeed) {
+    if (s_transition.braking) return;
+
+    const float error   = (s_gearStep - carriageStepper.currentPosition()) + s_carAccumulator;
+    const float size    = fabsf(error);
+    const float cap     = sqrtf(2.0f * GEAR_CATCH_UP_ACCEL * size);
+    float       catchUp = GEAR_CATCH_UP_GAIN * size;
+    if (catchUp > cap) catchUp = cap;
+    carriageStepper.setTargetSpeed(gearedSpeed + (error < 0.0f ? -catchUp : catchUp));
+}
+
+// Mandrel speed at the carriage position: the winding speed, or slower
+// where the toolarm plan says the toolarm could not keep up.  Called on
+// every mandrel step, it only sets the speed every MANDREL_LIMIT_STEPS.
+static void limitMandrel() {
+    const ToolarmPlan& plan = s_plan->toolarm;
+    if (!plan.isActive()) {
+        mandrelStepper.setSpeed(s_windSpeed);
+        return;
+    }
+    const long at = mandrelAngle();
+    if (at < s_limitAt) return;
+    s_limitAt = at + MANDREL_LIMIT_STEPS;
+
+    const float limit = plan.speedAt(carriageStepper.currentPosition());
+    mandrelStepper.setSpeed(limit < s_windSpeed ? limit : s_windSpeed);
+}
+
+// Start a dwell's ramp where the carriage stands.
+static void beginDwellRamp() {
+    const ToolarmPlan& plan = s_plan->toolarm;
+    s_dwellEdge = plan.isActive() ? plan.speedAt(carriageStepper.currentPosition()) : s_windSpeed;
+    s_limitAt   = s_dwellStart;
+}
+
+// Mandrel speed in a dwell, every MANDREL_LIMIT_STEPS mandrel steps: the
+// carriage stands, so the mandrel may ramp up to the winding speed at
+// DEFAULT_MANDREL_ACCEL, but it is back at the plan's speed where the
+// dwell ends.  Each speed holds until the next is set, so it is the ramp's
+// at the middle of its stretch: taken at the start, the slow steps off the
+// pass's speed would each hold it for a whole stretch.
+static void rampDwell() {
+    if (!s_plan->toolarm.isActive()) return;
+    const long at = mandrelAngle();
+    if (at < s_limitAt) return;
+    s_limitAt = at + MANDREL_LIMIT_STEPS;
+
+    const long mid  = at + MANDREL_LIMIT_STEPS / 2;
+    const long done = mid - s_dwellStart;
+    long       left = s_dwellTargetStep - mid;
+    if (left < 0) left = 0;
+    const float ramp = sqrtf(s_dwellEdge * s_dwellEdge + 2.0f * DEFAULT_MANDREL_ACCEL * (done < left ? done : left));
+    mandrelStepper.setSpeed(ramp < s_windSpeed ? ramp : s_windSpeed);
+}
+
+// Toolarm tracking, on every mandrel step: like the gearing, the speed the
+// surface demands at the carriage's actual speed (feed-forward; it ramps
+// at the ends of a pass and may lag the gear) plus a catch-up on the error
+// against the target under the carriage, capped so it can be shed within
+// TOOLARM_CATCH_UP_ACCEL.  Without the look-ahead the toolarm is
+// retargeted instead, as in the 4-axis scripts.
+static void followProfile(float carriageSpeed) {
+    const SplineProfile& surface = s_profile->mandrelProfile;
+    const long           at      = carriageStepper.currentPosition();
+    const long           target  = surface.getTargetStepsLerp(at);
+    if (!s_profile->toolarmLookAhead) {
+        toolarmStepper.moveTo(target);
+        return;
+    }
+
+    const float error   = static_cast<float>(target - toolarmStepper.currentPosition());
+    const float size    = fabsf(error);
+    const float cap     = sqrtf(2.0f * TOOLARM_CATCH_UP_ACCEL * size);
+    float       catchUp = TOOLARM_CATCH_UP_GAIN * size;
+    if (catchUp > cap) catchUp = cap;
+    toolarmStepper.setTargetSpeed(surface.getTargetSlope(at) * carriageSpeed + (error < 0.0f ? -catchUp : catchUp));
+}
+
+// Start the geared command of a pass where the carriage stands.
+static void beginPass() {
+    s_carAccumulator     = 0.0f;
+    s_gearStep           = carriageStepper.currentPosition();
+    s_lastMandrelStep    = mandrelAngle();
+    s_transition.braking = false;
+    s_limitAt            = mandrelAngle();
+    limitMandrel();
+}
+
+static const __FlashStringHelper* homeAxisName(uint8_t slot) {
+    return slot == static_cast<uint8_t>(HomeAxis::CARRIAGE) ? F("Carriage")
+         : slot == static_cast<uint8_t>(HomeAxis::TOOLARM)  ? F("Toolarm")
+                                                            : F("Toolhead");
+}
+
+static const __FlashStringHelper* traceAxisName(uint8_t axis) {
+    return axis == static_cast<uint8_t>(TraceAxis::MANDREL)  ? F("Mandrel")
+         : axis == static_cast<uint8_t>(TraceAxis::CARRIAGE) ? F("Carriage")
+         : axis == static_cast<uint8_t>(TraceAxis::TOOLARM)  ? F("Toolarm")
+                                                             : F("Toolhead");
+}
+
+// TraceAxis of homing slot @p slot.
+static TraceAxis homeTraceAxis(uint8_t slot) {
+    return slot == static_cast<uint8_t>(HomeAxis::CARRIAGE) ? TraceAxis::CARRIAGE
+         : slot == static_cast<uint8_t>(HomeAxis::TOOLARM)  ? TraceAxis::TOOLARM
+                                                            : TraceAxis::TOOLHEAD;
+}
+
+// One axis's homing, distances in @p unit at @p perStep units per step.
+static void printAxisHoming(uint8_t slot, float perStep, const __FlashStringHelper* unit) {
+    const HomingReport& r = s_homing.axis(slot).report();
+    Serial.print(F("[WINDING] "));
+    Serial.print(homeAxisName(slot));
+    Serial.print(F(" homed in "));
+    Serial.print(r.seconds, 1);
+    Serial.print(F(" s (seek overtravel "));
+    Serial.print(r.overtravel * perStep, 2);
+    Serial.print(unit);
+    if (r.homings > 1) {
+        Serial.print(F(", home moved "));
+        Serial.print(r.homeError * perStep, 3);
+        Serial.print(unit);
+        Serial.print(F(", repeatability "));
+        Serial.print(r.repeatability() * perStep, 3);
+        Serial.print(unit);
+        Serial.print(F(" over "));
+        Serial.print(r.homings);
+        Serial.print(F(" homings"));
+    }
+    if (r.readings) {
+        Serial.print(F(", backlash "));
+        Serial.print(r.backlash * perStep, 3);
+        Serial.print(unit);
+        Serial.print(F(" ±"));
+        Serial.print(r.backlashSpread * perStep * 0.5f, 3);
+        Serial.print(F(" over "));
+        Serial.print(r.readings);
+        Serial.print(F(" reversals"));
+    }
+    Serial.println(F(")."));
+
+    // Home moved by more than the switch scatters: the axis lost (or
+    // gained) steps during the last job, and that job's part is suspect.
+    if (r.lostSteps) {
+        Trace::record(TraceEvent::STEP_LOSS, static_cast<uint16_t>(homeTraceAxis(slot)), r.homeError);
+        Serial.print(F("[WINDING] "));
+        Serial.print(homeAxisName(slot));
+        Serial.print(F(" lost steps since its last homing: home moved "));
+        Serial.print(r.homeError * perStep, 2);
+        Serial.print(unit);
+        Serial.println(F(" — check the last part."));
+    }
+}
+
+// Report the homing that just ended.
+static void printHoming() {
+    if (s_homing.failed()) {
+        const uint8_t slot = s_homing.failedAxis();
+        const HomingFault fault = s_homing.axis(slot).report().fault;
+        Serial.print(F("[WINDING] Homing failed: "));
+        Serial.print(homeAxisName(slot));
+        Serial.println(fault == HomingFault::NO_SWITCH    ? F(": no limit switch within its travel.")
+                     : fault == HomingFault::SWITCH_STUCK ? F(": limit switch still closed after backing off.")
+                                                          : F(": limit switch not found on the slow approach."));
+        return;
+    }
+    printAxisHoming(static_cast<uint8_t>(HomeAxis::CARRIAGE), CarriageAxis::mmPerStep(), F(" mm"));
+    printAxisHoming(static_cast<uint8_t>(HomeAxis::TOOLARM), ToolarmAxis::mmPerStep(), F(" mm"));
+    printAxisHoming(static_cast<uint8_t>(HomeAxis::TOOLHEAD), ToolheadAxis::degreesPerStep(), F(" deg"));
+    Serial.print(F("[WINDING] All axes homed in "));
+    Serial.print(s_homing.seconds(), 1);
+    Serial.print(F(" s ("));
+    Serial.print(s_homing.sequentialSeconds(), 1);
+    Serial.println(F(" s one after another)."));
+}
+
+// Have the planner prepare whatever follows the active layer while it winds.
+static void requestNext() {
+    if (s_activeLayerIdx < s_profile->layerCount - 1) {
+        Planner::request(*s_profile, s_activeLayerIdx + 1);
+    } else if (s_queuedJobs > 0) {
+        const int next = jobSlot(1);
+        Planner::request(s_jobs[next], 0, &s_estimates[next]);
+    }
+}
+
+// Start winding the active layer from the current mandrel position.
+static void beginLayer() {
+    beginPass();
+    setState(WindingState::WINDING);
+    Trace::record(TraceEvent::LAYER_BEGIN, static_cast<uint16_t>(s_activeLayerIdx),
+                  s_profile->layers[s_activeLayerIdx].getTotalPasses());
+    requestNext();
+    planTransition();
+    planFlip();
+}
+
+// Stop every axis dead and drop the job.
+static void stopJob() {
+    if (s_homing.busy()) s_homing.abort();
+    mandrelStepper.setCurrentPosition(mandrelStepper.currentPosition());
+    carriageStepper.setCurrentPosition(carriageStepper.currentPosition());
+    toolarmStepper.setCurrentPosition(toolarmStepper.currentPosition());
+    toolheadStepper.setCurrentPosition(toolheadStepper.currentPosition());
+    if (toolheadStepper.setStepShift(0)) toolheadDriver.setStepShift(0);   // Stopped mid-flip.
+    setState(WindingState::IDLE);
+}
+
+// Take the latched input events into the trace and stop the job if the
+// E-stop was hit.  Its interrupt has already cut the drivers; here the
+// step generators stop dead so nothing resumes when they are re-enabled.
+static void pollInputs() {
+    InputEvent e;
+    while (Inputs::poll(e)) {
+        Trace::record(TraceEvent::SWITCH,
+                      static_cast<uint16_t>(static_cast<uint8_t>(e.input) | (e.active << 8)),
+                      static_cast<int32_t>(e.latchUs - e.edgeUs));
+    }
+
+    if (!Inputs::eStopLatched() || s_state == WindingState::IDLE || s_state == WindingState::COMPLETE) {
+        return;
+    }
+    stopJob();
+    Serial.println(F("[WINDING] E-stop — drivers disabled, job stopped. Release it and start again."));
+}
+
+// Stop the job if the mandrel has lost more than the limit within the last
+// revolution or two: it is stalling or slipping, not just dropping the odd
+// step (which the gearing absorbs, as it follows the encoder).
+static constexpr long FOLLOWING_LIMIT_STEPS = static_cast<long>(MandrelAxis::toSteps(MANDREL_FOLLOWING_LIMIT_DEG));
+
+static bool checkFollowing() {
+    const long step  = mandrelStepper.currentPosition();
+    const long error = followingError();
+    if (labs(error - s_followingBase) <= FOLLOWING_LIMIT_STEPS) {
+        if (labs(step - s_followingFrom) >= MandrelAxis::stepsPerRev()) {
+            s_followingBase = error;
+            s_followingFrom = step;
+        }
+        return false;
+    }
+
+    Trace::record(TraceEvent::FOLLOWING_ERROR, static_cast<uint16_t>(TraceAxis::MANDREL), error);
+    stopJob();
+    Serial.print(F("[WINDING] Mandrel following error "));
+    Serial.print(MandrelAxis::toDegrees(error), 1);
+    Serial.println(F("° — job stopped. Check the mandrel drive and start again."));
+    return true;
+}
+
+// Pause the job if a watched axis has stalled: it no longer turns with its
+// pulses, and every step from here on is lost.
+static bool checkStall() {
+    if (!s_stall.update()) return false;
+
+    const uint8_t axis   = s_stall.stalledAxis();
+    const Layer&  active = s_profile->layers[s_activeLayerIdx];
+    s_stallAlarm.count++;
+    s_stallAlarm.axis    = axis;
+    s_stallAlarm.layer   = s_activeLayerIdx;
+    s_stallAlarm.pass    = active.getPassesCompleted() + 1;
+    s_stallAlarm.result  = s_stall.lastResult(axis);
+    s_stallAlarm.seconds = Winding::getElapsedSeconds();
+    Trace::record(TraceEvent::STALL, static_cast<uint16_t>(axis | s_activeLayerIdx << 8),
+                  static_cast<int32_t>(s_stallAlarm.pass) << 16 | s_stallAlarm.result);
+
+    Serial.print(F("[WINDING] "));
+    Serial.print(traceAxisName(axis));
+    Serial.print(F(" stalled in layer "));
+    Serial.print(s_stallAlarm.layer);
+    Serial.print(F(", pass "));
+    Serial.print(s_stallAlarm.pass);
+    Serial.print(F(" (StallGuard "));
+    Serial.print(s_stallAlarm.result);
+    Serial.println(F("). Clear it and start again to re-home; resume carries on with the steps it lost."));
+    Winding::pause();
+    return true;
+}
 
 // ============================================================================
 //  WindProfile Implementation
@@ -41,12 +535,23 @@ bool WindProfile::addLayer(float length, float angle, float offset,
     return true;
 }
 
+void WindProfile::planPatterns(const EstimateParams& params) {
+    for (int i = 0; i < layerCount; i++) {
+        if (patternSequencing) Pattern::apply(layers[i], params);
+        else                   layers[i].clearPattern();
+    }
+}
+
 void WindProfile::clear() {
     for (int i = 0; i < MAX_LAYERS; i++) {
         layers[i] = Layer();
     }
     layerCount      = 0;
     mandrelDiameter = 0.0f;
+    mandrelProfile.clear();
+    patternSequencing = true;
+    overlapToolheadFlip = true;
+    toolarmLookAhead = true;
 }
 
 bool WindProfile::isValid() const {
@@ -58,61 +563,168 @@ bool WindProfile::isValid() const {
 // ============================================================================
 
 void Winding::init() {
-    // Compute derived ratios from actual motor configuration.
-    s_carriageStepsPerMM = computeCarriageStepsPerMM(CARRIAGE_MOTOR_PARAMS.microStepsPerRev);
-    s_mandrelStepsPerRev = computeMandrelStepsPerRev(MANDREL_MOTOR_PARAMS.microStepsPerRev);
+    // Debounced limit switches and E-stop; the E-stop interrupt cuts the
+    // drivers itself, update() then stops the job.
+    Inputs::setEStopAction(disableSteppers);
+    Inputs::setPositionSource(Input::CARRIAGE_LIMIT, carriagePosition);
+    Inputs::setPositionSource(Input::TOOLARM_LIMIT, toolarmPosition);
+    Inputs::setPositionSource(Input::TOOLHEAD_LIMIT, toolheadPosition);
+    Inputs::init();
+    if (MANDREL_ENCODER_FITTED) MandrelEncoder::init();
+
+    // Homing slots in HomeAxis order, stall slots in TraceAxis order (once:
+    // init() may run again).
+    if (s_homing.axes() == 0) {
+        s_homing.add(s_carriageHoming, Input::CARRIAGE_LIMIT);
+        s_homing.add(s_toolarmHoming, Input::TOOLARM_LIMIT);
+        s_homing.add(s_toolheadHoming, Input::TOOLHEAD_LIMIT);
+    }
+    if (s_stall.axes() == 0) {
+        s_stall.add(mandrelDriver, mandrelSpeed);
+        s_stall.add(carriageDriver, carriageSpeed);
+        s_stall.add(toolarmDriver, toolarmSpeed);
+        s_stall.add(toolheadDriver, toolheadSpeed);
+    }
 
-    // Configure limit-switch input.
-    pinMode(CARRIAGE_LIMIT_PIN, INPUT_PULLUP);
+    // Drop any queue left from before and start from the first ring slot.
+    s_activeJob  = 0;
+    s_queuedJobs = 0;
+    s_profile    = &s_jobs[0];
+    Planner::init();
 
     s_state = WindingState::IDLE;
 }
 
 void Winding::start() {
-    if (!s_profile.isValid()) {
+    if (!s_profile->isValid()) {
         Serial.println(F("[WINDING] Cannot start — no valid profile loaded."));
         return;
     }
+    if (Inputs::eStopLatched()) {
+        if (!Inputs::clearEStop()) {
+            Serial.println(F("[WINDING] Cannot start — E-stop pressed."));
+            return;
+        }
+        enableSteppers();
+    }
+
+    // Memory peaks are reported per job from here on.
+    MemStat::beginJob();
 
     // Reset runtime variables.
     s_activeLayerIdx = 0;
     s_carAccumulator = 0.0f;
+    s_gearStep       = 0;
+    s_transition     = LayerTransition();
+    s_flip           = ToolheadFlip();
+    s_positioning    = false;
 
-    // Reset progress on every layer.
-    for (int i = 0; i < s_profile.layerCount; i++) {
-        s_profile.layers[i].resetProgress();
-    }
+    // Plans prepared for an earlier run are stale.
+    Planner::reset();
 
-    // Apply winding motion parameters.
+    // Apply winding motion parameters (rebuilds the carriage ramp table).
     mandrelStepper.setMaxSpeed(DEFAULT_MANDREL_MAX_SPEED);
     mandrelStepper.setSpeed(DEFAULT_MANDREL_SPEED);
     carriageStepper.setMaxSpeed(DEFAULT_CARRIAGE_MAX_SPEED);
     carriageStepper.setAcceleration(DEFAULT_CARRIAGE_ACCEL);
 
+    // The axis positions approximate the distances zeroing has to cover.
+    // Layer 0 is planned here; every later plan is prepared in the background.
+    JobEstimate& estimate = s_estimates[s_activeJob];
+    prepareJob(*s_profile, estimate, carriageStepper.currentPosition(), toolarmStepper.currentPosition(),
+               toolheadStepper.currentPosition());
+    s_plan       = &Planner::prime(*s_profile, 0);
+    s_jobStartMs = millis();
+    s_jobStarted = true;
+
     // Begin with a homing sequence.
-    s_state = WindingState::ZEROING;
+    s_homing.start();
+    setState(WindingState::ZEROING);
+    for (int i = 0; i < s_profile->layerCount; i++) {
+        const Layer& l = s_profile->layers[i];
+        if (!l.hasPattern()) continue;
+        Serial.print(F("[WINDING] Layer "));
+        Serial.print(i);
+        Serial.print(F(": pattern "));
+        Serial.print(l.getPatternCircuits());
+        Serial.print(F(" circuits, skip "));
+        Serial.print(l.getPatternSkip());
+        Serial.print(F(", "));
+        Serial.print(estimate.layers[i].totalSeconds, 0);
+        Serial.print(F(" s (band by band "));
+        Serial.print(estimate.layers[i].sequentialSeconds, 0);
+        Serial.println(F(" s)."));
+    }
+    Serial.print(F("[WINDING] Estimated job time "));
+    Serial.print(estimate.totalSeconds, 0);
+    if (estimate.sequentialSeconds != estimate.totalSeconds) {
+        Serial.print(F(" s (band by band "));
+        Serial.print(estimate.sequentialSeconds, 0);
+    }
+    Serial.println(F(" s."));
     Serial.println(F("[WINDING] Zeroing started..."));
 }
 
+bool Winding::enqueue(const WindProfile& job) {
+    if (!job.isValid() || s_queuedJobs >= JOB_QUEUE_SIZE) return false;
+    s_jobs[jobSlot(1 + s_queuedJobs)] = job;
+    s_queuedJobs++;
+
+    // Already on the last layer: start preparing the job right away.
+    if (s_state != WindingState::IDLE && s_state != WindingState::COMPLETE) requestNext();
+    return true;
+}
+
+int Winding::getQueuedJobs() {
+    return s_queuedJobs;
+}
+
+void Winding::prepareJob(WindProfile& job, JobEstimate& estimate, long carriageHome, long toolarmHome,
+                         long toolheadHome) {
+    // Fit the mandrel profile (which also bakes the toolarm target table) and
+    // reset progress on every layer.  The layer plans bake the gear-ratio
+    // tables from it, so the step path never evaluates the spline.
+    if (job.mandrelProfile.getPointCount() >= 2) {
+        job.mandrelProfile.compute(CarriageAxis::stepsPerMM(), ToolarmAxis::stepsPerMM());
+    }
+    for (int i = 0; i < job.layerCount; i++) {
+        job.layers[i].resetProgress();
+    }
+
+    // Plan the winding patterns and predict the job time.
+    EstimateParams params = Estimate::defaultParams(carriageHome, toolarmHome, toolheadHome);
+    params.overlapFlip      = job.overlapToolheadFlip;
+    params.toolarmLookAhead = job.toolarmLookAhead;
+    job.planPatterns(params);
+    estimate = Estimate::job(job, params);
+}
+
 void Winding::pause() {
     if (s_state == WindingState::ZEROING ||
         s_state == WindingState::WINDING ||
         s_state == WindingState::DWELLING) {
         s_stateBeforePause = s_state;
-        s_state = WindingState::PAUSED;
+        setState(WindingState::PAUSED);
         Serial.println(F("[WINDING] Paused."));
     }
 }
 
 void Winding::resume() {
     if (s_state == WindingState::PAUSED) {
-        s_state = s_stateBeforePause;
+        s_stall.start();
+        setState(s_stateBeforePause);
         Serial.println(F("[WINDING] Resumed."));
     }
 }
 
+void Winding::calibrateBacklash() {
+    s_carriageHoming.measureBacklash(BACKLASH_CALIBRATION_CYCLES);
+    s_toolarmHoming.measureBacklash(BACKLASH_CALIBRATION_CYCLES);
+    s_toolheadHoming.measureBacklash(BACKLASH_CALIBRATION_CYCLES);
+}
+
 WindProfile& Winding::getProfile() {
-    return s_profile;
+    return *s_profile;
 }
 
 WindingState Winding::getState() {
@@ -123,11 +735,37 @@ int Winding::getActiveLayerIndex() {
     return s_activeLayerIdx;
 }
 
+const JobEstimate& Winding::getEstimate() {
+    return s_estimates[s_activeJob];
+}
+
+const HomingReport& Winding::getHomingReport(HomeAxis axis) {
+    return s_homing.axis(static_cast<uint8_t>(axis)).report();
+}
+
+const StallAlarm& Winding::getStallAlarm() {
+    return s_stallAlarm;
+}
+
+const StallMonitor& Winding::getStallMonitor() {
+    return s_stall;
+}
+
+long Winding::getGearedStep() {
+    return s_gearStep;
+}
+
+float Winding::getElapsedSeconds() {
+    return s_jobStarted ? (millis() - s_jobStartMs) / 1000.0f : 0.0f;
+}
+
 // ============================================================================
 //  Winding Controller — State Machine (called every loop())
 // ============================================================================
 
 void Winding::update() {
+    pollInputs();
+
     switch (s_state) {
 
     // ── Nothing to do in these states ────────────────────────────────────────
@@ -136,34 +774,66 @@ void Winding::update() {
     case WindingState::COMPLETE:
         return;
 
-    // ── ZEROING: drive carriage toward the home limit switch ─────────────────
+    // ── ZEROING: home every axis against its limit switch ───────────────────
     case WindingState::ZEROING: {
-        carriageStepper.setSpeed(-ZEROING_SPEED);
-        carriageStepper.runSpeed();
-
-        if (digitalRead(CARRIAGE_LIMIT_PIN) == LOW) {
-            carriageStepper.stop();
-            carriageStepper.setCurrentPosition(0);
-            s_lastMandrelStep = mandrelStepper.currentPosition();
-            s_carAccumulator  = 0.0f;
-            s_state = WindingState::WINDING;
-            Serial.println(F("[WINDING] Zeroing complete. Winding layer 0..."));
+        if (s_homing.update()) break;
+
+        if (s_homing.failed()) {
+            mandrelStepper.setSpeed(0);
+            setState(WindingState::IDLE);
+            printHoming();
+            break;
         }
+
+        if (!s_positioning) {
+            // Back to the winding limits the seeks replaced, the toolhead
+            // to the first pass's orientation and the toolarm to the surface.
+            carriageStepper.setMaxSpeed(DEFAULT_CARRIAGE_MAX_SPEED);
+            carriageStepper.setAcceleration(DEFAULT_CARRIAGE_ACCEL);
+            toolheadStepper.setMaxSpeed(DEFAULT_TOOLHEAD_MAX_SPEED);
+            toolheadStepper.setAcceleration(DEFAULT_TOOLHEAD_ACCEL);
+            toolheadStepper.moveTo(Estimate::toolheadSteps(s_profile->layers[0], true));
+            toolarmStepper.setMaxSpeed(DEFAULT_TOOLARM_MAX_SPEED);
+            toolarmStepper.setAcceleration(DEFAULT_TOOLARM_ACCEL);
+            if (s_plan->toolarm.isActive()) {
+                toolarmStepper.moveTo(s_profile->mandrelProfile.getTargetStepsLerp(carriageStepper.currentPosition()));
+            }
+            s_positioning = true;
+            printHoming();
+        }
+        const bool toolheadMoving = toolheadStepper.run();
+        const bool toolarmMoving  = toolarmStepper.run();
+        if (toolheadMoving || toolarmMoving) break;
+
+        // The mandrel stood while homing: measured and commanded agree.
+        s_positioning = false;
+        s_windSpeed   = mandrelStepper.speed();
+        if (MandrelEncoder::enabled()) MandrelEncoder::setSteps(mandrelStepper.currentPosition());
+        s_followingBase = 0;
+        s_followingFrom = mandrelStepper.currentPosition();
+        s_stall.start();
+        beginLayer();
+        Serial.println(F("[WINDING] Zeroing complete. Winding layer 0..."));
         break;
     }
 
     // ── WINDING: electronic gearing — sync carriage to mandrel ──────────────
     case WindingState::WINDING: {
-        Layer& active = s_profile.layers[s_activeLayerIdx];
+        Layer& active = s_profile->layers[s_activeLayerIdx];
 
-        const float ratio  = active.getStepRatio(s_carriageStepsPerMM, s_mandrelStepsPerRev);
+        // Index by the geared command; the carriage holds it to within a
+        // step or two once it has caught up.
+        const float ratio  = s_plan->gear.ratioAt(s_gearStep);
         const float target = active.getTargetEndpoint();
 
-        // 1. Spin mandrel at constant speed.
+        // 1. Spin the mandrel at the winding speed, or the toolarm plan's
+        //    slower one where the carriage is.
         mandrelStepper.runSpeed();
+        if (checkFollowing() || checkStall()) break;
 
-        // 2. Synchronise carriage to mandrel via fractional-step accumulator.
-        long stepNow = mandrelStepper.currentPosition();
+        // 2. Advance the geared command via fractional-step accumulator and
+        //    slave the carriage speed to it.
+        long stepNow = mandrelAngle();
 
         if (stepNow != s_lastMandrelStep) {
             long delta = stepNow - s_lastMandrelStep;
@@ -174,62 +844,147 @@ void Winding::update() {
 
             if (fabsf(s_carAccumulator) >= 1.0f) {
                 long steps = static_cast<long>(s_carAccumulator);
-                carriageStepper.move(steps);
+                s_gearStep       += steps;
                 s_carAccumulator -= steps;
+
+                // Hold the command at the end of a hand-over.
+                if (s_transition.pending &&
+                    (active.isGoingForward() ? s_gearStep >= s_transition.endStep
+                                             : s_gearStep <= s_transition.endStep)) {
+                    s_gearStep       = s_transition.endStep;
+                    s_carAccumulator = 0.0f;
+                }
+
+                Trace::record(TraceEvent::STEP_BURST,
+                              static_cast<uint16_t>(TraceAxis::CARRIAGE), steps);
+                Trace::record(TraceEvent::QUEUE_LEVEL,
+                              static_cast<uint16_t>(TraceAxis::CARRIAGE),
+                              s_gearStep - carriageStepper.currentPosition());
             }
+            limitMandrel();
+            const bool held = s_transition.pending && s_gearStep == s_transition.endStep;
+            followGear(held ? 0.0f : ratio * sign * mandrelStepper.speed());
+            if (s_plan->toolarm.isActive()) followProfile(carriageStepper.speed());
+        }
+
+        // A hand-over ends at rest on the layer's end step: once the carriage
+        // is within its stopping distance, run the rest as a positioned move.
+        if (s_transition.pending && !s_transition.braking &&
+            labs(s_transition.endStep - carriageStepper.currentPosition()) <=
+                carriageStepper.stepsToStop() + 1) {
+            s_transition.braking = true;
+            carriageStepper.moveTo(s_transition.endStep);
         }
 
         carriageStepper.run();
 
-        // 3. Detect end of pass.
-        float posMM = carriageStepper.currentPosition() / s_carriageStepsPerMM;
+        // 3. Flip the toolhead towards the next pass from the lead on; the
+        //    toolarm follows the surface.
+        if (s_flip.pending && labs(s_flip.endStep - carriageStepper.currentPosition()) <= s_flip.leadSteps) {
+            startFlip();
+        }
+        runToolhead();
+        toolarmStepper.run();
+
+        // 4. Detect end of pass.
+        float posMM = CarriageAxis::toMM(carriageStepper.currentPosition());
 
         bool reached = active.isGoingForward()
                      ? (posMM >= target)
                      : (posMM <= target);
+        if (s_transition.pending) {
+            reached = (carriageStepper.currentPosition() == s_transition.endStep);
+        }
 
         if (reached) {
-            // Compute dwell: fibre-placement rotation + stepover shift.
-            float totalDeg    = active.getDwell() + active.getStepoverDegrees();
-            long  dwellSteps  = static_cast<long>(
-                (totalDeg / 360.0f) * s_mandrelStepsPerRev);
-            s_dwellTargetStep = mandrelStepper.currentPosition() + dwellSteps;
+            // The carriage turns around from rest; nothing of this pass's
+            // ramp carries into the next.
+            carriageStepper.setSpeed(0.0f);
+            if (s_flip.pending) startFlip();
+            if (s_plan->toolarm.isActive()) {
+                toolarmStepper.moveTo(s_profile->mandrelProfile.getTargetStepsLerp(carriageStepper.currentPosition()));
+            }
 
-            s_state = WindingState::DWELLING;
+            // The layer's first pass need not start at an end (zeroing, or
+            // the previous layer's hand-over), so phase the pattern from
+            // where it ended, as if it had been a full pass.
+            if (active.hasPattern() && active.getPassesCompleted() == 0) {
+                s_layerStartStep = mandrelAngle() - s_plan->phaseSteps;
+            }
+
+            // Compute dwell: fibre-placement rotation + stepover shift, or
+            // the winding pattern's turn-around (landing each new circuit
+            // on its slot, so pass-rotation errors don't accumulate).
+            long dwellSteps = s_transition.pending
+                            ? s_transition.dwellSteps
+                            : Pattern::turnaroundSteps(active, mandrelAngle(),
+                                                       s_layerStartStep, MandrelAxis::stepsPerRev());
+            s_dwellStart      = mandrelAngle();
+            s_dwellTargetStep = s_dwellStart + dwellSteps;
+            beginDwellRamp();
+
+            setState(WindingState::DWELLING);
         }
         break;
     }
 
     // ── DWELLING: extra mandrel rotation while carriage is stationary ────────
     case WindingState::DWELLING: {
-        mandrelStepper.runSpeed();
+        // Past the dwell the mandrel holds until the toolhead flip is far
+        // enough along for the next pass.  The toolarm settles on the end.
+        if (mandrelAngle() < s_dwellTargetStep) {
+            if (mandrelStepper.runSpeed()) rampDwell();
+            if (checkFollowing()) break;
+        }
+        if (checkStall()) break;
+        runToolhead();
+        toolarmStepper.run();
 
-        if (mandrelStepper.currentPosition() >= s_dwellTargetStep) {
-            Layer& active = s_profile.layers[s_activeLayerIdx];
+        if (mandrelAngle() >= s_dwellTargetStep && labs(toolheadStepper.distanceToGo()) <= s_flip.holdSteps) {
+            Layer& active = s_profile->layers[s_activeLayerIdx];
             active.countPass();
+            Trace::record(TraceEvent::PASS_END, static_cast<uint16_t>(s_activeLayerIdx),
+                          active.getPassesCompleted());
 
             if (active.isDone()) {
-                // Try to advance to the next layer.
-                if (s_activeLayerIdx < s_profile.layerCount - 1) {
+                // Try to advance to the next layer, then to the next queued
+                // job; either way the plan was prepared while this layer wound.
+                if (s_activeLayerIdx < s_profile->layerCount - 1) {
                     s_activeLayerIdx++;
-                    s_carAccumulator  = 0.0f;
-                    s_lastMandrelStep = mandrelStepper.currentPosition();
-                    s_state = WindingState::WINDING;
+                    s_plan = &Planner::acquire(*s_profile, s_activeLayerIdx);
+                    beginLayer();
 
                     Serial.print(F("[WINDING] Layer "));
                     Serial.print(s_activeLayerIdx);
                     Serial.println(F(" started."));
+                } else if (s_queuedJobs > 0) {
+                    // The carriage stays referenced, so the job starts
+                    // without zeroing.
+                    s_activeJob      = jobSlot(1);
+                    s_queuedJobs--;
+                    s_profile        = &s_jobs[s_activeJob];
+                    s_activeLayerIdx = 0;
+                    s_plan           = &Planner::acquire(*s_profile, 0, &s_estimates[s_activeJob]);
+                    MemStat::beginJob();
+                    s_jobStartMs = millis();
+                    beginLayer();
+
+                    Serial.print(F("[WINDING] Next job started ("));
+                    Serial.print(s_queuedJobs);
+                    Serial.println(F(" more queued)."));
                 } else {
                     // All layers complete — stop motors.
                     mandrelStepper.setSpeed(0);
                     carriageStepper.setSpeed(0);
-                    s_state = WindingState::COMPLETE;
+                    setState(WindingState::COMPLETE);
                     Serial.println(F("[WINDING] All layers complete."));
                 }
             } else {
                 // Continue with the next pass of the current layer.
-                s_lastMandrelStep = mandrelStepper.currentPosition();
-                s_state = WindingState::WINDING;
+                beginPass();
+                setState(WindingState::WINDING);
+                planTransition();
+                planFlip();
             }
         }
         break;
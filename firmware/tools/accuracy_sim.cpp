@@ -0,0 +1,407 @@
+/// @file accuracy_sim.cpp
+/// @brief Fibre-placement accuracy simulator with golden-file regression check.
+///
+/// Runs a profile through the real winding state machine in virtual time (or
+/// replays a recorded step trace) and measures, for every pass, how far the
+/// laid fibre strays from the ideal helix implied by the layer geometry:
+///
+///   axial error  carriage position minus the ideal helix through the pass
+///                start point, at every recorded step inside the layer's
+///                winding zone (mm; outside it the fibre turns around)
+///   angle error  fibre angle over a sliding 10° mandrel window minus the
+///                nominal layer angle, inside the zone (degrees)
+///   phase error  circumferential offset of the pass start from where exact
+///                dwell + stepover arithmetic would put it (mm at the surface);
+///                for winding patterns, from the circuit's slot (plus the
+///                ideal traverse and planned turn-around on return passes),
+///                taken modulo one revolution, against the reference the
+///                firmware phases the pattern from (the end of the layer's
+///                first pass less one steady pass)
+///
+///     accuracy_sim <profile> [--loop-us N] [--per-pass]
+///                  [--steps-out trace.csv | --steps-in trace.csv]
+///                  [--golden file | --write-golden file]
+///
+/// With --golden the summary is compared against a stored baseline and the
+/// tool exits 1 if any metric regressed beyond its tolerance.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "sim.h"
+#include "pattern.h"
+
+/// Mandrel rotation over which the local fibre angle is measured.
+constexpr double ANGLE_WINDOW_DEG = 10.0;
+
+// ============================================================================
+//  Metrics
+// ============================================================================
+
+/// Accuracy figures for one pass.
+struct PassStats {
+    int    layer = 0;
+    int    pass  = 0;
+    double maxAxialMM   = 0.0;
+    double sumSqAxial   = 0.0;
+    long   axialSamples = 0;
+    double maxAngleDeg  = 0.0;
+    double sumSqAngle   = 0.0;
+    long   angleSamples = 0;
+    double phaseMM      = 0.0;
+};
+
+/// Job-wide summary (the values stored in golden files).
+struct Summary {
+    int    passes         = 0;
+    double maxAxialMM     = 0.0;
+    double rmsAxialMM     = 0.0;
+    double maxAngleErrDeg = 0.0;
+    double rmsAngleErrDeg = 0.0;
+    double maxPhaseMM     = 0.0;
+    double finalPhaseMM   = 0.0;
+};
+
+// Ideal carriage travel (mm) per mandrel revolution for a layer.
+static double idealMMPerRev(const Layer& l) {
+    return M_PI * l.getDiameter() / tan(l.getAngle() * M_PI / 180.0);
+}
+
+// Ideal mandrel rotation (revs) for the dwell + stepover shift of a layer,
+// or its pattern's turn-around rotation.
+static double idealShiftRevs(const Layer& l) {
+    if (l.hasPattern()) return l.getTurnaroundDegrees() / 360.0;
+    double stepoverDeg = l.getStepover() * 360.0 /
+                         (M_PI * l.getDiameter() * cos(l.getAngle() * M_PI / 180.0));
+    return (l.getDwell() + stepoverDeg) / 360.0;
+}
+
+// Split the trace into passes and measure each one.
+static std::vector<PassStats> analyse(const SimProfile& profile,
+                                      const std::vector<StepSample>& trace) {
+    const double stepsPerMM  = Sim::carriageStepsPerMM();
+    const double stepsPerRev = Sim::mandrelStepsPerRev();
+
+    // The layers as the firmware planned them at start().
+    const EstimateParams params  = Estimate::defaultParams();
+    const SplineProfile* mandrel = fitMandrel(profile);
+    std::vector<Layer>   planned = profile.layers;
+    if (profile.patternSequencing) {
+        for (Layer& l : planned) Pattern::apply(l, params);
+    }
+
+    std::vector<PassStats> out;
+    size_t i = 0;
+
+    // Ideal bookkeeping for the phase metric.
+    bool   haveJobStart  = false;
+    long   jobStartStep  = 0;
+    double idealRevs     = 0.0;   // Ideal rotation from job start to this pass start.
+    double idealEndMM    = 0.0;   // Ideal carriage position at the end of the last pass.
+    int    phaseLayer    = -1;    // Layer the pattern bookkeeping below belongs to.
+    long   layerStep     = 0;     // Phase reference of that layer (mandrel steps).
+    double circuitRevs   = 0.0;   // Ideal phase of the current pass start in the layer (revs).
+
+    while (i < trace.size()) {
+        // Find the sample where a pass starts (state becomes WINDING).
+        if (trace[i].state != WindingState::WINDING ||
+            (i > 0 && trace[i - 1].state == WindingState::WINDING)) {
+            i++;
+            continue;
+        }
+
+        const StepSample& start = trace[i];
+        if (start.layer >= static_cast<int>(profile.layers.size())) break;
+        const Layer& layer  = planned[start.layer];
+        const double k      = idealMMPerRev(layer);
+        const double circ   = M_PI * layer.getDiameter();
+        const bool   fwd    = (start.pass % 2) == 0;
+        const double sign   = fwd ? 1.0 : -1.0;
+        const double x0     = start.carriage / stepsPerMM;
+        const long   m0     = start.mandrel;
+
+        PassStats ps;
+        ps.layer = start.layer;
+        ps.pass  = start.pass;
+
+        if (!haveJobStart) {
+            haveJobStart = true;
+            jobStartStep = m0;
+            idealEndMM   = x0;
+        }
+        // A pattern is phased from the end of its layer's first pass, less
+        // one steady pass (as the firmware does, since the first pass may
+        // start short of the zone); that pass itself defines the reference.
+        const bool firstOfLayer = layer.hasPattern() && start.layer != phaseLayer;
+        if (layer.hasPattern()) {
+            if (fwd) {
+                circuitRevs = static_cast<double>(Pattern::slot(layer, start.pass / 2)) /
+                              layer.getPatternCircuits();
+            }
+            phaseLayer = start.layer;
+        }
+        if (firstOfLayer) {
+            ps.phaseMM = 0.0;
+        } else if (layer.hasPattern()) {
+            double d = (m0 - layerStep) / stepsPerRev - circuitRevs;
+            ps.phaseMM = (d - floor(d + 0.5)) * circ;
+        } else {
+            ps.phaseMM = ((m0 - jobStartStep) / stepsPerRev - idealRevs) * circ;
+        }
+
+        // Walk the pass up to and including the sample that ends it.
+        const long   windowSteps = static_cast<long>(ANGLE_WINDOW_DEG / 360.0 * stepsPerRev);
+        const double zoneFrom    = layer.getOffset() - 0.5 / stepsPerMM;
+        const double zoneTo      = layer.getOffset() + layer.getLength() + 0.5 / stepsPerMM;
+        size_t back = i;
+        size_t j    = i;
+        for (; j < trace.size(); j++) {
+            const StepSample& s = trace[j];
+            if (j > i && s.state != WindingState::WINDING &&
+                trace[j - 1].state != WindingState::WINDING) break;
+
+            // Fibre outside the winding zone is turn-around: a pass may start
+            // short of it (from home or a hand-over) or brake past it.
+            const double x = s.carriage / stepsPerMM;
+            if (x < zoneFrom || x > zoneTo) {
+                if (s.state != WindingState::WINDING) {
+                    j++;
+                    break;
+                }
+                continue;
+            }
+            const double ideal = x0 + sign * k * (s.mandrel - m0) / stepsPerRev;
+            const double err   = fabs(x - ideal);
+            ps.maxAxialMM  = fmax(ps.maxAxialMM, err);
+            ps.sumSqAxial += err * err;
+            ps.axialSamples++;
+
+            while (back < j && s.mandrel - trace[back + 1].mandrel >= windowSteps) back++;
+            const long dm = s.mandrel - trace[back].mandrel;
+            if (dm >= windowSteps) {
+                const double dx    = fabs(x - trace[back].carriage / stepsPerMM);
+                const double angle = atan2(circ * dm / stepsPerRev, dx) * 180.0 / M_PI;
+                const double aerr  = fabs(angle - layer.getAngle());
+                ps.maxAngleDeg  = fmax(ps.maxAngleDeg, aerr);
+                ps.sumSqAngle  += aerr * aerr;
+                ps.angleSamples++;
+            }
+
+            if (s.state != WindingState::WINDING) {
+                j++;
+                break;
+            }
+        }
+
+        // Advance the ideal rotation by this pass's travel plus the dwell shift.
+        // A hand-over brakes past the layer's end.
+        const bool   handOver = start.pass == layer.getTotalPasses() - 1 &&
+                                start.layer + 1 < static_cast<int>(planned.size());
+        const double target   = handOver ? Estimate::handOverEndMM(layer, params, mandrel)
+                              : fwd      ? layer.getOffset() + layer.getLength()
+                                         : layer.getOffset();
+        const double shiftRevs = handOver ? layer.getDwell() / 360.0 : idealShiftRevs(layer);
+        const double passRevs  = fabs(target - idealEndMM) / k + shiftRevs;
+        idealRevs   += passRevs;
+        circuitRevs += passRevs;
+        idealEndMM   = target;
+        if (firstOfLayer) {
+            const double steadyRevs = Estimate::passDegrees(layer, params) / 360.0;
+            layerStep   = trace[j - 1].mandrel - lround(steadyRevs * stepsPerRev);
+            circuitRevs = steadyRevs + shiftRevs;
+        }
+
+        out.push_back(ps);
+        i = j;
+    }
+    return out;
+}
+
+static Summary summarise(const std::vector<PassStats>& passes) {
+    Summary s;
+    double sumAx = 0.0, sumAn = 0.0;
+    long   nAx   = 0,   nAn   = 0;
+
+    for (const PassStats& p : passes) {
+        s.maxAxialMM     = fmax(s.maxAxialMM, p.maxAxialMM);
+        s.maxAngleErrDeg = fmax(s.maxAngleErrDeg, p.maxAngleDeg);
+        s.maxPhaseMM     = fmax(s.maxPhaseMM, fabs(p.phaseMM));
+        sumAx += p.sumSqAxial;  nAx += p.axialSamples;
+        sumAn += p.sumSqAngle;  nAn += p.angleSamples;
+    }
+    s.passes         = static_cast<int>(passes.size());
+    s.rmsAxialMM     = nAx ? sqrt(sumAx / nAx) : 0.0;
+    s.rmsAngleErrDeg = nAn ? sqrt(sumAn / nAn) : 0.0;
+    s.finalPhaseMM   = passes.empty() ? 0.0 : passes.back().phaseMM;
+    return s;
+}
+
+// ============================================================================
+//  Golden Files
+// ============================================================================
+
+/// One summary field with its regression tolerance.
+struct Metric {
+    const char* key;
+    double      Summary::*field;
+    double      absTol;     ///< Allowed absolute increase.
+    double      relTol;     ///< Allowed relative increase.
+};
+
+static const Metric METRICS[] = {
+    { "max_axial_mm",      &Summary::maxAxialMM,     0.01, 0.05 },
+    { "rms_axial_mm",      &Summary::rmsAxialMM,     0.01, 0.05 },
+    { "max_angle_err_deg", &Summary::maxAngleErrDeg, 0.05, 0.05 },
+    { "rms_angle_err_deg", &Summary::rmsAngleErrDeg, 0.05, 0.05 },
+    { "max_phase_mm",      &Summary::maxPhaseMM,     0.05, 0.05 },
+};
+
+static bool writeGolden(const char* path, const char* profilePath, const Summary& s) {
+    FILE* f = fopen(path, "w");
+    if (!f) return false;
+    fprintf(f, "# accuracy_sim golden summary for %s\n", profilePath);
+    fprintf(f, "# Regenerate with --write-golden only after reviewing the change.\n");
+    fprintf(f, "passes %d\n", s.passes);
+    for (const Metric& m : METRICS) fprintf(f, "%s %.6f\n", m.key, s.*m.field);
+    return fclose(f) == 0;
+}
+
+// @return 0 on pass, 1 on regression, 2 if the golden file is unusable.
+static int checkGolden(const char* path, const Summary& s) {
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "accuracy_sim: cannot open golden file %s\n", path);
+        return 2;
+    }
+    std::map<std::string, double> golden;
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        char   key[64];
+        double v;
+        if (line[0] != '#' && sscanf(line, "%63s %lf", key, &v) == 2) golden[key] = v;
+    }
+    fclose(f);
+
+    int rc = 0;
+    if (!golden.count("passes") || static_cast<int>(golden["passes"]) != s.passes) {
+        printf("FAIL  passes: %d, golden %d\n", s.passes, static_cast<int>(golden["passes"]));
+        rc = 1;
+    }
+    for (const Metric& m : METRICS) {
+        if (!golden.count(m.key)) {
+            fprintf(stderr, "accuracy_sim: golden file lacks %s\n", m.key);
+            return 2;
+        }
+        const double g     = golden[m.key];
+        const double v     = s.*m.field;
+        const double limit = g + fmax(m.absTol, fabs(g) * m.relTol);
+        const bool   bad   = v > limit;
+        printf("%s  %-18s %10.4f  golden %10.4f  limit %10.4f\n",
+               bad ? "FAIL" : "ok  ", m.key, v, g, limit);
+        if (bad) rc = 1;
+    }
+    return rc;
+}
+
+// ============================================================================
+//  Main
+// ============================================================================
+
+static void usage() {
+    fprintf(stderr,
+            "usage: accuracy_sim <profile> [--loop-us N] [--per-pass]\n"
+            "                    [--steps-out trace.csv | --steps-in trace.csv]\n"
+            "                    [--golden file | --write-golden file]\n");
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        usage();
+        return 2;
+    }
+
+    const char* profilePath = argv[1];
+    const char* stepsOut    = nullptr;
+    const char* stepsIn     = nullptr;
+    const char* golden      = nullptr;
+    const char* writeTo     = nullptr;
+    bool        perPass     = false;
+    SimOptions  options;
+
+    for (int a = 2; a < argc; a++) {
+        bool hasValue = a + 1 < argc;
+        if      (!strcmp(argv[a], "--loop-us") && hasValue)      options.loopUs = atoi(argv[++a]);
+        else if (!strcmp(argv[a], "--steps-out") && hasValue)    stepsOut = argv[++a];
+        else if (!strcmp(argv[a], "--steps-in") && hasValue)     stepsIn  = argv[++a];
+        else if (!strcmp(argv[a], "--golden") && hasValue)       golden   = argv[++a];
+        else if (!strcmp(argv[a], "--write-golden") && hasValue) writeTo  = argv[++a];
+        else if (!strcmp(argv[a], "--per-pass"))                 perPass  = true;
+        else {
+            usage();
+            return 2;
+        }
+    }
+
+    SimProfile  profile;
+    std::string error;
+    if (!loadProfile(profilePath, profile, error)) {
+        fprintf(stderr, "accuracy_sim: %s\n", error.c_str());
+        return 2;
+    }
+
+    Serial.setSink(nullptr);
+    std::vector<StepSample> trace;
+    if (stepsIn) {
+        if (!Sim::readTrace(stepsIn, trace)) {
+            fprintf(stderr, "accuracy_sim: cannot read %s\n", stepsIn);
+            return 2;
+        }
+    } else {
+        SimResult result;
+        if (!Sim::run(profile, options, &trace, result)) {
+            fprintf(stderr, "accuracy_sim: profile has more than %d layers\n", MAX_LAYERS);
+            return 2;
+        }
+        if (!result.completed) {
+            fprintf(stderr, "accuracy_sim: job did not complete within the timeout\n");
+            return 1;
+        }
+        printf("job time %.1f s (virtual), %llu loop passes\n",
+               result.durationUs / 1e6, static_cast<unsigned long long>(result.loops));
+        if (stepsOut && !Sim::writeTrace(stepsOut, trace)) {
+            fprintf(stderr, "accuracy_sim: cannot write %s\n", stepsOut);
+            return 2;
+        }
+    }
+
+    std::vector<PassStats> passes = analyse(profile, trace);
+    Summary s = summarise(passes);
+
+    if (perPass) {
+        printf("layer pass  max_axial_mm  rms_axial_mm  max_angle_err  phase_mm\n");
+        for (const PassStats& p : passes) {
+            printf("%5d %4d  %12.4f  %12.4f  %13.4f  %8.3f\n", p.layer, p.pass, p.maxAxialMM,
+                   p.axialSamples ? sqrt(p.sumSqAxial / p.axialSamples) : 0.0,
+                   p.maxAngleDeg, p.phaseMM);
+        }
+    }
+    printf("passes %d  axial max %.4f / rms %.4f mm  angle max %.3f / rms %.3f deg  "
+           "phase max %.3f / final %.3f mm\n",
+           s.passes, s.maxAxialMM, s.rmsAxialMM, s.maxAngleErrDeg, s.rmsAngleErrDeg,
+           s.maxPhaseMM, s.finalPhaseMM);
+
+    if (writeTo) {
+        if (!writeGolden(writeTo, profilePath, s)) {
+            fprintf(stderr, "accuracy_sim: cannot write %s\n", writeTo);
+            return 2;
+        }
+        printf("golden written to %s\n", writeTo);
+    }
+    if (golden) return checkGolden(golden, s);
+    return 0;
+}
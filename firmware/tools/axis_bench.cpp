@@ -0,0 +1,105 @@
+/// @file axis_bench.cpp
+/// @brief Compare the unit conversions on the step path: ratios derived at
+///        run time (the old Winding::init() helpers) versus the compile-time
+///        axis constants in axis.h.
+///
+///     axis_bench [--n N]
+///
+/// Three conversions are timed over N chained calls each:
+///
+///   end-of-pass   carriage steps → mm       runtime: steps / stepsPerMM
+///                                           axis.h:  steps × mmPerStep
+///   toolarm       mm → toolarm steps        runtime: mm × stepsPerMM (loaded)
+///                                           axis.h:  mm × literal
+///   dwell         degrees → mandrel steps   runtime: deg / 360 × stepsPerRev
+///                                           axis.h:  deg × stepsPerDegree
+///
+/// The runtime ratios are read from a volatile microstep setting, as the
+/// firmware read StepperMotorParams at start-up.  Prints ns per conversion
+/// (host), the largest difference between the two results and the constants
+/// themselves.  Host x86 divides in hardware, so the gap on the ESP32 —
+/// whose FPU has no divide instruction — is larger than shown here.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+#include "axis.h"
+
+static volatile uint16_t s_microStepsPerRev = CARRIAGE_MOTOR_PARAMS.microStepsPerRev;
+static volatile float    s_sink;   // Keeps the timed loops from being optimised away.
+
+// The ratios as the removed config.h helpers derived them at run time.
+struct RuntimeRatios {
+    float carriageStepsPerMM;
+    float toolarmStepsPerMM;
+    float mandrelStepsPerRev;
+};
+
+static RuntimeRatios runtimeRatios() {
+    const float micro = s_microStepsPerRev;
+    RuntimeRatios r;
+    r.carriageStepsPerMM = micro / (CARRIAGE_PULLEY_TEETH * 2.0f);
+    r.toolarmStepsPerMM  = micro / 4.0f;
+    r.mandrelStepsPerRev = micro * (static_cast<float>(MANDREL_PULLEY_TEETH) / MOTOR_PULLEY_TEETH);
+    return r;
+}
+
+// Each conversion feeds the next, as on the step path where one result
+// gates the branch that follows, so the loop measures latency.
+template <typename Fn>
+static double nsPerCall(long n, Fn fn) {
+    auto  t0 = std::chrono::steady_clock::now();
+    float x  = 0.0f;
+    for (long i = 0; i < n; i++) x = fn(x + static_cast<float>(i & 0xFFFF));
+    auto t1 = std::chrono::steady_clock::now();
+    s_sink  = x;
+    return std::chrono::duration<double, std::nano>(t1 - t0).count() / n;
+}
+
+// Over ±2^20 steps (±26 m of carriage travel, ±273 mandrel revolutions).
+template <typename Old, typename New>
+static double worstDiff(Old oldFn, New newFn) {
+    double worst = 0.0;
+    for (long i = -(1L << 20); i <= (1L << 20); i += 7) {
+        worst = fmax(worst, fabs(double(oldFn(static_cast<float>(i))) - newFn(static_cast<float>(i))));
+    }
+    return worst;
+}
+
+int main(int argc, char** argv) {
+    long n = 50000000;
+    for (int a = 1; a < argc; a++) {
+        if (!strcmp(argv[a], "--n") && a + 1 < argc) {
+            n = atol(argv[++a]);
+        } else {
+            fprintf(stderr, "usage: axis_bench [--n N]\n");
+            return 2;
+        }
+    }
+
+    const RuntimeRatios rt = runtimeRatios();
+
+    printf("constant                 runtime          axis.h\n");
+    printf("carriage steps/mm   %12.6f  %14.6f\n", rt.carriageStepsPerMM, CarriageAxis::stepsPerMM());
+    printf("toolarm steps/mm    %12.6f  %14.6f\n", rt.toolarmStepsPerMM, ToolarmAxis::stepsPerMM());
+    printf("mandrel steps/rev   %12.6f  %14.6f\n", rt.mandrelStepsPerRev, MandrelAxis::stepsPerRev());
+
+    auto endOld = [&](float v) { return v / rt.carriageStepsPerMM; };
+    auto endNew = [](float v)  { return v * CarriageAxis::mmPerStep(); };
+    auto armOld = [&](float v) { return (v * 0.001f) * rt.toolarmStepsPerMM; };
+    auto armNew = [](float v)  { return ToolarmAxis::toSteps(v * 0.001f); };
+    auto dwlOld = [&](float v) { return ((v * 0.01f) / 360.0f) * rt.mandrelStepsPerRev; };
+    auto dwlNew = [](float v)  { return MandrelAxis::toSteps(v * 0.01f); };
+
+    printf("\nconversion     runtime_ns  axis_ns  speedup  max_diff\n");
+    const double e0 = nsPerCall(n, endOld), e1 = nsPerCall(n, endNew);
+    printf("end-of-pass    %10.3f  %7.3f  %6.2fx  %.3g mm\n", e0, e1, e0 / e1, worstDiff(endOld, endNew));
+    const double a0 = nsPerCall(n, armOld), a1 = nsPerCall(n, armNew);
+    printf("toolarm        %10.3f  %7.3f  %6.2fx  %.3g steps\n", a0, a1, a0 / a1, worstDiff(armOld, armNew));
+    const double d0 = nsPerCall(n, dwlOld), d1 = nsPerCall(n, dwlNew);
+    printf("dwell          %10.3f  %7.3f  %6.2fx  %.3g steps\n", d0, d1, d0 / d1, worstDiff(dwlOld, dwlNew));
+    return 0;
+}
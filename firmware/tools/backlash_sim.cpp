@@ -0,0 +1,485 @@
+/// @file backlash_sim.cpp
+/// @brief Backlash compensation and its calibration against drives with a
+///        dead band, through thousands of reversals.
+///
+///     backlash_sim [profile] [--reversals N] [--carriage-um U]
+///                  [--toolhead-deg A] [--loop-us N] [--loop-jitter-us N]
+///                  [--seed N]
+///
+/// The carriage and the toolhead drive a load through a dead band of
+/// --carriage-um (default 150 µm) and --toolhead-deg (default 0.5°): after
+/// a reversal the motor turns that far before the load moves.  Each axis
+/// runs N reversals (default 5000) of positioned moves, velocity-mode
+/// reversals through rest and abrupt constant-speed reversals, with the
+/// compensation set to the dead band, off, and a step under and over it.
+/// Every loop() pass takes --loop-us (default 20) plus up to
+/// --loop-jitter-us (default 200) of virtual time.  The tool prints the
+/// spread of the load position less the logical one over the run — 0 if
+/// the logical position is the load's.
+///
+/// Then each axis homes against its limit switch, which closes at a load
+/// position and opens a differential past it, with the backlash measured
+/// (HomingAxis::measureBacklash()) over a range of dead bands and
+/// differentials, starting anywhere in the dead band; after each it runs
+/// reversals on the measured compensation.
+///
+/// Given a profile, last, the job is wound in the simulator with the same
+/// dead bands, uncompensated and calibrated while homing
+/// (Winding::calibrateBacklash()), and the tool prints the spread of load
+/// less logical position over the job for both axes.
+///
+/// Checks, each failing the tool (exit code 1):
+///
+///   - the motor's pulses are the logical steps plus the slack, always;
+///   - the load position less the logical one spreads by exactly the
+///     compensation's error — none set to the dead band — and does not
+///     drift through the reversals;
+///   - every calibration completes and measures the dead band to the step,
+///     home is the switch's closing point, and the reversals after it keep
+///     the load at the logical position;
+///   - the calibrated job completes with the load at the logical position
+///     throughout (within a step).
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "sim.h"
+#include "axis.h"
+#include "config.h"
+#include "homing.h"
+#include "inputs.h"
+#include "motor_control.h"
+
+// ============================================================================
+//  Simulated Drives
+// ============================================================================
+
+// A motor driving its load through a dead band (gap 0 … backlash: the
+// motor pushing towards negative … positive positions), and a limit switch
+// that closes with the load at switchAt and opens differential past it.
+struct Drive {
+    uint8_t stepPin;
+    uint8_t dirPin;
+    uint8_t limitPin;
+    long    physical;
+    long    load;
+    long    gap;
+    long    backlash;
+    long    switchAt;
+    long    differential;
+    bool    closed;
+    uint8_t dirLevel;
+    uint8_t stepLevel;
+};
+
+static Drive s_carriage = { CARRIAGE_MOTOR_PARAMS.step_pin, CARRIAGE_MOTOR_PARAMS.dir_pin,
+                            CARRIAGE_LIMIT_PIN, 0, 0, 0, 0, 0, 0, false, LOW, LOW };
+static Drive s_toolhead = { TOOLHEAD_MOTOR_PARAMS.step_pin, TOOLHEAD_MOTOR_PARAMS.dir_pin,
+                            TOOLHEAD_LIMIT_PIN, 0, 0, 0, 0, 0, 0, false, LOW, LOW };
+
+static void onPinWrite(uint8_t pin, uint8_t value) {
+    for (Drive* d : { &s_carriage, &s_toolhead }) {
+        if (pin == d->dirPin) {
+            d->dirLevel = value;
+        } else if (pin == d->stepPin) {
+            if (value == HIGH && d->stepLevel == LOW) {
+                if (d->dirLevel == HIGH) {
+                    d->physical++;
+                    if (d->gap < d->backlash) d->gap++;
+                    else                      d->load++;
+                } else {
+                    d->physical--;
+                    if (d->gap > 0) d->gap--;
+                    else            d->load--;
+                }
+            }
+            d->stepLevel = value;
+        }
+    }
+}
+
+// Active LOW, with the differential as hysteresis.
+static int onPinRead(uint8_t pin) {
+    for (Drive* d : { &s_carriage, &s_toolhead }) {
+        if (pin != d->limitPin) continue;
+        if (!d->closed && d->load <= d->switchAt) d->closed = true;
+        else if (d->closed && d->load > d->switchAt + d->differential) d->closed = false;
+        return d->closed ? LOW : HIGH;
+    }
+    return pin == E_STOP_PIN ? LOW : HIGH;   // The E-stop (normally closed) is released.
+}
+
+static long carriagePosition() { return carriageStepper.currentPosition(); }
+static long toolheadPosition() { return toolheadStepper.currentPosition(); }
+
+static std::mt19937 s_rng;
+static uint32_t     s_loopUs       = 20;
+static uint32_t     s_loopJitterUs = 200;
+
+static void nextLoop() {
+    hostAdvanceMicros(s_loopUs + std::uniform_int_distribution<uint32_t>(0, s_loopJitterUs)(s_rng));
+}
+
+// ============================================================================
+//  Axes
+// ============================================================================
+
+/// One axis under test: its stepper, drive and winding limits.
+template <class Stepper>
+struct Axis {
+    const char*  name;
+    Stepper&     stepper;
+    Drive&       drive;
+    HomingConfig homing;
+    Input        limit;
+    float        maxSpeed;
+    float        acceleration;
+    long         range;      ///< Longest move between reversals (steps).
+    long         start;      ///< Load start position for a homing (steps from the switch).
+    double       perStep;    ///< Display units per step…
+    const char*  unit;       ///< …and their name.
+};
+
+/// Load against logical position through a run of reversals.
+struct Consistency {
+    long   reversals = 0;
+    long   loadMin   = 0;   ///< Smallest / largest load less logical position.
+    long   loadMax   = 0;
+    long   motorMin  = 0;   ///< Smallest / largest pulses less logical position and slack.
+    long   motorMax  = 0;
+    double seconds   = 0.0;
+
+    long loadSpread() const  { return loadMax - loadMin; }
+    long motorSpread() const { return motorMax - motorMin; }
+};
+
+// Fresh stepper and drive: the load at @p load, engaged towards negative
+// positions (gap 0, as the stepper assumes at rest) unless @p gap says
+// otherwise, compensation @p compensation.
+template <class Stepper>
+static void reset(Axis<Stepper>& axis, long load, long gap, long compensation) {
+    axis.stepper = Stepper();
+    axis.stepper.setMaxSpeed(axis.maxSpeed);
+    axis.stepper.setAcceleration(axis.acceleration);
+    axis.stepper.setBacklash(compensation, axis.homing.takeUpSpeed);
+    axis.drive.physical  = load;
+    axis.drive.load      = load;
+    axis.drive.gap       = gap;
+    axis.drive.closed    = false;
+    axis.drive.stepLevel = LOW;
+    axis.stepper.setCurrentPosition(load);
+}
+
+// @p n reversals from rest, cycling through positioned moves, velocity
+// mode reversing through rest and abrupt reversals at the homing approach
+// speed, each up to axis.range steps.  Samples after every loop() pass.
+template <class Stepper>
+static Consistency reversals(Axis<Stepper>& axis, long n) {
+    Stepper&       st = axis.stepper;
+    const Drive&   d  = axis.drive;
+    Consistency    c;
+    const uint64_t t0   = hostMicros64();
+    int            last = 0;   // Direction of the last logical step.
+    long           pos  = st.currentPosition();
+    bool           first = true;
+
+    auto tick = [&]() {
+        nextLoop();
+        const long p = st.currentPosition();
+        if (p != pos) {
+            const int dir = p > pos ? 1 : -1;
+            if (last && dir != last) c.reversals++;
+            last = dir;
+            pos  = p;
+        }
+        const long load  = d.load - p;
+        const long motor = d.physical - p - st.slack();
+        if (first || load < c.loadMin)   c.loadMin  = load;
+        if (first || load > c.loadMax)   c.loadMax  = load;
+        if (first || motor < c.motorMin) c.motorMin = motor;
+        if (first || motor > c.motorMax) c.motorMax = motor;
+        first = false;
+    };
+
+    std::uniform_int_distribution<long> steps(1, axis.range);
+    std::uniform_real_distribution<float> speed(0.1f * axis.maxSpeed, axis.maxSpeed);
+    for (long i = 0; i < n; i++) {
+        const int  sign = (i % 2) ? 1 : -1;
+        const long from = st.currentPosition();
+        const long len  = steps(s_rng);
+        switch (i % 3) {
+        case 0:
+            st.moveTo(from + sign * len);
+            while (st.run()) tick();
+            break;
+        case 1:
+            st.setTargetSpeed(sign * speed(s_rng));
+            while ((st.currentPosition() - from) * sign < len) {
+                st.run();
+                tick();
+            }
+            break;
+        default:
+            st.setSpeed(sign * axis.homing.slowSpeed);
+            while ((st.currentPosition() - from) * sign < len / 4 + 1) {
+                st.runSpeed();
+                tick();
+            }
+            st.setSpeed(0.0f);
+            st.moveTo(st.currentPosition());   // The target is stale after setSpeed().
+            break;
+        }
+    }
+    // Come to rest for the next run.
+    st.moveTo(st.currentPosition());
+    st.stop();
+    while (st.run()) tick();
+    st.setSpeed(0.0f);
+
+    c.seconds = (hostMicros64() - t0) * 1e-6;
+    return c;
+}
+
+// ============================================================================
+//  Checks
+// ============================================================================
+
+static bool check(bool pass, const char* what) {
+    printf("%s  %s\n", pass ? "ok  " : "FAIL", what);
+    return pass;
+}
+
+// Reversals with the compensation at, off, under and over the dead band.
+template <class Stepper>
+static bool compensate(Axis<Stepper>& axis, long n, unsigned seed) {
+    const long b = axis.drive.backlash;
+    struct Mode {
+        const char* name;
+        long        compensation;
+    };
+    const Mode modes[] = {
+        { "matched", b }, { "off", 0 }, { "under", b > 0 ? b - 1 : 0 }, { "over", b + 1 },
+    };
+
+    printf("%s: dead band %ld steps (%.3f %s), %ld reversals, take-up %.0f steps/s (%.1f ms)\n\n",
+           axis.name, b, b * axis.perStep, axis.unit, n, axis.homing.takeUpSpeed,
+           1e3 * b / axis.homing.takeUpSpeed);
+    printf("mode      comp  reversals  load_spread  (%s)  motor_spread  seconds\n", axis.unit);
+
+    bool ok = true;
+    for (const Mode& m : modes) {
+        reset(axis, 0, 0, m.compensation);
+        s_rng.seed(seed);   // The same moves in every mode.
+        const Consistency c = reversals(axis, n);
+        printf("%-8s  %4ld  %9ld  %11ld  %6.3f  %12ld  %7.1f\n", m.name, m.compensation, c.reversals,
+               c.loadSpread(), c.loadSpread() * axis.perStep, c.motorSpread(), c.seconds);
+
+        const long expected = labs(b - m.compensation);
+        ok = ok && c.motorSpread() == 0 && c.loadSpread() == expected && c.reversals >= n - 1;
+        if (c.loadSpread() != expected) {
+            printf("FAIL  %s %s: load spreads %ld steps, expected %ld\n", axis.name, m.name,
+                   c.loadSpread(), expected);
+        }
+        if (c.motorSpread() != 0) {
+            printf("FAIL  %s %s: pulses and steps plus slack drift %ld steps apart\n", axis.name,
+                   m.name, c.motorSpread());
+        }
+    }
+    printf("\n");
+    return ok;
+}
+
+// Calibrate at the switch for each dead band and differential, then
+// reverse on the measured compensation.
+template <class Stepper>
+static bool calibrate(Axis<Stepper>& axis, long n) {
+    const long deadBands[]     = { 0, 1, 3, 6, 12, 20 };
+    const long differentials[] = { 0, 3 };
+    const long band            = axis.drive.backlash;
+
+    printf("\n%s calibration, %u cycles\n\n", axis.name, BACKLASH_CALIBRATION_CYCLES);
+    printf("dead_band  differential  measured  spread  readings  seconds  home  load_spread\n");
+    bool ok = true;
+    for (long h : differentials) {
+        for (long b : deadBands) {
+            axis.drive.backlash     = b;
+            axis.drive.differential = h;
+            reset(axis, axis.start, std::uniform_int_distribution<long>(0, b)(s_rng), b / 2 + 2);
+            Inputs::init();
+
+            HomingConfig config       = axis.homing;
+            config.switchDifferential = h;
+            HomingAxis<Stepper> homing(axis.stepper, config);
+            homing.measureBacklash(BACKLASH_CALIBRATION_CYCLES);
+            homing.start();
+            while (homing.busy()) {
+                homing.update(Inputs::active(axis.limit), Inputs::edgePosition(axis.limit));
+                nextLoop();
+            }
+            const HomingReport& r    = homing.report();
+            const bool          done = homing.stage() == HomingStage::DONE;
+            const long          home = axis.drive.load - axis.stepper.currentPosition() - axis.drive.switchAt;
+            const Consistency   c    = reversals(axis, n);
+            printf("%9ld  %12ld  %8ld  %6ld  %8u  %7.2f  %4ld  %11ld\n", b, h, r.backlash,
+                   r.backlashSpread, r.readings, r.seconds, home, c.loadSpread());
+
+            const bool pass = done && r.backlash == b && axis.stepper.backlash() == b &&
+                              r.readings == 2 * BACKLASH_CALIBRATION_CYCLES && home == 0 &&
+                              c.loadSpread() == 0 && c.motorSpread() == 0;
+            if (!pass) printf("FAIL  %s dead band %ld, differential %ld\n", axis.name, b, h);
+            ok = ok && pass;
+        }
+    }
+    axis.drive.backlash     = band;
+    axis.drive.differential = 0;
+    printf("\n");
+    return ok;
+}
+
+/// Load less logical position over a simulated job, from the first pass on.
+struct JobSpread {
+    bool completed = false;
+    long carriage  = 0;
+    long toolhead  = 0;
+    long reversals = 0;   ///< Carriage reversals.
+    double seconds = 0.0;
+};
+
+static JobSpread windJob(const SimProfile& profile, long carriage, long toolhead, bool calibrate) {
+    SimOptions options;
+    options.carriageBacklash  = carriage;
+    options.toolheadBacklash  = toolhead;
+    options.calibrateBacklash = calibrate;
+    std::vector<StepSample> trace;
+    SimResult               result;
+    JobSpread               j;
+    if (!Sim::run(profile, options, &trace, result)) return j;
+
+    long cMin = 0, cMax = 0, tMin = 0, tMax = 0;
+    bool first = true;
+    int  last  = 0;
+    long pos   = 0;
+    for (const StepSample& s : trace) {
+        if (s.state == WindingState::ZEROING) continue;
+        const long c = s.carriageLoad - s.carriage;
+        const long t = s.toolheadLoad - s.toolhead;
+        if (first) {
+            cMin = cMax = c;
+            tMin = tMax = t;
+            pos = s.carriage;
+        }
+        cMin = std::min(cMin, c);
+        cMax = std::max(cMax, c);
+        tMin = std::min(tMin, t);
+        tMax = std::max(tMax, t);
+        if (s.carriage != pos) {
+            const int dir = s.carriage > pos ? 1 : -1;
+            if (last && dir != last) j.reversals++;
+            last = dir;
+            pos  = s.carriage;
+        }
+        first = false;
+    }
+    j.completed = result.completed;
+    j.carriage  = cMax - cMin;
+    j.toolhead  = tMax - tMin;
+    j.seconds   = result.durationUs * 1e-6;
+    return j;
+}
+
+static void usage() {
+    fprintf(stderr,
+            "usage: backlash_sim [profile] [--reversals N] [--carriage-um U]\n"
+            "                    [--toolhead-deg A] [--loop-us N] [--loop-jitter-us N]\n"
+            "                    [--seed N]\n");
+}
+
+int main(int argc, char** argv) {
+    const char* path        = nullptr;
+    long        n           = 5000;
+    float       carriageUM  = 150.0f;
+    float       toolheadDeg = 0.5f;
+    unsigned    seed        = 1;
+    for (int a = 1; a < argc; a++) {
+        bool hasValue = a + 1 < argc;
+        if      (!strcmp(argv[a], "--reversals") && hasValue)      n              = atol(argv[++a]);
+        else if (!strcmp(argv[a], "--carriage-um") && hasValue)    carriageUM     = atof(argv[++a]);
+        else if (!strcmp(argv[a], "--toolhead-deg") && hasValue)   toolheadDeg    = atof(argv[++a]);
+        else if (!strcmp(argv[a], "--loop-us") && hasValue)        s_loopUs       = atoi(argv[++a]);
+        else if (!strcmp(argv[a], "--loop-jitter-us") && hasValue) s_loopJitterUs = atoi(argv[++a]);
+        else if (!strcmp(argv[a], "--seed") && hasValue)           seed           = atoi(argv[++a]);
+        else if (argv[a][0] != '-' && !path)                      path           = argv[a];
+        else {
+            usage();
+            return 2;
+        }
+    }
+    if (n < 2 || carriageUM < 0.0f || toolheadDeg < 0.0f) {
+        usage();
+        return 2;
+    }
+
+    SimProfile profile;
+    if (path) {
+        std::string error;
+        if (!loadProfile(path, profile, error)) {
+            fprintf(stderr, "%s: %s\n", path, error.c_str());
+            return 2;
+        }
+    }
+
+    Axis<CarriageStepper> carriage = {
+        "carriage", carriageStepper, s_carriage, CARRIAGE_HOMING, Input::CARRIAGE_LIMIT,
+        DEFAULT_CARRIAGE_MAX_SPEED, DEFAULT_CARRIAGE_ACCEL, lroundf(CarriageAxis::toSteps(10.0f)),
+        lroundf(CarriageAxis::toSteps(20.0f)), CarriageAxis::mmPerStep(), "mm",
+    };
+    Axis<ToolheadStepper> toolhead = {
+        "toolhead", toolheadStepper, s_toolhead, TOOLHEAD_HOMING, Input::TOOLHEAD_LIMIT,
+        DEFAULT_TOOLHEAD_MAX_SPEED, DEFAULT_TOOLHEAD_ACCEL, lroundf(ToolheadAxis::toSteps(30.0f)),
+        lroundf(ToolheadAxis::toSteps(45.0f)), ToolheadAxis::degreesPerStep(), "deg",
+    };
+    s_carriage.backlash = lroundf(CarriageAxis::toSteps(carriageUM / 1000.0f));
+    s_toolhead.backlash = lroundf(ToolheadAxis::toSteps(toolheadDeg));
+
+    hostResetClock();
+    hostSetPinWriter(onPinWrite);
+    hostSetPinReader(onPinRead);
+    Inputs::setPositionSource(Input::CARRIAGE_LIMIT, carriagePosition);
+    Inputs::setPositionSource(Input::TOOLHEAD_LIMIT, toolheadPosition);
+
+    bool ok = true;
+    ok = compensate(carriage, n, seed) && ok;
+    ok = compensate(toolhead, n, seed) && ok;
+    ok = check(ok, "pulses track steps plus slack; the load tracks the logical position to the "
+                   "compensation's error");
+
+    s_rng.seed(seed);
+    bool cal = calibrate(carriage, n / 10);
+    cal      = calibrate(toolhead, n / 10) && cal;
+    ok = check(cal, "every calibration measures the dead band to the step and keeps home and the "
+                    "load true") && ok;
+
+    if (path) {
+        const JobSpread plain = windJob(profile, 0, 0, false);
+        const JobSpread loose = windJob(profile, s_carriage.backlash, s_toolhead.backlash, false);
+        const JobSpread comp  = windJob(profile, s_carriage.backlash, s_toolhead.backlash, true);
+        printf("\n%s: carriage dead band %ld steps, toolhead %ld steps\n\n", path, s_carriage.backlash,
+               s_toolhead.backlash);
+        printf("run            completed  job_s    reversals  carriage_spread  toolhead_spread\n");
+        const JobSpread* const runs[]  = { &plain, &loose, &comp };
+        const char* const      names[] = { "no backlash", "uncompensated", "calibrated" };
+        for (int i = 0; i < 3; i++) {
+            printf("%-13s  %9s  %7.1f  %9ld  %15ld  %15ld\n", names[i], runs[i]->completed ? "yes" : "no",
+                   runs[i]->seconds, runs[i]->reversals, runs[i]->carriage, runs[i]->toolhead);
+        }
+        ok = check(comp.completed && comp.carriage <= 1 && comp.toolhead <= 1,
+                   "the calibrated job keeps the load at the logical position") && ok;
+    }
+    return ok ? 0 : 1;
+}
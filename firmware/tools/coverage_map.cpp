@@ -0,0 +1,545 @@
+/// @file coverage_map.cpp
+/// @brief Rasterise laid tows onto the unrolled mandrel surface.
+///
+/// Every pass (traverse plus the dwell rotation that follows it) is drawn as a
+/// band of the tow width on a grid covering the unrolled mandrel surface
+/// (x = axial mm, y = circumferential mm, wrapping at the circumference).
+/// Each cell counts how many passes covered it, so a helical layer that
+/// closes properly reads 2 everywhere in its winding zone (one forward and
+/// one return crossing); 0 is a gap.
+///
+/// Paths come either from the firmware arithmetic with perfect gearing (pass
+/// counts from recalcPasses, gear ratio from getStepRatio, truncated dwell
+/// steps — the default), or from a step trace recorded by accuracy_sim
+/// --steps-out / --simulate here.  Passes are rasterised in parallel.  The
+/// model takes any number of layers (200 take about half a second on one
+/// core); --simulate winds at most MAX_LAYERS, as the firmware does.
+///
+///     coverage_map <profile> [--steps-in trace.csv | --simulate]
+///                  [--cell mm] [--tow mm] [--threads N] [--layer N]
+///                  [--png map.png] [--csv map.csv]
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "config.h"
+#include "sim.h"
+#include "pattern.h"
+
+// ============================================================================
+//  Geometry
+// ============================================================================
+
+/// A point on the unrolled surface (y is not wrapped).
+struct Pt {
+    double x;
+    double y;
+};
+
+/// The path of one pass plus the tow width it is laid with.
+struct PassPath {
+    int             layer;
+    double          towMM;
+    std::vector<Pt> pts;
+};
+
+/// Coverage grid for one layer or the whole job.
+struct Grid {
+    double x0, cell;
+    int    cols, rows;
+    std::vector<uint16_t> count;
+
+    uint16_t& at(int c, int r) { return count[static_cast<size_t>(r) * cols + c]; }
+};
+
+// Build pass paths from the firmware arithmetic with ideal gearing.
+static void modelPaths(const SimProfile& profile, double towOverride,
+                       std::vector<PassPath>& out) {
+    const float carriageStepsPerMM = static_cast<float>(Sim::carriageStepsPerMM());
+    const float mandrelStepsPerRev = static_cast<float>(Sim::mandrelStepsPerRev());
+
+    double x       = 0.0;   // Carriage starts at home.
+    long   mandrel = 0;     // Mandrel position in steps.
+
+    for (size_t li = 0; li < profile.layers.size(); li++) {
+        Layer layer = profile.layers[li];   // Copy: countPass() mutates progress.
+        if (profile.patternSequencing) Pattern::apply(layer, Estimate::defaultParams());
+        layer.resetProgress();
+        long layerStart = mandrel;
+
+        const double circ  = PI * layer.getDiameter();
+        const float  ratio = layer.getStepRatio(carriageStepsPerMM, mandrelStepsPerRev);
+        const double tow   = towOverride > 0.0 ? towOverride : layer.getStepover();
+        if (ratio <= 0.0f) continue;
+
+        while (!layer.isDone()) {
+            PassPath p;
+            p.layer = static_cast<int>(li);
+            p.towMM = tow;
+
+            // Traverse: carriage steps = ratio * mandrel steps.
+            const double target  = layer.getTargetEndpoint();
+            const double carSteps = fabs(target - x) * carriageStepsPerMM;
+            const long   manSteps = lround(carSteps / ratio);
+            p.pts.push_back({ x, mandrel / mandrelStepsPerRev * circ });
+            mandrel += manSteps;
+            x        = target;
+            p.pts.push_back({ x, mandrel / mandrelStepsPerRev * circ });
+
+            // Dwell: same arithmetic as Winding::update().
+            if (layer.hasPattern() && layer.getPassesCompleted() == 0) {
+                layerStart = mandrel - lroundf(Estimate::passDegrees(layer, Estimate::defaultParams())
+                                               / 360.0f * mandrelStepsPerRev);
+            }
+            if (li + 1 < profile.layers.size() &&
+                layer.getPassesCompleted() == layer.getTotalPasses() - 1) {
+                mandrel += static_cast<long>((layer.getDwell() / 360.0f) * mandrelStepsPerRev);
+            } else {
+                mandrel += Pattern::turnaroundSteps(layer, mandrel, layerStart, mandrelStepsPerRev);
+            }
+            p.pts.push_back({ x, mandrel / mandrelStepsPerRev * circ });
+
+            out.push_back(std::move(p));
+            layer.countPass();
+        }
+    }
+}
+
+// Build pass paths from a recorded step trace (WINDING + DWELLING samples).
+static void tracePaths(const SimProfile& profile, const std::vector<StepSample>& trace,
+                       double towOverride, double minStepMM, std::vector<PassPath>& out) {
+    const double stepsPerMM  = Sim::carriageStepsPerMM();
+    const double stepsPerRev = Sim::mandrelStepsPerRev();
+
+    int curLayer = -1, curPass = -1;
+    for (const StepSample& s : trace) {
+        if (s.state != WindingState::WINDING && s.state != WindingState::DWELLING) continue;
+        if (s.layer >= static_cast<int>(profile.layers.size())) continue;
+
+        const Layer& layer = profile.layers[s.layer];
+        const Pt     pt    = { s.carriage / stepsPerMM,
+                               s.mandrel / stepsPerRev * PI * layer.getDiameter() };
+
+        if (s.layer != curLayer || s.pass != curPass) {
+            // A new pass starts where the previous one ended.
+            PassPath p;
+            p.layer = s.layer;
+            p.towMM = towOverride > 0.0 ? towOverride : layer.getStepover();
+            if (!out.empty() && out.back().layer == s.layer) p.pts.push_back(out.back().pts.back());
+            out.push_back(std::move(p));
+            curLayer = s.layer;
+            curPass  = s.pass;
+        }
+
+        // Decimate to roughly half-cell spacing.
+        std::vector<Pt>& pts = out.back().pts;
+        if (pts.empty() || fabs(pt.x - pts.back().x) >= minStepMM ||
+            fabs(pt.y - pts.back().y) >= minStepMM) {
+            pts.push_back(pt);
+        }
+    }
+}
+
+// ============================================================================
+//  Rasterisation
+// ============================================================================
+
+// Extend [lo, hi] with the y-range of the capsule (segment a-b dilated by r)
+// on the vertical line x = cx.
+static void capsuleSpan(const Pt& a, const Pt& b, double r, double cx,
+                        double& lo, double& hi) {
+    double sLo = INFINITY, sHi = -INFINITY;
+
+    // End discs.
+    for (const Pt* p : { &a, &b }) {
+        double d = cx - p->x;
+        if (fabs(d) <= r) {
+            double h = sqrt(r * r - d * d);
+            sLo = fmin(sLo, p->y - h);
+            sHi = fmax(sHi, p->y + h);
+        }
+    }
+
+    // Body: perpendicular distance <= r and projection inside the segment.
+    const double dx = b.x - a.x, dy = b.y - a.y;
+    const double len = sqrt(dx * dx + dy * dy);
+    if (len > 0.0) {
+        const double ux = cx - a.x;
+        double bLo = -INFINITY, bHi = INFINITY;
+
+        // Perpendicular: |ux*dy - (y-a.y)*dx| / len <= r
+        if (dx != 0.0) {
+            double c  = a.y + ux * dy / dx;
+            double hw = r * len / fabs(dx);
+            bLo = c - hw;
+            bHi = c + hw;
+        } else if (fabs(ux) > r) {
+            bLo = INFINITY;   // Vertical segment, column outside the band.
+        }
+
+        // Projection: 0 <= ux*dx + (y-a.y)*dy <= len²
+        if (dy != 0.0) {
+            double t0 = a.y + (0.0 - ux * dx) / dy;
+            double t1 = a.y + (len * len - ux * dx) / dy;
+            bLo = fmax(bLo, fmin(t0, t1));
+            bHi = fmin(bHi, fmax(t0, t1));
+        } else if (ux * dx < 0.0 || ux * dx > len * len) {
+            bLo = INFINITY;   // Horizontal segment, column beyond its ends.
+        }
+
+        if (bLo <= bHi) {
+            sLo = fmin(sLo, bLo);
+            sHi = fmax(sHi, bHi);
+        }
+    }
+
+    if (sLo <= sHi) {
+        lo = fmin(lo, sLo);
+        hi = fmax(hi, sHi);
+    }
+}
+
+// Add one pass to the grid.  Each pass is x-monotonic apart from its dwell,
+// which is contiguous with it, so its footprint in every column is a single
+// y-interval and each covered cell is counted exactly once per pass.
+static void rasterPass(const PassPath& p, Grid& g, std::vector<double>& lo,
+                       std::vector<double>& hi, std::atomic<uint16_t>* cells) {
+    const double r    = p.towMM * 0.5;
+    const double circ = g.rows * g.cell;
+    std::fill(lo.begin(), lo.end(),  INFINITY);
+    std::fill(hi.begin(), hi.end(), -INFINITY);
+
+    for (size_t i = 0; i + 1 < p.pts.size(); i++) {
+        const Pt& a = p.pts[i];
+        const Pt& b = p.pts[i + 1];
+        int c0 = static_cast<int>(floor((fmin(a.x, b.x) - r - g.x0) / g.cell));
+        int c1 = static_cast<int>(floor((fmax(a.x, b.x) + r - g.x0) / g.cell));
+        c0 = std::max(c0, 0);
+        c1 = std::min(c1, g.cols - 1);
+        for (int c = c0; c <= c1; c++) {
+            capsuleSpan(a, b, r, g.x0 + (c + 0.5) * g.cell, lo[c], hi[c]);
+        }
+    }
+
+    for (int c = 0; c < g.cols; c++) {
+        if (lo[c] > hi[c]) continue;
+        // Rows whose centre lies inside the interval.
+        long r0 = static_cast<long>(ceil(lo[c] / g.cell - 0.5));
+        long r1 = static_cast<long>(floor(hi[c] / g.cell - 0.5));
+        if (hi[c] - lo[c] >= circ) {
+            r0 = 0;
+            r1 = g.rows - 1;
+        }
+        for (long row = r0; row <= r1; row++) {
+            long w = ((row % g.rows) + g.rows) % g.rows;
+            cells[static_cast<size_t>(w) * g.cols + c].fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+// Rasterise a range of passes into g using nThreads workers.
+static void rasterLayer(const std::vector<PassPath>& paths, size_t begin, size_t end,
+                        Grid& g, int nThreads) {
+    std::vector<std::atomic<uint16_t>> cells(g.count.size());
+    for (auto& c : cells) c.store(0, std::memory_order_relaxed);
+
+    std::atomic<size_t> next(begin);
+    auto worker = [&]() {
+        std::vector<double> lo(g.cols), hi(g.cols);
+        for (size_t i; (i = next.fetch_add(1)) < end;) {
+            rasterPass(paths[i], g, lo, hi, cells.data());
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (int t = 1; t < nThreads; t++) pool.emplace_back(worker);
+    worker();
+    for (std::thread& t : pool) t.join();
+
+    for (size_t i = 0; i < cells.size(); i++) g.count[i] = cells[i].load(std::memory_order_relaxed);
+}
+
+// ============================================================================
+//  Output
+// ============================================================================
+
+/// Coverage statistics over the cells of a winding zone.
+struct ZoneStats {
+    long   cells = 0, gaps = 0;
+    int    minCount = 0, maxCount = 0;
+    double mean = 0.0;
+};
+
+static ZoneStats zoneStats(Grid& g, double xFrom, double xTo) {
+    ZoneStats s;
+    s.minCount = 65535;
+    double sum = 0.0;
+    for (int c = 0; c < g.cols; c++) {
+        double cx = g.x0 + (c + 0.5) * g.cell;
+        if (cx < xFrom || cx > xTo) continue;
+        for (int r = 0; r < g.rows; r++) {
+            int n = g.at(c, r);
+            s.cells++;
+            if (n == 0) s.gaps++;
+            s.minCount = std::min(s.minCount, n);
+            s.maxCount = std::max(s.maxCount, n);
+            sum += n;
+        }
+    }
+    if (s.cells) s.mean = sum / s.cells;
+    else         s.minCount = 0;
+    return s;
+}
+
+static bool writeCsv(const char* path, Grid& g) {
+    FILE* f = fopen(path, "w");
+    if (!f) return false;
+    // One row per circumferential cell, one column per axial cell.
+    fprintf(f, "y_mm\\x_mm");
+    for (int c = 0; c < g.cols; c++) fprintf(f, ",%.3f", g.x0 + (c + 0.5) * g.cell);
+    fprintf(f, "\n");
+    for (int r = 0; r < g.rows; r++) {
+        fprintf(f, "%.3f", (r + 0.5) * g.cell);
+        for (int c = 0; c < g.cols; c++) fprintf(f, ",%u", g.at(c, r));
+        fprintf(f, "\n");
+    }
+    return fclose(f) == 0;
+}
+
+static uint32_t crc32(const uint8_t* p, size_t n, uint32_t crc = 0) {
+    crc = ~crc;
+    while (n--) {
+        crc ^= *p++;
+        for (int k = 0; k < 8; k++) crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+    }
+    return ~crc;
+}
+
+static void put32(std::vector<uint8_t>& v, uint32_t x) {
+    for (int s = 24; s >= 0; s -= 8) v.push_back(static_cast<uint8_t>(x >> s));
+}
+
+static void pngChunk(FILE* f, const char* type, const std::vector<uint8_t>& data) {
+    std::vector<uint8_t> buf;
+    put32(buf, static_cast<uint32_t>(data.size()));
+    buf.insert(buf.end(), type, type + 4);
+    buf.insert(buf.end(), data.begin(), data.end());
+    put32(buf, crc32(buf.data() + 4, buf.size() - 4));
+    fwrite(buf.data(), 1, buf.size(), f);
+}
+
+// Write an RGB PNG (stored deflate blocks — no zlib dependency).  Gaps inside
+// a winding zone are red, covered cells are shaded by thickness.
+static bool writePng(const char* path, Grid& g, double zoneFrom, double zoneTo) {
+    FILE* f = fopen(path, "wb");
+    if (!f) return false;
+
+    int maxCount = 1;
+    for (uint16_t n : g.count) maxCount = std::max<int>(maxCount, n);
+
+    std::vector<uint8_t> raw;   // Filter byte + RGB per row, top row = y 0.
+    raw.reserve(static_cast<size_t>(g.rows) * (1 + 3 * g.cols));
+    for (int r = 0; r < g.rows; r++) {
+        raw.push_back(0);
+        for (int c = 0; c < g.cols; c++) {
+            int    n  = g.at(c, r);
+            double cx = g.x0 + (c + 0.5) * g.cell;
+            uint8_t rgb[3];
+            if (n == 0) {
+                bool inZone = cx >= zoneFrom && cx <= zoneTo;
+                rgb[0] = inZone ? 220 : 30;
+                rgb[1] = inZone ? 30  : 30;
+                rgb[2] = inZone ? 30  : 30;
+            } else {
+                uint8_t v = static_cast<uint8_t>(70 + 185 * n / maxCount);
+                rgb[0] = rgb[1] = rgb[2] = v;
+            }
+            raw.insert(raw.end(), rgb, rgb + 3);
+        }
+    }
+
+    std::vector<uint8_t> z = { 0x78, 0x01 };
+    size_t off = 0;
+    do {
+        size_t n    = std::min<size_t>(65535, raw.size() - off);
+        bool   last = off + n >= raw.size();
+        z.push_back(last ? 1 : 0);
+        z.push_back(n & 0xFF);   z.push_back((n >> 8) & 0xFF);
+        z.push_back(~n & 0xFF);  z.push_back((~n >> 8) & 0xFF);
+        z.insert(z.end(), raw.begin() + off, raw.begin() + off + n);
+        off += n;
+    } while (off < raw.size());
+    uint32_t s1 = 1, s2 = 0;
+    for (uint8_t b : raw) {
+        s1 = (s1 + b) % 65521;
+        s2 = (s2 + s1) % 65521;
+    }
+    put32(z, (s2 << 16) | s1);
+
+    static const uint8_t sig[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    fwrite(sig, 1, 8, f);
+    std::vector<uint8_t> ihdr;
+    put32(ihdr, g.cols);
+    put32(ihdr, g.rows);
+    ihdr.insert(ihdr.end(), { 8, 2, 0, 0, 0 });   // 8-bit RGB, no interlace.
+    pngChunk(f, "IHDR", ihdr);
+    pngChunk(f, "IDAT", z);
+    pngChunk(f, "IEND", {});
+    return fclose(f) == 0;
+}
+
+// ============================================================================
+//  Main
+// ============================================================================
+
+static void usage() {
+    fprintf(stderr,
+            "usage: coverage_map <profile> [--steps-in trace.csv | --simulate]\n"
+            "                    [--cell mm] [--tow mm] [--threads N] [--layer N]\n"
+            "                    [--png map.png] [--csv map.csv]\n");
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        usage();
+        return 2;
+    }
+
+    const char* profilePath = argv[1];
+    const char* stepsIn  = nullptr;
+    const char* pngPath  = nullptr;
+    const char* csvPath  = nullptr;
+    bool        simulate = false;
+    double      cell     = 0.5;
+    double      tow      = 0.0;
+    int         only     = -1;
+    int         nThreads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+
+    for (int a = 2; a < argc; a++) {
+        bool hasValue = a + 1 < argc;
+        if      (!strcmp(argv[a], "--steps-in") && hasValue) stepsIn  = argv[++a];
+        else if (!strcmp(argv[a], "--simulate"))             simulate = true;
+        else if (!strcmp(argv[a], "--cell") && hasValue)     cell     = atof(argv[++a]);
+        else if (!strcmp(argv[a], "--tow") && hasValue)      tow      = atof(argv[++a]);
+        else if (!strcmp(argv[a], "--threads") && hasValue)  nThreads = std::max(1, atoi(argv[++a]));
+        else if (!strcmp(argv[a], "--layer") && hasValue)    only     = atoi(argv[++a]);
+        else if (!strcmp(argv[a], "--png") && hasValue)      pngPath  = argv[++a];
+        else if (!strcmp(argv[a], "--csv") && hasValue)      csvPath  = argv[++a];
+        else {
+            usage();
+            return 2;
+        }
+    }
+    if (cell <= 0.0) {
+        usage();
+        return 2;
+    }
+
+    SimProfile  profile;
+    std::string error;
+    if (!loadProfile(profilePath, profile, error)) {
+        fprintf(stderr, "coverage_map: %s\n", error.c_str());
+        return 2;
+    }
+    if (only >= static_cast<int>(profile.layers.size())) {
+        fprintf(stderr, "coverage_map: profile has %zu layers\n", profile.layers.size());
+        return 2;
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+
+    std::vector<PassPath> paths;
+    if (stepsIn || simulate) {
+        std::vector<StepSample> trace;
+        if (stepsIn && !Sim::readTrace(stepsIn, trace)) {
+            fprintf(stderr, "coverage_map: cannot read %s\n", stepsIn);
+            return 2;
+        }
+        if (simulate) {
+            // The simulation winds the profile as the firmware would, so
+            // it takes at most MAX_LAYERS layers; the model takes any.
+            if (profile.layers.size() > static_cast<size_t>(MAX_LAYERS)) {
+                fprintf(stderr, "coverage_map: --simulate winds at most %d layers (%zu given)\n",
+                        MAX_LAYERS, profile.layers.size());
+                return 2;
+            }
+            Serial.setSink(nullptr);
+            SimResult result;
+            if (!Sim::run(profile, SimOptions(), &trace, result) || !result.completed) {
+                fprintf(stderr, "coverage_map: simulation failed\n");
+                return 1;
+            }
+        }
+        tracePaths(profile, trace, tow, cell * 0.5, paths);
+    } else {
+        modelPaths(profile, tow, paths);
+    }
+
+    // Grid spans every winding zone plus the home position, with a tow margin.
+    double xMin = 0.0, xMax = 0.0, maxTow = tow;
+    for (const Layer& l : profile.layers) {
+        xMin   = fmin(xMin, l.getOffset());
+        xMax   = fmax(xMax, l.getOffset() + l.getLength());
+        maxTow = fmax(maxTow, l.getStepover());
+    }
+    Grid total;
+    total.cell = cell;
+    total.x0   = xMin - maxTow;
+    total.cols = static_cast<int>(ceil((xMax - xMin + 2.0 * maxTow) / cell));
+    total.rows = static_cast<int>(ceil(PI * profile.diameter / cell));
+    total.count.assign(static_cast<size_t>(total.cols) * total.rows, 0);
+    Grid layerGrid = total;
+
+    printf("layer passes   gaps%%  min  mean  max\n");
+    size_t first = 0;
+    double zoneFrom = INFINITY, zoneTo = -INFINITY;
+    for (int li = 0; li < static_cast<int>(profile.layers.size()); li++) {
+        size_t last = first;
+        while (last < paths.size() && paths[last].layer == li) last++;
+        if (only >= 0 && li != only) {
+            first = last;
+            continue;
+        }
+
+        rasterLayer(paths, first, last, layerGrid, nThreads);
+        for (size_t i = 0; i < total.count.size(); i++) {
+            total.count[i] = static_cast<uint16_t>(
+                std::min<int>(65535, total.count[i] + layerGrid.count[i]));
+        }
+
+        const Layer& l = profile.layers[li];
+        ZoneStats s = zoneStats(layerGrid, l.getOffset(), l.getOffset() + l.getLength());
+        printf("%5d %6zu  %6.2f  %3d  %4.2f  %3d\n", li, last - first,
+               s.cells ? 100.0 * s.gaps / s.cells : 0.0, s.minCount, s.mean, s.maxCount);
+
+        zoneFrom = fmin(zoneFrom, l.getOffset());
+        zoneTo   = fmax(zoneTo, l.getOffset() + l.getLength());
+        first = last;
+    }
+
+    ZoneStats s = zoneStats(total, zoneFrom, zoneTo);
+    printf("total %6zu  %6.2f  %3d  %4.2f  %3d\n", paths.size(),
+           s.cells ? 100.0 * s.gaps / s.cells : 0.0, s.minCount, s.mean, s.maxCount);
+
+    double ms = std::chrono::duration<double, std::milli>(
+                    std::chrono::steady_clock::now() - t0).count();
+    printf("%d x %d cells of %.2f mm, %d thread%s, %.0f ms\n", total.cols, total.rows, cell,
+           nThreads, nThreads == 1 ? "" : "s", ms);
+
+    if (csvPath && !writeCsv(csvPath, total)) {
+        fprintf(stderr, "coverage_map: cannot write %s\n", csvPath);
+        return 2;
+    }
+    if (pngPath && !writePng(pngPath, total, zoneFrom, zoneTo)) {
+        fprintf(stderr, "coverage_map: cannot write %s\n", pngPath);
+        return 2;
+    }
+    return 0;
+}
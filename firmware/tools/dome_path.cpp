@@ -0,0 +1,162 @@
+/// @file dome_path.cpp
+/// @brief Generate and check a polar-turnaround dome path on the host.
+///
+///     dome_path [profile] --opening R0 [--slippage L] [--cyl-end X] [--dir +1|-1]
+///               [--entries N] [--csv out.csv]
+///
+/// Without a profile the 4-axis test vessel is used: 50 mm radius cylinder
+/// from x = 50 to 150 mm with hemispherical domes (50 points).  Runs the same
+/// DomePath generator the firmware runs at job load, then reports the
+/// cylinder angle, turnaround, dome rotation, table size and generation time.
+/// For geodesic paths (slippage 0) Clairaut's relation r·sin α = r₀ is
+/// checked along the table; the table is also streamed through a
+/// DomePathCursor step by step.  Exit code 1 if generation fails, the
+/// Clairaut error exceeds 1 % or the streamed carriage reverses.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+#include "config.h"
+#include "dome_path.h"
+#include "axis.h"
+#include "sim.h"
+
+static void usage() {
+    fprintf(stderr, "usage: dome_path [profile] --opening R0 [--slippage L] [--cyl-end X]\n"
+                    "                 [--dir +1|-1] [--entries N] [--csv out.csv]\n");
+}
+
+int main(int argc, char** argv) {
+    const char*    profilePath = nullptr;
+    const char*    csvPath     = nullptr;
+    DomePathParams params;
+    bool           haveCylEnd  = false;
+    for (int a = 1; a < argc; a++) {
+        bool hasValue = a + 1 < argc;
+        if      (!strcmp(argv[a], "--opening") && hasValue)  params.polarOpeningRadius = atof(argv[++a]);
+        else if (!strcmp(argv[a], "--slippage") && hasValue) params.slippage = atof(argv[++a]);
+        else if (!strcmp(argv[a], "--cyl-end") && hasValue) {
+            params.cylinderEndMM = atof(argv[++a]);
+            haveCylEnd           = true;
+        }
+        else if (!strcmp(argv[a], "--dir") && hasValue)      params.direction  = atoi(argv[++a]);
+        else if (!strcmp(argv[a], "--entries") && hasValue)  params.maxEntries = atoi(argv[++a]);
+        else if (!strcmp(argv[a], "--csv") && hasValue)      csvPath = argv[++a];
+        else if (argv[a][0] != '-' && !profilePath)          profilePath = argv[a];
+        else {
+            usage();
+            return 2;
+        }
+    }
+    if (params.polarOpeningRadius <= 0.0f) {
+        usage();
+        return 2;
+    }
+
+    static SplineProfile surface;
+    if (profilePath) {
+        SimProfile  profile;
+        std::string error;
+        if (!loadProfile(profilePath, profile, error)) {
+            fprintf(stderr, "dome_path: %s\n", error.c_str());
+            return 2;
+        }
+        for (size_t i = 0; i < profile.pointX.size(); i++) {
+            surface.addPoint(profile.pointX[i], profile.pointR[i]);
+        }
+        if (!haveCylEnd) {
+            fprintf(stderr, "dome_path: --cyl-end is required with a profile\n");
+            return 2;
+        }
+    } else {
+        const float R = 50.0f;
+        for (int i = 0; i <= 23; i++) {
+            float x = R * i / 23.0f;
+            surface.addPoint(x, sqrtf(R * R - (R - x) * (R - x)));
+        }
+        surface.addPoint(R + 50.0f, R);
+        surface.addPoint(R + 100.0f, R);
+        for (int i = 1; i <= 24; i++) {
+            float x = R * i / 24.0f;
+            surface.addPoint(R + 100.0f + x, sqrtf(R * R - x * x));
+        }
+        if (!haveCylEnd) params.cylinderEndMM = (params.direction < 0) ? R : R + 100.0f;
+    }
+    surface.compute();
+
+    params.carriageStepsPerMM  = CarriageAxis::stepsPerMM();
+    params.mandrelStepsPerRev  = MandrelAxis::stepsPerRev();
+    params.toolarmStepsPerMM   = ToolarmAxis::stepsPerMM();
+    params.toolheadStepsPerRev = ToolheadAxis::stepsPerRev();
+
+    static DomePath path;
+    auto t0 = std::chrono::steady_clock::now();
+    bool ok = path.generate(surface, params);
+    auto t1 = std::chrono::steady_clock::now();
+    if (!ok) {
+        fprintf(stderr, "dome_path: %s\n", path.getError());
+        return 1;
+    }
+
+    printf("%s path, polar opening %.2f mm, slippage %.3f\n",
+           params.slippage == 0.0f ? "geodesic" : "non-geodesic", params.polarOpeningRadius,
+           params.slippage);
+    printf("cylinder angle     %8.3f deg (bisection %d steps)\n", path.getCylinderAngle(),
+           path.getBisectionSteps());
+    printf("turnaround         %8.3f mm, radius %.3f mm\n", path.getTurnaroundMM(),
+           path.getTurnaroundRadius());
+    printf("dome rotation      %8.2f deg\n", path.getDomeRotationDeg());
+    printf("table              %d entries, %u bytes\n", path.getCount(), path.getTableBytes());
+    printf("generation         %8.2f ms (host)\n",
+           std::chrono::duration<double, std::milli>(t1 - t0).count());
+
+    int failures = 0;
+
+    // Clairaut: r · sin α is constant (= r₀) along a geodesic.
+    if (params.slippage == 0.0f) {
+        double worst = 0.0;
+        for (int i = 0; i < path.getCount(); i++) {
+            const DomePathEntry& e = path.entry(i);
+            double x = e.carriageStep / params.carriageStepsPerMM;
+            double c = surface.getRadius(x) * sin(e.angleCdeg * 0.01 * M_PI / 180.0);
+            worst = fmax(worst, fabs(c - params.polarOpeningRadius) / params.polarOpeningRadius);
+        }
+        printf("Clairaut error     %8.3f %%\n", 100.0 * worst);
+        if (worst > 0.01) failures++;
+    }
+
+    // Stream the table one mandrel step at a time, as the motion engine would.
+    DomePathCursor cursor;
+    cursor.begin(path);
+    long   lastCarriage = path.entry(0).carriageStep;
+    long   reversals    = 0, steps = 0;
+    for (long m = 0; cursor.seek(m); m++, steps++) {
+        long c = cursor.carriageStep();
+        if ((c - lastCarriage) * (params.direction < 0 ? -1 : 1) < 0) reversals++;
+        lastCarriage = c;
+    }
+    printf("streamed           %ld mandrel steps, %ld carriage reversals\n", steps, reversals);
+    if (reversals) failures++;
+
+    if (csvPath) {
+        FILE* f = fopen(csvPath, "w");
+        if (!f) {
+            fprintf(stderr, "dome_path: cannot write %s\n", csvPath);
+            return 2;
+        }
+        fprintf(f, "mandrel_step,carriage_step,toolarm_step,toolhead_step,angle_deg,ratio\n");
+        for (int i = 0; i < path.getCount(); i++) {
+            const DomePathEntry& e = path.entry(i);
+            fprintf(f, "%ld,%ld,%ld,%d,%.2f,%.5f\n", static_cast<long>(e.mandrelStep),
+                    static_cast<long>(e.carriageStep), static_cast<long>(e.toolarmStep),
+                    e.toolheadStep, e.angleCdeg * 0.01, path.ratioAt(i));
+        }
+        fclose(f);
+    }
+
+    printf("%s\n", failures ? "FAIL" : "ok");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,165 @@
+/// @file flip_overlap.cpp
+/// @brief Time the toolhead flip costs at every turn-around, flipped within
+///        the dwell only and overlapped with the carriage's ramps.
+///
+///     flip_overlap <profile> [--loop-us N]
+///
+/// Winds the profile twice in the simulator: sequentially ("flip 0" — the
+/// toolhead turns during the dwell and the next pass waits for it, as in
+/// the 4-axis scripts) and overlapped (the default — the flip starts while
+/// the carriage runs into the endpoint and may finish while it accelerates
+/// out of it; FlipTiming in estimate.h).  Per layer the tool prints the
+/// flip timing the plan uses (flip time and how much of it falls in the
+/// dwell, the lead and the lag; the lead in carriage steps and the toolhead
+/// steps the next pass may start with), each run's mean hold after the
+/// dwell per turn-around, and the time the overlap saves per turn-around,
+/// simulated and estimated.  It fails (exit code 1) if
+///
+///   - either run does not complete,
+///   - a layer winds slower overlapped than sequentially, or
+///   - the simulated saving per turn-around is off the estimate by more
+///     than 10 % or 20 ms.  The estimate times every turn-around from the
+///     layer's nominal dwell; a pattern's turn-arounds scatter around it
+///     as they land the circuits on their slots.
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "sim.h"
+#include "estimate.h"
+#include "pattern.h"
+
+static void usage() {
+    fprintf(stderr, "usage: flip_overlap <profile> [--loop-us N]\n");
+}
+
+// Per-layer results of one run.
+struct LayerRun {
+    double seconds = 0.0;   // First WINDING sample to the next layer's.
+    double hold    = 0.0;   // Time from the dwell's last mandrel step to the next pass.
+    int    turns   = 0;     // Turn-arounds followed by another pass.
+};
+
+static bool simulate(const SimProfile& profile, const SimOptions& options, std::vector<LayerRun>& out,
+                     SimResult& result) {
+    std::vector<StepSample> trace;
+    if (!Sim::run(profile, options, &trace, result) || !result.completed) return false;
+
+    out.assign(profile.layers.size(), LayerRun());
+    std::vector<double> starts(profile.layers.size() + 1, result.durationUs / 1e6);
+    WindingState last      = WindingState::IDLE;
+    int          lastLayer = 0;
+    uint64_t     dwellUs   = 0;   // Last sample in DWELLING.
+    for (const StepSample& s : trace) {
+        if (s.state == WindingState::WINDING && s.timeUs / 1e6 < starts[s.layer]) {
+            starts[s.layer] = s.timeUs / 1e6;
+        }
+        if (s.state == WindingState::DWELLING) dwellUs = s.timeUs;
+        if (s.state == WindingState::WINDING && last == WindingState::DWELLING) {
+            // A hand-over counts to the layer it leaves.
+            out[lastLayer].hold += (s.timeUs - dwellUs) / 1e6;
+            out[lastLayer].turns++;
+        }
+        last      = s.state;
+        lastLayer = s.layer;
+    }
+    for (size_t i = 0; i < profile.layers.size(); i++) {
+        out[i].seconds = starts[i + 1] - starts[i];
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        usage();
+        return 2;
+    }
+
+    SimOptions options;
+    for (int a = 2; a < argc; a++) {
+        bool hasValue = a + 1 < argc;
+        if (!strcmp(argv[a], "--loop-us") && hasValue) {
+            options.loopUs = atoi(argv[++a]);
+        } else {
+            usage();
+            return 2;
+        }
+    }
+
+    SimProfile  overlapped;
+    std::string error;
+    if (!loadProfile(argv[1], overlapped, error)) {
+        fprintf(stderr, "flip_overlap: %s\n", error.c_str());
+        return 2;
+    }
+    overlapped.overlapToolheadFlip = true;
+    SimProfile sequential          = overlapped;
+    sequential.overlapToolheadFlip = false;
+
+    // The plan's flip timing and the estimate, as Winding::start() has them.
+    EstimateParams ovlParams = Estimate::defaultParams();
+    ovlParams.loopUs         = options.loopUs;
+    EstimateParams seqParams = ovlParams;
+    seqParams.overlapFlip    = false;
+
+    const SplineProfile* mandrel = fitMandrel(overlapped);
+
+    Serial.setSink(nullptr);
+    std::vector<LayerRun> seqRun, ovlRun;
+    SimResult             seqResult, ovlResult;
+    if (!simulate(sequential, options, seqRun, seqResult) || !simulate(overlapped, options, ovlRun, ovlResult)) {
+        fprintf(stderr, "flip_overlap: simulation failed (more than %d layers?)\n", MAX_LAYERS);
+        return 1;
+    }
+
+    printf("layer  flip_s  in_dwell  lead_s  lag_s  lead_steps  hold_steps   hold_ms (seq)   saved_ms (est)\n");
+    int    rc    = 0;
+    float  pos   = 0.0f;
+    double saved = 0.0, savedEst = 0.0;
+    int    turns = 0;
+    for (size_t i = 0; i < overlapped.layers.size(); i++) {
+        Layer layer = overlapped.layers[i];
+        if (overlapped.patternSequencing) Pattern::apply(layer, ovlParams);
+        const Layer*        next = i + 1 < overlapped.layers.size() ? &overlapped.layers[i + 1] : nullptr;
+        const LayerEstimate seq  = Estimate::layer(layer, seqParams, pos, next, mandrel);
+        const LayerEstimate ovl  = Estimate::layer(layer, ovlParams, pos, next, mandrel);
+        const FlipTiming    turn = Estimate::turnaroundFlip(layer, ovlParams);
+        pos = ovl.endMM;
+
+        const LayerRun& s = seqRun[i];
+        const LayerRun& o = ovlRun[i];
+        const int       n = o.turns > 0 ? o.turns : 1;
+        const double perTurn    = (s.seconds - o.seconds) / n;
+        const double perTurnEst = (seq.totalSeconds - ovl.totalSeconds) / n;
+        saved    += s.seconds - o.seconds;
+        savedEst += seq.totalSeconds - ovl.totalSeconds;
+        turns    += o.turns;
+
+        printf("%5zu  %6.3f  %8.3f  %6.3f  %5.3f  %10ld  %10ld  %7.1f (%6.1f)  %7.1f (%6.1f)\n", i, turn.seconds,
+               turn.seconds - turn.waitSeconds - turn.leadSeconds - turn.lagSeconds, turn.leadSeconds,
+               turn.lagSeconds, turn.leadSteps, turn.holdSteps, 1e3 * o.hold / n, 1e3 * s.hold / n,
+               1e3 * perTurn, 1e3 * perTurnEst);
+
+        if (o.seconds > s.seconds + 1e-3) {
+            printf("FAIL  layer %zu: %.3f s overlapped, %.3f s sequential\n", i, o.seconds, s.seconds);
+            rc = 1;
+        }
+        if (fabs(perTurn - perTurnEst) > fmax(0.1 * fabs(perTurnEst), 0.020)) {
+            printf("FAIL  layer %zu: saves %.1f ms per turn-around, estimated %.1f ms\n", i, 1e3 * perTurn,
+                   1e3 * perTurnEst);
+            rc = 1;
+        }
+    }
+
+    const double seqTotal = seqResult.durationUs / 1e6;
+    const double ovlTotal = ovlResult.durationUs / 1e6;
+    printf("job %.1f s sequential, %.1f s overlapped: %.1f s saved (estimated %.1f s), "
+           "%.1f ms per turn-around over %d\n",
+           seqTotal, ovlTotal, seqTotal - ovlTotal, savedEst, turns > 0 ? 1e3 * saved / turns : 0.0, turns);
+    printf("%s\n", rc ? "FAIL" : "ok");
+    return rc;
+}
@@ -0,0 +1,179 @@
+/// @file gear_lag.cpp
+/// @brief Measure how far the geared carriage trails the ideal helix, per
+///        pass, across mandrel speeds.
+///
+///     gear_lag <profile> [--speeds a,b,c] [--loop-us N] [--per-pass]
+///
+/// Winds the profile once per mandrel speed (steps/s; default 600,900,1200)
+/// and compares the carriage, at every recorded step, with the ideal helix
+/// through the pass start — the layer's nominal mm per revolution, so use
+/// cylindrical profiles.  Lag is positive when the carriage trails.  Per
+/// pass:
+///
+///   peak     largest lag (mm)
+///   mid      lag half-way through the pass's mandrel rotation (mm) — the
+///            steady following error
+///   settle   carriage travel from the pass start until the lag is back
+///            within SETTLE_MM after its peak (mm; − if it never is)
+///   excess   mandrel rotation the pass took beyond the ideal helix over the
+///            same travel (degrees) — what a turn-around has to absorb
+///
+/// The summary row per speed gives the largest peak and the mean of the
+/// others over the passes whose geared speed is within the carriage's
+/// maximum speed (carriage-limited passes trail by design).
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "sim.h"
+#include "config.h"
+
+/// Lag (mm) below which the carriage counts as caught up.
+constexpr double SETTLE_MM = 0.1;
+
+/// Lag figures for one pass.
+struct PassLag {
+    int    layer    = 0;
+    int    pass     = 0;
+    bool   limited  = false;   ///< Geared speed above the carriage maximum.
+    double peakMM   = 0.0;
+    double midMM    = 0.0;
+    double settleMM = -1.0;
+    double excessDeg = 0.0;
+};
+
+// Split the trace into passes and measure each one.
+static std::vector<PassLag> analyse(const SimProfile& profile, const std::vector<StepSample>& trace,
+                                    float mandrelSpeed) {
+    const double stepsPerMM  = Sim::carriageStepsPerMM();
+    const double stepsPerRev = Sim::mandrelStepsPerRev();
+
+    std::vector<PassLag> out;
+    size_t i = 0;
+    while (i < trace.size()) {
+        // Find the sample where a pass starts (state becomes WINDING).
+        if (trace[i].state != WindingState::WINDING ||
+            (i > 0 && trace[i - 1].state == WindingState::WINDING)) {
+            i++;
+            continue;
+        }
+
+        const StepSample& start = trace[i];
+        if (start.layer >= static_cast<int>(profile.layers.size())) break;
+        const Layer& layer = profile.layers[start.layer];
+        const double k     = M_PI * layer.getDiameter() / tan(layer.getAngle() * M_PI / 180.0);
+        const double sign  = (start.pass % 2) == 0 ? 1.0 : -1.0;
+        const double x0    = start.carriage / stepsPerMM;
+        const long   m0    = start.mandrel;
+
+        size_t end = i;
+        while (end + 1 < trace.size() && trace[end + 1].state == WindingState::WINDING) end++;
+
+        PassLag p;
+        p.layer   = start.layer;
+        p.pass    = start.pass;
+        p.limited = k / stepsPerRev * stepsPerMM * mandrelSpeed > DEFAULT_CARRIAGE_MAX_SPEED;
+
+        const long mMid   = (m0 + trace[end].mandrel) / 2;
+        bool       midSet = false, peaked = false;
+        for (size_t j = i; j <= end; j++) {
+            const StepSample& s   = trace[j];
+            const double      x   = s.carriage / stepsPerMM;
+            const double      lag = sign * (x0 + sign * k * (s.mandrel - m0) / stepsPerRev - x);
+            if (lag > p.peakMM) {
+                p.peakMM   = lag;
+                p.settleMM = -1.0;
+                peaked     = true;
+            } else if (peaked && p.settleMM < 0.0 && fabs(lag) <= SETTLE_MM) {
+                p.settleMM = fabs(x - x0);
+            }
+            if (!midSet && s.mandrel >= mMid) {
+                p.midMM = lag;
+                midSet  = true;
+            }
+        }
+        if (!peaked) p.settleMM = 0.0;
+
+        const double travel = fabs(trace[end].carriage / stepsPerMM - x0);
+        p.excessDeg = ((trace[end].mandrel - m0) / stepsPerRev - travel / k) * 360.0;
+
+        out.push_back(p);
+        i = end + 1;
+    }
+    return out;
+}
+
+static void usage() {
+    fprintf(stderr, "usage: gear_lag <profile> [--speeds a,b,c] [--loop-us N] [--per-pass]\n");
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        usage();
+        return 2;
+    }
+
+    std::vector<float> speeds = { 600.0f, 900.0f, 1200.0f };
+    SimOptions         options;
+    bool               perPass = false;
+    for (int a = 2; a < argc; a++) {
+        bool hasValue = a + 1 < argc;
+        if (!strcmp(argv[a], "--speeds") && hasValue) {
+            speeds.clear();
+            for (char* s = strtok(argv[++a], ","); s; s = strtok(nullptr, ",")) speeds.push_back(atof(s));
+        } else if (!strcmp(argv[a], "--loop-us") && hasValue) {
+            options.loopUs = atoi(argv[++a]);
+        } else if (!strcmp(argv[a], "--per-pass")) {
+            perPass = true;
+        } else {
+            usage();
+            return 2;
+        }
+    }
+
+    SimProfile  profile;
+    std::string error;
+    if (!loadProfile(argv[1], profile, error)) {
+        fprintf(stderr, "gear_lag: %s\n", error.c_str());
+        return 2;
+    }
+
+    Serial.setSink(nullptr);
+    printf("mandrel  passes  peak_mm  mid_mm  settle_mm  excess_deg  job_s\n");
+    for (float speed : speeds) {
+        options.mandrelSpeed = speed;
+        std::vector<StepSample> trace;
+        SimResult               result;
+        if (!Sim::run(profile, options, &trace, result) || !result.completed) {
+            fprintf(stderr, "gear_lag: simulation at %.0f steps/s failed\n", speed);
+            return 1;
+        }
+
+        const std::vector<PassLag> passes = analyse(profile, trace, speed);
+        double peak = 0.0, mid = 0.0, settle = 0.0, excess = 0.0;
+        int    n = 0, settled = 0;
+        for (const PassLag& p : passes) {
+            if (perPass) {
+                printf("  %4.0f  %5d %4d  %7.3f  %6.3f  %9.2f  %10.3f%s\n", speed, p.layer, p.pass,
+                       p.peakMM, p.midMM, p.settleMM, p.excessDeg, p.limited ? "  limited" : "");
+            }
+            if (p.limited) continue;
+            peak    = fmax(peak, p.peakMM);
+            mid    += p.midMM;
+            excess += p.excessDeg;
+            n++;
+            if (p.settleMM >= 0.0) {
+                settle += p.settleMM;
+                settled++;
+            }
+        }
+        printf("%7.0f  %6d  %7.3f  %6.3f  %9.2f  %10.3f  %5.1f\n", speed, n, peak,
+               n ? mid / n : 0.0, settled ? settle / settled : -1.0, n ? excess / n : 0.0,
+               result.durationUs / 1e6);
+        fflush(stdout);
+    }
+    return 0;
+}
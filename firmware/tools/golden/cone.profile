@@ -0,0 +1,6 @@
+# Conical mandrel: radius 30 mm at home tapering to 20 mm at 220 mm.
+# The diameter is the reference for pass count and stepover.
+diameter 50
+point 0 30
+point 220 20
+layer 200 45 10 4 10
@@ -0,0 +1,26 @@
+# Cylindrical mandrel, radius 50 mm, with domed ends rising from 20 mm.
+# The toolarm follows the surface; on the dome shoulders it cannot keep up
+# at the winding speed (toolarm_track).
+diameter 100
+point 0 20
+point 10 36
+point 20 44
+point 30 48
+point 40 50
+point 60 50
+point 80 50
+point 100 50
+point 120 50
+point 140 50
+point 160 50
+point 180 50
+point 200 50
+point 220 50
+point 240 50
+point 260 50
+point 270 48
+point 280 44
+point 290 36
+point 300 20
+layer 280 60 10 4 10
+layer 280 80 10 4 10
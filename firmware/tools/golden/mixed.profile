@@ -0,0 +1,5 @@
+# Low, mid and near-hoop angles with an offset winding zone.
+diameter 80
+layer 150 30 10 6 20
+layer 150 55 10 6 20
+layer 150 80 10 6 0
@@ -0,0 +1,12 @@
+# Ten layers sharing one winding zone: every boundary is a hand-over.
+diameter 60
+layer 150 25 0 8 15
+layer 150 65 0 8 15
+layer 150 45 0 8 15
+layer 150 25 0 8 15
+layer 150 65 0 8 15
+layer 150 45 0 8 15
+layer 150 25 0 8 15
+layer 150 65 0 8 15
+layer 150 45 0 8 15
+layer 150 85 0 8 0
@@ -0,0 +1,3 @@
+# The firmware's built-in "profile" test job.
+diameter 50
+layer 200 45 0 4 10
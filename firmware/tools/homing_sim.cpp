@@ -0,0 +1,523 @@
+/// @file homing_sim.cpp
+/// @brief Two-stage carriage homing against a simulated limit switch, next to
+///        the single-speed homing it replaced, and all axes homed one after
+///        another against the HomingCoordinator.
+///
+///     homing_sim [--distance-mm D] [--cycles N] [--loop-us N]
+///                [--loop-jitter-us N] [--switch-jitter-um N]
+///                [--switch-delay-us N] [--toolarm-mm D] [--toolhead-deg A]
+///                [--seed N]
+///
+/// The carriage starts D mm (default 1000) from the switch and is homed N
+/// times (default 20) by each method, moved to a random point between D/2
+/// and D after every homing as a job would leave it.  The switch closes at
+/// a point scattered uniformly by ±--switch-jitter-um (default 20 µm) on
+/// every actuation and reads closed 0 … --switch-delay-us (default 500 µs:
+/// contact bounce, input filter) later, so a faster approach homes further
+/// past it and scatters more.  Two-stage homing sees the switch through
+/// the debounced inputs (inputs.h) and homes at the position latched at its
+/// edge, as the firmware does; the single-speed method reads the pin as it
+/// did.  Every loop() pass takes --loop-us (default 20) plus up to
+/// --loop-jitter-us (default 200) of virtual time.  Per method
+/// the tool prints the mean and longest homing time, the home
+/// repeatability (spread of the home position in the previous home's
+/// frame) and the largest home error, then the spread of the seek's
+/// trigger points — the repeatability of homing at the seek speed alone —
+/// and the first two-stage homing against Estimate::homing().  Then the
+/// carriage loses three times HomingConfig::lossLimit between two homings
+/// (it falls behind its pulses moving away from the switch), which the
+/// second must flag.
+///
+/// Then every axis homes from its own start — the carriage D mm, the
+/// toolarm --toolarm-mm (default 100) and the toolhead --toolhead-deg
+/// (default 180) from their switches, which are ideal — first one after
+/// another as the 4-axis scripts did, then concurrently through the
+/// HomingCoordinator in the configured dependency order.  The tool prints
+/// each axis's time in both runs, the time saved and Estimate::zeroing().
+///
+/// Last, the carriage homes against an ideal switch at a known point with
+/// loops of 20, 200, 1000 and 5000 µs, approaching at the configured speed
+/// and at the seek speed, from where the loop sees the switch and from the
+/// latched edge position; the tool prints each home's error.
+///
+/// Checks, each failing the tool (exit code 1):
+///
+///   - every two-stage homing completes;
+///   - its repeatability is within the switch scatter (a home error is the
+///     difference of two closing points) plus the steps of one switch delay
+///     at the approach speed and the step the edge lands in;
+///   - no repeated homing flags lost steps, and the one after the loss
+///     does, with home moved by the loss to within the repeatability
+///     allowance;
+///   - a homing that starts on the switch completes;
+///   - with no switch the seek gives up after the carriage travel
+///     (HomingFault::NO_SWITCH), and with a switch that never opens the
+///     back-off reports HomingFault::SWITCH_STUCK;
+///   - the coordinated homing completes within 2 % of the longest chain of
+///     dependent axes, from the axes' times when homed alone;
+///   - every latched home is within a step of the known switch point.
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <random>
+
+#include "axis.h"
+#include "config.h"
+#include "estimate.h"
+#include "homing.h"
+#include "inputs.h"
+#include "motor_control.h"
+
+// ============================================================================
+//  Simulated Carriage and Switch
+// ============================================================================
+
+enum class SwitchMode { NORMAL, ABSENT, STUCK };
+
+static long         s_physical  = 0;       // Steps from the switch's nominal closing point.
+static uint8_t      s_dirLevel  = LOW;
+static uint8_t      s_stepLevel = LOW;
+static long         s_closeAt   = 0;       // This actuation's closing point (steps).
+static bool         s_closed    = false;
+static long         s_scatter   = 0;       // ± closing-point scatter (steps).
+static uint32_t     s_delayUs   = 500;     // Longest closure-to-report delay.
+static uint64_t     s_reportAt  = 0;       // Virtual time this closure reads LOW.
+static bool         s_reached   = false;   // The carriage has reached the closing point.
+static SwitchMode   s_mode      = SwitchMode::NORMAL;
+static std::mt19937 s_rng;
+
+// Toolarm and toolhead, with ideal switches closed at or below step 0.
+struct IdealAxis {
+    uint8_t stepPin;
+    uint8_t dirPin;
+    uint8_t limitPin;
+    long    physical;
+    uint8_t dirLevel;
+    uint8_t stepLevel;
+};
+
+static IdealAxis s_toolarm  = { TOOLARM_MOTOR_PARAMS.step_pin, TOOLARM_MOTOR_PARAMS.dir_pin,
+                                TOOLARM_LIMIT_PIN, 0, LOW, LOW };
+static IdealAxis s_toolhead = { TOOLHEAD_MOTOR_PARAMS.step_pin, TOOLHEAD_MOTOR_PARAMS.dir_pin,
+                                TOOLHEAD_LIMIT_PIN, 0, LOW, LOW };
+
+static void onPinWrite(uint8_t pin, uint8_t value) {
+    for (IdealAxis* axis : { &s_toolarm, &s_toolhead }) {
+        if (pin == axis->dirPin) {
+            axis->dirLevel = value;
+        } else if (pin == axis->stepPin) {
+            if (value == HIGH && axis->stepLevel == LOW) axis->physical += (axis->dirLevel == HIGH) ? 1 : -1;
+            axis->stepLevel = value;
+        }
+    }
+    if (pin == CARRIAGE_MOTOR_PARAMS.dir_pin) {
+        s_dirLevel = value;
+    } else if (pin == CARRIAGE_MOTOR_PARAMS.step_pin) {
+        if (value == HIGH && s_stepLevel == LOW) s_physical += (s_dirLevel == HIGH) ? 1 : -1;
+        s_stepLevel = value;
+    }
+}
+
+// Active LOW.  The closure reads LOW a random 0 … s_delayUs after the
+// carriage reaches the closing point; a new point is drawn once the switch
+// has fully opened.
+static int onPinRead(uint8_t pin) {
+    if (pin == s_toolarm.limitPin)  return s_toolarm.physical <= 0 ? LOW : HIGH;
+    if (pin == s_toolhead.limitPin) return s_toolhead.physical <= 0 ? LOW : HIGH;
+    if (pin == E_STOP_PIN) return LOW;   // Released (normally closed).
+    if (pin != CARRIAGE_LIMIT_PIN) return HIGH;
+    if (s_mode == SwitchMode::ABSENT) return HIGH;
+    if (s_mode == SwitchMode::STUCK) return LOW;
+
+    if ((s_closed || s_reached) && s_physical > s_scatter) {
+        s_closed  = false;
+        s_reached = false;
+        s_closeAt = std::uniform_int_distribution<long>(-s_scatter, s_scatter)(s_rng);
+    }
+    if (!s_reached && s_physical <= s_closeAt) {
+        s_reached  = true;
+        s_reportAt = hostMicros64() + std::uniform_int_distribution<uint32_t>(0, s_delayUs)(s_rng);
+    }
+    if (s_reached && hostMicros64() >= s_reportAt) s_closed = true;
+    return s_closed ? LOW : HIGH;
+}
+
+static uint32_t s_loopUs       = 20;
+static uint32_t s_loopJitterUs = 200;
+
+static void nextLoop() {
+    hostAdvanceMicros(s_loopUs + std::uniform_int_distribution<uint32_t>(0, s_loopJitterUs)(s_rng));
+}
+
+static bool switchClosed(uint8_t pin = CARRIAGE_LIMIT_PIN) {
+    return digitalRead(pin) == LOW;
+}
+
+// Reposition the carriage to @p physical steps from the switch, as a job
+// leaves it (winding limits, positioned move).
+static void moveTo(long physical) {
+    carriageStepper.setMaxSpeed(DEFAULT_CARRIAGE_MAX_SPEED);
+    carriageStepper.setAcceleration(DEFAULT_CARRIAGE_ACCEL);
+    carriageStepper.moveTo(carriageStepper.currentPosition() + (physical - s_physical));
+    while (carriageStepper.run()) nextLoop();
+}
+
+// ============================================================================
+//  Homing Methods
+// ============================================================================
+
+/// One homing: time, and the home in the previous home's frame.
+struct HomingRun {
+    bool        done   = false;
+    double      seconds = 0.0;
+    long        error  = 0;
+    HomingFault fault  = HomingFault::NONE;
+};
+
+// The ZEROING state before two-stage homing: constant 400 steps/s onto the
+// switch, home where it reads closed.
+static HomingRun homeSingleSpeed() {
+    const uint64_t t0 = hostMicros64();
+    HomingRun h;
+    for (long loops = 0; loops < 100000000L; loops++) {
+        carriageStepper.setSpeed(-400.0f);
+        carriageStepper.runSpeed();
+        if (switchClosed()) {
+            h.error = carriageStepper.currentPosition();
+            carriageStepper.stop();
+            carriageStepper.setCurrentPosition(0);
+            h.done = true;
+            break;
+        }
+        nextLoop();
+    }
+    h.seconds = (hostMicros64() - t0) * 1e-6;
+    return h;
+}
+
+// Two-stage homing from the position latched at the switch edge, or with
+// @p latched false (carriage only) from where the loop sees the switch, as
+// before position latching.
+static HomingRun homeTwoStage(Homing& axis, Input limit = Input::CARRIAGE_LIMIT, bool latched = true) {
+    HomingRun h;
+    axis.start();
+    HomingStage stage = HomingStage::SEEK;
+    while (axis.busy()) {
+        const long edge = latched ? Inputs::edgePosition(limit) : carriageStepper.currentPosition();
+        stage = axis.update(Inputs::active(limit), edge);
+        nextLoop();
+    }
+    h.done    = (stage == HomingStage::DONE);
+    h.seconds = axis.report().seconds;
+    h.error   = axis.report().homeError;
+    h.fault   = axis.report().fault;
+    return h;
+}
+
+/// Homing figures over the cycles of one method.
+struct Summary {
+    int    homings = 0;
+    double sumS = 0.0, maxS = 0.0;
+    long   errMin = 0, errMax = 0, worst = 0;
+
+    void add(const HomingRun& h, bool referenced) {
+        homings++;
+        sumS += h.seconds;
+        maxS  = fmax(maxS, h.seconds);
+        if (!referenced) return;
+        if (homings == 2 || h.error < errMin) errMin = h.error;
+        if (homings == 2 || h.error > errMax) errMax = h.error;
+        if (labs(h.error) > worst) worst = labs(h.error);
+    }
+};
+
+static void printSummary(const char* name, const Summary& s) {
+    const double umPerStep = CarriageAxis::mmPerStep() * 1000.0;
+    printf("%-12s  %7d  %7.2f  %7.2f  %12.1f  %12.1f\n", name, s.homings,
+           s.homings ? s.sumS / s.homings : 0.0, s.maxS, (s.errMax - s.errMin) * umPerStep,
+           s.worst * umPerStep);
+}
+
+// Position sources of the limit inputs, as Winding::init() sets them.
+static long carriagePosition() { return carriageStepper.currentPosition(); }
+static long toolarmPosition()  { return toolarmStepper.currentPosition(); }
+static long toolheadPosition() { return toolheadStepper.currentPosition(); }
+
+// Fresh steppers and switches, the carriage @p physical steps from its
+// switch and the toolarm and toolhead @p toolarm / @p toolhead from theirs.
+static void reset(long physical, SwitchMode mode, long toolarm = 0, long toolhead = 0) {
+    hostResetClock();
+    toolarmStepper  = ToolarmStepper();
+    toolheadStepper = ToolheadStepper();
+    s_toolarm.physical  = toolarm;
+    s_toolhead.physical = toolhead;
+    carriageStepper = CarriageStepper();
+    carriageStepper.setMaxSpeed(DEFAULT_CARRIAGE_MAX_SPEED);   // As Winding::start().
+    carriageStepper.setAcceleration(DEFAULT_CARRIAGE_ACCEL);
+    s_physical      = physical;
+    s_stepLevel     = LOW;
+    s_closed        = false;
+    s_reached       = false;
+    s_closeAt       = 0;
+    s_mode          = mode;
+    Inputs::init();
+}
+
+static void usage() {
+    fprintf(stderr,
+            "usage: homing_sim [--distance-mm D] [--cycles N] [--loop-us N]\n"
+            "                  [--loop-jitter-us N] [--switch-jitter-um N]\n"
+            "                  [--switch-delay-us N] [--toolarm-mm D] [--toolhead-deg A]\n"
+            "                  [--seed N]\n");
+}
+
+int main(int argc, char** argv) {
+    float    distanceMM = 1000.0f;
+    int      cycles     = 20;
+    float    jitterUM   = 20.0f;
+    float    toolarmMM  = 100.0f;
+    float    toolheadDeg = 180.0f;
+    unsigned seed       = 1;
+    for (int a = 1; a < argc; a++) {
+        bool hasValue = a + 1 < argc;
+        if      (!strcmp(argv[a], "--distance-mm") && hasValue)      distanceMM     = atof(argv[++a]);
+        else if (!strcmp(argv[a], "--cycles") && hasValue)           cycles         = atoi(argv[++a]);
+        else if (!strcmp(argv[a], "--loop-us") && hasValue)          s_loopUs       = atoi(argv[++a]);
+        else if (!strcmp(argv[a], "--loop-jitter-us") && hasValue)   s_loopJitterUs = atoi(argv[++a]);
+        else if (!strcmp(argv[a], "--switch-jitter-um") && hasValue) jitterUM       = atof(argv[++a]);
+        else if (!strcmp(argv[a], "--switch-delay-us") && hasValue)  s_delayUs      = atoi(argv[++a]);
+        else if (!strcmp(argv[a], "--toolarm-mm") && hasValue)       toolarmMM      = atof(argv[++a]);
+        else if (!strcmp(argv[a], "--toolhead-deg") && hasValue)     toolheadDeg    = atof(argv[++a]);
+        else if (!strcmp(argv[a], "--seed") && hasValue)             seed           = atoi(argv[++a]);
+        else {
+            usage();
+            return 2;
+        }
+    }
+    if (cycles < 2 || distanceMM <= 0.0f) {
+        usage();
+        return 2;
+    }
+
+    hostSetPinWriter(onPinWrite);
+    hostSetPinReader(onPinRead);
+    Inputs::setPositionSource(Input::CARRIAGE_LIMIT, carriagePosition);
+    Inputs::setPositionSource(Input::TOOLARM_LIMIT, toolarmPosition);
+    Inputs::setPositionSource(Input::TOOLHEAD_LIMIT, toolheadPosition);
+    s_scatter = lroundf(jitterUM / 1000.0f * CarriageAxis::stepsPerMM());
+
+    const long distance = lroundf(CarriageAxis::toSteps(distanceMM));
+    bool       ok       = true;
+
+    // ── Repeated homings, each method from the same start and positions ──────
+    Summary   single, twoStage;
+    HomingRun firstTwoStage;
+    long      seekMin = 0, seekMax = 0;   // Seek trigger points relative to home.
+    int       falseLosses = 0;            // Homings flagging steps that were not lost.
+    for (int method = 0; method < 2; method++) {
+        reset(distance, SwitchMode::NORMAL);
+        s_rng.seed(seed);
+        HomingAxis<CarriageStepper> axis(carriageStepper, CARRIAGE_HOMING);
+        for (int c = 0; c < cycles; c++) {
+            const HomingRun h = method ? homeTwoStage(axis) : homeSingleSpeed();
+            if (method == 0) {
+                single.add(h, c > 0);
+            } else {
+                twoStage.add(h, c > 0);
+                if (c == 0) firstTwoStage = h;
+                if (!h.done) {
+                    printf("FAIL  two-stage homing %d did not complete\n", c);
+                    ok = false;
+                    break;
+                }
+                if (axis.report().lostSteps) falseLosses++;
+                const long seekHit = axis.report().seekHit;
+                if (c == 0 || seekHit < seekMin) seekMin = seekHit;
+                if (c == 0 || seekHit > seekMax) seekMax = seekHit;
+            }
+            moveTo(std::uniform_int_distribution<long>(distance / 2, distance)(s_rng));
+        }
+    }
+
+    printf("carriage %.0f mm from the switch, %d homings, switch scatter ±%.0f µm / %u µs, "
+           "loop %u…%u µs\n\n", distanceMM, cycles, jitterUM, s_delayUs, s_loopUs,
+           s_loopUs + s_loopJitterUs);
+    printf("method        homings   mean_s    max_s  repeat_um   worst_err_um\n");
+    printSummary("single 400", single);
+    printSummary("two-stage", twoStage);
+    printf("seek trigger spread %.1f µm (a single %.0f steps/s approach)\n",
+           (seekMax - seekMin) * CarriageAxis::mmPerStep() * 1000.0, CARRIAGE_HOMING.fastSpeed);
+
+    const uint32_t meanLoopUs = s_loopUs + s_loopJitterUs / 2;
+    const float    estimateS  = Estimate::homing(CARRIAGE_HOMING, distance, meanLoopUs);
+    printf("\nfirst two-stage homing %.2f s, Estimate::homing() %.2f s (%+.1f %%)\n",
+           firstTwoStage.seconds, estimateS,
+           100.0 * (estimateS - firstTwoStage.seconds) / firstTwoStage.seconds);
+
+    // Each error is the difference of two closing points (up to 4× the
+    // scatter apart); the closure reads late by up to the switch delay, so
+    // add the steps of that at the approach speed, and one for the step the
+    // edge lands in.  Debounce and loop latency do not count: home is the
+    // latched edge.
+    const long allowed = 4 * s_scatter + 1 +
+        static_cast<long>(ceilf(CARRIAGE_HOMING.slowSpeed * s_delayUs * 1e-6f));
+    const long repeat  = twoStage.errMax - twoStage.errMin;
+    printf("%s  two-stage repeatability %ld steps (allowed %ld)\n",
+           repeat <= allowed ? "ok  " : "FAIL", repeat, allowed);
+    if (repeat > allowed) ok = false;
+
+    // ── Steps lost between homings ───────────────────────────────────────────
+    {
+        reset(distance, SwitchMode::NORMAL);
+        s_rng.seed(seed);
+        HomingAxis<CarriageStepper> axis(carriageStepper, CARRIAGE_HOMING);
+        homeTwoStage(axis);
+        moveTo(std::uniform_int_distribution<long>(distance / 2, distance)(s_rng));
+        const long loss = 3 * CARRIAGE_HOMING.lossLimit;
+        s_physical -= loss;
+        const HomingRun h    = homeTwoStage(axis);
+        const bool      pass = falseLosses == 0 && h.done && axis.report().lostSteps &&
+                               labs(h.error - loss) <= allowed;
+        printf("%s  %d false step-loss flags; %ld steps lost flagged %s, home moved %ld (limit %ld)\n",
+               pass ? "ok  " : "FAIL", falseLosses, loss, axis.report().lostSteps ? "yes" : "no", h.error,
+               CARRIAGE_HOMING.lossLimit);
+        if (!pass) ok = false;
+    }
+
+    // ── Edge cases ───────────────────────────────────────────────────────────
+    struct Case {
+        const char* name;
+        long        start;
+        SwitchMode  mode;
+        HomingStage stage;
+        HomingFault fault;
+    };
+    const Case cases[] = {
+        { "start on the switch", -5, SwitchMode::NORMAL, HomingStage::DONE, HomingFault::NONE },
+        { "no switch", distance, SwitchMode::ABSENT, HomingStage::FAILED, HomingFault::NO_SWITCH },
+        { "switch stuck closed", distance, SwitchMode::STUCK, HomingStage::FAILED, HomingFault::SWITCH_STUCK },
+    };
+    for (const Case& c : cases) {
+        reset(c.start, c.mode);
+        HomingAxis<CarriageStepper> axis(carriageStepper, CARRIAGE_HOMING);
+        const HomingRun h = homeTwoStage(axis);
+        const bool   pass = (axis.stage() == c.stage && h.fault == c.fault);
+        printf("%s  %-20s %s after %.2f s\n", pass ? "ok  " : "FAIL", c.name,
+               axis.stage() == HomingStage::DONE ? "homed" : "failed", h.seconds);
+        if (!pass) ok = false;
+    }
+
+    // ── All axes: one after another, then coordinated ────────────────────────
+    const long toolarm  = lroundf(ToolarmAxis::toSteps(toolarmMM));
+    const long toolhead = lroundf(ToolheadAxis::toSteps(toolheadDeg));
+    const char* const names[HOMED_AXES]  = { "carriage", "toolarm", "toolhead" };
+    const Input       limits[HOMED_AXES] = { Input::CARRIAGE_LIMIT, Input::TOOLARM_LIMIT, Input::TOOLHEAD_LIMIT };
+
+    reset(distance, SwitchMode::NORMAL, toolarm, toolhead);
+    s_rng.seed(seed);
+    HomingAxis<CarriageStepper> carriage(carriageStepper, CARRIAGE_HOMING);
+    HomingAxis<ToolarmStepper>  arm(toolarmStepper, TOOLARM_HOMING);
+    HomingAxis<ToolheadStepper> head(toolheadStepper, TOOLHEAD_HOMING);
+    Homing* const axes[HOMED_AXES] = { &carriage, &arm, &head };
+
+    double alone[HOMED_AXES], sequential = 0.0;
+    bool   homed = true;
+    for (uint8_t i = 0; i < HOMED_AXES; i++) {
+        const HomingRun h = homeTwoStage(*axes[i], limits[i]);
+        alone[i]    = h.seconds;
+        sequential += h.seconds;
+        homed       = homed && h.done;
+    }
+
+    reset(distance, SwitchMode::NORMAL, toolarm, toolhead);
+    s_rng.seed(seed);
+    HomingAxis<CarriageStepper> carriage2(carriageStepper, CARRIAGE_HOMING);
+    HomingAxis<ToolarmStepper>  arm2(toolarmStepper, TOOLARM_HOMING);
+    HomingAxis<ToolheadStepper> head2(toolheadStepper, TOOLHEAD_HOMING);
+    HomingCoordinator coordinator;
+    coordinator.add(carriage2, Input::CARRIAGE_LIMIT);
+    coordinator.add(arm2, Input::TOOLARM_LIMIT);
+    coordinator.add(head2, Input::TOOLHEAD_LIMIT);
+    coordinator.start();
+    while (coordinator.update()) nextLoop();
+    homed = homed && !coordinator.failed();
+
+    // The longest chain of dependent axes, from their times alone.
+    double finish[HOMED_AXES], chain = 0.0;
+    for (uint8_t i = 0; i < HOMED_AXES; i++) {
+        double start = 0.0;
+        for (uint8_t j = 0; j < i; j++) {
+            if ((axes[i]->config().after & (1u << j)) && finish[j] > start) start = finish[j];
+        }
+        finish[i] = start + alone[i];
+        chain     = fmax(chain, finish[i]);
+    }
+
+    printf("\nall axes: carriage %.0f mm, toolarm %.0f mm, toolhead %.0f deg from their switches\n\n",
+           distanceMM, toolarmMM, toolheadDeg);
+    printf("axis        alone_s  coordinated_s  waits_for\n");
+    for (uint8_t i = 0; i < HOMED_AXES; i++) {
+        printf("%-10s  %7.2f  %13.2f  ", names[i], alone[i], coordinator.axis(i).report().seconds);
+        const uint8_t after = axes[i]->config().after;
+        if (!after) printf("-");
+        for (uint8_t j = 0; j < HOMED_AXES; j++) {
+            if (after & (1u << j)) printf("%s ", names[j]);
+        }
+        printf("\n");
+    }
+    EstimateParams params = Estimate::defaultParams(distance, toolarm, toolhead);
+    params.loopUs         = meanLoopUs;
+    printf("one after another %.2f s, coordinated %.2f s (saved %.2f s, %.0f %%), "
+           "longest chain %.2f s, Estimate::zeroing() %.2f s\n",
+           sequential, coordinator.seconds(), sequential - coordinator.seconds(),
+           100.0 * (sequential - coordinator.seconds()) / sequential, chain, Estimate::zeroing(params));
+
+    const bool concurrent = homed && coordinator.seconds() <= 1.02 * chain;
+    printf("%s  coordinated homing within 2 %% of the longest chain\n", concurrent ? "ok  " : "FAIL");
+    if (!concurrent) ok = false;
+
+    // ── Known switch point, loop latency swept ───────────────────────────────
+    // An ideal switch closes at physical step 0, so a home error is where
+    // stepper position 0 lands: negative past the switch.
+    s_scatter      = 0;
+    s_delayUs      = 0;
+    s_loopJitterUs = 0;
+    HomingConfig fastApproach = CARRIAGE_HOMING;
+    fastApproach.slowSpeed    = CARRIAGE_HOMING.fastSpeed;
+    const HomingConfig* const approaches[] = { &CARRIAGE_HOMING, &fastApproach };
+    const uint32_t            latencies[]  = { 20, 200, 1000, 5000 };
+    const double              umPerStep    = CarriageAxis::mmPerStep() * 1000.0;
+
+    printf("\nhome error at a known switch point (µm), approach at %.0f / %.0f steps/s\n\n",
+           CARRIAGE_HOMING.slowSpeed, fastApproach.slowSpeed);
+    printf("loop_us   read_slow  latched_slow   read_fast  latched_fast\n");
+    long worstLatched = 0;
+    bool latchedDone  = true;
+    for (uint32_t loopUs : latencies) {
+        s_loopUs = loopUs;
+        printf("%7u", loopUs);
+        for (const HomingConfig* config : approaches) {
+            for (bool latched : { false, true }) {
+                reset(CarriageAxis::toSteps(20.0f), SwitchMode::NORMAL);
+                HomingAxis<CarriageStepper> axis(carriageStepper, *config);
+                const HomingRun h     = homeTwoStage(axis, Input::CARRIAGE_LIMIT, latched);
+                const long      error = s_physical - carriageStepper.currentPosition();
+                printf("  %10.1f", error * umPerStep);
+                if (latched) {
+                    latchedDone  = latchedDone && h.done;
+                    worstLatched = std::max(worstLatched, labs(error));
+                }
+            }
+        }
+        printf("\n");
+    }
+    const bool exact = latchedDone && worstLatched <= 1;
+    printf("%s  latched home within 1 step of the switch at every latency and speed (worst %ld)\n",
+           exact ? "ok  " : "FAIL", worstLatched);
+    if (!exact) ok = false;
+
+    return ok ? 0 : 1;
+}
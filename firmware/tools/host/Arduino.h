@@ -0,0 +1,194 @@
+/// @file Arduino.h
+/// @brief Minimal host-side stand-in for the Arduino core.
+///
+/// Lets the firmware sources (layer, winding, steppers, ...) compile and
+/// run on a PC inside the host tools.  Time is virtual: micros() only moves
+/// when a tool calls hostAdvanceMicros(), so a simulated job runs as fast as
+/// the host can execute it and is fully deterministic.  GPIO reads and writes
+/// are routed through hooks so a tool can model limit switches and observe
+/// step pulses.  Pin interrupts and a periodic hardware timer are delivered
+/// from virtual time: whenever the clock moves, attached pins whose level
+/// (as the reader hook reports it) changed fire their ISR, and the timer ISR
+/// runs at each of its ticks on the way.
+///
+/// Build host tools with -DARDUINO=10800 -Itools/host (see tools/README).
+
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+// ============================================================================
+//  Core Types and Constants
+// ============================================================================
+
+typedef bool    boolean;
+typedef uint8_t byte;
+
+#ifndef PI
+#define PI 3.1415926535897932384626433832795
+#endif
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT        0x01
+#define OUTPUT       0x03
+#define INPUT_PULLUP 0x05
+
+#define RISING  0x01
+#define FALLING 0x02
+#define CHANGE  0x03
+
+#define IRAM_ATTR
+#define digitalPinToInterrupt(p) (p)
+
+#define DEC 10
+#define HEX 16
+
+#define radians(deg) ((deg) * (PI / 180.0))
+#define degrees(rad) ((rad) * (180.0 / PI))
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+using std::max;
+using std::min;
+
+class __FlashStringHelper;
+#define F(str) (reinterpret_cast<const __FlashStringHelper*>(str))
+
+// ============================================================================
+//  Virtual Time
+// ============================================================================
+
+unsigned long micros();
+unsigned long millis();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+inline void yield() {}
+
+/// Advance the virtual clock.
+void hostAdvanceMicros(uint64_t us);
+
+/// Full 64-bit virtual time (micros() wraps like the real one).
+uint64_t hostMicros64();
+
+/// Reset the virtual clock to zero.
+void hostResetClock();
+
+// ============================================================================
+//  GPIO
+// ============================================================================
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int  digitalRead(uint8_t pin);
+
+/// Hook returning the level of an input pin (default: HIGH, i.e. pulled up).
+void hostSetPinReader(int (*reader)(uint8_t pin));
+
+/// Hook observing every digitalWrite (e.g. to count step pulses).
+void hostSetPinWriter(void (*writer)(uint8_t pin, uint8_t value));
+
+// ============================================================================
+//  Interrupts and Hardware Timer
+// ============================================================================
+
+void attachInterruptArg(uint8_t pin, void (*isr)(void*), void* arg, int mode);
+void detachInterrupt(uint8_t pin);
+
+/// Run @p isr every @p periodUs of virtual time (stands in for a hardware
+/// timer alarm; replaces a previous one, nullptr stops it).
+void hostAttachTimer(void (*isr)(), uint32_t periodUs);
+
+/// Deliver interrupts for pin changes since the clock last moved, without
+/// moving it (hostAdvanceMicros does this itself).
+void hostPollInterrupts();
+
+// ============================================================================
+//  Print / Serial
+// ============================================================================
+
+/// Subset of Arduino's Print used by the firmware.  Output goes to a FILE*
+/// (stdout by default, nullptr discards).
+class Print {
+public:
+    explicit Print(FILE* sink = stdout) : sink_(sink) {}
+
+    void setSink(FILE* sink) { sink_ = sink; }
+
+    size_t write(uint8_t b) { return write(&b, 1); }
+    size_t write(const uint8_t* buf, size_t len) {
+        return sink_ ? fwrite(buf, 1, len, sink_) : len;
+    }
+
+    size_t print(const char* s)                  { return out("%s", s); }
+    size_t print(const __FlashStringHelper* s)   { return print(reinterpret_cast<const char*>(s)); }
+    size_t print(char c)                         { return out("%c", c); }
+    size_t print(int v, int base = DEC)          { return print(static_cast<long>(v), base); }
+    size_t print(unsigned int v, int base = DEC) { return print(static_cast<unsigned long>(v), base); }
+    size_t print(long v, int base = DEC)         { return out(base == HEX ? "%lX" : "%ld", v); }
+    size_t print(unsigned long v, int base = DEC){ return out(base == HEX ? "%lX" : "%lu", v); }
+    size_t print(double v, int digits = 2)       { return out("%.*f", digits, v); }
+
+    template <typename T>
+    size_t println(T v)              { size_t n = print(v); return n + println(); }
+    size_t println(double v, int d)  { size_t n = print(v, d); return n + println(); }
+    size_t println()                 { return out("\r\n"); }
+
+    template <typename... Args>
+    size_t printf(const char* fmt, Args... args) { return out(fmt, args...); }
+
+private:
+    FILE* sink_;
+
+    template <typename... Args>
+    size_t out(const char* fmt, Args... args) {
+        return sink_ ? static_cast<size_t>(fprintf(sink_, fmt, args...)) : 0;
+    }
+};
+
+/// Subset of Arduino's Stream: a Print that can also be read.
+class Stream : public Print {
+public:
+    explicit Stream(FILE* sink = stdout) : Print(sink) {}
+    virtual ~Stream() {}
+
+    virtual int    available() { return 0; }
+    virtual int    read() { return -1; }
+    virtual size_t write(const uint8_t* buf, size_t len) { return Print::write(buf, len); }
+    virtual void   flush() {}
+
+    size_t write(uint8_t b) { return write(&b, 1); }
+};
+
+#define SERIAL_8N1 0x800001c
+
+/// Serial stand-in.  Host tools never feed Serial input; a tool can wire a
+/// device model (a Stream) to another port with attach(), which then
+/// carries its bytes both ways.
+class HardwareSerial : public Stream {
+public:
+    explicit HardwareSerial(FILE* sink = stdout) : Stream(sink) {}
+
+    void begin(unsigned long, uint32_t = SERIAL_8N1, int8_t = -1, int8_t = -1) {}
+    void attach(Stream* device) { device_ = device; }
+
+    int available() override { return device_ ? device_->available() : 0; }
+    int read() override      { return device_ ? device_->read() : -1; }
+    size_t write(const uint8_t* buf, size_t len) override {
+        return device_ ? device_->write(buf, len) : Stream::write(buf, len);
+    }
+    void flush() override { if (device_) device_->flush(); }
+
+    using Stream::write;
+
+private:
+    Stream* device_ = nullptr;
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial2;   ///< Driver UART; silent unless a tool attaches a model.
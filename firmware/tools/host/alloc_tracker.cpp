@@ -0,0 +1,175 @@
+/// @file alloc_tracker.cpp
+/// @brief Counting replacements for the global operator new / delete and,
+///        on glibc, the C allocator.
+
+#include "alloc_tracker.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <atomic>
+#include <new>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+
+// glibc's own allocator, under the names it exports for replacements.
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* p, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void* __libc_valloc(size_t size);
+void* __libc_pvalloc(size_t size);
+void  __libc_free(void* p);
+}
+#endif
+
+// ============================================================================
+//  Counters
+// ============================================================================
+
+static std::atomic<size_t>   s_live{0};
+static std::atomic<size_t>   s_peak{0};
+static std::atomic<size_t>   s_max{0};
+static std::atomic<uint64_t> s_count{0};
+
+static void raise(std::atomic<size_t>& mark, size_t value) {
+    size_t seen = mark.load(std::memory_order_relaxed);
+    while (value > seen && !mark.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {
+    }
+}
+
+static void add(size_t size) {
+    size_t live = s_live.fetch_add(size, std::memory_order_relaxed) + size;
+    raise(s_peak, live);
+    raise(s_max, live);
+    s_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+#if defined(__GLIBC__)
+
+// Every block is counted at its usable size when the C allocator hands it
+// out and released when it comes back, so operator new, the C library and
+// std::thread all land in the same counters.
+static void* counted(void* p) {
+    if (p) add(malloc_usable_size(p));
+    return p;
+}
+
+static void* trackedAlloc(size_t size) { return malloc(size); }
+static void  trackedFree(void* p)      { free(p); }
+
+#else   // Only operator new / delete are counted.
+
+// Every block carries its size in a header padded to max_align_t, so the
+// pointer handed out keeps the alignment malloc guarantees.
+constexpr size_t HEADER = alignof(max_align_t);
+
+static void* trackedAlloc(size_t size) {
+    void* raw = malloc(size + HEADER);
+    if (!raw) return nullptr;
+    *static_cast<size_t*>(raw) = size;
+    add(size);
+    return static_cast<char*>(raw) + HEADER;
+}
+
+static void trackedFree(void* p) {
+    if (!p) return;
+    void* raw = static_cast<char*>(p) - HEADER;
+    s_live.fetch_sub(*static_cast<size_t*>(raw), std::memory_order_relaxed);
+    free(raw);
+}
+
+#endif
+
+// ============================================================================
+//  Tracker API
+// ============================================================================
+
+size_t   AllocTracker::liveBytes()   { return s_live.load(); }
+size_t   AllocTracker::peakBytes()   { return s_peak.load(); }
+size_t   AllocTracker::maxBytes()    { return s_max.load(); }
+uint64_t AllocTracker::allocations() { return s_count.load(); }
+
+void AllocTracker::resetPeak() {
+    s_peak.store(s_live.load());
+}
+
+uint32_t AllocTracker::heapFreeAtPeak() {
+    size_t peak = s_peak.load();
+    return peak < HOST_HEAP_SIZE ? static_cast<uint32_t>(HOST_HEAP_SIZE - peak) : 0;
+}
+
+uint32_t AllocTracker::heapMinFree() {
+    size_t max = s_max.load();
+    return max < HOST_HEAP_SIZE ? static_cast<uint32_t>(HOST_HEAP_SIZE - max) : 0;
+}
+
+// ============================================================================
+//  Global Operator Replacements
+// ============================================================================
+
+void* operator new(size_t size) {
+    void* p = trackedAlloc(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return trackedAlloc(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return trackedAlloc(size);
+}
+
+void operator delete(void* p) noexcept                              { trackedFree(p); }
+void operator delete[](void* p) noexcept                            { trackedFree(p); }
+void operator delete(void* p, size_t) noexcept                      { trackedFree(p); }
+void operator delete[](void* p, size_t) noexcept                    { trackedFree(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept       { trackedFree(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept     { trackedFree(p); }
+
+#if defined(__GLIBC__)
+
+// ============================================================================
+//  C Allocator Replacements (glibc)
+// ============================================================================
+
+extern "C" {
+
+void* malloc(size_t size)                          { return counted(__libc_malloc(size)); }
+void* calloc(size_t count, size_t size)            { return counted(__libc_calloc(count, size)); }
+void* memalign(size_t alignment, size_t size)      { return counted(__libc_memalign(alignment, size)); }
+void* aligned_alloc(size_t alignment, size_t size) { return counted(__libc_memalign(alignment, size)); }
+void* valloc(size_t size)                          { return counted(__libc_valloc(size)); }
+void* pvalloc(size_t size)                         { return counted(__libc_pvalloc(size)); }
+
+int posix_memalign(void** out, size_t alignment, size_t size) {
+    void* p = __libc_memalign(alignment, size);
+    if (!p) return ENOMEM;
+    *out = counted(p);
+    return 0;
+}
+
+void* realloc(void* p, size_t size) {
+    const size_t before = p ? malloc_usable_size(p) : 0;
+    void*        q      = __libc_realloc(p, size);
+    if (!q && size) return nullptr;   // Failed: p is untouched.
+    s_live.fetch_sub(before, std::memory_order_relaxed);
+    return counted(q);
+}
+
+void free(void* p) {
+    if (!p) return;
+    s_live.fetch_sub(malloc_usable_size(p), std::memory_order_relaxed);
+    __libc_free(p);
+}
+
+}  // extern "C"
+
+#endif
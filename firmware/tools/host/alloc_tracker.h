@@ -0,0 +1,49 @@
+/// @file alloc_tracker.h
+/// @brief Host heap model: counts every operator new / malloc made by the
+///        process so the firmware's memory instrumentation (memstat.cpp) and
+///        tools/mem_budget can see allocations made during a simulated job.
+///
+/// operator new / delete are replaced everywhere; on glibc so are malloc,
+/// calloc, realloc, the aligned forms and free, so allocations made by the
+/// C library, String or std::thread count too (at their usable size).
+/// Elsewhere only operator new / delete are seen.
+///
+/// The heap is modelled as HOST_HEAP_SIZE bytes with no fragmentation, so
+/// "free" is HOST_HEAP_SIZE minus the live bytes.  The peak is tracked
+/// between resetPeak() calls, so a reading taken after a burst of short-lived
+/// allocations still reports the worst point.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// Modelled heap size — roughly what an ESP32 Arduino sketch has free after boot.
+constexpr uint32_t HOST_HEAP_SIZE = 300 * 1024;
+
+/// @namespace AllocTracker
+/// @brief Global allocation counters.
+namespace AllocTracker {
+
+    /// Bytes currently allocated.
+    size_t liveBytes();
+
+    /// Highest liveBytes() since the last resetPeak().
+    size_t peakBytes();
+
+    /// Highest liveBytes() since the process started.
+    size_t maxBytes();
+
+    /// Number of allocations since the process started.
+    uint64_t allocations();
+
+    /// Restart the peak window at the current live bytes.
+    void resetPeak();
+
+    /// HOST_HEAP_SIZE − peakBytes() (free heap at the worst point of the window).
+    uint32_t heapFreeAtPeak();
+
+    /// HOST_HEAP_SIZE − maxBytes() (lowest free heap since start).
+    uint32_t heapMinFree();
+
+}  // namespace AllocTracker
@@ -0,0 +1,112 @@
+/// @file host_arduino.cpp
+/// @brief Virtual clock, GPIO hooks, interrupts and Serial for the host
+///        Arduino stand-in.
+
+#include "Arduino.h"
+
+HardwareSerial Serial;
+HardwareSerial Serial2(nullptr);
+
+// ============================================================================
+//  Virtual Time
+// ============================================================================
+
+static uint64_t s_nowUs = 0;
+
+static void     (*s_timerIsr)() = nullptr;
+static uint32_t s_timerPeriodUs = 0;
+static uint64_t s_timerNextUs   = 0;
+
+unsigned long micros() { return static_cast<uint32_t>(s_nowUs); }
+unsigned long millis() { return static_cast<uint32_t>(s_nowUs / 1000); }
+
+void delay(unsigned long ms)            { hostAdvanceMicros(static_cast<uint64_t>(ms) * 1000); }
+void delayMicroseconds(unsigned int us) { hostAdvanceMicros(us); }
+
+uint64_t hostMicros64() { return s_nowUs; }
+
+void hostResetClock() {
+    s_nowUs       = 0;
+    s_timerNextUs = s_timerPeriodUs;
+}
+
+void hostAdvanceMicros(uint64_t us) {
+    const uint64_t end = s_nowUs + us;
+    hostPollInterrupts();
+    while (s_timerIsr && s_timerNextUs <= end) {
+        s_nowUs = s_timerNextUs;
+        s_timerNextUs += s_timerPeriodUs;
+        s_timerIsr();
+    }
+    s_nowUs = end;
+}
+
+// ============================================================================
+//  GPIO
+// ============================================================================
+
+static int  (*s_pinReader)(uint8_t)          = nullptr;
+static void (*s_pinWriter)(uint8_t, uint8_t) = nullptr;
+
+void pinMode(uint8_t, uint8_t) {}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+    if (s_pinWriter) s_pinWriter(pin, value);
+}
+
+int digitalRead(uint8_t pin) {
+    return s_pinReader ? s_pinReader(pin) : HIGH;
+}
+
+void hostSetPinReader(int (*reader)(uint8_t))          { s_pinReader = reader; }
+void hostSetPinWriter(void (*writer)(uint8_t, uint8_t)) { s_pinWriter = writer; }
+
+// ============================================================================
+//  Interrupts and Hardware Timer
+// ============================================================================
+
+struct PinInterrupt {
+    uint8_t pin;
+    int     mode;
+    int     level;     // Level at the last poll.
+    void  (*isr)(void*);
+    void*   arg;
+};
+
+static constexpr uint8_t MAX_PIN_INTERRUPTS = 8;
+static PinInterrupt s_interrupts[MAX_PIN_INTERRUPTS];
+static uint8_t      s_interruptCount = 0;
+
+void attachInterruptArg(uint8_t pin, void (*isr)(void*), void* arg, int mode) {
+    detachInterrupt(pin);
+    if (s_interruptCount == MAX_PIN_INTERRUPTS) return;
+    s_interrupts[s_interruptCount++] = { pin, mode, digitalRead(pin), isr, arg };
+}
+
+void detachInterrupt(uint8_t pin) {
+    for (uint8_t i = 0; i < s_interruptCount; i++) {
+        if (s_interrupts[i].pin != pin) continue;
+        s_interrupts[i] = s_interrupts[--s_interruptCount];
+        return;
+    }
+}
+
+void hostAttachTimer(void (*isr)(), uint32_t periodUs) {
+    s_timerIsr      = periodUs ? isr : nullptr;
+    s_timerPeriodUs = periodUs;
+    s_timerNextUs   = s_nowUs + periodUs;
+}
+
+void hostPollInterrupts() {
+    static bool s_inIsr = false;   // An ISR reading pins must not recurse.
+    if (s_inIsr) return;
+    s_inIsr = true;
+    for (uint8_t i = 0; i < s_interruptCount; i++) {
+        PinInterrupt& p = s_interrupts[i];
+        const int level = digitalRead(p.pin);
+        if (level == p.level) continue;
+        p.level = level;
+        if (p.mode == CHANGE || (p.mode == RISING) == (level == HIGH)) p.isr(p.arg);
+    }
+    s_inIsr = false;
+}
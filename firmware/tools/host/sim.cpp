@@ -0,0 +1,414 @@
+/// @file sim.cpp
+/// @brief Virtual-time job runner, profile parser and step-trace I/O.
+
+#include "sim.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+
+#include "axis.h"
+#include "config.h"
+#include "encoder.h"
+#include "homing.h"
+#include "memstat.h"
+#include "motor_control.h"
+#include "planner.h"
+
+// ============================================================================
+//  Profiles
+// ============================================================================
+
+bool loadProfile(const char* path, SimProfile& out, std::string& error) {
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        error = std::string("cannot open ") + path;
+        return false;
+    }
+
+    out = SimProfile();
+    char line[256];
+    int  lineNo = 0;
+    bool ok     = true;
+
+    while (ok && fgets(line, sizeof(line), f)) {
+        lineNo++;
+        char* hash = strchr(line, '#');
+        if (hash) *hash = '\0';
+
+        char  key[32];
+        float v[5];
+        int   n = sscanf(line, "%31s %f %f %f %f %f", key, &v[0], &v[1], &v[2], &v[3], &v[4]);
+        if (n <= 0) continue;   // Blank or comment-only line.
+
+        if (strcmp(key, "diameter") == 0 && n == 2 && v[0] > 0.0f) {
+            out.diameter = v[0];
+        } else if (strcmp(key, "layer") == 0 && n == 6) {
+            if (out.diameter <= 0.0f) {
+                error = "layer before diameter";
+                ok    = false;
+            } else {
+                out.layers.push_back(Layer(v[0], v[1], v[2], v[3], v[4], out.diameter));
+            }
+        } else if (strcmp(key, "point") == 0 && n == 3 && v[1] > 0.0f) {
+            if (!out.pointX.empty() && v[0] <= out.pointX.back()) {
+                error = "point positions must increase";
+                ok    = false;
+            } else {
+                out.pointX.push_back(v[0]);
+                out.pointR.push_back(v[1]);
+            }
+        } else if (strcmp(key, "pattern") == 0 && n == 2) {
+            out.patternSequencing = (v[0] != 0.0f);
+        } else if (strcmp(key, "flip") == 0 && n == 2) {
+            out.overlapToolheadFlip = (v[0] != 0.0f);
+        } else if (strcmp(key, "lookahead") == 0 && n == 2) {
+            out.toolarmLookAhead = (v[0] != 0.0f);
+        } else {
+            error = "unrecognised directive";
+            ok    = false;
+        }
+
+        if (!ok) error = std::string(path) + ":" + std::to_string(lineNo) + ": " + error;
+    }
+    fclose(f);
+
+    if (ok && out.layers.empty()) {
+        error = std::string(path) + ": no layers";
+        ok    = false;
+    }
+    return ok;
+}
+
+bool applyProfile(const SimProfile& in, WindProfile& out) {
+    if (in.layers.size() > static_cast<size_t>(MAX_LAYERS)) return false;
+
+    out.clear();
+    out.mandrelDiameter   = in.diameter;
+    out.patternSequencing = in.patternSequencing;
+    out.overlapToolheadFlip = in.overlapToolheadFlip;
+    out.toolarmLookAhead    = in.toolarmLookAhead;
+    for (const Layer& l : in.layers) {
+        out.layers[out.layerCount++] = l;
+    }
+    for (size_t i = 0; i < in.pointX.size(); i++) {
+        if (!out.mandrelProfile.addPoint(in.pointX[i], in.pointR[i])) return false;
+    }
+    out.mandrelProfile.compute();
+    return true;
+}
+
+const SplineProfile* fitMandrel(const SimProfile& in) {
+    static SplineProfile mandrel;
+    mandrel.clear();
+    for (size_t i = 0; i < in.pointX.size(); i++) {
+        if (!mandrel.addPoint(in.pointX[i], in.pointR[i])) return nullptr;
+    }
+    if (mandrel.getPointCount() < 2) return nullptr;
+    mandrel.compute(CarriageAxis::stepsPerMM(), ToolarmAxis::stepsPerMM());
+    return &mandrel;
+}
+
+// ============================================================================
+//  Simulated Machine
+// ============================================================================
+
+// A homed axis: its pulses, the load behind its drive's backlash and its
+// limit switch.  The motor turns through the dead band before the load
+// moves: gap runs 0 (pushing towards negative positions) … backlash.
+struct SimAxis {
+    uint8_t stepPin;
+    uint8_t dirPin;
+    uint8_t limitPin;
+    uint8_t address;      // Driver's UART address.
+    long    physical;     // Steps from the start position.
+    long    switchStep;   // Load position of the switch.
+    uint8_t dirLevel;
+    uint8_t stepLevel;
+    long    backlash;     // Dead band (steps).
+    long    gap;          // Motor within it.
+    long    load;         // Load position (steps from the start position).
+    TmcNodeModel* driver; // Driver model it steps through (nullptr: strapped).
+    uint16_t microsteps;  // The axis's own resolution.
+};
+
+static SimAxis s_axes[] = {
+    { CARRIAGE_MOTOR_PARAMS.step_pin, CARRIAGE_MOTOR_PARAMS.dir_pin, CARRIAGE_LIMIT_PIN,
+      CARRIAGE_DRIVER_CONFIG.address, 0, 0, LOW, LOW, 0, 0, 0, nullptr, CARRIAGE_MOTOR_PARAMS.microsteps },
+    { TOOLARM_MOTOR_PARAMS.step_pin, TOOLARM_MOTOR_PARAMS.dir_pin, TOOLARM_LIMIT_PIN,
+      TOOLARM_DRIVER_CONFIG.address, 0, 0, LOW, LOW, 0, 0, 0, nullptr, TOOLARM_MOTOR_PARAMS.microsteps },
+    { TOOLHEAD_MOTOR_PARAMS.step_pin, TOOLHEAD_MOTOR_PARAMS.dir_pin, TOOLHEAD_LIMIT_PIN,
+      TOOLHEAD_DRIVER_CONFIG.address, 0, 0, LOW, LOW, 0, 0, 0, nullptr, TOOLHEAD_MOTOR_PARAMS.microsteps },
+};
+static SimAxis& s_carriage = s_axes[static_cast<uint8_t>(HomeAxis::CARRIAGE)];
+static SimAxis& s_toolhead = s_axes[static_cast<uint8_t>(HomeAxis::TOOLHEAD)];
+
+// A driver switched to a coarser resolution moves the motor several of the
+// axis's steps a pulse.
+static void onAxisPulse(SimAxis& axis) {
+    if (axis.driver && !axis.driver->step(axis.dirLevel == HIGH)) return;   // Jammed.
+    const int steps = axis.driver ? axis.microsteps / axis.driver->microsteps() : 1;
+    for (int i = 0; i < steps; i++) {
+        if (axis.dirLevel == HIGH) {
+            axis.physical++;
+            if (axis.gap < axis.backlash) axis.gap++;
+            else                          axis.load++;
+        } else {
+            axis.physical--;
+            if (axis.gap > 0) axis.gap--;
+            else              axis.load--;
+        }
+    }
+}
+
+// The mandrel: its pulses, the ones it loses (a slip drops a run of
+// pulses every so often) and the encoder on its shaft.
+struct SimMandrel {
+    long     physical;     // Steps turned from the start position.
+    uint8_t  dirLevel;
+    uint8_t  stepLevel;
+    uint32_t slipEvery;    // Pulses between slips (0: none).
+    uint32_t slipSteps;    // Pulses lost per slip.
+    uint32_t pulses;       // Pulses since the last slip.
+    uint32_t dropping;     // Pulses still to lose in this slip.
+    long     lost;         // Pulses lost so far.
+    TmcNodeModel* driver;  // Driver model it steps through (nullptr: strapped).
+};
+
+static SimMandrel s_mandrel = {};
+
+static void onMandrelPulse() {
+    if (s_mandrel.driver && !s_mandrel.driver->step(s_mandrel.dirLevel == HIGH)) {
+        s_mandrel.lost++;   // Jammed.
+        return;
+    }
+    if (s_mandrel.dropping > 0) {
+        s_mandrel.dropping--;
+        s_mandrel.lost++;
+        return;
+    }
+    if (s_mandrel.slipEvery && ++s_mandrel.pulses >= s_mandrel.slipEvery) {
+        s_mandrel.pulses   = 0;
+        s_mandrel.dropping = s_mandrel.slipSteps;
+    }
+    s_mandrel.physical += (s_mandrel.dirLevel == HIGH) ? 1 : -1;
+}
+
+// Encoder lines at the physical mandrel angle (Gray code: 00, A, AB, B).
+static int encoderLine(uint8_t pin) {
+    const long    stepsPerRev = static_cast<long>(MandrelAxis::stepsPerRev());
+    const int64_t scaled      = static_cast<int64_t>(s_mandrel.physical) * MANDREL_ENCODER_COUNTS_PER_REV;
+    const int64_t count       = scaled >= 0 ? scaled / stepsPerRev : -((-scaled + stepsPerRev - 1) / stepsPerRev);
+    const int     phase       = static_cast<int>(count & 3);
+    const bool    a           = phase == 1 || phase == 2;
+    const bool    b           = phase >= 2;
+    return (pin == MANDREL_ENCODER_A_PIN ? a : b) ? HIGH : LOW;
+}
+
+// Count step pulses (rising edges) using the last DIR level.
+static void onPinWrite(uint8_t pin, uint8_t value) {
+    if (pin == MANDREL_MOTOR_PARAMS.dir_pin) {
+        s_mandrel.dirLevel = value;
+    } else if (pin == MANDREL_MOTOR_PARAMS.step_pin) {
+        if (value == HIGH && s_mandrel.stepLevel == LOW) onMandrelPulse();
+        s_mandrel.stepLevel = value;
+    }
+    for (SimAxis& axis : s_axes) {
+        if (pin == axis.dirPin) {
+            axis.dirLevel = value;
+        } else if (pin == axis.stepPin) {
+            if (value == HIGH && axis.stepLevel == LOW) onAxisPulse(axis);
+            axis.stepLevel = value;
+        }
+    }
+}
+
+// A limit switch is active LOW while its axis is at or past it; the E-stop
+// (normally closed) is released.
+static int onPinRead(uint8_t pin) {
+    for (const SimAxis& axis : s_axes) {
+        if (pin == axis.limitPin) return (axis.load <= axis.switchStep) ? LOW : HIGH;
+    }
+    if (pin == MANDREL_ENCODER_A_PIN || pin == MANDREL_ENCODER_B_PIN) return encoderLine(pin);
+    return pin == E_STOP_PIN ? LOW : HIGH;
+}
+
+long Sim::carriagePhysicalSteps() {
+    return s_carriage.physical;
+}
+
+long Sim::carriageLoadSteps() {
+    return s_carriage.load;
+}
+
+long Sim::mandrelPhysicalSteps() {
+    return s_mandrel.physical;
+}
+
+long Sim::mandrelLostSteps() {
+    return s_mandrel.lost;
+}
+
+double Sim::carriageStepsPerMM() {
+    return CarriageAxis::stepsPerMM();
+}
+
+double Sim::mandrelStepsPerRev() {
+    return MandrelAxis::stepsPerRev();
+}
+
+bool Sim::run(const SimProfile& profile, const SimOptions& options,
+              std::vector<StepSample>* trace, SimResult& result) {
+    result = SimResult();
+
+    // Fresh steppers: their last-step times would otherwise carry over from
+    // a previous run in this process onto the reset clock.
+    hostResetClock();
+    mandrelStepper  = MandrelStepper();
+    carriageStepper = CarriageStepper();
+    toolarmStepper  = ToolarmStepper();
+    toolheadStepper = ToolheadStepper();
+    for (SimAxis& axis : s_axes) {
+        axis.physical  = 0;
+        axis.stepLevel = LOW;
+        axis.backlash  = 0;
+        axis.gap       = 0;
+        axis.load      = 0;
+    }
+    s_carriage.backlash = options.carriageBacklash;
+    s_carriage.gap      = options.carriageBacklash / 2;
+    s_toolhead.backlash = options.toolheadBacklash;
+    s_toolhead.gap      = options.toolheadBacklash / 2;
+    s_mandrel           = SimMandrel();
+    s_mandrel.slipEvery = options.mandrelSlipEvery;
+    s_mandrel.slipSteps = options.mandrelSlipSteps;
+    s_carriage.switchStep = -static_cast<long>(options.homeDistanceMM * carriageStepsPerMM());
+    s_axes[static_cast<uint8_t>(HomeAxis::TOOLARM)].switchStep =
+        -static_cast<long>(ToolarmAxis::toSteps(options.toolarmHomeMM));
+    s_axes[static_cast<uint8_t>(HomeAxis::TOOLHEAD)].switchStep =
+        -static_cast<long>(ToolheadAxis::toSteps(options.toolheadHomeDeg));
+    hostSetPinWriter(onPinWrite);
+    hostSetPinReader(onPinRead);
+
+    MemStat::init();
+    initSteppers();
+    // Drivers left present by an earlier run are probed again and found
+    // absent without a model.
+    Serial2.attach(options.drivers);
+    if (options.drivers || mandrelDriver.present() || toolarmDriver.present() || toolheadDriver.present()) {
+        initDrivers();
+    }
+    if (options.drivers) {
+        options.drivers->flush();
+        s_mandrel.driver = options.drivers->node(MANDREL_DRIVER_CONFIG.address);
+        for (SimAxis& axis : s_axes) axis.driver = options.drivers->node(axis.address);
+    } else {
+        for (SimAxis& axis : s_axes) axis.driver = nullptr;
+    }
+    Winding::init();
+    if (options.mandrelEncoder) MandrelEncoder::init();
+    else                        MandrelEncoder::end();
+    if (!applyProfile(profile, Winding::getProfile())) return false;
+    const WindProfile job     = Winding::getProfile();
+    int               repeats = options.repeatJobs;
+    if (options.calibrateBacklash) Winding::calibrateBacklash();
+    Winding::start();
+    if (options.mandrelSpeed > 0.0f) {
+        if (options.mandrelSpeed > mandrelStepper.maxSpeed()) mandrelStepper.setMaxSpeed(options.mandrelSpeed);
+        mandrelStepper.setSpeed(options.mandrelSpeed);
+    }
+
+    const uint64_t timeoutUs = static_cast<uint64_t>(options.timeoutS * 1e6);
+    long         lastMandrel  = mandrelStepper.currentPosition();
+    long         lastCarriage = carriageStepper.currentPosition();
+    WindingState lastState    = Winding::getState();
+    uint32_t     planWait     = 0;
+
+    using Clock = std::chrono::steady_clock;
+    // Back in IDLE the job has stopped (homing failed or an alarm); PAUSED
+    // it waits for an operator (a stall).
+    while (Winding::getState() != WindingState::COMPLETE && Winding::getState() != WindingState::IDLE &&
+           Winding::getState() != WindingState::PAUSED && hostMicros64() < timeoutUs) {
+        // Keep the queue topped up with further runs of the job.
+        if (repeats > 0 && Winding::enqueue(job)) repeats--;
+
+        const uint32_t          handed = Planner::handovers();
+        const Clock::time_point t0     = Clock::now();
+        Winding::update();
+        const double us = std::chrono::duration<double, std::micro>(Clock::now() - t0).count();
+        if (Planner::handovers() != handed && us > result.maxHandoverUs) result.maxHandoverUs = us;
+        MemStat::poll();
+        result.loops++;
+
+        // Stand-in for the planner task.
+        if (!Planner::pending()) {
+            planWait = 0;
+        } else if (options.plannerLatencyLoops != UINT32_MAX &&
+                   planWait++ >= options.plannerLatencyLoops) {
+            Planner::service();
+            planWait = 0;
+        }
+
+        long         m     = mandrelStepper.currentPosition();
+        long         c     = carriageStepper.currentPosition();
+        WindingState state = Winding::getState();
+        if (trace && (m != lastMandrel || c != lastCarriage || state != lastState)) {
+            int layer = Winding::getActiveLayerIndex();
+            trace->push_back({ hostMicros64(), m, c, state, layer,
+                               Winding::getProfile().layers[layer].getPassesCompleted(),
+                               Winding::getGearedStep(), s_mandrel.physical,
+                               toolarmStepper.currentPosition(), s_carriage.load,
+                               toolheadStepper.currentPosition(), s_toolhead.load });
+        }
+        lastMandrel  = m;
+        lastCarriage = c;
+        lastState    = state;
+
+        hostAdvanceMicros(options.loopUs);
+    }
+
+    result.completed  = (Winding::getState() == WindingState::COMPLETE);
+    result.durationUs = hostMicros64();
+    result.planMisses = Planner::misses();
+    result.handovers  = Planner::handovers();
+
+    hostSetPinWriter(nullptr);
+    hostSetPinReader(nullptr);
+    Serial2.attach(nullptr);
+    return true;
+}
+
+// ============================================================================
+//  Step-Trace I/O
+// ============================================================================
+
+bool Sim::writeTrace(const char* path, const std::vector<StepSample>& trace) {
+    FILE* f = fopen(path, "w");
+    if (!f) return false;
+
+    fprintf(f, "time_us,state,layer,pass,mandrel,carriage\n");
+    for (const StepSample& s : trace) {
+        fprintf(f, "%llu,%d,%d,%d,%ld,%ld\n", static_cast<unsigned long long>(s.timeUs),
+                static_cast<int>(s.state), s.layer, s.pass, s.mandrel, s.carriage);
+    }
+    return fclose(f) == 0;
+}
+
+bool Sim::readTrace(const char* path, std::vector<StepSample>& trace) {
+    FILE* f = fopen(path, "r");
+    if (!f) return false;
+
+    trace.clear();
+    char line[128];
+    while (fgets(line, sizeof(line), f)) {
+        unsigned long long t;
+        int  state, layer, pass;
+        long m, c;
+        if (sscanf(line, "%llu,%d,%d,%d,%ld,%ld", &t, &state, &layer, &pass, &m, &c) != 6) {
+            continue;   // Header or malformed line.
+        }
+        trace.push_back({ t, m, c, static_cast<WindingState>(state), layer, pass, c, m, 0, c, 0, 0 });
+    }
+    fclose(f);
+    return true;
+}
@@ -0,0 +1,171 @@
+/// @file sim.h
+/// @brief Virtual-time harness that runs the real winding state machine on
+///        the host.
+///
+/// The firmware sources (Winding, Layer, the stepper driver, ...) are compiled
+/// unchanged against the Arduino stand-in in this directory.  Sim::run()
+/// calls Winding::update() and MemStat::poll() once per simulated loop()
+/// pass, advances the virtual clock by a fixed loop period, models the
+/// carriage limit switch from the step pulses actually emitted on the
+/// carriage STEP/DIR pins (less any backlash the options give the drive)
+/// and the mandrel encoder from the mandrel's (less any pulses a simulated
+/// slip loses), and records a step trace whenever
+/// either axis moves or the state changes.  Given a TmcModel it puts the
+/// drivers on the UART, and the motors of the axes on it move only if their
+/// driver model does (a jammed motor loses its pulses).  It also stands in for the layer planner's
+/// worker task, running waiting requests after a configurable delay.
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "config.h"
+#include "tmc_model.h"
+#include "winding.h"
+
+// ============================================================================
+//  Profiles
+// ============================================================================
+
+/// @struct SimProfile
+/// @brief A winding job read from a profile file.
+///
+/// Profile files are plain text, one directive per line, '#' starts a comment:
+///
+///     diameter 50                    # mandrel OD (mm)
+///     layer 200 45 0 4 10            # length angle offset stepover dwell
+///     point 0 30                     # mandrel surface: position radius (mm)
+///     pattern 0                      # 0: lay passes band by band (default 1)
+///     flip 0                         # 0: flip the toolhead in the dwell only (default 1)
+///     lookahead 0                    # 0: retarget the toolarm every step (default 1)
+///
+/// Layers take the most recent diameter.  Optional point lines describe a
+/// tapered or domed mandrel (WindProfile::mandrelProfile).  Unlike
+/// WindProfile the host copy is not limited to MAX_LAYERS.
+struct SimProfile {
+    float              diameter = 0.0f;
+    std::vector<Layer> layers;
+    std::vector<float> pointX;   ///< Mandrel surface points (WindProfile::mandrelProfile).
+    std::vector<float> pointR;
+    bool               patternSequencing = true;   ///< WindProfile::patternSequencing.
+    bool               overlapToolheadFlip = true; ///< WindProfile::overlapToolheadFlip.
+    bool               toolarmLookAhead = true;    ///< WindProfile::toolarmLookAhead.
+};
+
+/// Parse a profile file.  On failure returns false and describes the problem
+/// in @p error.
+bool loadProfile(const char* path, SimProfile& out, std::string& error);
+
+/// Copy a host profile into the firmware WindProfile.
+/// @return false if it has more than MAX_LAYERS layers.
+bool applyProfile(const SimProfile& in, WindProfile& out);
+
+/// Fit the host profile's mandrel surface as Winding::prepareJob() does.
+/// @return the surface, or nullptr for a cylinder (no points).  The
+///         storage is static: valid until the next call.
+const SplineProfile* fitMandrel(const SimProfile& in);
+
+// ============================================================================
+//  Simulation
+// ============================================================================
+
+/// @struct SimOptions
+/// @brief Knobs for one simulated job.
+struct SimOptions {
+    uint32_t loopUs              = 20;      ///< Virtual duration of one loop() pass (µs).
+    float    homeDistanceMM      = 10.0f;   ///< Carriage start distance from the limit switch (mm).
+    float    toolarmHomeMM       = 5.0f;    ///< Toolarm start distance from its home switch (mm).
+    float    toolheadHomeDeg     = 30.0f;   ///< Toolhead start angle from its home switch (°).
+    double   timeoutS            = 86400.0; ///< Abort if the job runs longer than this (virtual s).
+    uint32_t plannerLatencyLoops = 0;       ///< Loop passes a layer-plan request waits before the
+                                            ///< stand-in worker runs it (UINT32_MAX: never, so
+                                            ///< every boundary plans in line).
+    int      repeatJobs          = 0;       ///< Further runs of the profile, queued behind it.
+    float    mandrelSpeed        = 0.0f;    ///< Mandrel winding speed (steps/s; 0: the firmware
+                                            ///< default, DEFAULT_MANDREL_SPEED).
+    bool     mandrelEncoder      = MANDREL_ENCODER_FITTED;  ///< Fit the mandrel encoder (encoder.h).
+    uint32_t mandrelSlipEvery    = 0;       ///< Mandrel pulses between slips (0: never slips).
+    uint32_t mandrelSlipSteps    = 32;      ///< Pulses a slip loses (32: four full steps at 1/8,
+                                            ///< one pole pitch).
+    long     carriageBacklash    = 0;       ///< Carriage drive dead band (steps); the limit
+                                            ///< switch sees the load behind it.
+    long     toolheadBacklash    = 0;       ///< The same for the toolhead.
+    bool     calibrateBacklash   = false;   ///< Measure the backlash while homing
+                                            ///< (Winding::calibrateBacklash()).
+    TmcModel* drivers            = nullptr; ///< Driver UART (a fresh model per run, drivers
+                                            ///< fitted) that initDrivers() configures;
+                                            ///< nullptr: the drivers are strapped.
+};
+
+/// @struct StepSample
+/// @brief One step-trace entry, recorded whenever either axis position or the
+///        winding state changes.
+struct StepSample {
+    uint64_t     timeUs;       ///< Virtual time (µs since job start).
+    long         mandrel;      ///< mandrelStepper.currentPosition().
+    long         carriage;     ///< carriageStepper.currentPosition().
+    WindingState state;        ///< State after the update that produced the move.
+    int          layer;        ///< Active layer index.
+    int          pass;         ///< Passes completed in the active layer.
+    long         target;       ///< Winding::getGearedStep() — the geared command
+                               ///< (not stored in trace files; readTrace() copies carriage).
+    long         physical;     ///< Mandrel steps actually turned — mandrel less the slips
+                               ///< (not stored in trace files; readTrace() copies mandrel).
+    long         toolarm;      ///< toolarmStepper.currentPosition() (not stored in trace
+                               ///< files; readTrace() sets 0).
+    long         carriageLoad; ///< Carriage load position — the pulses less the backlash
+                               ///< (not stored in trace files; readTrace() copies carriage).
+    long         toolhead;     ///< toolheadStepper.currentPosition() and the toolhead load
+    long         toolheadLoad; ///< position (not stored in trace files; readTrace() sets 0).
+};
+
+/// @struct SimResult
+/// @brief Outcome of Sim::run().
+struct SimResult {
+    bool     completed     = false; ///< Reached WindingState::COMPLETE.
+    uint64_t durationUs    = 0;     ///< Virtual job time.
+    uint64_t loops         = 0;     ///< Number of Winding::update() calls.
+    uint32_t planMisses    = 0;     ///< Planner::misses() at the end of the run.
+    uint32_t handovers     = 0;     ///< Planner::handovers() at the end of the run.
+    double   maxHandoverUs = 0.0;   ///< Longest Winding::update() call that handed over a
+                                    ///< layer plan (host wall time, µs).
+};
+
+/// @namespace Sim
+/// @brief Virtual-time job runner.
+namespace Sim {
+
+    /// Run a complete job through Winding::update(), until it completes,
+    /// stops (back in IDLE), pauses (a stall) or times out.
+    /// @param trace  Receives the step trace (may be nullptr).
+    /// @return false if the profile could not be loaded into the firmware.
+    bool run(const SimProfile& profile, const SimOptions& options,
+             std::vector<StepSample>* trace, SimResult& result);
+
+    /// Physical carriage position in steps, counted from the STEP/DIR pulses
+    /// since the start of the last run (0 = start position).
+    long carriagePhysicalSteps();
+
+    /// Carriage load position in steps: the physical position less the
+    /// drive's backlash (SimOptions::carriageBacklash).
+    long carriageLoadSteps();
+
+    /// Physical mandrel position in steps (pulses less those lost to slips)
+    /// and the pulses lost, since the start of the last run.
+    long mandrelPhysicalSteps();
+    long mandrelLostSteps();
+
+    /// Carriage microsteps per mm, as Winding::init() derives it.
+    double carriageStepsPerMM();
+
+    /// Mandrel microsteps per mandrel revolution, as Winding::init() derives it.
+    double mandrelStepsPerRev();
+
+    /// Write / read a step trace as CSV
+    /// (time_us,state,layer,pass,mandrel,carriage).
+    bool writeTrace(const char* path, const std::vector<StepSample>& trace);
+    bool readTrace(const char* path, std::vector<StepSample>& trace);
+
+}  // namespace Sim
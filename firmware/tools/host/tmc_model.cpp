@@ -0,0 +1,231 @@
+/// @file tmc_model.cpp
+/// @brief TMC2209 UART and register model for the host tools.
+
+#include "tmc_model.h"
+
+#include <math.h>
+
+static constexpr uint8_t GCONF      = 0x00;
+static constexpr uint8_t GSTAT      = 0x01;
+static constexpr uint8_t IFCNT      = 0x02;
+static constexpr uint8_t IOIN       = 0x06;
+static constexpr uint8_t IHOLD_IRUN = 0x10;
+static constexpr uint8_t TCOOLTHRS  = 0x14;
+static constexpr uint8_t SGTHRS     = 0x40;
+static constexpr uint8_t SG_RESULT  = 0x41;
+static constexpr uint8_t CHOPCONF   = 0x6C;
+
+static constexpr uint32_t MSTEP_REG_SELECT = 1UL << 7;
+static constexpr uint32_t VSENSE           = 1UL << 17;
+
+// ============================================================================
+//  Driver
+// ============================================================================
+
+TmcNodeModel::TmcNodeModel(uint8_t address) : address_(address) {}
+
+uint32_t TmcNodeModel::read(uint8_t reg) const {
+    switch (reg) {
+    case GCONF:    return gconf_;
+    case GSTAT:    return gstat_;
+    case IFCNT:    return writes_ & 0xFF;
+    case IOIN:     return 0x21UL << 24 | (address_ & 1) << 2 | (address_ >> 1) << 3;   // VERSION, MS1, MS2.
+    case CHOPCONF: return chopconf_;
+    case SG_RESULT: {
+        const double now = static_cast<double>(hostMicros64());
+        if (!stealthChop() || jammed() || lastPulseUs_ < 0.0) return 0;
+        const double interval = fmax(intervalUs_, now - lastPulseUs_);
+        const double tstep    = interval * 12.0 * microsteps() / 256.0;   // 12 MHz clocks per 1/256 step.
+        double       sg       = 510.0 * (1.0 - fmin(fmax(load_, 0.0f), 1.0f));
+        if (tcoolthrs_ && tstep > tcoolthrs_) sg *= tcoolthrs_ / tstep;
+        return static_cast<uint32_t>(sg);
+    }
+    default:       return 0;   // Write-only or not modelled.
+    }
+}
+
+void TmcNodeModel::write(uint8_t reg, uint32_t value, double startUs) {
+    const uint16_t before = microsteps();
+    switch (reg) {
+    case GCONF:      gconf_ = value & 0x3FF; break;
+    case GSTAT:      gstat_ &= ~value; break;
+    case IHOLD_IRUN: iholdIrun_ = value & 0x000F1F1F; break;
+    case CHOPCONF:   chopconf_ = value; break;
+    case TCOOLTHRS:  tcoolthrs_ = value & 0xFFFFF; break;
+    case SGTHRS:     sgthrs_ = static_cast<uint8_t>(value); break;
+    default:         break;
+    }
+    writes_++;
+    if (microsteps() != before) {
+        changes_++;
+        if (lastPulseUs_ >= startUs) raced_++;
+    }
+}
+
+bool TmcNodeModel::jammed() const {
+    return jamUs_ >= 0.0 && static_cast<double>(hostMicros64()) >= jamUs_;
+}
+
+bool TmcNodeModel::step(bool forward) {
+    const double now = static_cast<double>(hostMicros64());
+    intervalUs_  = lastPulseUs_ < 0.0 ? 0.0 : now - lastPulseUs_;
+    lastPulseUs_ = now;
+    pulses_++;
+    if (jammed()) {
+        stalled_++;
+        return false;
+    }
+    const long size = 256 / microsteps();
+    position256_ += forward ? size : -size;
+    return true;
+}
+
+uint16_t TmcNodeModel::microsteps() const {
+    if (gconf_ & MSTEP_REG_SELECT) {
+        const uint32_t mres = (chopconf_ >> 24) & 0xF;
+        return static_cast<uint16_t>(256 >> (mres > 8 ? 8 : mres));
+    }
+    // MS2, MS1 (address bits 1, 0): 8, 32, 64, 16.
+    static const uint16_t strapped[4] = { 8, 32, 64, 16 };
+    return strapped[address_ & 3];
+}
+
+// RMS current of scale @p cs: (CS + 1) / 32 · V_FS / (R + 20 mΩ) / √2.
+static float currentMA(uint32_t cs, bool vsense, float senseOhms) {
+    return 1000.0f * (cs + 1) / 32.0f * (vsense ? 0.180f : 0.325f) / (senseOhms + 0.02f) / sqrtf(2.0f);
+}
+
+float TmcNodeModel::runCurrentMA(float senseOhms) const {
+    return currentMA((iholdIrun_ >> 8) & 0x1F, chopconf_ & VSENSE, senseOhms);
+}
+
+float TmcNodeModel::holdCurrentMA(float senseOhms) const {
+    return currentMA(iholdIrun_ & 0x1F, chopconf_ & VSENSE, senseOhms);
+}
+
+// ============================================================================
+//  Line
+// ============================================================================
+
+static uint8_t reflect(uint8_t b) {
+    uint8_t r = 0;
+    for (int i = 0; i < 8; i++) r |= ((b >> i) & 1) << (7 - i);
+    return r;
+}
+
+uint8_t TmcModel::crc(const uint8_t* data, uint8_t length) {
+    uint8_t crc = 0;
+    for (uint8_t i = 0; i < length; i++) {
+        crc ^= reflect(data[i]);
+        for (int bit = 0; bit < 8; bit++) crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+    }
+    return crc;
+}
+
+void TmcModel::fit(uint8_t address) {
+    nodes_[address & 3]  = TmcNodeModel(address & 3);
+    fitted_[address & 3] = true;
+}
+
+TmcNodeModel* TmcModel::node(uint8_t address) {
+    arrive();
+    return address < 4 && fitted_[address] ? &nodes_[address] : nullptr;
+}
+
+void TmcModel::received(uint8_t b, double at) {
+    auto it = toHost_.end();
+    while (it != toHost_.begin() && (it - 1)->at > at) --it;
+    toHost_.insert(it, Byte{ b, at });
+}
+
+size_t TmcModel::write(const uint8_t* buf, size_t len) {
+    arrive();
+    double at = fmax(static_cast<double>(hostMicros64()), wireFree_);
+    for (size_t i = 0; i < len; i++) {
+        uint8_t b = buf[i];
+        if (corruptIn_ && --corruptIn_ == 0) b ^= 0x01;
+        at += byteUs_;
+        toNodes_.push_back(Byte{ b, at });
+        received(b, at);   // The echo.
+    }
+    wireFree_ = at;
+    return len;
+}
+
+void TmcModel::flush() {
+    const double now = static_cast<double>(hostMicros64());
+    if (wireFree_ > now) hostAdvanceMicros(static_cast<uint64_t>(ceil(wireFree_ - now)));
+    arrive();
+}
+
+int TmcModel::available() {
+    arrive();
+    const double now = static_cast<double>(hostMicros64());
+    int n = 0;
+    for (const Byte& b : toHost_) {
+        if (b.at > now) break;
+        n++;
+    }
+    return n;
+}
+
+int TmcModel::read() {
+    if (!available()) return -1;
+    const uint8_t b = toHost_.front().value;
+    toHost_.pop_front();
+    return b;
+}
+
+void TmcModel::arrive() {
+    const double now = static_cast<double>(hostMicros64());
+    while (!toNodes_.empty() && toNodes_.front().at <= now) {
+        const Byte b = toNodes_.front();
+        toNodes_.pop_front();
+        parse(b.value, b.at);
+    }
+}
+
+void TmcModel::parse(uint8_t b, double at) {
+    if (at - lastByte_ > 63 * byteUs_ / 10.0 + byteUs_) length_ = 0;   // Idle: resynchronise.
+    lastByte_ = at;
+    if (length_ == 0) {
+        if ((b & 0x0F) != 0x05) return;
+        frameStart_ = at - byteUs_;
+    }
+    frame_[length_++] = b;
+    if (length_ < 3) return;
+
+    const bool    isWrite = frame_[2] & 0x80;
+    const uint8_t size    = isWrite ? 8 : 4;
+    if (length_ < size) return;
+    length_ = 0;
+
+    datagrams_++;
+    if (crc(frame_, size - 1) != frame_[size - 1]) {
+        crcErrors_++;
+        return;
+    }
+    if (frame_[1] >= 4 || !fitted_[frame_[1]]) return;
+    TmcNodeModel* n = &nodes_[frame_[1]];
+    const uint8_t reg = frame_[2] & 0x7F;
+    if (isWrite) {
+        const uint32_t value = static_cast<uint32_t>(frame_[3]) << 24 | static_cast<uint32_t>(frame_[4]) << 16 |
+                               static_cast<uint32_t>(frame_[5]) << 8 | frame_[6];
+        n->write(reg, value, frameStart_);
+    } else {
+        reply(*n, reg, at);
+    }
+}
+
+void TmcModel::reply(TmcNodeModel& node, uint8_t reg, double at) {
+    const uint32_t v = node.read(reg);
+    uint8_t d[8] = { 0x05, 0xFF, reg, static_cast<uint8_t>(v >> 24), static_cast<uint8_t>(v >> 16),
+                     static_cast<uint8_t>(v >> 8), static_cast<uint8_t>(v), 0 };
+    d[7] = crc(d, 7);
+    at = fmax(at, wireFree_) + 8 * byteUs_ / 10.0;   // SENDDELAY: 8 bit times.
+    for (uint8_t b : d) {
+        at += byteUs_;
+        received(b, at);
+    }
+    wireFree_ = at;
+}
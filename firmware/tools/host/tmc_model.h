@@ -0,0 +1,158 @@
+/// @file tmc_model.h
+/// @brief Register-level model of TMC2209 drivers on their single-wire UART.
+///
+/// TmcModel is the line: a Stream the firmware's TmcBus talks to once a
+/// tool attaches it to Serial2.  Bytes written go onto the wire one after
+/// another at the baud rate and reach the drivers in virtual time, so a
+/// write takes effect a frame after it was queued, as on the bench.  Every
+/// byte comes back as its echo (TX and RX share the wire), and a read is
+/// answered SENDDELAY (8 bit times) after its last byte.  The drivers parse
+/// datagrams as the datasheet describes: sync nibble, address, register,
+/// data, CRC8; a datagram with a bad CRC is dropped and not counted in
+/// IFCNT, and a pause of more than 63 bit times resynchronises the parser.
+/// The CRC is computed byte-wise on reflected bytes rather than with the
+/// datasheet's bit loop, so the two implementations check each other.
+///
+/// TmcNodeModel is one driver's registers — GCONF, GSTAT, IFCNT, IOIN,
+/// IHOLD_IRUN (write-only: it reads as 0), CHOPCONF — at their reset values,
+/// and its motor: a tool feeds it the axis's STEP pulses and it moves
+/// 256 / microsteps of a 1/256 step per pulse at the resolution in force
+/// (MRES once GCONF mstep_reg_select is set, else the MS1/MS2 straps, which
+/// are also the address).  A pulse while a datagram that changes the
+/// resolution is on the wire is counted as raced: which resolution it
+/// stepped at depends on the timing.
+///
+/// StallGuard: TCOOLTHRS and SGTHRS are held (write-only), and SG_RESULT
+/// reads 510 × (1 − load) for the load a tool sets (setLoad(), a fraction
+/// of what the current holds), scaled down by TSTEP / TCOOLTHRS below the
+/// TCOOLTHRS speed, where the back-EMF is too small to measure.  TSTEP is
+/// the last pulse interval, or the time since the last pulse if that is
+/// longer, so the reading falls away once the pulses stop.  A motor jammed
+/// (jam()) no longer moves at its pulses and reads 0, as does one in
+/// SpreadCycle.
+
+#pragma once
+
+#include <stdint.h>
+#include <deque>
+
+#include "Arduino.h"
+
+/// @class TmcNodeModel
+/// @brief One TMC2209: registers and motor position.
+class TmcNodeModel {
+public:
+    explicit TmcNodeModel(uint8_t address = 0);
+
+    /// Register value as a read returns it.
+    uint32_t read(uint8_t reg) const;
+
+    /// Apply a write whose datagram went onto the wire at @p startUs.
+    void write(uint8_t reg, uint32_t value, double startUs);
+
+    /// A STEP pulse now, towards positive positions if @p forward.
+    /// @return false if the motor is jammed and did not move.
+    bool step(bool forward);
+
+    /// Load on the motor as a fraction of what its current holds (0 … 1).
+    void setLoad(float load) { load_ = load; }
+
+    /// Jam the motor from virtual time @p atUs on (µs; < 0: free it).
+    void jam(double atUs) { jamUs_ = atUs; }
+    bool jammed() const;
+
+    /// Resolution in force (microsteps per full step).
+    uint16_t microsteps() const;
+
+    /// RMS run / hold current the scales give (mA; R_SENSE = @p senseOhms).
+    float runCurrentMA(float senseOhms) const;
+    float holdCurrentMA(float senseOhms) const;
+
+    bool stealthChop() const { return !(gconf_ & (1UL << 2)); }
+
+    uint8_t  address() const     { return address_; }
+    long     position256() const { return position256_; }   ///< Motor position (1/256 steps).
+    uint32_t pulses() const      { return pulses_; }
+    uint32_t raced() const       { return raced_; }          ///< Pulses during a resolution change.
+    uint32_t resolutionChanges() const { return changes_; }
+    uint32_t writes() const      { return writes_; }         ///< Datagrams accepted (IFCNT, unwrapped).
+    uint32_t stalledPulses() const { return stalled_; }      ///< Pulses lost to a jam.
+    uint32_t tcoolthrs() const   { return tcoolthrs_; }
+    uint8_t  sgthrs() const      { return sgthrs_; }
+
+private:
+    uint8_t  address_;
+    uint32_t gconf_      = 0x00000101;   ///< I_scale_analog, multistep_filt.
+    uint32_t gstat_      = 0x00000001;   ///< reset.
+    uint32_t iholdIrun_  = 0x00011F10;   ///< IHOLD 16, IRUN 31, IHOLDDELAY 1.
+    uint32_t chopconf_   = 0x10000053;
+    uint32_t tcoolthrs_  = 0;
+    uint8_t  sgthrs_     = 0;
+    float    load_       = 0.0f;
+    double   jamUs_      = -1.0;
+    uint32_t writes_     = 0;
+    long     position256_ = 0;
+    uint32_t pulses_     = 0;
+    uint32_t raced_      = 0;
+    uint32_t changes_    = 0;
+    uint32_t stalled_    = 0;
+    double   lastPulseUs_ = -1.0;
+    double   intervalUs_ = 0.0;   ///< Between the last two pulses.
+};
+
+/// @class TmcModel
+/// @brief The UART line and the drivers on it.
+class TmcModel : public Stream {
+public:
+    explicit TmcModel(uint32_t baud) : Stream(nullptr), byteUs_(10.0e6 / baud) {}
+
+    /// Put a driver at @p address (0 … 3) on the line.
+    void fit(uint8_t address);
+
+    /// The driver at @p address, or nullptr; up to date with what has
+    /// arrived on the wire by now.
+    TmcNodeModel* node(uint8_t address);
+
+    /// Flip bit 0 of the @p n-th byte written from now on (1: the next).
+    void corrupt(uint32_t n) { corruptIn_ = n; }
+
+    uint32_t datagrams() const { return datagrams_; }   ///< Complete datagrams seen.
+    uint32_t crcErrors() const { return crcErrors_; }   ///< Of those, dropped for their CRC.
+
+    // Stream
+    int    available() override;
+    int    read() override;
+    size_t write(const uint8_t* buf, size_t len) override;
+    void   flush() override;   ///< Advances the clock until the wire is quiet.
+
+    using Stream::write;
+
+    /// CRC8 of @p length bytes, byte-wise on reflected bytes.
+    static uint8_t crc(const uint8_t* data, uint8_t length);
+
+private:
+    struct Byte {
+        uint8_t value;
+        double  at;   ///< Virtual time its stop bit ends (µs).
+    };
+
+    // Parse the bytes that have arrived by now.
+    void arrive();
+    void parse(uint8_t b, double at);
+    void reply(TmcNodeModel& node, uint8_t reg, double at);
+    void received(uint8_t b, double at);
+
+    double                   byteUs_;
+    double                   wireFree_ = 0.0;   ///< The line is busy until here.
+    std::deque<Byte>         toNodes_;          ///< On their way to the drivers…
+    std::deque<Byte>         toHost_;           ///< …and back (echo, replies), by time.
+    TmcNodeModel             nodes_[4];
+    bool                     fitted_[4] = {};
+    uint8_t                  frame_[8]  = {};   ///< Datagram being parsed.
+    uint8_t                  length_    = 0;
+    double                   frameStart_ = 0.0;
+    double                   lastByte_  = -1e9;
+    uint32_t                 corruptIn_ = 0;
+    uint32_t                 datagrams_ = 0;
+    uint32_t                 crcErrors_ = 0;
+};
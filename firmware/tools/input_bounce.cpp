@@ -0,0 +1,292 @@
+/// @file input_bounce.cpp
+/// @brief Bouncing edges injected into the debounced inputs (inputs.h).
+///
+///     input_bounce [--trials N] [--seed N]
+///
+/// Drives the limit-switch and E-stop lines through the host stand-in's pin
+/// reader; the edge interrupts and the debounce timer run from virtual time
+/// as on the ESP32.  Fixed cases first, then N random contact bounces
+/// (default 1000): 1 … 11 edges spread over less than the debounce window,
+/// at a random phase to the timer, closing or opening.  The tool prints the
+/// events per case and the latch latency range.
+///
+/// Checks, each failing the tool (exit code 1):
+///
+///   - bounce shorter than INPUT_DEBOUNCE_US gives exactly one event, in
+///     the final state, stamped with the first edge;
+///   - it latches no sooner than INPUT_DEBOUNCE_US and no later than
+///     INPUT_DEBOUNCE_US + INPUT_SCAN_US after the first edge, and active()
+///     only changes then;
+///   - a glitch shorter than the window gives no event;
+///   - chatter longer than the window ends in the final state with the
+///     events alternating;
+///   - the E-stop runs its action (every driver disabled) at its first edge,
+///     once, and its latch only clears once it is released.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "config.h"
+#include "inputs.h"
+#include "motor_control.h"
+
+// ============================================================================
+//  Simulated Lines and Drivers
+// ============================================================================
+
+static uint8_t s_level[64];   // Line level per pin.
+
+static int onPinRead(uint8_t pin) {
+    return pin < 64 ? s_level[pin] : HIGH;
+}
+
+// Enable pins: level and time of the last write.
+static const uint8_t ENABLE_PINS[] = {
+    MANDREL_MOTOR_PARAMS.enable_pin, CARRIAGE_MOTOR_PARAMS.enable_pin,
+    TOOLARM_MOTOR_PARAMS.enable_pin, TOOLHEAD_MOTOR_PARAMS.enable_pin,
+};
+constexpr int ENABLE_COUNT = sizeof(ENABLE_PINS) / sizeof(ENABLE_PINS[0]);
+static uint8_t  s_enableLevel[ENABLE_COUNT];
+static uint64_t s_enableAtUs[ENABLE_COUNT];
+
+static void onPinWrite(uint8_t pin, uint8_t value) {
+    for (int i = 0; i < ENABLE_COUNT; i++) {
+        if (pin != ENABLE_PINS[i]) continue;
+        s_enableLevel[i] = value;
+        s_enableAtUs[i]  = hostMicros64();
+    }
+}
+
+static int      s_actions  = 0;
+static uint64_t s_actionUs = 0;
+
+static void onEStop() {
+    s_actions++;
+    s_actionUs = hostMicros64();
+    disableSteppers();
+}
+
+// Lines idle: switches open (HIGH), E-stop released (closed to GND, LOW).
+static void reset() {
+    memset(s_level, HIGH, sizeof(s_level));
+    s_level[E_STOP_PIN] = LOW;
+    s_actions = 0;
+    hostResetClock();
+    Inputs::setEStopAction(onEStop);
+    Inputs::init();
+    enableSteppers();
+}
+
+// ============================================================================
+//  Edge Playback
+// ============================================================================
+
+/// A line change @p atUs after the start of a sequence.
+struct Edge {
+    uint32_t atUs;
+    uint8_t  level;
+};
+
+/// What a sequence produced.
+struct Outcome {
+    std::vector<InputEvent> events;
+    uint64_t firstEdgeUs = 0;
+    bool     earlyChange = false;   // active() changed before the window ended.
+};
+
+// Play @p edges on @p pin from the current time, then run @p settleUs more,
+// polling events every @p loopUs like the loop would.
+static Outcome play(Input input, uint8_t pin, const std::vector<Edge>& edges,
+                    uint32_t settleUs = 3 * INPUT_DEBOUNCE_US, uint32_t loopUs = 50) {
+    Outcome        out;
+    const uint64_t t0     = hostMicros64();
+    const bool     before = Inputs::active(input);
+    out.firstEdgeUs       = t0 + (edges.empty() ? 0 : edges.front().atUs);
+
+    const uint64_t end = t0 + (edges.empty() ? 0 : edges.back().atUs) + settleUs;
+    size_t         next = 0;
+    while (hostMicros64() < end) {
+        while (next < edges.size() && t0 + edges[next].atUs <= hostMicros64()) {
+            s_level[pin] = edges[next++].level;
+        }
+        InputEvent e;
+        while (Inputs::poll(e)) out.events.push_back(e);
+        if (out.events.empty() && Inputs::active(input) != before &&
+            hostMicros64() < out.firstEdgeUs + INPUT_DEBOUNCE_US) {
+            out.earlyChange = true;
+        }
+
+        uint64_t step = end - hostMicros64();
+        if (step > loopUs) step = loopUs;
+        if (next < edges.size() && t0 + edges[next].atUs - hostMicros64() < step) {
+            step = t0 + edges[next].atUs - hostMicros64();
+        }
+        hostAdvanceMicros(step);
+    }
+    InputEvent e;
+    while (Inputs::poll(e)) out.events.push_back(e);
+    return out;
+}
+
+// A bounce: @p count edges over @p spanUs ending on @p level.
+static std::vector<Edge> bounce(uint8_t level, int count, uint32_t spanUs, std::mt19937& rng) {
+    std::vector<uint32_t> at(count);
+    at[0] = 0;
+    for (int i = 1; i < count; i++) at[i] = std::uniform_int_distribution<uint32_t>(1, spanUs)(rng);
+    std::sort(at.begin() + 1, at.end());
+    std::vector<Edge> edges;
+    for (int i = 0; i < count; i++) {
+        // Alternate so that the last edge lands on @p level.
+        const bool onLevel = ((count - 1 - i) % 2) == 0;
+        edges.push_back({ at[i], static_cast<uint8_t>(onLevel ? level : !level) });
+    }
+    return edges;
+}
+
+// ============================================================================
+//  Checks
+// ============================================================================
+
+static bool s_ok = true;
+
+static void check(bool pass, const char* name, const char* detail = "") {
+    printf("%s  %-44s %s\n", pass ? "ok  " : "FAIL", name, detail);
+    if (!pass) s_ok = false;
+}
+
+// One clean event in the wanted state, stamped with the first edge, latched
+// within the bound.
+static bool clean(const Outcome& o, Input input, bool active) {
+    if (o.events.size() != 1 || o.earlyChange) return false;
+    const InputEvent& e       = o.events[0];
+    const uint32_t    latency = e.latchUs - e.edgeUs;
+    return e.input == input && e.active == active && Inputs::active(input) == active &&
+           e.edgeUs == static_cast<uint32_t>(o.firstEdgeUs) &&
+           latency >= INPUT_DEBOUNCE_US && latency <= INPUT_DEBOUNCE_US + INPUT_SCAN_US;
+}
+
+static void usage() {
+    fprintf(stderr, "usage: input_bounce [--trials N] [--seed N]\n");
+}
+
+int main(int argc, char** argv) {
+    int      trials = 1000;
+    unsigned seed   = 1;
+    for (int a = 1; a < argc; a++) {
+        bool hasValue = a + 1 < argc;
+        if      (!strcmp(argv[a], "--trials") && hasValue) trials = atoi(argv[++a]);
+        else if (!strcmp(argv[a], "--seed") && hasValue)   seed   = atoi(argv[++a]);
+        else {
+            usage();
+            return 2;
+        }
+    }
+
+    hostSetPinReader(onPinRead);
+    hostSetPinWriter(onPinWrite);
+    std::mt19937 rng(seed);
+    char         detail[96];
+
+    printf("debounce window %u µs, timer %u µs: limit latency bound %u µs\n\n",
+           INPUT_DEBOUNCE_US, INPUT_SCAN_US, INPUT_DEBOUNCE_US + INPUT_SCAN_US);
+
+    // ── Fixed cases on the carriage limit ───────────────────────────────────
+    const Input   limit = Input::CARRIAGE_LIMIT;
+    const uint8_t pin   = CARRIAGE_LIMIT_PIN;
+    reset();
+
+    const Outcome closing = play(limit, pin, { { 0, LOW }, { 40, HIGH }, { 90, LOW }, { 300, HIGH },
+                                             { 320, LOW }, { 1500, HIGH }, { 1520, LOW } });
+    snprintf(detail, sizeof(detail), "%zu event(s), latched after %u µs", closing.events.size(),
+             closing.events.empty() ? 0 : closing.events[0].latchUs - closing.events[0].edgeUs);
+    check(clean(closing, limit, true), "7-edge bounce closing", detail);
+
+    const Outcome opening = play(limit, pin, { { 0, HIGH }, { 15, LOW }, { 60, HIGH }, { 1900, LOW },
+                                            { 1950, HIGH } });
+    snprintf(detail, sizeof(detail), "%zu event(s)", opening.events.size());
+    check(clean(opening, limit, false), "5-edge bounce opening within the window", detail);
+
+    const Outcome glitch = play(limit, pin, { { 0, LOW }, { 300, HIGH } });
+    snprintf(detail, sizeof(detail), "%zu event(s)", glitch.events.size());
+    check(glitch.events.empty() && !Inputs::active(limit), "glitch shorter than the window", detail);
+
+    std::vector<Edge> chatter;
+    for (uint32_t t = 0; t <= 5000; t += 170) chatter.push_back({ t, static_cast<uint8_t>((t / 170) % 2 ? HIGH : LOW) });
+    chatter.push_back({ 5100, LOW });
+    const Outcome longBounce = play(limit, pin, chatter);
+    bool alternating = !longBounce.events.empty();
+    for (size_t i = 0; i < longBounce.events.size(); i++) {
+        if (longBounce.events[i].active != (i % 2 == 0)) alternating = false;
+    }
+    snprintf(detail, sizeof(detail), "%zu alternating event(s), ends %s", longBounce.events.size(),
+             Inputs::active(limit) ? "closed" : "open");
+    check(alternating && Inputs::active(limit) && longBounce.events.back().active,
+          "5.1 ms chatter", detail);
+
+    // ── Random bounces on every limit switch ─────────────────────────────────
+    const uint8_t pins[] = { CARRIAGE_LIMIT_PIN, TOOLARM_LIMIT_PIN, TOOLHEAD_LIMIT_PIN };
+    int      bad = 0;
+    uint32_t minLatency = UINT32_MAX, maxLatency = 0;
+    reset();
+    for (int t = 0; t < trials; t++) {
+        const uint8_t which = t % 3;
+        const Input   in    = static_cast<Input>(which);
+        const bool    close = !Inputs::active(in);
+        const int     count = 1 + 2 * std::uniform_int_distribution<int>(0, 5)(rng);   // Odd: ends changed.
+        const uint32_t span = std::uniform_int_distribution<uint32_t>(0, INPUT_DEBOUNCE_US - 1)(rng);
+
+        hostAdvanceMicros(std::uniform_int_distribution<uint32_t>(0, 2 * INPUT_SCAN_US)(rng));
+        const Outcome o = play(in, pins[which], bounce(close ? LOW : HIGH, count, span, rng));
+        if (!clean(o, in, close)) {
+            if (bad++ < 5) {
+                printf("      trial %d: %s, %d edges over %u µs: %zu event(s)\n", t,
+                       close ? "closing" : "opening", count, span, o.events.size());
+            }
+            continue;
+        }
+        const uint32_t latency = o.events[0].latchUs - o.events[0].edgeUs;
+        if (latency < minLatency) minLatency = latency;
+        if (latency > maxLatency) maxLatency = latency;
+    }
+    snprintf(detail, sizeof(detail), "%d/%d clean, latency %u…%u µs", trials - bad, trials,
+             bad == trials ? 0 : minLatency, maxLatency);
+    check(bad == 0, "random bounces", detail);
+    if (Inputs::overflows()) check(false, "event ring overflowed");
+
+    // ── E-stop ───────────────────────────────────────────────────────────────
+    reset();
+    const Outcome press = play(Input::E_STOP, E_STOP_PIN,
+                               { { 0, HIGH }, { 30, LOW }, { 80, HIGH }, { 700, LOW }, { 720, HIGH } });
+    bool disabled = true;
+    for (int i = 0; i < ENABLE_COUNT; i++) {
+        disabled = disabled && s_enableLevel[i] == HIGH && s_enableAtUs[i] == press.firstEdgeUs;
+    }
+    snprintf(detail, sizeof(detail), "%d action(s), drivers off %+lld µs from the edge", s_actions,
+             static_cast<long long>(s_actionUs - press.firstEdgeUs));
+    check(s_actions == 1 && disabled && Inputs::eStopLatched(), "E-stop press cuts the drivers", detail);
+    check(clean(press, Input::E_STOP, true), "E-stop press debounced to one event");
+
+    check(!Inputs::clearEStop() && Inputs::eStopLatched(), "latch held while pressed");
+    const Outcome release = play(Input::E_STOP, E_STOP_PIN, { { 0, LOW }, { 50, HIGH }, { 120, LOW } });
+    check(clean(release, Input::E_STOP, false) && s_actions == 1 && Inputs::clearEStop() &&
+          !Inputs::eStopLatched(), "release clears the latch");
+
+    // Pressed at start-up: latched, and the drivers cut at once.
+    enableSteppers();
+    s_level[E_STOP_PIN] = HIGH;
+    s_actions = 0;
+    Inputs::init();
+    disabled = true;
+    for (int i = 0; i < ENABLE_COUNT; i++) disabled = disabled && s_enableLevel[i] == HIGH;
+    check(s_actions == 1 && disabled && Inputs::eStopLatched() && !Inputs::clearEStop(),
+          "pressed at start-up");
+
+    hostSetPinReader(nullptr);
+    hostSetPinWriter(nullptr);
+    return s_ok ? 0 : 1;
+}
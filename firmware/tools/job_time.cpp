@@ -0,0 +1,138 @@
+/// @file job_time.cpp
+/// @brief Print the job-time estimate for a profile and validate it against
+///        the virtual-time simulation.
+///
+///     job_time <profile> [--home-mm N] [--loop-us N] [--validate]
+///
+/// Uses the same Estimate code the firmware runs at job start.  With
+/// --validate the job is also simulated through Winding::update() and the
+/// tool exits 1 if the total estimate is off by more than 2 %.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "axis.h"
+#include "estimate.h"
+#include "pattern.h"
+#include "sim.h"
+
+/// Maximum allowed relative error of the total estimate.
+constexpr double MAX_ERROR = 0.02;
+
+static void usage() {
+    fprintf(stderr, "usage: job_time <profile> [--home-mm N] [--loop-us N] [--validate]\n");
+}
+
+static void printDuration(double s) {
+    int h = static_cast<int>(s / 3600.0);
+    int m = static_cast<int>(fmod(s, 3600.0) / 60.0);
+    printf("%d:%02d:%04.1f", h, m, fmod(s, 60.0));
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        usage();
+        return 2;
+    }
+
+    SimOptions options;
+    bool       validate = false;
+    for (int a = 2; a < argc; a++) {
+        bool hasValue = a + 1 < argc;
+        if      (!strcmp(argv[a], "--home-mm") && hasValue) options.homeDistanceMM = atof(argv[++a]);
+        else if (!strcmp(argv[a], "--loop-us") && hasValue) options.loopUs = atoi(argv[++a]);
+        else if (!strcmp(argv[a], "--validate"))            validate = true;
+        else {
+            usage();
+            return 2;
+        }
+    }
+
+    SimProfile  profile;
+    std::string error;
+    if (!loadProfile(argv[1], profile, error)) {
+        fprintf(stderr, "job_time: %s\n", error.c_str());
+        return 2;
+    }
+
+    // Estimate layer by layer so profiles beyond MAX_LAYERS work too.
+    EstimateParams params = Estimate::defaultParams(
+        lround(options.homeDistanceMM * Sim::carriageStepsPerMM()),
+        lround(ToolarmAxis::toSteps(options.toolarmHomeMM)),
+        lround(ToolheadAxis::toSteps(options.toolheadHomeDeg)));
+    params.loopUs           = validate ? options.loopUs : 0;
+    params.overlapFlip      = profile.overlapToolheadFlip;
+    params.toolarmLookAhead = profile.toolarmLookAhead;
+
+    const SplineProfile* mandrel = fitMandrel(profile);
+    const double zeroing = Estimate::zeroing(params) + Estimate::positioning(profile.layers[0], params, mandrel);
+    std::vector<LayerEstimate> est;
+    double total = zeroing;
+    float  pos   = 0.0f;
+    for (size_t i = 0; i < profile.layers.size(); i++) {
+        // Plan the winding pattern as Winding::start() does.
+        Layer layer = profile.layers[i];
+        if (profile.patternSequencing) Pattern::apply(layer, params);
+        est.push_back(Estimate::layer(layer, params, pos,
+                                      i + 1 < profile.layers.size() ? &profile.layers[i + 1] : nullptr, mandrel));
+        pos    = est.back().endMM;
+        total += est.back().totalSeconds;
+    }
+
+    // Simulated per-layer times, from the first WINDING sample of each layer.
+    std::vector<double> actual;
+    double actualZeroing = 0.0, actualTotal = 0.0;
+    if (validate) {
+        Serial.setSink(nullptr);
+        std::vector<StepSample> trace;
+        SimResult result;
+        if (!Sim::run(profile, options, &trace, result) || !result.completed) {
+            fprintf(stderr, "job_time: simulation failed (more than %d layers?)\n", MAX_LAYERS);
+            return 1;
+        }
+        std::vector<double> starts(profile.layers.size() + 1, result.durationUs / 1e6);
+        for (const StepSample& s : trace) {
+            if (s.state == WindingState::WINDING && s.timeUs / 1e6 < starts[s.layer]) {
+                starts[s.layer] = s.timeUs / 1e6;
+            }
+        }
+        actualZeroing = starts[0];
+        for (size_t i = 0; i < profile.layers.size(); i++) {
+            actual.push_back(starts[i + 1] - starts[i]);
+        }
+        actualTotal = result.durationUs / 1e6;
+    }
+
+    printf("layer passes   wind_s  dwell_s   flip_s  total_s");
+    if (validate) printf("   sim_s   error");
+    printf("\n");
+    printf("zero            -        -        -  %7.1f", zeroing);
+    if (validate) printf(" %7.1f  %+5.1f%%", actualZeroing,
+                         actualZeroing > 0 ? 100.0 * (zeroing - actualZeroing) / actualZeroing : 0.0);
+    printf("\n");
+    for (size_t i = 0; i < est.size(); i++) {
+        const LayerEstimate& e = est[i];
+        printf("%5zu %6d  %7.1f  %7.1f  %7.1f  %7.1f", i, e.passes, e.windSeconds, e.dwellSeconds,
+               e.flipSeconds, e.totalSeconds);
+        if (validate) printf(" %7.1f  %+5.1f%%", actual[i],
+                             100.0 * (e.totalSeconds - actual[i]) / actual[i]);
+        printf("\n");
+    }
+
+    printf("estimated job time ");
+    printDuration(total);
+    printf(" (%.1f s)\n", total);
+
+    if (validate) {
+        double err = (total - actualTotal) / actualTotal;
+        printf("simulated job time ");
+        printDuration(actualTotal);
+        printf(" (%.1f s), error %+.2f%% — %s\n", actualTotal, 100.0 * err,
+               fabs(err) <= MAX_ERROR ? "ok" : "FAIL");
+        return fabs(err) <= MAX_ERROR ? 0 : 1;
+    }
+    return 0;
+}
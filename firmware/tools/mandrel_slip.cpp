@@ -0,0 +1,197 @@
+/// @file mandrel_slip.cpp
+/// @brief Check that the mandrel encoder keeps the layup in phase when the
+///        mandrel loses steps, and stops a stalling mandrel.
+///
+///     mandrel_slip <profile> [--slip-every N] [--slip-steps N] [--loop-us N]
+///
+/// Winds the profile four times in the simulator:
+///
+///   reference   no slips, no encoder
+///   open loop   the mandrel loses --slip-steps pulses (default 32, one pole
+///               pitch) every --slip-every pulses (default 10000), no encoder
+///   encoder     the same slips, gearing on the encoder
+///   stall       the encoder, losing the slip every 64 pulses
+///
+/// and compares every pass with the reference's by the physical mandrel
+/// angle: where the pass starts (phase — counted from the end of the
+/// layer's first pass, which the firmware phases the layer's pattern from)
+/// and how far the mandrel turns while the carriage crosses (rotation —
+/// the helix angle).  The tool prints both runs' worst errors and fails
+/// (exit code 1) if
+///
+///   - the open-loop run shows no error (the slips did not bite),
+///   - the encoder run does not complete, or is off the reference by more
+///     than one slip (plus two encoder counts) in either measure.  Open
+///     loop every slip adds to the phase error for the rest of the layer;
+///     with the encoder a slip costs at most the pass it happens in and
+///     the next start — when the carriage cannot catch up with the gear
+///     before the pass ends (it lags the gear at its speed limit on steep
+///     passes, or the slip comes just before the end) — until a turnaround
+///     lands the circuit on its slot again, or
+///   - the stall run completes, or does not stop within one slip of losing
+///     MANDREL_FOLLOWING_LIMIT_DEG.
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "sim.h"
+#include "axis.h"
+#include "config.h"
+
+static void usage() {
+    fprintf(stderr, "usage: mandrel_slip <profile> [--slip-every N] [--slip-steps N] [--loop-us N]\n");
+}
+
+// Physical mandrel position where each pass starts and ends.
+struct Pass {
+    int  layer;
+    long start;
+    long end;
+};
+
+static std::vector<Pass> passesOf(const std::vector<StepSample>& trace) {
+    std::vector<Pass> passes;
+    WindingState      last = WindingState::IDLE;
+    for (const StepSample& s : trace) {
+        if (s.state == WindingState::WINDING && last != WindingState::WINDING) {
+            passes.push_back({ s.layer, s.physical, s.physical });
+        } else if (s.state != WindingState::WINDING && last == WindingState::WINDING) {
+            passes.back().end = s.physical;
+        }
+        last = s.state;
+    }
+    return passes;
+}
+
+// Worst pass-start phase and pass-rotation differences from the reference
+// (mandrel steps).
+struct Errors {
+    long phase    = 0;
+    long rotation = 0;
+};
+
+static Errors compare(const std::vector<Pass>& run, const std::vector<Pass>& ref) {
+    const long stepsPerRev = static_cast<long>(MandrelAxis::stepsPerRev());
+    Errors     e;
+    size_t     first = 0;   // The layer's first pass.
+    for (size_t i = 0; i < run.size() && i < ref.size(); i++) {
+        if (i == 0 || ref[i].layer != ref[i - 1].layer) first = i;
+        long phase = i == first ? 0 : ((run[i].start - run[first].end) - (ref[i].start - ref[first].end)) % stepsPerRev;
+        if (phase > stepsPerRev / 2)  phase -= stepsPerRev;
+        if (phase < -stepsPerRev / 2) phase += stepsPerRev;
+        const long rotation = (run[i].end - run[i].start) - (ref[i].end - ref[i].start);
+        e.phase    = labs(phase) > labs(e.phase) ? phase : e.phase;
+        e.rotation = labs(rotation) > labs(e.rotation) ? rotation : e.rotation;
+    }
+    return e;
+}
+
+static void printRun(const char* name, const SimResult& r, long lost, const Errors& e) {
+    printf("%-10s  %-9s  %8.1f s  %5ld  %+9.2f  %+12.2f\n", name,
+           r.completed ? "complete" : "stopped", r.durationUs / 1e6, lost,
+           MandrelAxis::toDegrees(e.phase), MandrelAxis::toDegrees(e.rotation));
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        usage();
+        return 2;
+    }
+
+    SimOptions slipping;
+    slipping.mandrelSlipEvery = 10000;
+    for (int a = 2; a < argc; a++) {
+        bool hasValue = a + 1 < argc;
+        if (!strcmp(argv[a], "--slip-every") && hasValue) {
+            slipping.mandrelSlipEvery = strtoul(argv[++a], nullptr, 10);
+        } else if (!strcmp(argv[a], "--slip-steps") && hasValue) {
+            slipping.mandrelSlipSteps = strtoul(argv[++a], nullptr, 10);
+        } else if (!strcmp(argv[a], "--loop-us") && hasValue) {
+            slipping.loopUs = atoi(argv[++a]);
+        } else {
+            usage();
+            return 2;
+        }
+    }
+
+    SimProfile  profile;
+    std::string error;
+    if (!loadProfile(argv[1], profile, error)) {
+        fprintf(stderr, "mandrel_slip: %s\n", error.c_str());
+        return 2;
+    }
+
+    SimOptions reference = slipping;
+    reference.mandrelSlipEvery = 0;
+    reference.mandrelEncoder   = false;
+    SimOptions openLoop = slipping;
+    openLoop.mandrelEncoder = false;
+    SimOptions encoder = slipping;
+    encoder.mandrelEncoder = true;
+    SimOptions stall = encoder;
+    stall.mandrelSlipEvery = 64;
+
+    Serial.setSink(nullptr);
+    std::vector<StepSample> refTrace, openTrace, encTrace;
+    SimResult ref, open, enc, stalled;
+    if (!Sim::run(profile, reference, &refTrace, ref) || !ref.completed) {
+        fprintf(stderr, "mandrel_slip: simulation failed (more than %d layers?)\n", MAX_LAYERS);
+        return 1;
+    }
+    Sim::run(profile, openLoop, &openTrace, open);
+    const long openLost = Sim::mandrelLostSteps();
+    Sim::run(profile, encoder, &encTrace, enc);
+    const long encLost = Sim::mandrelLostSteps();
+    Sim::run(profile, stall, nullptr, stalled);
+    const long stallLost = Sim::mandrelLostSteps();
+
+    const std::vector<Pass> refPasses = passesOf(refTrace);
+    const Errors openErr = compare(passesOf(openTrace), refPasses);
+    const Errors encErr  = compare(passesOf(encTrace), refPasses);
+
+    printf("slip of %u steps every %u pulses, %zu passes\n", slipping.mandrelSlipSteps,
+           slipping.mandrelSlipEvery, refPasses.size());
+    printf("run         result       job_time   lost  phase_deg  rotation_deg\n");
+    printRun("reference", ref, 0, Errors());
+    printRun("open loop", open, openLost, openErr);
+    printRun("encoder", enc, encLost, encErr);
+    printRun("stall", stalled, stallLost, Errors());
+
+    int rc = 0;
+    if (openErr.phase == 0 && openErr.rotation == 0) {
+        printf("FAIL  open loop: %ld steps lost, but the passes match the reference\n", openLost);
+        rc = 1;
+    } else {
+        printf("ok    open loop: slips shift the layup by up to %.2f°\n",
+               MandrelAxis::toDegrees(labs(openErr.phase) > labs(openErr.rotation) ? openErr.phase
+                                                                                    : openErr.rotation));
+    }
+
+    // The measured angle is good to one count; allow one more for the
+    // reference's own rounding.
+    const long tolerance = static_cast<long>(2 * MandrelAxis::stepsPerRev() / MANDREL_ENCODER_COUNTS_PER_REV) + 1;
+    const long slip      = static_cast<long>(slipping.mandrelSlipSteps);
+    if (!enc.completed || labs(encErr.phase) > slip + tolerance || labs(encErr.rotation) > slip + tolerance) {
+        printf("FAIL  encoder: %s, phase %+ld / rotation %+ld steps off (tolerance %ld)\n",
+               enc.completed ? "completed" : "stopped", encErr.phase, encErr.rotation, slip + tolerance);
+        rc = 1;
+    } else {
+        printf("ok    encoder: %ld steps lost, no pass off by more than one slip (%ld steps)\n", encLost,
+               slip + tolerance);
+    }
+
+    const long limit = static_cast<long>(MandrelAxis::toSteps(MANDREL_FOLLOWING_LIMIT_DEG));
+    if (stalled.completed || stallLost <= limit || stallLost > limit + slip + tolerance) {
+        printf("FAIL  stall: %s after losing %ld steps (limit %ld)\n",
+               stalled.completed ? "completed" : "stopped", stallLost, limit);
+        rc = 1;
+    } else {
+        printf("ok    stall: stopped at %.1f s after losing %ld steps (limit %ld)\n",
+               stalled.durationUs / 1e6, stallLost, limit);
+    }
+    return rc;
+}
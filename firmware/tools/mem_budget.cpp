@@ -0,0 +1,174 @@
+/// @file mem_budget.cpp
+/// @brief Run jobs under the host allocation tracker and fail if a job's peak
+///        heap use exceeds its budget.
+///
+///     mem_budget <profile>... [--budget BYTES] [--loop-us N]
+///
+/// Each profile is loaded and wound through the simulation with the global
+/// operator new / delete counted (tools/host/alloc_tracker).  The figures are
+/// read back through MemStat — the same job and per-state peaks the firmware
+/// reports with "mem" — so the tool also exercises that surface.  Exit code 1
+/// if any job peaks above the budget (default MEMSTAT_JOB_HEAP_BUDGET).
+///
+/// Each profile's layer plans are also built on a thread with a painted
+/// stack: exit code 1 if the deepest build, times PLANNER_STACK_MARGIN,
+/// does not fit the planner task's stack (PLANNER_TASK_STACK).
+///
+/// Job storage is static (Winding::memoryBytes()), so a job is expected to
+/// peak at 0.  Before the jobs the tool checks that a known new[] and
+/// malloc() show up in MemStat's job peak, so a 0 is a measurement and not
+/// a blind tracker; it exits 2 if they do not.
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "alloc_tracker.h"
+#include "estimate.h"
+#include "memstat.h"
+#include "planner.h"
+#include "sim.h"
+#include "winding.h"
+
+static void usage() {
+    fprintf(stderr, "usage: mem_budget <profile>... [--budget BYTES] [--loop-us N]\n");
+}
+
+// Written so the probe allocations below cannot be elided.
+static void* volatile s_probe[2];
+
+// A new[] and a malloc() of PROBE_BYTES each, live across a sample, must
+// raise the job peak by both.
+static bool trackerSeesHeap() {
+    const size_t PROBE_BYTES = 4096;
+    MemStat::beginJob();
+    s_probe[0] = new char[PROBE_BYTES];
+    s_probe[1] = malloc(PROBE_BYTES);
+    MemStat::sample();
+    delete[] static_cast<char*>(s_probe[0]);
+    free(s_probe[1]);
+
+    const uint32_t seen = MemStat::jobPeakUsed();
+    const bool     ok   = seen >= 2 * PROBE_BYTES;
+    printf("tracker: new[] + malloc() of %zu bytes each peak at %u bytes — %s\n", PROBE_BYTES,
+           static_cast<unsigned>(seen), ok ? "ok" : "NOT SEEN");
+    return ok;
+}
+
+// ── Planner task stack ──────────────────────────────────────────────────
+// The worker body (Planner::service()) runs on a thread whose stack is
+// painted first; how far down the paint was overwritten, from the thread's
+// entry, is the depth it needs.  The job preparation the first request
+// carries (patterns and estimate) and every layer's plan are built.
+
+constexpr size_t  STACK_PROBE_BYTES = 256 * 1024;
+constexpr uint8_t STACK_PAINT       = 0xA5;
+
+static WindProfile    s_stackJob;
+static JobEstimate    s_stackEstimate;
+static uintptr_t      s_stackEntry = 0;   // Address of a local at the thread's entry.
+
+static void* serviceLayers(void*) {
+    volatile uint8_t entry = 0;
+    s_stackEntry = reinterpret_cast<uintptr_t>(&entry);
+    for (int layer = 0; layer < s_stackJob.layerCount; layer++) {
+        Planner::request(s_stackJob, layer, layer == 0 ? &s_stackEstimate : nullptr);
+        Planner::service();
+    }
+    return nullptr;
+}
+
+// Stack depth of the planner's work for @p profile (bytes), or 0 on failure.
+static size_t plannerStackBytes(const SimProfile& profile) {
+    if (!applyProfile(profile, s_stackJob)) return 0;
+    Planner::reset();
+
+    uint8_t* stack = static_cast<uint8_t*>(malloc(STACK_PROBE_BYTES));
+    memset(stack, STACK_PAINT, STACK_PROBE_BYTES);
+    pthread_attr_t attr;
+    pthread_t      thread;
+    pthread_attr_init(&attr);
+    pthread_attr_setstack(&attr, stack, STACK_PROBE_BYTES);
+    const bool ran = pthread_create(&thread, &attr, serviceLayers, nullptr) == 0 &&
+                     pthread_join(thread, nullptr) == 0;
+    pthread_attr_destroy(&attr);
+
+    size_t lowest = 0;
+    while (lowest < STACK_PROBE_BYTES && stack[lowest] == STACK_PAINT) lowest++;
+    const size_t used = ran ? s_stackEntry - reinterpret_cast<uintptr_t>(stack + lowest) : 0;
+    free(stack);
+    Planner::reset();
+    return used;
+}
+
+static const char* const STATE_NAMES[MEMSTAT_STATE_COUNT] = {
+    "IDLE", "PAUSED", "ZEROING", "WINDING", "DWELLING", "COMPLETE"
+};
+
+int main(int argc, char** argv) {
+    SimOptions               options;
+    uint32_t                 budget = MEMSTAT_JOB_HEAP_BUDGET;
+    std::vector<const char*> paths;
+    for (int a = 1; a < argc; a++) {
+        bool hasValue = a + 1 < argc;
+        if      (!strcmp(argv[a], "--budget") && hasValue)  budget = strtoul(argv[++a], nullptr, 10);
+        else if (!strcmp(argv[a], "--loop-us") && hasValue) options.loopUs = atoi(argv[++a]);
+        else if (argv[a][0] == '-') {
+            usage();
+            return 2;
+        } else {
+            paths.push_back(argv[a]);
+        }
+    }
+    if (paths.empty()) {
+        usage();
+        return 2;
+    }
+
+    Serial.setSink(nullptr);
+    if (!trackerSeesHeap()) return 2;
+    int failures = 0;
+    for (const char* path : paths) {
+        SimProfile  profile;
+        std::string error;
+        if (!loadProfile(path, profile, error)) {
+            fprintf(stderr, "mem_budget: %s\n", error.c_str());
+            return 2;
+        }
+
+        // No step trace: the tool's own buffers must not count against the job.
+        SimResult result;
+        uint64_t  allocsBefore = AllocTracker::allocations();
+        if (!Sim::run(profile, options, nullptr, result) || !result.completed) {
+            fprintf(stderr, "mem_budget: %s: simulation failed\n", path);
+            return 2;
+        }
+        MemStat::sample();
+        uint64_t allocs = AllocTracker::allocations() - allocsBefore;
+
+        uint32_t used = MemStat::jobPeakUsed();
+        bool     ok   = used <= budget;
+        printf("%s: peak %u / budget %u bytes, %llu allocations — %s\n", path,
+               static_cast<unsigned>(used), static_cast<unsigned>(budget),
+               static_cast<unsigned long long>(allocs), ok ? "ok" : "OVER BUDGET");
+        for (uint8_t i = 0; i < MEMSTAT_STATE_COUNT; i++) {
+            const MemoryPeak& p = MemStat::statePeak(static_cast<WindingState>(i));
+            if (p.samples == 0) continue;
+            uint32_t stateUsed = MemStat::jobBaseline() > p.minHeapFree
+                                     ? MemStat::jobBaseline() - p.minHeapFree : 0;
+            printf("  %-9s %8u samples, peak %u bytes\n", STATE_NAMES[i],
+                   static_cast<unsigned>(p.samples), static_cast<unsigned>(stateUsed));
+        }
+        if (!ok) failures++;
+
+        const size_t stack   = plannerStackBytes(profile);
+        const bool   stackOk = stack > 0 && stack * PLANNER_STACK_MARGIN <= PLANNER_TASK_STACK;
+        printf("  planner stack %zu bytes x %u margin / task stack %u bytes — %s\n", stack,
+               static_cast<unsigned>(PLANNER_STACK_MARGIN), static_cast<unsigned>(PLANNER_TASK_STACK),
+               stackOk ? "ok" : "TOO SMALL");
+        if (!stackOk) failures++;
+    }
+    return failures ? 1 : 0;
+}
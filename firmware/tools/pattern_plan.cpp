@@ -0,0 +1,205 @@
+/// @file pattern_plan.cpp
+/// @brief Print the winding pattern planned for each layer and compare it with
+///        band-by-band sequencing.
+///
+///     pattern_plan <profile> [--loop-us N] [--simulate]
+///
+/// For every layer: circuits, chosen skip index, slot spacing, the extra
+/// rotation per circuit, dwell and total mandrel revolutions, and the
+/// predicted layer time — each next to the band-by-band figure.  With
+/// --simulate the job is wound through Winding::update() both ways; the tool
+/// prints the simulated layer times and checks that the patterned circuits
+/// started on every slot exactly once (exit code 1 if not).
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+#include "axis.h"
+#include "estimate.h"
+#include "pattern.h"
+#include "sim.h"
+
+/// Circuit starts may miss their slot by at most this fraction of a slot.
+constexpr double MAX_SLOT_ERROR = 0.25;
+
+static void usage() {
+    fprintf(stderr, "usage: pattern_plan <profile> [--loop-us N] [--simulate]\n");
+}
+
+/// Simulated figures for one layer.
+struct LayerRun {
+    double              seconds = 0.0;
+    std::vector<double> circuitStarts;   ///< Mandrel phase at each circuit start (revs, 0 … 1)
+                                         ///< from the layer's phase reference.
+};
+
+// Wind the profile and split the trace into layers.
+static bool simulate(const SimProfile& profile, const std::vector<Layer>& planned,
+                     const SimOptions& options, std::vector<LayerRun>& out) {
+    std::vector<StepSample> trace;
+    SimResult result;
+    if (!Sim::run(profile, options, &trace, result) || !result.completed) return false;
+
+    const double stepsPerRev = Sim::mandrelStepsPerRev();
+    const size_t n           = profile.layers.size();
+    std::vector<double> starts(n + 1, result.durationUs / 1e6);
+    std::vector<long>   startStep(n, 0);
+    out.assign(n, LayerRun());
+
+    for (size_t i = 0; i < trace.size(); i++) {
+        const StepSample& s = trace[i];
+        const Layer&      l = planned[s.layer];
+        if (s.state == WindingState::WINDING && s.timeUs / 1e6 < starts[s.layer]) {
+            starts[s.layer]    = s.timeUs / 1e6;
+            startStep[s.layer] = s.mandrel;
+        }
+        if (i == 0 || s.state == trace[i - 1].state) continue;
+
+        // Patterned layers are phased from the end of their first pass, as
+        // if it had run at the steady lag (see Winding::update()).
+        if (s.state == WindingState::DWELLING && s.pass == 0 && l.hasPattern()) {
+            startStep[s.layer] = s.mandrel - lround(
+                Estimate::passDegrees(l, Estimate::defaultParams()) / 360.0 * stepsPerRev);
+            out[s.layer].circuitStarts.push_back(0.0);
+        }
+        // A forward pass starting: record its phase in the layer.
+        if (s.state == WindingState::WINDING && s.pass % 2 == 0 &&
+            (s.pass > 0 || !l.hasPattern())) {
+            double revs = (s.mandrel - startStep[s.layer]) / stepsPerRev;
+            out[s.layer].circuitStarts.push_back(revs - floor(revs));
+        }
+    }
+    for (size_t i = 0; i < n; i++) out[i].seconds = starts[i + 1] - starts[i];
+    return true;
+}
+
+// Largest gap between neighbouring circuit starts around the mandrel (revs).
+static double largestGap(std::vector<double> phases) {
+    if (phases.size() < 2) return 1.0;
+    std::sort(phases.begin(), phases.end());
+    double gap = phases.front() + 1.0 - phases.back();
+    for (size_t i = 1; i < phases.size(); i++) gap = fmax(gap, phases[i] - phases[i - 1]);
+    return gap;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        usage();
+        return 2;
+    }
+
+    SimOptions options;
+    bool       runSim = false;
+    for (int a = 2; a < argc; a++) {
+        bool hasValue = a + 1 < argc;
+        if      (!strcmp(argv[a], "--loop-us") && hasValue) options.loopUs = atoi(argv[++a]);
+        else if (!strcmp(argv[a], "--simulate"))            runSim = true;
+        else {
+            usage();
+            return 2;
+        }
+    }
+
+    SimProfile  profile;
+    std::string error;
+    if (!loadProfile(argv[1], profile, error)) {
+        fprintf(stderr, "pattern_plan: %s\n", error.c_str());
+        return 2;
+    }
+
+    // Same parameters Winding::start() plans with.
+    EstimateParams params = Estimate::defaultParams(
+        lround(options.homeDistanceMM * Sim::carriageStepsPerMM()),
+        lround(ToolarmAxis::toSteps(options.toolarmHomeMM)),
+        lround(ToolheadAxis::toSteps(options.toolheadHomeDeg)));
+
+    printf("layer passes circ skip  slot_deg  pass_deg  extra_deg (band)  dwell_rev (band)"
+           "  mandrel_rev (band)  pred_s (band)\n");
+    std::vector<Layer> planned;
+    params.overlapFlip      = profile.overlapToolheadFlip;
+    params.toolarmLookAhead = profile.toolarmLookAhead;
+    const SplineProfile* mandrel = fitMandrel(profile);
+    double totalPattern = Estimate::zeroing(params) + Estimate::positioning(profile.layers[0], params, mandrel);
+    double totalBand    = totalPattern;
+    float  pos          = 0.0f;
+    for (size_t i = 0; i < profile.layers.size(); i++) {
+        Layer             layer = profile.layers[i];
+        const WindPattern p     = Pattern::apply(layer, params);
+        const LayerEstimate e   = Estimate::layer(layer, params, pos,
+                                                  i + 1 < profile.layers.size() ? &profile.layers[i + 1] : nullptr,
+                                                  mandrel);
+        pos = e.endMM;
+        totalPattern += e.totalSeconds;
+        totalBand    += e.sequentialSeconds;
+        planned.push_back(layer);
+
+        if (!p.valid) {
+            printf("%5zu %6d  (no pattern)\n", i, layer.getTotalPasses());
+            continue;
+        }
+        printf("%5zu %6d %4d %4d  %8.2f  %8.1f  %8.2f (%6.2f)  %8.2f (%6.2f)  %10.2f (%6.2f)  %6.1f (%6.1f)\n",
+               i, layer.getTotalPasses(), p.circuits, p.skip, p.slotDeg, p.passDeg,
+               p.extraDeg, 2.0f * layer.getStepoverDegrees(), p.dwellRevs, p.bandDwellRevs,
+               p.mandrelRevs, p.bandMandrelRevs, e.totalSeconds, e.sequentialSeconds);
+
+        printf("      slot order:");
+        for (int c = 0; c < p.circuits && c < 24; c++) printf(" %d", Pattern::slot(layer, c));
+        printf(p.circuits > 24 ? " ...\n" : "\n");
+    }
+    printf("predicted job time %.1f s, band by band %.1f s (%+.1f %%)\n", totalPattern, totalBand,
+           100.0 * (totalPattern - totalBand) / totalBand);
+
+    if (!runSim) return 0;
+
+    Serial.setSink(nullptr);
+    SimProfile band = profile;
+    band.patternSequencing = false;
+    std::vector<LayerRun> runPattern, runBand;
+    std::vector<Layer> unplanned = profile.layers;
+    if (!simulate(profile, planned, options, runPattern) ||
+        !simulate(band, unplanned, options, runBand)) {
+        fprintf(stderr, "pattern_plan: simulation failed (more than %d layers?)\n", MAX_LAYERS);
+        return 1;
+    }
+
+    int rc = 0;
+    printf("\nlayer   sim_s (band)   largest_gap_deg (band)  slot_err_deg  slots\n");
+    double simPattern = 0.0, simBand = 0.0;
+    for (size_t i = 0; i < planned.size(); i++) {
+        const Layer&    layer = planned[i];
+        const LayerRun& rp    = runPattern[i];
+        const LayerRun& rb    = runBand[i];
+        simPattern += rp.seconds;
+        simBand    += rb.seconds;
+
+        printf("%5zu  %6.1f (%6.1f)  %8.2f (%8.2f)", i, rp.seconds, rb.seconds,
+               360.0 * largestGap(rp.circuitStarts), 360.0 * largestGap(rb.circuitStarts));
+        if (!layer.hasPattern()) {
+            printf("\n");
+            continue;
+        }
+
+        // Each circuit must start near its slot, and the slots must all differ.
+        const int         s = layer.getPatternCircuits();
+        std::vector<bool> seen(s, false);
+        double            worst = 0.0;
+        bool              ok    = static_cast<int>(rp.circuitStarts.size()) == s;
+        for (size_t c = 0; ok && c < rp.circuitStarts.size(); c++) {
+            const int slot = Pattern::slot(layer, static_cast<int>(c));
+            double    d    = rp.circuitStarts[c] - static_cast<double>(slot) / s;
+            d -= floor(d + 0.5);
+            worst = fmax(worst, fabs(d));
+            if (seen[slot] || fabs(d) * s > MAX_SLOT_ERROR) ok = false;
+            seen[slot] = true;
+        }
+        printf("  %12.3f  %s\n", 360.0 * worst, ok ? "ok" : "FAIL");
+        if (!ok) rc = 1;
+    }
+    printf("simulated layers %.1f s, band by band %.1f s (%+.1f %%)\n", simPattern, simBand,
+           100.0 * (simPattern - simBand) / simBand);
+    return rc;
+}
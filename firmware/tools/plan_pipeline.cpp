@@ -0,0 +1,123 @@
+/// @file plan_pipeline.cpp
+/// @brief Check that background layer planning changes nothing but when the
+///        work is done.
+///
+///     plan_pipeline <profile> [--loop-us N] [--latency N] [--repeat N]
+///
+/// Winds the profile, followed by N queued repeats (default 1), twice: with
+/// the stand-in planner worker serving each request after --latency loop
+/// passes (default 0), and with the worker never running, so every layer
+/// boundary builds its plan in line.  The tool prints the plan hand-overs
+/// and misses of both runs and the longest Winding::update() call at a
+/// boundary (host wall time, so only the ratio means much), and fails
+/// (exit code 1) if
+///
+///   - the two step traces differ in any sample,
+///   - the in-line run does not count every boundary as a miss, or
+///   - the background run misses a plan with the default latency.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "sim.h"
+
+static void usage() {
+    fprintf(stderr, "usage: plan_pipeline <profile> [--loop-us N] [--latency N] [--repeat N]\n");
+}
+
+static bool sameSample(const StepSample& a, const StepSample& b) {
+    return a.timeUs == b.timeUs && a.mandrel == b.mandrel && a.carriage == b.carriage &&
+           a.state == b.state && a.layer == b.layer && a.pass == b.pass && a.target == b.target;
+}
+
+static void printRun(const char* name, const SimResult& r) {
+    printf("%-10s  %8.1f s  %6u  %6u  %11.1f\n", name, r.durationUs / 1e6, r.handovers,
+           r.planMisses, r.maxHandoverUs);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        usage();
+        return 2;
+    }
+
+    SimOptions options;
+    options.repeatJobs = 1;
+    bool latencySet = false;
+    for (int a = 2; a < argc; a++) {
+        bool hasValue = a + 1 < argc;
+        if (!strcmp(argv[a], "--loop-us") && hasValue) {
+            options.loopUs = atoi(argv[++a]);
+        } else if (!strcmp(argv[a], "--latency") && hasValue) {
+            options.plannerLatencyLoops = strtoul(argv[++a], nullptr, 10);
+            latencySet = true;
+        } else if (!strcmp(argv[a], "--repeat") && hasValue) {
+            options.repeatJobs = atoi(argv[++a]);
+        } else {
+            usage();
+            return 2;
+        }
+    }
+
+    SimProfile  profile;
+    std::string error;
+    if (!loadProfile(argv[1], profile, error)) {
+        fprintf(stderr, "plan_pipeline: %s\n", error.c_str());
+        return 2;
+    }
+
+    Serial.setSink(nullptr);
+    SimOptions inLine = options;
+    inLine.plannerLatencyLoops = UINT32_MAX;
+
+    std::vector<StepSample> bgTrace, inTrace;
+    SimResult bg, in;
+    if (!Sim::run(profile, options, &bgTrace, bg) || !bg.completed ||
+        !Sim::run(profile, inLine, &inTrace, in) || !in.completed) {
+        fprintf(stderr, "plan_pipeline: simulation failed (more than %d layers?)\n", MAX_LAYERS);
+        return 1;
+    }
+
+    const uint32_t boundaries =
+        static_cast<uint32_t>((options.repeatJobs + 1) * profile.layers.size() - 1);
+    printf("%d job(s) x %zu layers, %u boundaries\n", options.repeatJobs + 1,
+           profile.layers.size(), boundaries);
+    printf("run            job_time  handed  missed  boundary_us\n");
+    printRun("background", bg);
+    printRun("in line", in);
+
+    int rc = 0;
+    size_t diff = 0;
+    while (diff < bgTrace.size() && diff < inTrace.size() && sameSample(bgTrace[diff], inTrace[diff])) {
+        diff++;
+    }
+    if (diff != bgTrace.size() || diff != inTrace.size()) {
+        printf("FAIL  step traces differ at sample %zu of %zu / %zu\n", diff, bgTrace.size(),
+               inTrace.size());
+        rc = 1;
+    } else {
+        printf("ok    step traces identical (%zu samples)\n", bgTrace.size());
+    }
+
+    if (in.handovers != boundaries || in.planMisses != boundaries) {
+        printf("FAIL  in-line run handed over %u / missed %u plans, expected %u\n",
+               in.handovers, in.planMisses, boundaries);
+        rc = 1;
+    } else {
+        printf("ok    in-line run missed every boundary\n");
+    }
+
+    if (bg.handovers != boundaries || (!latencySet && bg.planMisses != 0)) {
+        printf("FAIL  background run handed over %u plans, %u not ready in time\n",
+               bg.handovers, bg.planMisses);
+        rc = 1;
+    } else {
+        printf("%s  background run: %u of %u plans not ready in time (latency %u loops)\n",
+               bg.planMisses ? "note" : "ok  ", bg.planMisses, boundaries,
+               options.plannerLatencyLoops);
+    }
+    return rc;
+}
@@ -0,0 +1,146 @@
+/// @file profile_angle.cpp
+/// @brief Fibre-angle error along a profiled (tapered / domed) mandrel.
+///
+///     profile_angle <profile> [--margin MM] [--limit DEG] [--loop-us N]
+///
+/// Winds the profile through the simulation and measures the local fibre
+/// angle over a sliding 10° mandrel window, using the mandrel radius at the
+/// carriage position (SplineProfile), against the layer angle.  The check is
+/// made on the geared command (carriage target position), which is what the
+/// ratio table drives; the stepped carriage follows the same path a lag
+/// behind and its angle error, which adds the follower's speed hunting, is
+/// printed alongside.  The first and last --margin mm of every pass are
+/// skipped: that is where the carriage turns around, which accuracy_sim
+/// already covers.  For comparison the error a constant ratio for the
+/// reference diameter would give is printed too.  Exit code 1 if the
+/// commanded error exceeds --limit (default 0.5°).
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "sim.h"
+
+/// Mandrel rotation over which the local fibre angle is measured.
+constexpr double ANGLE_WINDOW_DEG = 10.0;
+
+static void usage() {
+    fprintf(stderr, "usage: profile_angle <profile> [--margin MM] [--limit DEG] [--loop-us N]\n");
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        usage();
+        return 2;
+    }
+
+    SimOptions options;
+    double     marginMM = 10.0;
+    double     limitDeg = 0.5;
+    for (int a = 2; a < argc; a++) {
+        bool hasValue = a + 1 < argc;
+        if      (!strcmp(argv[a], "--margin") && hasValue)  marginMM       = atof(argv[++a]);
+        else if (!strcmp(argv[a], "--limit") && hasValue)   limitDeg       = atof(argv[++a]);
+        else if (!strcmp(argv[a], "--loop-us") && hasValue) options.loopUs = atoi(argv[++a]);
+        else {
+            usage();
+            return 2;
+        }
+    }
+
+    SimProfile  profile;
+    std::string error;
+    if (!loadProfile(argv[1], profile, error)) {
+        fprintf(stderr, "profile_angle: %s\n", error.c_str());
+        return 2;
+    }
+
+    // Host copy of the surface (double precision evaluation of the same fit).
+    SplineProfile surface;
+    for (size_t i = 0; i < profile.pointX.size(); i++) {
+        surface.addPoint(profile.pointX[i], profile.pointR[i]);
+    }
+    surface.compute();
+    auto radiusAt = [&](double x, const Layer& l) {
+        return surface.isReady() ? surface.getRadius(static_cast<float>(x))
+                                 : l.getDiameter() * 0.5;
+    };
+
+    Serial.setSink(nullptr);
+    std::vector<StepSample> trace;
+    SimResult               result;
+    if (!Sim::run(profile, options, &trace, result) || !result.completed) {
+        fprintf(stderr, "profile_angle: simulation failed (more than %d layers?)\n", MAX_LAYERS);
+        return 2;
+    }
+
+    const double stepsPerMM  = Sim::carriageStepsPerMM();
+    const double stepsPerRev = Sim::mandrelStepsPerRev();
+    const long   windowSteps = static_cast<long>(ANGLE_WINDOW_DEG / 360.0 * stepsPerRev);
+
+    // Max / rms angle error of one layer along the commanded or stepped path.
+    struct AngleStats {
+        double max   = 0.0;
+        double rms   = 0.0;
+        long   count = 0;
+    };
+    auto measure = [&](size_t li, long StepSample::*axis, double lo, double hi) {
+        const Layer& layer = profile.layers[li];
+        AngleStats   st;
+        double       sumSq = 0.0;
+        size_t       back  = 0;
+        for (size_t j = 0; j < trace.size(); j++) {
+            const StepSample& s = trace[j];
+            if (s.layer != static_cast<int>(li) || s.state != WindingState::WINDING) {
+                back = j + 1;
+                continue;
+            }
+            if (back < j && trace[back].pass != s.pass) back = j;
+            while (back < j && s.mandrel - trace[back + 1].mandrel >= windowSteps) back++;
+            if (s.mandrel - trace[back].mandrel < windowSteps) continue;
+
+            const double x0 = trace[back].*axis / stepsPerMM;
+            const double x1 = s.*axis / stepsPerMM;
+            if (fmin(x0, x1) < lo || fmax(x0, x1) > hi) continue;
+
+            const double r     = radiusAt(0.5 * (x0 + x1), layer);
+            const double arc   = r * 2.0 * M_PI * (s.mandrel - trace[back].mandrel) / stepsPerRev;
+            const double angle = atan2(arc, fabs(x1 - x0)) * 180.0 / M_PI;
+            const double err   = fabs(angle - layer.getAngle());
+            st.max = fmax(st.max, err);
+            sumSq += err * err;
+            st.count++;
+        }
+        st.rms = st.count ? sqrt(sumSq / st.count) : 0.0;
+        return st;
+    };
+
+    printf("layer  angle  cmd_max  cmd_rms  step_max  step_rms  windows  const_ratio\n");
+    double worst = 0.0;
+    for (size_t li = 0; li < profile.layers.size(); li++) {
+        const Layer& layer = profile.layers[li];
+        const double lo    = layer.getOffset() + marginMM;
+        const double hi    = layer.getOffset() + layer.getLength() - marginMM;
+
+        AngleStats cmd  = measure(li, &StepSample::target, lo, hi);
+        AngleStats step = measure(li, &StepSample::carriage, lo, hi);
+
+        // Reference: one constant ratio for the layer's nominal diameter.
+        const double k = M_PI * layer.getDiameter() / tan(layer.getAngle() * M_PI / 180.0);
+        double constErr = 0.0;
+        for (double x = lo; x <= hi; x += 0.5) {
+            double angle = atan2(2.0 * M_PI * radiusAt(x, layer), k) * 180.0 / M_PI;
+            constErr = fmax(constErr, fabs(angle - layer.getAngle()));
+        }
+
+        printf("%5zu  %5.1f  %7.3f  %7.3f  %8.3f  %8.3f  %7ld  %11.3f\n", li, layer.getAngle(),
+               cmd.max, cmd.rms, step.max, step.rms, cmd.count, constErr);
+        worst = fmax(worst, cmd.max);
+    }
+
+    bool ok = worst <= limitDeg;
+    printf("max angle error %.3f deg (limit %.2f) — %s\n", worst, limitDeg, ok ? "ok" : "FAIL");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,136 @@
+/// @file spline_lut_bench.cpp
+/// @brief Compare SplineProfile toolarm-target lookup: per-step spline
+///        evaluation versus the baked uniform-grid table.
+///
+///     spline_lut_bench [--profiles N] [--reps N] [--seed N]
+///
+/// For a 50-point dome / cylinder / dome profile (the 4-axis test geometry)
+/// and N random smooth 50-point profiles, every carriage step across the
+/// profile is converted to a toolarm step target three ways:
+///
+///   spline   getTarget(step / stepsPerMM) × toolarmStepsPerMM — the current
+///            per-iteration path (segment scan + cubic in float)
+///   nearest  getTargetSteps()      — table entry nearest the step
+///   lerp     getTargetStepsLerp()  — linear interpolation between entries
+///
+/// and the lookup cost (ns per call, host) and the worst difference from the
+/// spline path (toolarm steps) are printed with the table size.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <random>
+
+#include "config.h"
+#include "axis.h"
+#include "spline_profile.h"
+
+static volatile long s_sink;   // Keeps the timed loops from being optimised away.
+
+struct Result {
+    double nsSpline = 0.0, nsNearest = 0.0, nsLerp = 0.0;
+    long   errNearest = 0, errLerp = 0;
+};
+
+template <typename Fn>
+static double timeLoop(long first, long last, int reps, Fn fn) {
+    auto t0 = std::chrono::steady_clock::now();
+    long acc = 0;
+    for (int r = 0; r < reps; r++) {
+        for (long s = first; s <= last; s++) acc += fn(s);
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    s_sink = acc;
+    double calls = static_cast<double>(reps) * (last - first + 1);
+    return std::chrono::duration<double, std::nano>(t1 - t0).count() / calls;
+}
+
+static Result bench(const SplineProfile& p, float carSPM, float armSPM, int reps) {
+    const long first = static_cast<long>(p.getStart() * carSPM);
+    const long last  = static_cast<long>(p.getEnd() * carSPM);
+    auto spline = [&](long s) { return lroundf(p.getTarget(s / carSPM) * armSPM); };
+
+    Result r;
+    for (long s = first; s <= last; s++) {
+        long ref = spline(s);
+        r.errNearest = std::max(r.errNearest, labs(p.getTargetSteps(s) - ref));
+        r.errLerp    = std::max(r.errLerp, labs(p.getTargetStepsLerp(s) - ref));
+    }
+    r.nsSpline  = timeLoop(first, last, reps, spline);
+    r.nsNearest = timeLoop(first, last, reps, [&](long s) { return p.getTargetSteps(s); });
+    r.nsLerp    = timeLoop(first, last, reps, [&](long s) { return p.getTargetStepsLerp(s); });
+    return r;
+}
+
+static void print(const char* name, const SplineProfile& p, const Result& r, float armSPM) {
+    printf("%-10s %5d %6ld %6u  %8.1f %8.1f %8.1f  %5ld (%.3f mm) %5ld (%.3f mm)\n", name,
+           p.getTableEntries(), p.getTablePitch(), p.getTableBytes(), r.nsSpline, r.nsNearest,
+           r.nsLerp, r.errNearest, r.errNearest / armSPM, r.errLerp, r.errLerp / armSPM);
+}
+
+int main(int argc, char** argv) {
+    int      profiles = 20;
+    int      reps     = 20;
+    unsigned seed     = 1;
+    for (int a = 1; a < argc; a++) {
+        bool hasValue = a + 1 < argc;
+        if      (!strcmp(argv[a], "--profiles") && hasValue) profiles = atoi(argv[++a]);
+        else if (!strcmp(argv[a], "--reps") && hasValue)     reps     = atoi(argv[++a]);
+        else if (!strcmp(argv[a], "--seed") && hasValue)     seed     = strtoul(argv[++a], nullptr, 10);
+        else {
+            fprintf(stderr, "usage: spline_lut_bench [--profiles N] [--reps N] [--seed N]\n");
+            return 2;
+        }
+    }
+
+    const float carSPM = CarriageAxis::stepsPerMM();
+    const float armSPM = ToolarmAxis::stepsPerMM();
+    printf("carriage %.1f steps/mm, toolarm %.1f steps/mm, table capacity %u bytes\n\n",
+           carSPM, armSPM, SplineProfile::tableCapacityBytes());
+    printf("profile    entries pitch  bytes   spline_ns nearest_ns lerp_ns  max_err_nearest   max_err_lerp\n");
+
+    static SplineProfile p;   // ~5 KB; keep it off the stack like the firmware does.
+
+    // Dome / cylinder / dome as in the 4-axis scripts, 50 points in total.
+    const float R = 50.0f;
+    p.clear();
+    p.setStandoff(5.0f);
+    for (int i = 0; i <= 23; i++) {
+        float x = R * i / 23.0f;
+        p.addPoint(x, sqrtf(R * R - (R - x) * (R - x)));
+    }
+    p.addPoint(R + 50.0f, R);
+    p.addPoint(R + 100.0f, R);
+    for (int i = 1; i <= 24; i++) {
+        float x = R * i / 24.0f;
+        p.addPoint(R + 100.0f + x, sqrtf(R * R - x * x));
+    }
+    p.compute(carSPM, armSPM);
+    print("dome", p, bench(p, carSPM, armSPM, reps), armSPM);
+
+    // Random smooth profiles: 50 points, 2–8 mm apart, radius walking ±2 mm.
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> gap(2.0f, 8.0f), step(-2.0f, 2.0f);
+    Result worst;
+    for (int k = 0; k < profiles; k++) {
+        p.clear();
+        float x = 0.0f, r = 40.0f;
+        for (int i = 0; i < SPLINE_MAX_POINTS; i++) {
+            p.addPoint(x, r);
+            x += gap(rng);
+            r  = fminf(fmaxf(r + step(rng), 10.0f), 80.0f);
+        }
+        p.compute(carSPM, armSPM);
+        Result res = bench(p, carSPM, armSPM, reps);
+        worst.nsSpline   = fmax(worst.nsSpline, res.nsSpline);
+        worst.nsNearest  = fmax(worst.nsNearest, res.nsNearest);
+        worst.nsLerp     = fmax(worst.nsLerp, res.nsLerp);
+        worst.errNearest = std::max(worst.errNearest, res.errNearest);
+        worst.errLerp    = std::max(worst.errLerp, res.errLerp);
+        if (k == 0) print("random0", p, res, armSPM);
+    }
+    print("random/max", p, worst, armSPM);
+    return 0;
+}
@@ -0,0 +1,263 @@
+/// @file stall_sim.cpp
+/// @brief Check that a stalled axis pauses the job within a few steps, in
+///        the layer and pass it stalled in, and that a clean job does not.
+///
+///     stall_sim <profile> [--load F] [--jam-at F] [--loop-us N]
+///
+/// Winds the profile in the simulator with the drivers strapped, then with
+/// TMC2209 models on the UART (tools/host/tmc_model.h) whose motors carry
+/// --load (default 0.6) of what their current holds, so SG_RESULT reads
+/// 510 × (1 − load) at speed.  initDrivers() configures them as at start-up
+/// and the stall monitor (stall_monitor.h) reads them while the job winds.
+/// The tool prints each watched axis's readings and lowest SG_RESULT
+/// against its stall level.
+///
+/// Then it winds twice more with a motor jammed --jam-at (default 0.4) of
+/// the way through the job: the mandrel at the first step it makes from
+/// there while winding a pass, and the toolhead at the first step of the
+/// next flip.  A jammed motor no longer turns; the tool prints where the
+/// job paused, the stall alarm and the pulses the motor lost.
+///
+/// Checks, each failing the tool (exit code 1):
+///
+///   - the job with the drivers completes without a stall, winding (from
+///     the end of zeroing, which seeks coarser through the drivers) in the
+///     time of the strapped one to 0.1 % — the reads never block — with
+///     readings of the mandrel and the toolhead;
+///   - in that job the toolhead flips at TOOLHEAD_FLIP_MICROSTEPS (fewer
+///     pulses through its driver than half the steps it turns) and its
+///     motor keeps to its logical position from the first pass to the end;
+///   - each jam pauses the job within DETECT_MS of the motor being due at
+///     its driver's stallMinSpeed (the toolhead flips from rest), with the
+///     stall alarm on the jammed axis, in the layer and pass it jammed in.
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "sim.h"
+#include "config.h"
+#include "motor_control.h"
+#include "stall_monitor.h"
+#include "tmc_model.h"
+#include "trace.h"
+
+// Longest a jam at speed may go unnoticed: the settling time, confirming
+// readings of two watched axes in turn, a read each STALL_POLL_US, and a
+// read's time on the wire.
+static constexpr double DETECT_MS =
+    (STALL_SETTLE_US + (STALL_CONFIRM_READINGS + 1) * 2 * STALL_POLL_US) * 1e-3 + 2.0;
+
+static const char* const AXIS_NAMES[] = { "mandrel", "carriage", "toolarm", "toolhead" };
+
+static void usage() {
+    fprintf(stderr, "usage: stall_sim <profile> [--load F] [--jam-at F] [--loop-us N]\n");
+}
+
+// A fresh UART with the drivers of the mandrel, toolarm and toolhead at
+// @p load.
+static void fitDrivers(TmcModel& model, float load) {
+    model = TmcModel(TMC_UART_BAUD);
+    for (uint8_t address : { MANDREL_DRIVER_CONFIG.address, TOOLARM_DRIVER_CONFIG.address,
+                             TOOLHEAD_DRIVER_CONFIG.address }) {
+        model.fit(address);
+        model.node(address)->setLoad(load);
+    }
+}
+
+/// Where one jam was set, and what came of it.
+struct Jam {
+    TraceAxis axis;
+    uint8_t   address;
+    double    rampMs  = 0;   ///< From rest to the driver's stallMinSpeed.
+    uint64_t  atUs    = 0;   ///< Virtual time the motor jams.
+    int       layer   = 0;   ///< Layer and pass (1-based) it jams in.
+    int       pass    = 0;
+    SimResult result;
+    uint32_t  lost    = 0;   ///< Pulses the jammed motor lost.
+};
+
+// First sample from @p fromUs on that @p starts (given the trace and its
+// index) says is a step of the axis.
+template <class Starts>
+static bool findJam(const std::vector<StepSample>& trace, uint64_t fromUs, Starts starts, Jam& jam) {
+    for (size_t i = 2; i < trace.size(); i++) {
+        if (trace[i].timeUs < fromUs || !starts(trace, i)) continue;
+        jam.atUs  = trace[i].timeUs;
+        jam.layer = trace[i].layer;
+        jam.pass  = trace[i].pass + 1;
+        return true;
+    }
+    return false;
+}
+
+// Steps the toolhead turns over the trace, and how far from the first
+// pass on its motor leaves the offset from its logical position it started
+// the pass with.
+static void toolheadTravel(const std::vector<StepSample>& trace, long& travel, long& drift) {
+    travel = drift = 0;
+    bool winding = false;
+    long offset  = 0;
+    for (size_t i = 1; i < trace.size(); i++) {
+        travel += labs(trace[i].toolhead - trace[i - 1].toolhead);
+        const StepSample& s = trace[i];
+        if (s.state != WindingState::WINDING && s.state != WindingState::DWELLING) continue;
+        if (!winding) offset = s.toolhead - s.toolheadLoad;
+        winding = true;
+        const long off = labs(s.toolhead - s.toolheadLoad - offset);
+        if (off > drift) drift = off;
+    }
+}
+
+// Seconds from the end of zeroing to the end of the job.
+static double windingSeconds(const std::vector<StepSample>& trace, const SimResult& r) {
+    for (const StepSample& s : trace) {
+        if (s.state == WindingState::WINDING) return (r.durationUs - s.timeUs) * 1e-6;
+    }
+    return 0.0;
+}
+
+static bool runJam(const SimProfile& profile, const SimOptions& options, float load, Jam& jam) {
+    TmcModel   model(TMC_UART_BAUD);
+    SimOptions o = options;
+    fitDrivers(model, load);
+    model.node(jam.address)->jam(static_cast<double>(jam.atUs));
+    o.drivers = &model;
+    Sim::run(profile, o, nullptr, jam.result);
+    jam.lost = model.node(jam.address)->stalledPulses();
+
+    const StallAlarm& alarm  = Winding::getStallAlarm();
+    const double      late   = (jam.result.durationUs - static_cast<double>(jam.atUs)) * 1e-3;
+    const double      allow  = DETECT_MS + jam.rampMs;
+    const bool        paused = Winding::getState() == WindingState::PAUSED;
+    printf("%-8s jammed at %7.2f s (layer %d, pass %d): %s %6.2f ms later (allowed %.1f), alarm %s layer %d pass %d "
+           "SG %u, %u pulses lost\n",
+           AXIS_NAMES[static_cast<uint8_t>(jam.axis)], jam.atUs * 1e-6, jam.layer, jam.pass,
+           paused ? "paused" : "NOT paused", late, allow, AXIS_NAMES[alarm.axis & 3], alarm.layer, alarm.pass,
+           alarm.result, jam.lost);
+    return paused && late <= allow && alarm.axis == static_cast<uint8_t>(jam.axis) &&
+           alarm.layer == jam.layer && alarm.pass == jam.pass;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        usage();
+        return 2;
+    }
+
+    SimOptions options;
+    float      load  = 0.6f;
+    float      jamAt = 0.4f;
+    for (int a = 2; a < argc; a++) {
+        bool hasValue = a + 1 < argc;
+        if (!strcmp(argv[a], "--load") && hasValue) {
+            load = atof(argv[++a]);
+        } else if (!strcmp(argv[a], "--jam-at") && hasValue) {
+            jamAt = atof(argv[++a]);
+        } else if (!strcmp(argv[a], "--loop-us") && hasValue) {
+            options.loopUs = atoi(argv[++a]);
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (load < 0.0f || load > 1.0f || jamAt <= 0.0f || jamAt >= 1.0f) {
+        usage();
+        return 2;
+    }
+
+    SimProfile  profile;
+    std::string error;
+    if (!loadProfile(argv[1], profile, error)) {
+        fprintf(stderr, "stall_sim: %s\n", error.c_str());
+        return 2;
+    }
+
+    Serial.setSink(nullptr);
+    bool ok = true;
+
+    // ── Strapped, then watched ───────────────────────────────────────────────
+    std::vector<StepSample> strappedTrace;
+    SimResult               strapped;
+    if (!Sim::run(profile, options, &strappedTrace, strapped) || !strapped.completed) {
+        fprintf(stderr, "stall_sim: simulation failed (more than %d layers?)\n", MAX_LAYERS);
+        return 1;
+    }
+
+    TmcModel model(TMC_UART_BAUD);
+    fitDrivers(model, load);
+    SimOptions watched = options;
+    watched.drivers    = &model;
+    std::vector<StepSample> trace;
+    SimResult               clean;
+    const uint32_t          stallsBefore = Winding::getStallAlarm().count;
+    Sim::run(profile, watched, &trace, clean);
+
+    const StallMonitor& monitor = Winding::getStallMonitor();
+    const double strappedS = windingSeconds(strappedTrace, strapped);
+    const double cleanS    = windingSeconds(trace, clean);
+    printf("load %.2f: winding %.2f s strapped, %.2f s watched (%s)\n\n", load, strappedS, cleanS,
+           clean.completed ? "complete" : "NOT complete");
+    printf("axis      watched  stall_level  min_speed  readings  lowest\n");
+    for (uint8_t i = 0; i < monitor.axes(); i++) {
+        if (!monitor.watched(i)) {
+            printf("%-8s  %7s\n", AXIS_NAMES[i], "no");
+            continue;
+        }
+        printf("%-8s  %7s  %11u  %9.0f  %8u  %6u\n", AXIS_NAMES[i], "yes", monitor.driver(i).stallLevel(),
+               monitor.driver(i).stallMinSpeed(), monitor.readings(i), monitor.lowestResult(i));
+    }
+    const uint8_t mandrel  = static_cast<uint8_t>(TraceAxis::MANDREL);
+    const uint8_t toolhead = static_cast<uint8_t>(TraceAxis::TOOLHEAD);
+    const bool    quiet    = clean.completed && Winding::getStallAlarm().count == stallsBefore &&
+                             monitor.readings(mandrel) > 0 && monitor.readings(toolhead) > 0 &&
+                             fabs(cleanS - strappedS) <= 1e-3 * strappedS;
+    printf("%s  the watched job completes without a stall, winding in the strapped job's time\n",
+           quiet ? "ok  " : "FAIL");
+    ok = quiet && ok;
+
+    const TmcNodeModel* head = model.node(TOOLHEAD_DRIVER_CONFIG.address);
+    long                travel, drift;
+    toolheadTravel(trace, travel, drift);
+    const bool coarse = head->pulses() < travel / 2 && drift == 0;
+    printf("%s  the toolhead flips at %u microsteps: %u pulses for %ld steps, %u resolution changes, "
+           "motor off by %ld\n\n",
+           coarse ? "ok  " : "FAIL", TOOLHEAD_FLIP_MICROSTEPS, head->pulses(), travel, head->resolutionChanges(),
+           drift);
+    ok = coarse && ok;
+
+    // ── Jams ─────────────────────────────────────────────────────────────────
+    const uint64_t from = static_cast<uint64_t>(jamAt * clean.durationUs);
+    Jam            jams[2];
+    jams[0].axis    = TraceAxis::MANDREL;
+    jams[0].address = MANDREL_DRIVER_CONFIG.address;
+    jams[1].axis    = TraceAxis::TOOLHEAD;
+    jams[1].address = TOOLHEAD_DRIVER_CONFIG.address;
+    jams[1].rampMs  = 1e3 * TOOLHEAD_DRIVER_CONFIG.stallMinSpeed / DEFAULT_TOOLHEAD_ACCEL;
+    typedef const std::vector<StepSample>& Trace;
+    const bool found =
+        findJam(trace, from, [](Trace t, size_t i) {
+            // A mandrel step in a pass.
+            return t[i].state == WindingState::WINDING && t[i - 1].state == WindingState::WINDING &&
+                   t[i].mandrel != t[i - 1].mandrel;
+        }, jams[0]) &&
+        findJam(trace, from, [](Trace t, size_t i) {
+            // The first toolhead step of a flip.
+            return t[i].toolhead != t[i - 1].toolhead && t[i - 1].toolhead == t[i - 2].toolhead;
+        }, jams[1]);
+    if (!found) {
+        printf("FAIL  no mandrel step or toolhead flip after %.0f %% of the job\n", jamAt * 100.0f);
+        return 1;
+    }
+
+    bool caught = true;
+    for (Jam& jam : jams) caught = runJam(profile, options, load, jam) && caught;
+    printf("%s  every jam pauses the job within %.1f ms at speed, on its axis, in its layer and pass\n",
+           caught ? "ok  " : "FAIL", DETECT_MS);
+    ok = caught && ok;
+
+    return ok ? 0 : 1;
+}
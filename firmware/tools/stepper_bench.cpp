@@ -0,0 +1,405 @@
+/// @file stepper_bench.cpp
+/// @brief Compare AccelStepper with the compile-time StepDirStepper and its
+///        integer ramp table: equivalence and cost per step.
+///
+///     stepper_bench [--steps N]
+///
+/// Equivalence, each failing the tool (exit code 1):
+///
+///   - runSpeed(): the same constant-speed runs on both, which must agree
+///     exactly, call for call.
+///   - Ramp table at the carriage defaults: no interval shorter than the
+///     one at maximum speed, intervals falling with the level.
+///   - run(): scripted moves replayed on both at the carriage defaults —
+///     plain and triangular moves, a target extended, shortened and
+///     reversed mid-move, stop(), maximum speed and acceleration changed
+///     mid-move, and a geared target moving back and forth.  The final
+///     positions must match, the positions at any time and the peak travel
+///     agree to 2 % of the travel, and the end time to 2 % plus one
+///     first-step interval.  Printed with the number of leading steps that
+///     are identical (the acceleration is AccelStepper's step for step).
+///   - setSpeed(0) stops a motor that setTargetSpeed() has crawling below
+///     the ramp's first level, and one running on the ramp: no step after
+///     it, speed() 0 and a resolution change accepted.
+///
+/// Cost: N steps through runSpeed() at a constant speed, and N steps through
+/// run() on back-and-forth ramped moves with the clock advanced 20 µs (the
+/// firmware loop) and 300 µs (about one call per step) per call.  The clock
+/// advance is timed on its own and its cost per pass subtracted.  Prints ns
+/// and (on x86) TSC cycles per step, GPIO writes per step and calls per
+/// step, and the time to build the ramp table.  Pin writes on the host are
+/// a counting hook, so the direct register writes StepDirStepper makes on
+/// the ESP32 are not represented; the figures cover dispatch and
+/// bookkeeping only.  Host x86 divides in hardware, so the gain from the
+/// table on the ESP32 — whose FPU has no divide instruction and which does
+/// doubles in software — is larger than shown here.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#else
+#define HAVE_TSC 0
+#endif
+
+#include "AccelStepper.h"
+#include "motor_control.h"
+
+constexpr uint8_t REF_STEP_PIN = 2, REF_DIR_PIN = 3;
+constexpr uint8_t NEW_STEP_PIN = 4, NEW_DIR_PIN = 5;
+
+using BenchStepper = StepDirStepper<NEW_STEP_PIN, NEW_DIR_PIN, StepDirPins::NONE, CARRIAGE_RAMP_STEPS>;
+
+static volatile uint32_t s_pinWrites;   // Stands in for the GPIO register store.
+
+static void countWrite(uint8_t, uint8_t) { s_pinWrites = s_pinWrites + 1; }
+
+// ============================================================================
+//  Timing
+// ============================================================================
+
+struct Cost {
+    double   ns;
+    double   cycles;   ///< 0 without a TSC.
+    uint32_t writes;
+    double   calls;    ///< Calls per step.
+};
+
+static uint64_t cycleCount() {
+#if HAVE_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+// Calls body() until it reports @p steps steps; per-step cost of the loop.
+template <typename Body>
+static Cost timeSteps(long steps, Body body) {
+    s_pinWrites   = 0;
+    auto     t0   = std::chrono::steady_clock::now();
+    uint64_t c0   = cycleCount();
+    long     done = 0, calls = 0;
+    for (; done < steps; calls++) done += body();
+    uint64_t c1 = cycleCount();
+    auto     t1 = std::chrono::steady_clock::now();
+    Cost c;
+    c.ns     = std::chrono::duration<double, std::nano>(t1 - t0).count() / steps;
+    c.cycles = static_cast<double>(c1 - c0) / steps;
+    c.writes = s_pinWrites;
+    c.calls  = static_cast<double>(calls) / steps;
+    return c;
+}
+
+// Subtract the clock-only loop (@p perCall: cost of one pass) from @p a.
+static Cost minus(Cost a, const Cost& perCall) {
+    a.ns     -= perCall.ns * a.calls;
+    a.cycles -= perCall.cycles * a.calls;
+    return a;
+}
+
+// Constant speed: one step per 250 µs, the clock advanced by that much per call.
+template <typename Stepper>
+static Cost runSpeedCost(Stepper& s, long steps) {
+    s.setMaxSpeed(8000);
+    s.setSpeed(4000);
+    return timeSteps(steps, [&]() -> long {
+        hostAdvanceMicros(250);
+        return s.runSpeed() ? 1 : 0;
+    });
+}
+
+// Ramped moves of ±4000 steps at the carriage defaults, reversed at each
+// end; the clock advances @p loopUs per call.  At 20 µs most calls do not
+// step (the firmware loop); at 300 µs nearly every call does, which
+// isolates the per-step ramp update.
+template <typename Stepper>
+static Cost runCost(Stepper& s, long steps, uint32_t loopUs) {
+    s.setMaxSpeed(3000);
+    s.setAcceleration(5000);
+    s.moveTo(4000);
+    return timeSteps(steps, [&]() -> long {
+        hostAdvanceMicros(loopUs);
+        const long before = s.currentPosition();
+        if (!s.run()) s.moveTo(-s.targetPosition());
+        return s.currentPosition() != before ? 1 : 0;
+    });
+}
+
+// One pass of the timing loop that only advances the clock.
+static Cost clockOnly(long calls) {
+    return timeSteps(calls, []() -> long {
+        hostAdvanceMicros(20);
+        return 1;
+    });
+}
+
+// ============================================================================
+//  Equivalence
+// ============================================================================
+
+// Constant speed: runSpeed() is unchanged from AccelStepper, so both must
+// agree exactly, call for call.
+static bool constantSpeedSame() {
+    hostResetClock();
+    AccelStepper a(AccelStepper::DRIVER, REF_STEP_PIN, REF_DIR_PIN);
+    BenchStepper b;
+    a.setMaxSpeed(6000);
+    b.setMaxSpeed(6000);
+
+    const float speeds[] = {1234.5f, -3999.0f, 400.0f, 0.0f};
+    long        calls    = 0;
+    for (float v : speeds) {
+        a.setSpeed(v);
+        b.setSpeed(v);
+        for (long i = 0; i < 200000; i++, calls++) {
+            hostAdvanceMicros(13);
+            if (a.runSpeed() != b.runSpeed() || a.currentPosition() != b.currentPosition()) {
+                printf("FAIL  constant speed %.1f, call %ld: position %ld / %ld\n",
+                       static_cast<double>(v), calls, a.currentPosition(), b.currentPosition());
+                return false;
+            }
+        }
+    }
+    printf("ok    runSpeed() identical over %ld calls\n", calls);
+    return true;
+}
+
+struct Command {
+    enum Op { MOVE_TO, MAX_SPEED, ACCEL, STOP };
+    uint32_t atUs;
+    Op       op;
+    float    value;
+};
+
+struct Scenario {
+    const char*          name;
+    std::vector<Command> commands;
+};
+
+struct StepEvent {
+    uint32_t timeUs;
+    long     position;
+};
+
+// Replays @p sc on @p s (carriage defaults, 5 µs per run() call) until every
+// command is applied and the motor has stopped; one event per step.
+template <typename Stepper>
+static std::vector<StepEvent> replay(Stepper& s, const Scenario& sc) {
+    hostResetClock();
+    s.setMaxSpeed(3000);
+    s.setAcceleration(5000);
+
+    std::vector<StepEvent> steps;
+    size_t   next = 0;
+    uint32_t t    = 0;
+    for (; t < 120000000; t += 5) {
+        hostAdvanceMicros(5);
+        for (; next < sc.commands.size() && sc.commands[next].atUs <= t; next++) {
+            const Command& c = sc.commands[next];
+            switch (c.op) {
+            case Command::MOVE_TO:   s.moveTo(static_cast<long>(c.value)); break;
+            case Command::MAX_SPEED: s.setMaxSpeed(c.value);               break;
+            case Command::ACCEL:     s.setAcceleration(c.value);           break;
+            case Command::STOP:      s.stop();                             break;
+            }
+        }
+        const long before  = s.currentPosition();
+        const bool running = s.run();
+        if (s.currentPosition() != before) steps.push_back({t, s.currentPosition()});
+        if (!running && next == sc.commands.size()) break;
+    }
+    return steps;
+}
+
+static long positionAt(const std::vector<StepEvent>& steps, uint32_t t) {
+    long pos = 0;
+    for (const StepEvent& e : steps) {
+        if (e.timeUs > t) break;
+        pos = e.position;
+    }
+    return pos;
+}
+
+static std::vector<Scenario> scenarios() {
+    std::vector<Scenario> list = {
+        {"move 20000",            {{0, Command::MOVE_TO, 20000}}},
+        {"move 300 (no cruise)",  {{0, Command::MOVE_TO, 300}}},
+        {"extend mid-accel",      {{0, Command::MOVE_TO, 2000}, {200000, Command::MOVE_TO, 8000}}},
+        {"shorten mid-cruise",    {{0, Command::MOVE_TO, 20000}, {2000000, Command::MOVE_TO, 5000}}},
+        {"reverse mid-move",      {{0, Command::MOVE_TO, 10000}, {1500000, Command::MOVE_TO, -3000}}},
+        {"stop mid-move",         {{0, Command::MOVE_TO, 10000}, {1500000, Command::STOP, 0}}},
+        {"max speed down / up",   {{0, Command::MOVE_TO, 15000}, {1000000, Command::MAX_SPEED, 1500},
+                                   {3000000, Command::MAX_SPEED, 3000}}},
+        {"acceleration change",   {{0, Command::MOVE_TO, 15000}, {300000, Command::ACCEL, 20000},
+                                   {2500000, Command::ACCEL, 5000}}},
+    };
+
+    // Electronic gearing: a target moving at 1500 steps/s, reversed every
+    // 2 s, updated every millisecond as Winding::update() does.
+    Scenario gearing = {"geared target", {}};
+    double   target  = 0.0;
+    for (uint32_t ms = 1; ms <= 8000; ms++) {
+        target += ((ms - 1) / 2000 % 2 ? -1.5 : 1.5);
+        gearing.commands.push_back({ms * 1000, Command::MOVE_TO, static_cast<float>(lround(target))});
+    }
+    list.push_back(gearing);
+    return list;
+}
+
+// The same motion, to a tolerance: the acceleration is AccelStepper's step
+// for step, the deceleration mirrors it rather than running its recurrence
+// backwards, so profiles part at the first deceleration and a move can end
+// up to one first-step interval (c0) later — the table's last step mirrors
+// its first.
+static bool rampEquivalent() {
+    const double c0Ms = 0.676 * sqrt(2.0 / 5000) * 1000.0;
+    printf("\nscenario               steps  same_prefix  end_ms (ref / table)  max_dev  overshoot\n");
+    bool ok = true;
+    for (const Scenario& sc : scenarios()) {
+        AccelStepper a(AccelStepper::DRIVER, REF_STEP_PIN, REF_DIR_PIN);
+        BenchStepper b;
+        const std::vector<StepEvent> ra = replay(a, sc), rb = replay(b, sc);
+
+        size_t same = 0;
+        while (same < ra.size() && same < rb.size() && ra[same].timeUs == rb[same].timeUs &&
+               ra[same].position == rb[same].position) {
+            same++;
+        }
+        long maxDev = 0, peakA = 0, peakB = 0;
+        for (const StepEvent& e : ra) {
+            maxDev = max(maxDev, labs(e.position - positionAt(rb, e.timeUs)));
+            peakA  = max(peakA, labs(e.position));
+        }
+        for (const StepEvent& e : rb) {
+            maxDev = max(maxDev, labs(e.position - positionAt(ra, e.timeUs)));
+            peakB  = max(peakB, labs(e.position));
+        }
+
+        const double endA   = ra.empty() ? 0.0 : ra.back().timeUs / 1000.0;
+        const double endB   = rb.empty() ? 0.0 : rb.back().timeUs / 1000.0;
+        const long   finalA = ra.empty() ? 0 : ra.back().position;
+        const long   finalB = rb.empty() ? 0 : rb.back().position;
+        const long   limit  = max(3L, peakA / 50);   // 2 % of the travel.
+        const bool   pass   = finalA == finalB && maxDev <= limit &&
+                              fabs(endB - endA) <= 0.02 * endA + c0Ms && labs(peakB - peakA) <= limit;
+        printf("%-4s %-20s %6zu  %11zu  %9.1f / %9.1f  %7ld  %4ld / %ld\n", pass ? "ok" : "FAIL",
+               sc.name, ra.size(), same, endA, endB, maxDev, peakA, peakB);
+        ok = ok && pass;
+    }
+    return ok;
+}
+
+// Every interval at least the one at maximum speed, and no step taken at
+// a level the distance to go could not stop from.
+static bool rampBounded() {
+    StepRamp<CARRIAGE_RAMP_STEPS> ramp;
+    ramp.build(3000, 5000);
+    const uint32_t cmin = 1000000 / 3000;
+    for (uint16_t k = 1; k <= ramp.top(); k++) {
+        if (ramp.interval(k) < cmin || (k > 1 && ramp.interval(k) > ramp.interval(k - 1))) {
+            printf("FAIL  ramp interval %u at level %u\n", ramp.interval(k), k);
+            return false;
+        }
+    }
+    printf("ok    ramp 3000 steps/s at 5000 steps/s²: %u levels, %u … %u µs, %u bytes\n",
+           ramp.top(), ramp.interval(1), ramp.interval(ramp.top()), ramp.memoryBytes());
+    return true;
+}
+
+// setSpeed(0) stops the motor whatever setTargetSpeed() left it doing:
+// crawling below level 1 (speed_ is 0 there) or on the ramp.
+static bool velocityStops() {
+    hostResetClock();
+    const float speeds[] = {30.0f, -30.0f, 2000.0f};
+    for (float v : speeds) {
+        BenchStepper s;
+        s.setMaxSpeed(3000);
+        s.setAcceleration(5000);
+        s.setTargetSpeed(v);
+        for (int i = 0; i < 20000; i++) {
+            hostAdvanceMicros(20);
+            s.run();
+        }
+        const long at = s.currentPosition();
+        s.setSpeed(0.0f);
+        for (int i = 0; i < 20000; i++) {
+            hostAdvanceMicros(20);
+            s.runSpeed();
+        }
+        if (at == 0 || s.speed() != 0.0f || s.currentPosition() != at || !s.setStepShift(2)) {
+            printf("FAIL  setSpeed(0) after setTargetSpeed(%.0f): speed %.1f, moved %ld\n", v, s.speed(),
+                   s.currentPosition() - at);
+            return false;
+        }
+    }
+    printf("ok    setSpeed(0) stops a crawl below level 1 and a ramp in velocity mode\n");
+    return true;
+}
+
+// ============================================================================
+//  Main
+// ============================================================================
+
+static void printCost(const char* name, const Cost& c, long steps) {
+    printf("%-26s  %8.2f  %9.1f  %6.2f  %6.2f\n", name, c.ns, c.cycles,
+           static_cast<double>(c.writes) / steps, c.calls);
+}
+
+int main(int argc, char** argv) {
+    long steps = 5000000;
+    for (int a = 1; a < argc; a++) {
+        if (!strcmp(argv[a], "--steps") && a + 1 < argc) {
+            steps = atol(argv[++a]);
+        } else {
+            fprintf(stderr, "usage: stepper_bench [--steps N]\n");
+            return 2;
+        }
+    }
+
+    hostSetPinWriter(countWrite);
+    if (!constantSpeedSame() || !rampBounded() || !rampEquivalent() || !velocityStops()) return 1;
+
+    // Table build, as at job start (setMaxSpeed + setAcceleration).
+    StepRamp<CARRIAGE_RAMP_STEPS> ramp;
+    const long builds = 2000;
+    auto       t0     = std::chrono::steady_clock::now();
+    for (long i = 0; i < builds; i++) {
+        ramp.build(3000.0f + (i & 1), 5000.0f);
+        s_pinWrites = s_pinWrites + ramp.interval(ramp.top());   // Keep the build.
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    printf("\nramp table build: %.1f µs (host)\n",
+           std::chrono::duration<double, std::micro>(t1 - t0).count() / builds);
+
+    AccelStepper refSpeed(AccelStepper::DRIVER, REF_STEP_PIN, REF_DIR_PIN);
+    AccelStepper refLoop(AccelStepper::DRIVER, REF_STEP_PIN, REF_DIR_PIN);
+    AccelStepper refStep(AccelStepper::DRIVER, REF_STEP_PIN, REF_DIR_PIN);
+    BenchStepper newSpeed, newLoop, newStep;
+
+    const Cost base = clockOnly(steps);
+    const Cost rs0  = minus(runSpeedCost(refSpeed, steps), base);
+    const Cost rs1  = minus(runSpeedCost(newSpeed, steps), base);
+    const Cost r0   = minus(runCost(refLoop, steps, 20), base);
+    const Cost r1   = minus(runCost(newLoop, steps, 20), base);
+    const Cost p0   = minus(runCost(refStep, steps, 300), base);
+    const Cost p1   = minus(runCost(newStep, steps, 300), base);
+
+    printf("\n%ld steps per case%s\n", steps, HAVE_TSC ? "" : " (no TSC: cycles not measured)");
+    printf("per step                          ns     cycles  writes   calls\n");
+    printCost("runSpeed  AccelStepper", rs0, steps);
+    printCost("runSpeed  StepDirStepper", rs1, steps);
+    printCost("run 20µs  AccelStepper", r0, steps);
+    printCost("run 20µs  StepDirStepper", r1, steps);
+    printCost("run 300µs AccelStepper", p0, steps);
+    printCost("run 300µs StepDirStepper", p1, steps);
+    printf("\nspeedup   runSpeed %.2fx   run 20µs %.2fx   run 300µs %.2fx\n", rs0.ns / rs1.ns,
+           r0.ns / r1.ns, p0.ns / p1.ns);
+    return 0;
+}
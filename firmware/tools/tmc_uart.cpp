@@ -0,0 +1,482 @@
+/// @file tmc_uart.cpp
+/// @brief TMC2209 UART configuration against a register-level driver model,
+///        and microstep resolution switching on the move.
+///
+///     tmc_uart [--moves N] [--homings N] [--loop-us N] [--seed N]
+///
+/// The drivers' UART is the register model (tools/host/tmc_model.h) with a
+/// TMC2209 at every axis's address.  initDrivers() probes and configures
+/// them as at start-up; the tool prints what each driver model was left
+/// with — resolution, run and hold current, chopper, writes accepted —
+/// and the virtual time it took.  Then it does it again with a byte of the
+/// configuration corrupted on the wire, with a driver missing, and with
+/// the run current swept from 100 mA to 1.7 A.
+///
+/// Next the toolarm (with 13 steps of backlash compensation) and the
+/// toolhead run N random moves each (default 400), positioned and at
+/// constant speed, every one at a resolution drawn from the axis's own down
+/// to full steps, switched at rest through the driver and the stepper
+/// together.  The driver model moves the motor by its resolution in force
+/// at each pulse; the tool prints the pulses and moves at each resolution.
+/// A last pulse goes out straight after a switch, without waiting for the
+/// driver, which the model must catch.
+///
+/// Last the toolarm homes --homings times (default 10) from random points
+/// 10 … 100 mm from its switch, seeking at TOOLARM_HOMING_SEEK_MICROSTEPS
+/// through its driver and, for comparison, at its own resolution without
+/// it.  The switch closes at a motor position; every loop() pass takes
+/// --loop-us (default 20) of virtual time.  The tool prints the mean
+/// homing time, the pulses and the fastest pulse rate per homing.
+///
+/// Checks, each failing the tool (exit code 1):
+///
+///   - every driver on the UART is found and configured — resolution, run
+///     and hold current within half a current step of the request, chopper
+///     — with each write counted and read back, and the carriage (no
+///     address) left alone;
+///   - a corrupted byte is dropped by the driver model and the write
+///     retried; a missing driver is reported absent and never written;
+///   - the swept run current is within half a step of the request and
+///     what the driver reports is what the model holds;
+///   - on every move the motor stays at the logical position plus the
+///     backlash slack, exactly, and a positioned move ends within a pulse
+///     of its target; no pulse races a resolution change, and the one
+///     that is made to is caught;
+///   - every homing completes with home at the switch, to the step, at the
+///     axis's own resolution afterwards, and the coarse seek uses fewer
+///     pulses and takes no more than 5 % longer.
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <random>
+
+#include "axis.h"
+#include "config.h"
+#include "homing.h"
+#include "motor_control.h"
+#include "tmc_model.h"
+
+// ============================================================================
+//  Driver Models and Motors
+// ============================================================================
+
+static TmcModel* s_model = nullptr;
+
+// A motor stepped by its driver model, and the toolarm's limit switch.
+struct Motor {
+    uint8_t stepPin;
+    uint8_t dirPin;
+    uint8_t address;
+    uint8_t dirLevel;
+    uint8_t stepLevel;
+    long    zero;   ///< Driver model position (1/256 steps) of motor position 0.
+};
+
+static Motor s_toolarm  = { TOOLARM_MOTOR_PARAMS.step_pin, TOOLARM_MOTOR_PARAMS.dir_pin,
+                            TOOLARM_DRIVER_CONFIG.address, LOW, LOW, 0 };
+static Motor s_toolhead = { TOOLHEAD_MOTOR_PARAMS.step_pin, TOOLHEAD_MOTOR_PARAMS.dir_pin,
+                            TOOLHEAD_DRIVER_CONFIG.address, LOW, LOW, 0 };
+
+static bool s_switchClosed = false;   // Toolarm switch: closed at motor position ≤ 0…
+static long s_switchEdge   = 0;       // …and the logical position its last change latched.
+
+// Motor position in the axis's steps.
+static long motorSteps(const Motor& m, uint16_t microsteps) {
+    const TmcNodeModel* n = s_model->node(m.address);
+    return (n->position256() - m.zero) / (256 / microsteps);
+}
+
+static void onPinWrite(uint8_t pin, uint8_t value) {
+    if (!s_model) return;
+    for (Motor* m : { &s_toolarm, &s_toolhead }) {
+        if (pin == m->dirPin) {
+            m->dirLevel = value;
+        } else if (pin == m->stepPin) {
+            TmcNodeModel* n = s_model->node(m->address);
+            if (value == HIGH && m->stepLevel == LOW && n) n->step(m->dirLevel == HIGH);
+            m->stepLevel = value;
+        }
+    }
+    if (pin == s_toolarm.stepPin && value == HIGH && s_model->node(s_toolarm.address)) {
+        const bool closed = motorSteps(s_toolarm, TOOLARM_MOTOR_PARAMS.microsteps) <= 0;
+        if (closed != s_switchClosed) s_switchEdge = toolarmStepper.currentPosition();
+        s_switchClosed = closed;
+    }
+}
+
+static uint32_t s_loopUs = 20;
+
+static void nextLoop() { hostAdvanceMicros(s_loopUs); }
+
+// Let the wire go quiet (a write's datagram reach its driver).
+static void settle() {
+    while (!tmcBus.idle()) nextLoop();
+    s_model->flush();
+}
+
+// A fresh line with drivers at the addresses in @p fitted (bit per address).
+static void fit(TmcModel& model, uint8_t fitted) {
+    model = TmcModel(TMC_UART_BAUD);
+    for (uint8_t a = 0; a < 4; a++) {
+        if (fitted & (1u << a)) model.fit(a);
+    }
+    s_model = &model;
+    Serial2.attach(&model);
+}
+
+static bool check(bool pass, const char* what) {
+    printf("%s  %s\n", pass ? "ok  " : "FAIL", what);
+    return pass;
+}
+
+// ============================================================================
+//  Configuration
+// ============================================================================
+
+/// One axis's driver as configured.
+struct DriverUnderTest {
+    const char*      name;
+    Tmc2209&         driver;
+    const TmcConfig& config;
+    uint16_t         microsteps;
+};
+
+static const DriverUnderTest s_drivers[] = {
+    { "mandrel", mandrelDriver, MANDREL_DRIVER_CONFIG, MANDREL_MOTOR_PARAMS.microsteps },
+    { "carriage", carriageDriver, CARRIAGE_DRIVER_CONFIG, CARRIAGE_MOTOR_PARAMS.microsteps },
+    { "toolarm", toolarmDriver, TOOLARM_DRIVER_CONFIG, TOOLARM_MOTOR_PARAMS.microsteps },
+    { "toolhead", toolheadDriver, TOOLHEAD_DRIVER_CONFIG, TOOLHEAD_MOTOR_PARAMS.microsteps },
+};
+
+// Half a current step in the sense range in force (mA).
+static float halfStepMA(const TmcNodeModel& n) {
+    const float fullScale = (n.read(TmcReg::CHOPCONF) & TmcReg::VSENSE) ? 0.180f : 0.325f;
+    return 0.5f * 1000.0f * fullScale / (TMC_SENSE_OHMS + 0.02f) / sqrtf(2.0f) / 32.0f;
+}
+
+// Is @p d's driver model configured as it should be?
+static bool configured(const DriverUnderTest& d) {
+    const TmcNodeModel* n = s_model->node(d.config.address);
+    if (!n || !d.driver.present()) return false;
+    const float half = halfStepMA(*n);
+    const float hold = d.config.runCurrentMA * d.config.holdPercent * 0.01f;
+    return n->microsteps() == d.microsteps && (n->read(TmcReg::GCONF) & TmcReg::PDN_DISABLE) &&
+           n->stealthChop() == d.config.stealthChop &&
+           fabsf(n->runCurrentMA(TMC_SENSE_OHMS) - d.config.runCurrentMA) <= half + 0.5f &&
+           fabsf(n->holdCurrentMA(TMC_SENSE_OHMS) - hold) <= 2.0f * half + 0.5f &&
+           labs(lroundf(n->runCurrentMA(TMC_SENSE_OHMS)) - d.driver.runCurrentMA()) <= 1;
+}
+
+static void printDriverModels(uint64_t us) {
+    printf("axis      address  microsteps  run_mA (asked)  hold_mA (asked)  chopper  writes  faults\n");
+    for (const DriverUnderTest& d : s_drivers) {
+        const TmcNodeModel* n = d.config.address == TMC_NO_ADDRESS ? nullptr : s_model->node(d.config.address);
+        if (!n) {
+            printf("%-8s  %7s  %10u  %-48s\n", d.name, "-", d.microsteps, "strapped, not on the UART");
+            continue;
+        }
+        printf("%-8s  %7u  %10u  %6.0f (%5u)  %7.0f (%5.0f)  %-7s  %6u  %6u\n", d.name, n->address(),
+               n->microsteps(), n->runCurrentMA(TMC_SENSE_OHMS), d.config.runCurrentMA,
+               n->holdCurrentMA(TMC_SENSE_OHMS), d.config.runCurrentMA * d.config.holdPercent * 0.01f,
+               n->stealthChop() ? "stealth" : "spread", n->writes(), d.driver.faults());
+    }
+    printf("%.1f ms, %u datagrams, %u CRC errors\n\n", us * 1e-3, s_model->datagrams(), s_model->crcErrors());
+}
+
+static bool configuration(TmcModel& model) {
+    const uint8_t onBus = (1u << MANDREL_DRIVER_CONFIG.address) | (1u << TOOLARM_DRIVER_CONFIG.address) |
+                          (1u << TOOLHEAD_DRIVER_CONFIG.address);
+    bool ok = true;
+
+    // Every driver there.
+    fit(model, onBus);
+    printf("Strapped before configuration: toolarm 1/%u, toolhead 1/%u\n\n",
+           model.node(TOOLARM_DRIVER_CONFIG.address)->microsteps(),
+           model.node(TOOLHEAD_DRIVER_CONFIG.address)->microsteps());
+    uint64_t t0    = hostMicros64();
+    uint8_t  found = initDrivers();
+    printf("Drivers found: %u\n", found);
+    printDriverModels(hostMicros64() - t0);
+    bool all = found == 3 && !carriageDriver.present() && model.crcErrors() == 0;
+    for (const DriverUnderTest& d : s_drivers) {
+        if (d.config.address == TMC_NO_ADDRESS) continue;
+        all = all && configured(d) && model.node(d.config.address)->writes() == 6 && d.driver.faults() == 0 &&
+              d.driver.verify();
+    }
+    ok = check(all, "every driver on the UART is configured and read back; the carriage is left alone") && ok;
+
+    // A byte of the mandrel's configuration corrupted on the wire: 8 bytes
+    // of probe and counter read, then its writes.
+    fit(model, onBus);
+    model.corrupt(20);
+    t0    = hostMicros64();
+    found = initDrivers();
+    printf("One configuration byte corrupted\n");
+    printDriverModels(hostMicros64() - t0);
+    bool retried = found == 3 && model.crcErrors() == 1 && mandrelDriver.faults() == 1;
+    for (const DriverUnderTest& d : s_drivers) {
+        if (d.config.address != TMC_NO_ADDRESS) retried = retried && configured(d);
+    }
+    ok = check(retried, "a corrupted write is dropped, noticed and the configuration retried") && ok;
+
+    // The toolarm's driver missing.
+    fit(model, onBus & ~(1u << TOOLARM_DRIVER_CONFIG.address));
+    found = initDrivers();
+    const uint32_t before = model.datagrams();
+    toolarmDriver.setStepShift(2);
+    toolarmDriver.setCurrent(500, 50);
+    settle();
+    printf("Toolarm driver missing: %u found, toolarm %s\n\n", found,
+           toolarmDriver.present() ? "present" : "absent");
+    ok = check(found == 2 && !toolarmDriver.present() && toolarmDriver.stepShift() == 0 &&
+               model.datagrams() == before,
+               "a missing driver is reported absent and never written") && ok;
+
+    // Run current sweep, and the chopper back and forth.
+    fit(model, onBus);
+    initDrivers();
+    TmcNodeModel& arm  = *model.node(TOOLARM_DRIVER_CONFIG.address);
+    float         worst = 0.0f, worstStep = 0.0f;
+    bool          agree = true;
+    for (uint16_t mA = 100; mA <= 1700; mA += 25) {
+        toolarmDriver.setCurrent(mA, 50);
+        settle();
+        const float err = fabsf(arm.runCurrentMA(TMC_SENSE_OHMS) - mA) / halfStepMA(arm);
+        if (err > worst) {
+            worst     = err;
+            worstStep = 2.0f * halfStepMA(arm);
+        }
+        agree = agree && labs(lroundf(arm.runCurrentMA(TMC_SENSE_OHMS)) - toolarmDriver.runCurrentMA()) <= 1 &&
+                labs(lroundf(arm.holdCurrentMA(TMC_SENSE_OHMS)) - toolarmDriver.holdCurrentMA()) <= 1;
+    }
+    toolarmDriver.setStealthChop(!TOOLARM_DRIVER_CONFIG.stealthChop);
+    settle();
+    const bool flipped = arm.stealthChop() != TOOLARM_DRIVER_CONFIG.stealthChop;
+    toolarmDriver.setStealthChop(TOOLARM_DRIVER_CONFIG.stealthChop);
+    toolarmDriver.setCurrent(TOOLARM_DRIVER_CONFIG.runCurrentMA, TOOLARM_DRIVER_CONFIG.holdPercent);
+    settle();
+    printf("Run current 100 … 1700 mA: worst %.2f of half a step (step %.1f mA there)\n\n", worst, worstStep);
+    ok = check(worst <= 1.0f + 1e-3f && agree && flipped && toolarmDriver.verify() &&
+               configured(s_drivers[2]),
+               "every run current is within half a step and the driver reports what it set") && ok;
+    return ok;
+}
+
+// ============================================================================
+//  Resolution Switching
+// ============================================================================
+
+/// Pulses and moves at each resolution, and the worst deviations.
+struct MoveStats {
+    long     moves[4]  = {};
+    long     pulses[4] = {};
+    long     drift     = 0;   ///< Largest |motor − logical − slack − start offset| (steps).
+    long     endError  = 0;   ///< Largest |target − position| after a move, over the pulse size.
+};
+
+template <class Stepper>
+static MoveStats moves(const char* name, Stepper& st, Tmc2209& driver, Motor& motor, uint16_t microsteps,
+                       float maxSpeed, float accel, long backlash, long range, long n, std::mt19937& rng) {
+    MoveStats s;
+    driver.setStepShift(0);
+    settle();
+    st = Stepper();
+    st.setMaxSpeed(maxSpeed);
+    st.setAcceleration(accel);
+    st.setBacklash(backlash, 1600.0f);
+    motor.zero = s_model->node(motor.address)->position256();
+    const long offset = -st.slack();
+
+    auto sample = [&]() {
+        const long d = labs(motorSteps(motor, microsteps) - st.currentPosition() - st.slack() - offset);
+        if (d > s.drift) s.drift = d;
+    };
+
+    std::uniform_int_distribution<int>  shifts(0, 3);
+    std::uniform_int_distribution<long> steps(-range, range);
+    std::uniform_real_distribution<float> speed(0.1f * maxSpeed, maxSpeed);
+    for (long i = 0; i < n; i++) {
+        const uint8_t shift = static_cast<uint8_t>(shifts(rng));
+        driver.setStepShift(shift);
+        st.setStepShift(shift);
+        settle();
+        const uint32_t p0 = s_model->node(motor.address)->pulses();
+        if (i % 4 != 3) {
+            const long target = st.currentPosition() + steps(rng);
+            st.moveTo(target);
+            while (st.run()) {
+                nextLoop();
+                sample();
+            }
+            const long e = labs(target - st.currentPosition()) >> shift;
+            if (e > s.endError) s.endError = e;
+        } else {
+            const long  from = st.currentPosition();
+            const float v    = (i % 8 == 3 ? 1.0f : -1.0f) * speed(rng) * 0.25f;
+            const long  len  = labs(steps(rng)) / 4 + 1;
+            st.setSpeed(v);
+            while (labs(st.currentPosition() - from) < len) {
+                st.runSpeed();
+                nextLoop();
+                sample();
+            }
+            st.setSpeed(0.0f);
+            st.moveTo(st.currentPosition());   // The target is stale after setSpeed().
+        }
+        s.moves[shift]++;
+        s.pulses[shift] += s_model->node(motor.address)->pulses() - p0;
+    }
+    driver.setStepShift(0);
+    st.setStepShift(0);
+    settle();
+
+    printf("%s: %ld moves, backlash %ld steps\n", name, n, backlash);
+    printf("microsteps  moves  pulses\n");
+    for (int k = 0; k < 4; k++) printf("%10u  %5ld  %6ld\n", microsteps >> k, s.moves[k], s.pulses[k]);
+    printf("drift %ld steps, worst end %ld pulses from the target\n\n", s.drift, s.endError);
+    return s;
+}
+
+static bool switching(long n, unsigned seed) {
+    std::mt19937 rng(seed);
+    const MoveStats arm  = moves("toolarm", toolarmStepper, toolarmDriver, s_toolarm,
+                                 TOOLARM_MOTOR_PARAMS.microsteps, DEFAULT_TOOLARM_MAX_SPEED,
+                                 DEFAULT_TOOLARM_ACCEL, 13, lroundf(ToolarmAxis::toSteps(5.0f)), n, rng);
+    const MoveStats head = moves("toolhead", toolheadStepper, toolheadDriver, s_toolhead,
+                                 TOOLHEAD_MOTOR_PARAMS.microsteps, DEFAULT_TOOLHEAD_MAX_SPEED,
+                                 DEFAULT_TOOLHEAD_ACCEL, 0, lroundf(ToolheadAxis::toSteps(180.0f)), n, rng);
+    const uint32_t raced = s_model->node(s_toolarm.address)->raced() + s_model->node(s_toolhead.address)->raced();
+    bool ok = check(arm.drift == 0 && head.drift == 0 && arm.endError == 0 && head.endError == 0 && raced == 0,
+                    "the motor stays at the logical position plus the slack at every resolution; "
+                    "moves end within a pulse and no pulse races a switch");
+
+    // Switch and pulse at once, without waiting for the driver.
+    toolheadDriver.setStepShift(2);
+    hostAdvanceMicros(100);
+    digitalWrite(s_toolhead.stepPin, HIGH);
+    digitalWrite(s_toolhead.stepPin, LOW);
+    settle();
+    const uint32_t caught = s_model->node(s_toolhead.address)->raced();
+    printf("Pulse right after a switch: %u raced\n\n", caught);
+    ok = check(caught == 1, "the model catches a pulse that races a resolution change") && ok;
+    toolheadDriver.setStepShift(0);
+    settle();
+    return ok;
+}
+
+// ============================================================================
+//  Homing
+// ============================================================================
+
+/// Toolarm homings from random points, with or without its driver.
+struct HomingStats {
+    double seconds  = 0.0;   ///< Mean.
+    double pulses   = 0.0;   ///< Mean.
+    double rate     = 0.0;   ///< Fastest pulse rate (pulses/s).
+    long   worst    = 0;     ///< Largest |motor − logical| once homed.
+    bool   complete = true;
+};
+
+static HomingStats homings(Tmc2209* driver, long n, unsigned seed) {
+    std::mt19937                          rng(seed);
+    std::uniform_real_distribution<float> from(10.0f, 100.0f);
+    TmcNodeModel&                         node = *s_model->node(s_toolarm.address);
+    HomingStats                           s;
+
+    for (long i = 0; i < n; i++) {
+        toolarmDriver.setStepShift(0);
+        settle();
+        toolarmStepper = ToolarmStepper();
+        const long start = lroundf(ToolarmAxis::toSteps(from(rng)));
+        s_toolarm.zero   = node.position256() - start * (256 / TOOLARM_MOTOR_PARAMS.microsteps);
+        s_switchClosed   = false;
+        toolarmStepper.setCurrentPosition(start);
+
+        HomingAxis<ToolarmStepper> homing(toolarmStepper, TOOLARM_HOMING, driver);
+        const uint32_t p0    = node.pulses();
+        uint32_t       pLast = p0;
+        uint64_t       tLast = hostMicros64();
+        homing.start();
+        while (homing.busy()) {
+            homing.update(s_switchClosed, s_switchEdge);
+            nextLoop();
+            // Pulse rate over 10 ms windows.
+            if (hostMicros64() - tLast >= 10000) {
+                s.rate = fmax(s.rate, (node.pulses() - pLast) * 1e6 / (hostMicros64() - tLast));
+                pLast  = node.pulses();
+                tLast  = hostMicros64();
+            }
+        }
+        const long err = labs(motorSteps(s_toolarm, TOOLARM_MOTOR_PARAMS.microsteps) -
+                              toolarmStepper.currentPosition());
+        s.complete = s.complete && homing.stage() == HomingStage::DONE && toolarmStepper.stepShift() == 0 &&
+                     node.microsteps() == TOOLARM_MOTOR_PARAMS.microsteps;
+        s.worst    = std::max(s.worst, err);
+        s.seconds += homing.report().seconds / n;
+        s.pulses  += static_cast<double>(node.pulses() - p0) / n;
+    }
+    return s;
+}
+
+static bool homing(long n, unsigned seed) {
+    const HomingStats coarse = homings(&toolarmDriver, n, seed);
+    const HomingStats fine   = homings(nullptr, n, seed);
+
+    printf("Toolarm homing, %ld from 10 … 100 mm, seek %.0f steps/s\n\n", n, TOOLARM_HOMING_FAST_SPEED);
+    printf("seek        microsteps  mean_s  pulses   peak_pulses/s  home_error\n");
+    printf("coarse      %10u  %6.3f  %7.0f  %13.0f  %10ld\n", TOOLARM_HOMING_SEEK_MICROSTEPS, coarse.seconds,
+           coarse.pulses, coarse.rate, coarse.worst);
+    printf("own         %10u  %6.3f  %7.0f  %13.0f  %10ld\n\n", TOOLARM_MOTOR_PARAMS.microsteps, fine.seconds,
+           fine.pulses, fine.rate, fine.worst);
+    return check(coarse.complete && fine.complete && coarse.worst == 0 && fine.worst == 0 &&
+                 coarse.pulses < fine.pulses && coarse.seconds <= 1.05 * fine.seconds,
+                 "every homing ends at the switch at the axis's own resolution; the coarse seek "
+                 "pulses less for no more than 5 % longer");
+}
+
+// ============================================================================
+//  Main
+// ============================================================================
+
+static void usage() {
+    fprintf(stderr, "usage: tmc_uart [--moves N] [--homings N] [--loop-us N] [--seed N]\n");
+}
+
+int main(int argc, char** argv) {
+    long     n       = 400;
+    long     homes   = 10;
+    unsigned seed    = 1;
+    for (int a = 1; a < argc; a++) {
+        bool hasValue = a + 1 < argc;
+        if      (!strcmp(argv[a], "--moves") && hasValue)   n        = atol(argv[++a]);
+        else if (!strcmp(argv[a], "--homings") && hasValue) homes    = atol(argv[++a]);
+        else if (!strcmp(argv[a], "--loop-us") && hasValue) s_loopUs = atoi(argv[++a]);
+        else if (!strcmp(argv[a], "--seed") && hasValue)    seed     = atoi(argv[++a]);
+        else {
+            usage();
+            return 2;
+        }
+    }
+    if (n < 1 || homes < 1 || s_loopUs < 1) {
+        usage();
+        return 2;
+    }
+
+    hostResetClock();
+    hostSetPinWriter(onPinWrite);
+    initSteppers();
+
+    TmcModel model(TMC_UART_BAUD);
+    bool ok = configuration(model);
+
+    const uint8_t onBus = (1u << MANDREL_DRIVER_CONFIG.address) | (1u << TOOLARM_DRIVER_CONFIG.address) |
+                          (1u << TOOLHEAD_DRIVER_CONFIG.address);
+    fit(model, onBus);
+    initDrivers();
+    ok = switching(n, seed) && ok;
+    ok = homing(homes, seed) && ok;
+    return ok ? 0 : 1;
+}
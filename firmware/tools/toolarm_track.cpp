@@ -0,0 +1,175 @@
+/// @file toolarm_track.cpp
+/// @brief Check that the toolarm follows a profiled mandrel, slowing the
+///        mandrel only where it has to.
+///
+///     toolarm_track <profile> [--loop-us N]
+///
+/// Winds the profile twice in the simulator: retargeting the toolarm to the
+/// surface under the carriage on every step ("lookahead 0", as the 4-axis
+/// scripts do in MOVING) and with the look-ahead plan (the default —
+/// toolarm_plan.h).  Per layer the tool prints the plan (slowest mandrel
+/// speed and how much of the zone is slowed), each run's worst toolarm
+/// error against the surface while winding, and what the slow-downs cost:
+/// simulated (the look-ahead run's layer time over the retargeting run's)
+/// and estimated, and what slowing the whole layer to the plan's slowest
+/// speed would cost instead.  It fails (exit code 1) if
+///
+///   - either run does not complete,
+///   - the look-ahead run's toolarm is ever more than TRACK_TOLERANCE_MM
+///     off the surface (within a carriage step of the carriage position),
+///   - a layer's slow-downs cost more than slowing it uniformly would, or
+///   - the simulated cost is off the estimate by more than 10 % or 0.5 s.
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "sim.h"
+#include "axis.h"
+#include "estimate.h"
+#include "pattern.h"
+#include "toolarm_plan.h"
+
+// Worst toolarm error the look-ahead may show (mm).
+static const double TRACK_TOLERANCE_MM = 0.1;
+
+static void usage() {
+    fprintf(stderr, "usage: toolarm_track <profile> [--loop-us N]\n");
+}
+
+// Toolarm steps between @p toolarm and the surface within a carriage step
+// of @p carriage: the carriage moves in steps, and on a steep section one
+// of them is many toolarm steps of the target.  The surface is the spline
+// itself, so the error includes the firmware's target table.
+static double surfaceError(const SplineProfile& mandrel, long carriage, long toolarm) {
+    const double a = mandrel.getTarget(CarriageAxis::toMM(carriage - 1)) * ToolarmAxis::stepsPerMM();
+    const double b = mandrel.getTarget(CarriageAxis::toMM(carriage + 1)) * ToolarmAxis::stepsPerMM();
+    if (toolarm < fmin(a, b)) return fmin(a, b) - toolarm;
+    if (toolarm > fmax(a, b)) return toolarm - fmax(a, b);
+    return 0.0;
+}
+
+// Per-layer results of one run.
+struct LayerRun {
+    double seconds = 0.0;   // First WINDING sample to the next layer's.
+    double errorMM = 0.0;   // Worst toolarm error while winding.
+};
+
+static bool simulate(const SimProfile& profile, const SimOptions& options, const SplineProfile& mandrel,
+                     std::vector<LayerRun>& out, SimResult& result) {
+    std::vector<StepSample> trace;
+    if (!Sim::run(profile, options, &trace, result) || !result.completed) return false;
+
+    out.assign(profile.layers.size(), LayerRun());
+    std::vector<double> starts(profile.layers.size() + 1, result.durationUs / 1e6);
+    for (const StepSample& s : trace) {
+        if (s.state != WindingState::WINDING) continue;
+        if (s.timeUs / 1e6 < starts[s.layer]) starts[s.layer] = s.timeUs / 1e6;
+        const double error = surfaceError(mandrel, s.carriage, s.toolarm) * ToolarmAxis::mmPerStep();
+        if (error > out[s.layer].errorMM) out[s.layer].errorMM = error;
+    }
+    for (size_t i = 0; i < profile.layers.size(); i++) {
+        out[i].seconds = starts[i + 1] - starts[i];
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        usage();
+        return 2;
+    }
+
+    SimOptions options;
+    for (int a = 2; a < argc; a++) {
+        bool hasValue = a + 1 < argc;
+        if (!strcmp(argv[a], "--loop-us") && hasValue) {
+            options.loopUs = atoi(argv[++a]);
+        } else {
+            usage();
+            return 2;
+        }
+    }
+
+    SimProfile  lookAhead;
+    std::string error;
+    if (!loadProfile(argv[1], lookAhead, error)) {
+        fprintf(stderr, "toolarm_track: %s\n", error.c_str());
+        return 2;
+    }
+    const SplineProfile* mandrel = fitMandrel(lookAhead);
+    if (!mandrel) {
+        fprintf(stderr, "toolarm_track: %s has no mandrel profile (the toolarm is not driven)\n", argv[1]);
+        return 2;
+    }
+    lookAhead.toolarmLookAhead = true;
+    SimProfile retarget        = lookAhead;
+    retarget.toolarmLookAhead  = false;
+
+    // The plans and the estimate, as Winding::start() has them.
+    EstimateParams params = Estimate::defaultParams();
+    params.loopUs         = options.loopUs;
+    params.overlapFlip    = lookAhead.overlapToolheadFlip;
+    EstimateParams fixed  = params;
+    fixed.toolarmLookAhead = false;
+
+    std::vector<Layer>       layers;
+    std::vector<ToolarmPlan> plans(lookAhead.layers.size());
+    for (size_t i = 0; i < lookAhead.layers.size(); i++) {
+        Layer layer = lookAhead.layers[i];
+        if (lookAhead.patternSequencing) Pattern::apply(layer, params);
+        layers.push_back(layer);
+        plans[i].build(layer, *mandrel, params);
+    }
+
+    Serial.setSink(nullptr);
+    std::vector<LayerRun> fixedRun, planRun;
+    SimResult             fixedResult, planResult;
+    if (!simulate(retarget, options, *mandrel, fixedRun, fixedResult) ||
+        !simulate(lookAhead, options, *mandrel, planRun, planResult)) {
+        fprintf(stderr, "toolarm_track: simulation failed (more than %d layers?)\n", MAX_LAYERS);
+        return 1;
+    }
+
+    printf("layer  min_speed  slowed  error_mm (retarget)   cost_s (est)  uniform_s\n");
+    int    rc       = 0;
+    float  pos      = 0.0f;
+    double worstFix = 0.0;
+    for (size_t i = 0; i < layers.size(); i++) {
+        const Layer*        next = i + 1 < layers.size() ? &lookAhead.layers[i + 1] : nullptr;
+        const LayerEstimate a    = Estimate::layer(layers[i], params, pos, next, mandrel);
+        const LayerEstimate b    = Estimate::layer(layers[i], fixed, pos, next, mandrel);
+        pos = a.endMM;
+
+        const ToolarmSummary& sum     = plans[i].summary();
+        const double          cost    = planRun[i].seconds - fixedRun[i].seconds;
+        const double          costEst = a.totalSeconds - b.totalSeconds;
+        const double          uniform = sum.uniformSeconds * a.passes;
+        if (fixedRun[i].errorMM > worstFix) worstFix = fixedRun[i].errorMM;
+
+        printf("%5zu  %7.0f %%  %4.0f %%  %8.3f (%8.3f)  %6.1f (%5.1f)  %9.1f\n", i, 100.0 * sum.minSpeed,
+               100.0 * sum.slowedShare, planRun[i].errorMM, fixedRun[i].errorMM, cost, costEst, uniform);
+
+        if (planRun[i].errorMM > TRACK_TOLERANCE_MM) {
+            printf("FAIL  layer %zu: toolarm %.3f mm off the surface (tolerance %.3f mm)\n", i,
+                   planRun[i].errorMM, TRACK_TOLERANCE_MM);
+            rc = 1;
+        }
+        if (cost > uniform + 1e-3) {
+            printf("FAIL  layer %zu: slow-downs cost %.1f s, slowing the whole layer %.1f s\n", i, cost, uniform);
+            rc = 1;
+        }
+        if (fabs(cost - costEst) > fmax(0.1 * fabs(costEst), 0.5)) {
+            printf("FAIL  layer %zu: slow-downs cost %.1f s, estimated %.1f s\n", i, cost, costEst);
+            rc = 1;
+        }
+    }
+
+    printf("job %.1f s retargeting (toolarm up to %.3f mm off), %.1f s with the look-ahead\n",
+           fixedResult.durationUs / 1e6, worstFix, planResult.durationUs / 1e6);
+    printf("%s\n", rc ? "FAIL" : "ok");
+    return rc;
+}
@@ -0,0 +1,275 @@
+/// @file trace2chrome.cpp
+/// @brief Convert a firmware trace dump into Chrome / Perfetto trace JSON.
+///
+/// Capture the raw serial output of the "trace" command to a file (any text
+/// printed around the frame is skipped), then:
+///
+///     trace2chrome capture.bin > trace.json
+///
+/// and open trace.json in chrome://tracing or https://ui.perfetto.dev.
+/// If the capture holds several dumps the last complete one is converted.
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "trace.h"
+
+// Mirrors WindingState in winding.h (kept local so this tool has no Arduino
+// dependency).
+static const char* const STATE_NAMES[] = {
+    "IDLE", "PAUSED", "ZEROING", "WINDING", "DWELLING", "COMPLETE"
+};
+static const char* const AXIS_NAMES[] = { "mandrel", "carriage", "toolarm", "toolhead" };
+// Mirrors Input in inputs.h.
+static const char* const INPUT_NAMES[] = {
+    "carriage limit", "toolarm limit", "toolhead limit", "E-stop"
+};
+
+// Thread ids used to group events into tracks.
+enum Track { TRACK_STATE = 1, TRACK_LAYER, TRACK_PASS, TRACK_SERIAL, TRACK_INPUT };
+
+// ============================================================================
+//  Capture Parsing
+// ============================================================================
+
+static bool readFile(const char* path, std::vector<uint8_t>& out) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return false;
+    uint8_t buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) out.insert(out.end(), buf, buf + n);
+    fclose(f);
+    return true;
+}
+
+// Locate the last complete frame; returns false if none is found.
+static bool findFrame(const std::vector<uint8_t>& data, TraceHeader& header,
+                      std::vector<TraceRecord>& records) {
+    bool found = false;
+    for (size_t i = 0; i + sizeof(TraceHeader) <= data.size(); i++) {
+        TraceHeader h;
+        memcpy(&h, &data[i], sizeof(h));
+        if (h.magic != TRACE_MAGIC) continue;
+        if (h.version != TRACE_VERSION || h.recordSize != sizeof(TraceRecord)) {
+            fprintf(stderr, "trace2chrome: skipping frame with version %u / record size %u\n",
+                    h.version, h.recordSize);
+            continue;
+        }
+        size_t body = static_cast<size_t>(h.count) * sizeof(TraceRecord);
+        if (i + sizeof(h) + body > data.size()) continue;   // Truncated capture.
+
+        header = h;
+        records.resize(h.count);
+        if (body) memcpy(records.data(), &data[i + sizeof(h)], body);
+        found = true;
+        i += sizeof(h) + body - 1;
+    }
+    return found;
+}
+
+// ============================================================================
+//  JSON Output
+// ============================================================================
+
+static bool s_firstEvent = true;
+
+static void beginEvent() {
+    printf(s_firstEvent ? "\n    " : ",\n    ");
+    s_firstEvent = false;
+}
+
+static void sliceEvent(const char* name, int tid, uint64_t ts, uint64_t end) {
+    beginEvent();
+    printf("{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%llu,\"dur\":%llu}",
+           name, tid, static_cast<unsigned long long>(ts),
+           static_cast<unsigned long long>(end - ts));
+}
+
+static void instantEvent(const char* name, int tid, uint64_t ts) {
+    beginEvent();
+    printf("{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":%d,\"ts\":%llu}",
+           name, tid, static_cast<unsigned long long>(ts));
+}
+
+static void counterEvent(const char* name, const char* series, uint64_t ts, long value) {
+    beginEvent();
+    printf("{\"name\":\"%s\",\"ph\":\"C\",\"pid\":1,\"ts\":%llu,\"args\":{\"%s\":%ld}}",
+           name, static_cast<unsigned long long>(ts), series, value);
+}
+
+static void threadName(int tid, const char* name) {
+    beginEvent();
+    printf("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+           tid, name);
+}
+
+static const char* stateName(int s) {
+    return (s >= 0 && s < static_cast<int>(sizeof(STATE_NAMES) / sizeof(STATE_NAMES[0])))
+         ? STATE_NAMES[s] : "?";
+}
+
+static const char* axisName(int a) {
+    return (a >= 0 && a < static_cast<int>(sizeof(AXIS_NAMES) / sizeof(AXIS_NAMES[0]))) ? AXIS_NAMES[a] : "axis";
+}
+
+static const char* inputName(int i) {
+    return (i >= 0 && i < static_cast<int>(sizeof(INPUT_NAMES) / sizeof(INPUT_NAMES[0])))
+         ? INPUT_NAMES[i] : "input";
+}
+
+// Build a printable command name from a packed SERIAL_CMD value.
+static std::string unpackCommand(int32_t packed, uint16_t length) {
+    std::string s;
+    for (int i = 0; i < 4; i++) {
+        char c = static_cast<char>((static_cast<uint32_t>(packed) >> (8 * i)) & 0xFF);
+        if (c == '\0') break;
+        s += (c == '"' || c == '\\' || c < 0x20) ? '?' : c;
+    }
+    if (length > 4) s += "...";
+    return s.empty() ? std::string("(empty)") : s;
+}
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        fprintf(stderr, "usage: trace2chrome <capture-file>\n");
+        return 2;
+    }
+
+    std::vector<uint8_t> data;
+    if (!readFile(argv[1], data)) {
+        fprintf(stderr, "trace2chrome: cannot read %s\n", argv[1]);
+        return 1;
+    }
+
+    TraceHeader header = {};
+    std::vector<TraceRecord> records;
+    if (!findFrame(data, header, records)) {
+        fprintf(stderr, "trace2chrome: no complete trace frame in %s\n", argv[1]);
+        return 1;
+    }
+    if (header.dropped) {
+        fprintf(stderr, "trace2chrome: %u older records were overwritten before the dump\n",
+                header.dropped);
+    }
+
+    // Unwrap the 32-bit micros() timestamps relative to the first record.
+    std::vector<uint64_t> ts(records.size());
+    uint64_t t = 0;
+    for (size_t i = 0; i < records.size(); i++) {
+        if (i > 0) t += static_cast<uint32_t>(records[i].timeUs - records[i - 1].timeUs);
+        ts[i] = t;
+    }
+    const uint64_t endTs = records.empty() ? 0 : ts.back();
+
+    printf("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    threadName(TRACK_STATE,  "state");
+    threadName(TRACK_LAYER,  "layer");
+    threadName(TRACK_PASS,   "pass");
+    threadName(TRACK_SERIAL, "serial");
+    threadName(TRACK_INPUT,  "inputs");
+
+    // Open slices, closed by the next event of the same kind.
+    int      curState   = -1;  uint64_t stateStart = 0;
+    int      curLayer   = -1;  uint64_t layerStart = 0;
+    uint64_t passStart  = 0;   bool     inPass     = false;
+    char     name[48];
+
+    for (size_t i = 0; i < records.size(); i++) {
+        const TraceRecord& r = records[i];
+        const uint64_t now = ts[i];
+
+        switch (static_cast<TraceEvent>(r.event)) {
+        case TraceEvent::STATE:
+            if (curState >= 0) sliceEvent(stateName(curState), TRACK_STATE, stateStart, now);
+            curState   = r.arg;
+            stateStart = now;
+            if (curState == 5 && curLayer >= 0) {   // COMPLETE closes the last layer.
+                snprintf(name, sizeof(name), "layer %d", curLayer);
+                sliceEvent(name, TRACK_LAYER, layerStart, now);
+                curLayer = -1;
+            }
+            break;
+
+        case TraceEvent::LAYER_BEGIN:
+            if (curLayer >= 0) {
+                snprintf(name, sizeof(name), "layer %d", curLayer);
+                sliceEvent(name, TRACK_LAYER, layerStart, now);
+            }
+            curLayer   = r.arg;
+            layerStart = now;
+            passStart  = now;
+            inPass     = true;
+            break;
+
+        case TraceEvent::PASS_END:
+            snprintf(name, sizeof(name), "L%u pass %d", r.arg, static_cast<int>(r.value));
+            if (inPass) sliceEvent(name, TRACK_PASS, passStart, now);
+            else        instantEvent(name, TRACK_PASS, now);
+            passStart = now;
+            inPass    = true;
+            break;
+
+        case TraceEvent::SERIAL_CMD:
+            instantEvent(unpackCommand(r.value, r.arg).c_str(), TRACK_SERIAL, now);
+            break;
+
+        case TraceEvent::STEP_BURST:
+            snprintf(name, sizeof(name), "%s burst", axisName(r.arg));
+            counterEvent(name, "steps", now, r.value);
+            break;
+
+        case TraceEvent::QUEUE_LEVEL:
+            snprintf(name, sizeof(name), "%s queue", axisName(r.arg));
+            counterEvent(name, "steps", now, r.value);
+            break;
+
+        case TraceEvent::MARK:
+            snprintf(name, sizeof(name), "mark %u:%d", r.arg, static_cast<int>(r.value));
+            instantEvent(name, TRACK_STATE, now);
+            break;
+
+        case TraceEvent::PLAN_MISS:
+            snprintf(name, sizeof(name), "plan miss L%u (%d)", r.arg, static_cast<int>(r.value));
+            instantEvent(name, TRACK_LAYER, now);
+            break;
+
+        case TraceEvent::SWITCH:
+            snprintf(name, sizeof(name), "%s %s (%d us)", inputName(r.arg & 0xFF),
+                     (r.arg >> 8) ? "on" : "off", static_cast<int>(r.value));
+            instantEvent(name, TRACK_INPUT, now);
+            break;
+
+        case TraceEvent::STALL:
+            snprintf(name, sizeof(name), "%s stall L%u P%d (SG %d)", axisName(r.arg & 0xFF), r.arg >> 8,
+                     static_cast<int>(r.value >> 16), static_cast<int>(r.value & 0xFFFF));
+            instantEvent(name, TRACK_STATE, now);
+            break;
+
+        case TraceEvent::STEP_LOSS:
+            snprintf(name, sizeof(name), "%s home moved %d steps", axisName(r.arg), static_cast<int>(r.value));
+            instantEvent(name, TRACK_STATE, now);
+            break;
+
+        case TraceEvent::FOLLOWING_ERROR:
+            snprintf(name, sizeof(name), "%s following error %d steps", axisName(r.arg), static_cast<int>(r.value));
+            instantEvent(name, TRACK_STATE, now);
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    // Close whatever is still open at the end of the capture.
+    if (curState >= 0) sliceEvent(stateName(curState), TRACK_STATE, stateStart, endTs);
+    if (curLayer >= 0) {
+        snprintf(name, sizeof(name), "layer %d", curLayer);
+        sliceEvent(name, TRACK_LAYER, layerStart, endTs);
+    }
+
+    printf("\n]}\n");
+    fprintf(stderr, "trace2chrome: %u records, %.3f s\n", header.count, endTs / 1e6);
+    return 0;
+}